@@ -2,10 +2,13 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
 
 #include "AudioCommon/AlsaSoundStream.h"
 #include "AudioCommon/AOSoundStream.h"
 #include "AudioCommon/AudioCommon.h"
+#include "AudioCommon/CaptureSoundStream.h"
 #include "AudioCommon/CoreAudioSoundStream.h"
 #include "AudioCommon/Mixer.h"
 #include "AudioCommon/NullSoundStream.h"
@@ -54,6 +57,8 @@ namespace AudioCommon
 			g_sound_stream = new PulseAudio();
 		else if (backend == BACKEND_OPENSLES && OpenSLESStream::isValid())
 			g_sound_stream = new OpenSLESStream();
+		else if (backend == BACKEND_CAPTURE && CaptureSound::isValid())
+			g_sound_stream = new CaptureSound();
 
 		if (!g_sound_stream && NullSound::isValid())
 		{
@@ -74,6 +79,8 @@ namespace AudioCommon
 				g_sound_stream->Start();
 			}
 
+			g_sound_stream->GetMixer()->SetLatencyTarget(std::max(SConfig::GetInstance().m_MixerLatency, 1));
+
 			if (SConfig::GetInstance().m_DumpAudio && !s_audio_dump_start)
 				StartAudioDump();
 
@@ -94,6 +101,9 @@ namespace AudioCommon
 		if (g_sound_stream)
 		{
 			g_sound_stream->Stop();
+			CMixer* mixer = g_sound_stream->GetMixer();
+			INFO_LOG(AUDIO, "Mixer underruns: %" PRIu64 " frames, overruns: %" PRIu64 " frames",
+			         mixer->GetUnderrunCount(), mixer->GetOverrunCount());
 			if (SConfig::GetInstance().m_DumpAudio && s_audio_dump_start)
 				StopAudioDump();
 			delete g_sound_stream;
@@ -123,6 +133,8 @@ namespace AudioCommon
 			backends.push_back(BACKEND_OPENAL);
 		if (OpenSLESStream::isValid())
 			backends.push_back(BACKEND_OPENSLES);
+		if (CaptureSound::isValid())
+			backends.push_back(BACKEND_CAPTURE);
 		return backends;
 	}
 
@@ -0,0 +1,145 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <utility>
+
+#include "AudioCommon/CaptureSoundStream.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/SystemTimers.h"
+
+bool CaptureSound::Start()
+{
+	m_path = SConfig::GetInstance().m_CapturePath;
+	if (m_path.empty())
+		m_path = File::GetUserPath(D_DUMPAUDIO_IDX) + "capture.flac";
+	File::CreateFullPath(m_path);
+
+	std::string extension;
+	SplitPath(m_path, nullptr, nullptr, &extension);
+	std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+	m_flac = extension != ".wav";
+
+	if (m_flac)
+	{
+		if (!m_flac_writer.Start(m_path, m_mixer->GetSampleRate()))
+			return false;
+	}
+	else
+	{
+		if (!m_wave_writer.Start(m_path, m_mixer->GetSampleRate()))
+			return false;
+		m_wave_writer.SetSkipSilence(false);
+	}
+
+	NOTICE_LOG(AUDIO, "Capturing audio to %s", m_path.c_str());
+
+	m_block.reserve(FLAC_BLOCK_SIZE * 2);
+	m_have_last_ticks = false;
+	m_run_thread.Set();
+	m_thread = std::thread(&CaptureSound::WriterThread, this);
+	return true;
+}
+
+void CaptureSound::Stop()
+{
+	if (!m_thread.joinable())
+		return;
+
+	if (!m_block.empty())
+		m_blocks.Push(std::move(m_block));
+
+	m_run_thread.Clear();
+	m_blocks_queued.Set();
+	m_thread.join();
+
+	if (m_flac)
+	{
+		NOTICE_LOG(AUDIO, "Captured %llu frames to %s",
+		           (unsigned long long)m_flac_writer.GetSampleCount(), m_path.c_str());
+		m_flac_writer.Stop();
+	}
+	else
+	{
+		NOTICE_LOG(AUDIO, "Captured %u frames to %s", m_wave_writer.GetAudioSize() / 4, m_path.c_str());
+		m_wave_writer.Stop();
+	}
+}
+
+void CaptureSound::Update()
+{
+	RenderUntil(CoreTiming::GetTicks(), SystemTimers::GetTicksPerSecond());
+}
+
+void CaptureSound::RenderUntil(u64 ticks, u64 ticks_per_second)
+{
+	// The first update only sets the starting point. Time going backwards or
+	// jumping ahead by more than a second means a state was loaded, start over
+	// from there rather than capturing a gap.
+	if (!m_have_last_ticks || ticks < m_last_ticks || ticks - m_last_ticks > ticks_per_second)
+	{
+		m_have_last_ticks = true;
+		m_last_ticks = ticks;
+		m_ticks_remainder = 0;
+		return;
+	}
+
+	// Render the frames which were played in the emulated time since the last
+	// update, carrying the fraction of a frame over to the next one.
+	m_ticks_remainder += (ticks - m_last_ticks) * m_mixer->GetSampleRate();
+	m_last_ticks = ticks;
+	const u32 num_samples_to_render = (u32)(m_ticks_remainder / ticks_per_second);
+	m_ticks_remainder %= ticks_per_second;
+	if (!num_samples_to_render)
+		return;
+
+	const size_t offset = m_block.size();
+	m_block.resize(offset + num_samples_to_render * 2);
+	m_mixer->Mix(&m_block[offset], num_samples_to_render);
+
+	if (m_block.size() >= FLAC_BLOCK_SIZE * 2)
+	{
+		m_blocks.Push(std::move(m_block));
+		m_blocks_queued.Set();
+		m_block = std::vector<short>();
+		m_block.reserve(FLAC_BLOCK_SIZE * 2 + num_samples_to_render * 2);
+	}
+}
+
+void CaptureSound::WriterThread()
+{
+	Common::SetCurrentThreadName("Audio capture thread");
+
+	while (m_run_thread.IsSet())
+	{
+		m_blocks_queued.Wait();
+		WriteBlocks();
+	}
+
+	// Stop() queues the last partial block before clearing the flag.
+	WriteBlocks();
+}
+
+void CaptureSound::WriteBlocks()
+{
+	std::vector<short> block;
+	while (m_blocks.Pop(block))
+	{
+		// CMixer::Mix puts the right channel first.
+		const u32 num_frames = (u32)(block.size() / 2);
+		for (u32 i = 0; i < num_frames; i++)
+			std::swap(block[i * 2], block[i * 2 + 1]);
+
+		if (m_flac)
+			m_flac_writer.AddStereoSamples(block.data(), num_frames);
+		else
+			m_wave_writer.AddStereoSamples(block.data(), num_frames);
+	}
+}
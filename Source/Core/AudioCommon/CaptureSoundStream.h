@@ -0,0 +1,58 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AudioCommon/FlacFile.h"
+#include "AudioCommon/SoundStream.h"
+#include "AudioCommon/WaveFile.h"
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/FifoQueue.h"
+#include "Common/Flag.h"
+
+// A sound stream without an audio device: on every update, the mixer is pulled for
+// the frames played in the emulated time since the last one, and the output is
+// handed to a writer thread that encodes it to FLAC (or WAV, if the capture path
+// ends in .wav). The emulation thread only ever
+// copies samples into a block and queues it, so it never waits on the disk.
+class CaptureSound final : public SoundStream
+{
+public:
+	bool Start() override;
+	void Stop() override;
+	void Update() override;
+
+	static bool isValid() { return true; }
+
+	// Renders the frames played until the given emulated time. Update() calls
+	// this with the current time.
+	void RenderUntil(u64 ticks, u64 ticks_per_second);
+
+private:
+	void WriterThread();
+	void WriteBlocks();
+
+	std::string m_path;
+	bool m_flac;
+	FlacFileWriter m_flac_writer;
+	WaveFileWriter m_wave_writer;
+
+	std::thread m_thread;
+	Common::Flag m_run_thread;
+	Common::Event m_blocks_queued;
+	Common::FifoQueue<std::vector<short>, false> m_blocks;
+
+	// Interleaved frames gathered since the last block was queued.
+	std::vector<short> m_block;
+
+	bool m_have_last_ticks = false;
+	u64 m_last_ticks = 0;
+	// The emulated time since the last rendered frame, in ticks * sample rate.
+	u64 m_ticks_remainder = 0;
+};
@@ -18,6 +18,12 @@
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
 
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <xmmintrin.h>
+#elif defined(_M_ARM_64)
+#include <arm_neon.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
@@ -33,56 +39,60 @@ static float l_fwr, r_fwr, lpr_fwr, lmr_fwr;
 static std::vector<float> fwrbuf_l, fwrbuf_r;
 static float adapt_l_gain, adapt_r_gain, adapt_lpr_gain, adapt_lmr_gain;
 static std::vector<float> lf, rf, lr, rr, cf, cr;
-static float LFE_buf[256];
-static unsigned int lfe_pos;
-static float *filter_coefs_lfe;
 static unsigned int len125;
 
-template<class T, class _ftype_t>
-static _ftype_t DotProduct(int count, const T *buf, const _ftype_t *coefficients)
+// The LFE low-pass filter runs over blocks of this many frames at a time.
+static const int LFE_BLOCK_SIZE = 256;
+// Filter taps, oldest sample first.
+static std::vector<float> lfe_taps;
+// The last len125 - 1 filter inputs, followed by the current block.
+static std::vector<float> lfe_history;
+
+static float DotProduct(int count, const float *buf, const float *coefficients)
 {
-	int i;
-	float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+	int i = 0;
+	float sum = 0.0f;
 
-	// Unrolled loop
-	for (i = 0; (i + 3) < count; i += 4)
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	__m128 sum0 = _mm_setzero_ps(), sum1 = _mm_setzero_ps();
+	__m128 sum2 = _mm_setzero_ps(), sum3 = _mm_setzero_ps();
+	for (; (i + 15) < count; i += 16)
 	{
-		sum0 += buf[i + 0] * coefficients[i + 0];
-		sum1 += buf[i + 1] * coefficients[i + 1];
-		sum2 += buf[i + 2] * coefficients[i + 2];
-		sum3 += buf[i + 3] * coefficients[i + 3];
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(&buf[i + 0]), _mm_loadu_ps(&coefficients[i + 0])));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(&buf[i + 4]), _mm_loadu_ps(&coefficients[i + 4])));
+		sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(&buf[i + 8]), _mm_loadu_ps(&coefficients[i + 8])));
+		sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(&buf[i + 12]), _mm_loadu_ps(&coefficients[i + 12])));
 	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3)));
+	sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(_M_ARM_64)
+	float32x4_t sum0 = vdupq_n_f32(0.0f), sum1 = vdupq_n_f32(0.0f);
+	float32x4_t sum2 = vdupq_n_f32(0.0f), sum3 = vdupq_n_f32(0.0f);
+	for (; (i + 15) < count; i += 16)
+	{
+		sum0 = vmlaq_f32(sum0, vld1q_f32(&buf[i + 0]), vld1q_f32(&coefficients[i + 0]));
+		sum1 = vmlaq_f32(sum1, vld1q_f32(&buf[i + 4]), vld1q_f32(&coefficients[i + 4]));
+		sum2 = vmlaq_f32(sum2, vld1q_f32(&buf[i + 8]), vld1q_f32(&coefficients[i + 8]));
+		sum3 = vmlaq_f32(sum3, vld1q_f32(&buf[i + 12]), vld1q_f32(&coefficients[i + 12]));
+	}
+	sum = vaddvq_f32(vaddq_f32(vaddq_f32(sum0, sum1), vaddq_f32(sum2, sum3)));
+#endif
 
-	// Epilogue of unrolled loop
 	for (; i < count; i++)
-		sum0 += buf[i] * coefficients[i];
+		sum += buf[i] * coefficients[i];
 
-	return sum0 + sum1 + sum2 + sum3;
+	return sum;
 }
 
-template<class T>
-static T FIRFilter(const T *buf, int pos, int len, int count, const float *coefficients)
+// Runs the LFE low-pass over the current block, writing every sixth output.
+static void LFEFilter(int count, float *out)
 {
-	int count1, count2;
-
-	if (pos >= count)
-	{
-		pos -= count;
-		count1 = count; count2 = 0;
-	}
-	else
-	{
-		count2 = pos;
-		count1 = count - pos;
-		pos = len - count1;
-	}
-
-	// high part of window
-	const T *ptr = &buf[pos];
+	for (int i = 0; i < count; i++)
+		out[i * 6] = DotProduct(len125, &lfe_history[i], lfe_taps.data());
 
-	float r1 = DotProduct(count1, ptr, coefficients); coefficients += count1;
-	float r2 = DotProduct(count2, buf, coefficients);
-	return T(r1 + r2);
+	// Keep the inputs the next block still needs.
+	std::copy(lfe_history.begin() + count, lfe_history.begin() + count + len125 - 1, lfe_history.begin());
 }
 
 /*
@@ -188,33 +198,34 @@ static void OnSeek()
 	std::fill(rr.begin(), rr.end(), 0.0f);
 	std::fill(cf.begin(), cf.end(), 0.0f);
 	std::fill(cr.begin(), cr.end(), 0.0f);
-	lfe_pos = 0;
-	memset(LFE_buf, 0, sizeof(LFE_buf));
+	std::fill(lfe_history.begin(), lfe_history.end(), 0.0f);
 }
 
 static void Done()
 {
 	OnSeek();
 
-	if (filter_coefs_lfe)
-	{
-		free(filter_coefs_lfe);
-	}
-
-	filter_coefs_lfe = nullptr;
+	lfe_taps.clear();
+	lfe_history.clear();
 }
 
-static float* CalculateCoefficients125HzLowpass(int rate)
+static void CalculateCoefficients125HzLowpass(int rate)
 {
 	len125 = 256;
 	float f = 125.0f / (rate / 2);
 	float *coeffs = DesignFIR(&len125, &f, 0);
 	static const float M3_01DB = 0.7071067812f;
-	for (unsigned int i = 0; i < len125; i++)
-	{
-		coeffs[i] *= M3_01DB;
-	}
-	return coeffs;
+
+	// The filter used to run over a circular buffer starting at the newest
+	// sample, which applies coeffs[0] to it and coeffs[m - 1] to the sample m
+	// frames older. Store the taps in that order, reversed to match the history.
+	lfe_taps.resize(len125);
+	lfe_taps[len125 - 1] = coeffs[0] * M3_01DB;
+	for (unsigned int m = 1; m < len125; m++)
+		lfe_taps[len125 - 1 - m] = coeffs[m - 1] * M3_01DB;
+	free(coeffs);
+
+	lfe_history.assign(len125 - 1 + LFE_BLOCK_SIZE, 0.0f);
 }
 
 static float PassiveLock(float x)
@@ -334,56 +345,58 @@ void DPL2Decode(float *samples, int numsamples, float *out)
 		rr.resize(dlbuflen);
 		cf.resize(dlbuflen);
 		cr.resize(dlbuflen);
-		filter_coefs_lfe = CalculateCoefficients125HzLowpass(fmt_freq);
-		lfe_pos = 0;
-		memset(LFE_buf, 0, sizeof(LFE_buf));
+		CalculateCoefficients125HzLowpass(fmt_freq);
 	}
 
 	float *in = samples; // Input audio data
-	float *end = in + numsamples * fmt_nchannels; // Loop end
 
-	while (in < end)
+	for (int block_start = 0; block_start < numsamples; block_start += LFE_BLOCK_SIZE)
 	{
-		const int k = cyc_pos;
-
-		const int fwr_pos = (k + FWRDURATION) % dlbuflen;
-		/* Update the full wave rectified total amplitude */
-		/* Input matrix decoder */
-		l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
-		r_fwr += fabs(in[1]) - fabs(fwrbuf_r[fwr_pos]);
-		lpr_fwr += fabs(in[0] + in[1]) - fabs(fwrbuf_l[fwr_pos] + fwrbuf_r[fwr_pos]);
-		lmr_fwr += fabs(in[0] - in[1]) - fabs(fwrbuf_l[fwr_pos] - fwrbuf_r[fwr_pos]);
-
-		/* Matrix encoded 2 channel sources */
-		fwrbuf_l[k] = in[0];
-		fwrbuf_r[k] = in[1];
-		MatrixDecode(in, k, 0, 1, true, dlbuflen,
-			l_fwr, r_fwr,
-			lpr_fwr, lmr_fwr,
-			&adapt_l_gain, &adapt_r_gain,
-			&adapt_lpr_gain, &adapt_lmr_gain,
-			&lf[0], &rf[0], &lr[0], &rr[0], &cf[0]);
-
-		out[cur + 0] = lf[k];
-		out[cur + 1] = rf[k];
-		out[cur + 2] = cf[k];
-		LFE_buf[lfe_pos] = (lf[k] + rf[k] + 2.0f * cf[k] + lr[k] + rr[k]) / 2.0f;
-		out[cur + 3] = FIRFilter(LFE_buf, lfe_pos, len125, len125, filter_coefs_lfe);
-		lfe_pos++;
-		if (lfe_pos == len125)
-		{
-			lfe_pos = 0;
-		}
-		out[cur + 4] = lr[k];
-		out[cur + 5] = rr[k];
-		// Next sample...
-		in += 2;
-		cur += 6;
-		cyc_pos--;
-		if (cyc_pos < 0)
+		const int block_size = std::min(numsamples - block_start, LFE_BLOCK_SIZE);
+		float *lfe_in = &lfe_history[len125 - 1];
+
+		for (int i = 0; i < block_size; i++)
 		{
-			cyc_pos += dlbuflen;
+			const int k = cyc_pos;
+
+			const int fwr_pos = (k + FWRDURATION) % dlbuflen;
+			/* Update the full wave rectified total amplitude */
+			/* Input matrix decoder */
+			l_fwr += fabs(in[0]) - fabs(fwrbuf_l[fwr_pos]);
+			r_fwr += fabs(in[1]) - fabs(fwrbuf_r[fwr_pos]);
+			lpr_fwr += fabs(in[0] + in[1]) - fabs(fwrbuf_l[fwr_pos] + fwrbuf_r[fwr_pos]);
+			lmr_fwr += fabs(in[0] - in[1]) - fabs(fwrbuf_l[fwr_pos] - fwrbuf_r[fwr_pos]);
+
+			/* Matrix encoded 2 channel sources */
+			fwrbuf_l[k] = in[0];
+			fwrbuf_r[k] = in[1];
+			MatrixDecode(in, k, 0, 1, true, dlbuflen,
+				l_fwr, r_fwr,
+				lpr_fwr, lmr_fwr,
+				&adapt_l_gain, &adapt_r_gain,
+				&adapt_lpr_gain, &adapt_lmr_gain,
+				&lf[0], &rf[0], &lr[0], &rr[0], &cf[0]);
+
+			out[cur + 0] = lf[k];
+			out[cur + 1] = rf[k];
+			out[cur + 2] = cf[k];
+			lfe_in[i] = (lf[k] + rf[k] + 2.0f * cf[k] + lr[k] + rr[k]) / 2.0f;
+			out[cur + 4] = lr[k];
+			out[cur + 5] = rr[k];
+			// Next sample...
+			in += fmt_nchannels;
+			cur += 6;
+			cyc_pos--;
+			if (cyc_pos < 0)
+			{
+				cyc_pos += dlbuflen;
+			}
 		}
+
+		// The matrix decoder adapts every sample, but the 256-tap LFE filter
+		// doesn't depend on its own output, so it runs afterwards over the
+		// whole block.
+		LFEFilter(block_size, &out[block_start * 6 + 3]);
 	}
 }
 
@@ -391,5 +404,4 @@ void DPL2Reset()
 {
 	olddelay = -1;
 	oldfreq = 0;
-	filter_coefs_lfe = nullptr;
 }
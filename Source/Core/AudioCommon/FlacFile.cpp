@@ -0,0 +1,479 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "AudioCommon/FlacFile.h"
+#include "Common/CommonTypes.h"
+#include "Common/MsgHandler.h"
+
+enum
+{
+	STREAMINFO_SIZE = 34,
+	// The largest partition order tried when Rice coding residuals.
+	MAX_PARTITION_ORDER = 8,
+	MAX_RICE_PARAMETER = 14,
+	MAX_FIXED_ORDER = 4,
+};
+
+// Stereo decorrelation modes, as stored in the frame header.
+enum
+{
+	CHANNELS_INDEPENDENT = 0x1,
+	CHANNELS_LEFT_SIDE = 0x8,
+	CHANNELS_RIGHT_SIDE = 0x9,
+	CHANNELS_MID_SIDE = 0xA,
+};
+
+class FlacFileWriter::BitWriter
+{
+public:
+	explicit BitWriter(std::vector<u8>& out) : m_out(out), m_acc(0), m_count(0) {}
+
+	void Write(u32 value, u32 bits)
+	{
+		m_acc = (m_acc << bits) | (value & ((1ULL << bits) - 1));
+		m_count += bits;
+		while (m_count >= 8)
+		{
+			m_count -= 8;
+			m_out.push_back((u8)(m_acc >> m_count));
+		}
+	}
+
+	void WriteRice(u32 value, u32 k)
+	{
+		u32 quotient = value >> k;
+		while (quotient >= 32)
+		{
+			Write(0, 32);
+			quotient -= 32;
+		}
+		if (quotient + 1 + k <= 32)
+		{
+			Write((1 << k) | (value & ((1 << k) - 1)), quotient + 1 + k);
+		}
+		else
+		{
+			Write(1, quotient + 1);
+			Write(value, k);
+		}
+	}
+
+	void AlignToByte()
+	{
+		if (m_count)
+			Write(0, 8 - m_count);
+	}
+
+private:
+	std::vector<u8>& m_out;
+	u64 m_acc;
+	u32 m_count;
+};
+
+static u8 CRC8(const u8* data, size_t size)
+{
+	u8 crc = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80) ? (u8)((crc << 1) ^ 0x07) : (u8)(crc << 1);
+	}
+	return crc;
+}
+
+static u16 CRC16(const u8* data, size_t size)
+{
+	u16 crc = 0;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc ^= data[i] << 8;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? (u16)((crc << 1) ^ 0x8005) : (u16)(crc << 1);
+	}
+	return crc;
+}
+
+static u32 ZigZag(s32 value)
+{
+	return ((u32)value << 1) ^ (u32)(value >> 31);
+}
+
+// Picks the fixed predictor order with the smallest total absolute residual,
+// the same heuristic the reference encoder uses.
+static u32 BestFixedOrder(const s32* x, u32 count, u64* residual_sum)
+{
+	u64 sums[MAX_FIXED_ORDER + 1] = {};
+	s32 last0 = x[3];
+	s32 last1 = x[3] - x[2];
+	s32 last2 = last1 - (x[2] - x[1]);
+	s32 last3 = last2 - (x[2] - x[1] - (x[1] - x[0]));
+
+	for (u32 i = MAX_FIXED_ORDER; i < count; i++)
+	{
+		s32 e0 = x[i];
+		s32 e1 = e0 - last0;
+		s32 e2 = e1 - last1;
+		s32 e3 = e2 - last2;
+		s32 e4 = e3 - last3;
+		sums[0] += std::abs(e0);
+		sums[1] += std::abs(e1);
+		sums[2] += std::abs(e2);
+		sums[3] += std::abs(e3);
+		sums[4] += std::abs(e4);
+		last0 = e0;
+		last1 = e1;
+		last2 = e2;
+		last3 = e3;
+	}
+
+	u32 order = 0;
+	for (u32 i = 1; i <= MAX_FIXED_ORDER; i++)
+	{
+		if (sums[i] < sums[order])
+			order = i;
+	}
+	*residual_sum = sums[order];
+	return order;
+}
+
+// Estimated bits for a block of Rice coded residuals whose zigzagged values add
+// up to sum.
+static u32 RiceParameter(u64 sum, u32 count, u64* bits)
+{
+	u32 best_k = 0;
+	u64 best_bits = UINT64_MAX;
+	for (u32 k = 0; k <= MAX_RICE_PARAMETER; k++)
+	{
+		u64 cost = (u64)count * (k + 1) + (sum >> k);
+		if (cost < best_bits)
+		{
+			best_bits = cost;
+			best_k = k;
+		}
+	}
+	*bits = best_bits;
+	return best_k;
+}
+
+// Rough size of a channel after fixed prediction, used to pick the stereo mode.
+static u64 ChannelCost(const s32* x, u32 count)
+{
+	if (count <= MAX_FIXED_ORDER)
+		return 0;
+	u64 sum;
+	BestFixedOrder(x, count, &sum);
+	return sum;
+}
+
+FlacFileWriter::FlacFileWriter()
+	: m_sample_rate(0)
+	, m_sample_count(0)
+	, m_frame_number(0)
+	, m_min_frame_size(0)
+	, m_max_frame_size(0)
+	, m_block_fill(0)
+{
+}
+
+FlacFileWriter::~FlacFileWriter()
+{
+	Stop();
+}
+
+bool FlacFileWriter::Start(const std::string& filename, unsigned int sample_rate)
+{
+	if (m_file)
+	{
+		PanicAlertT("The file %s was already open, the file header will not be written.", filename.c_str());
+		return false;
+	}
+
+	m_file.Open(filename, "wb");
+	if (!m_file)
+	{
+		PanicAlertT("The file %s could not be opened for writing. Please check if it's already opened by another program.", filename.c_str());
+		return false;
+	}
+
+	m_sample_rate = sample_rate;
+	m_sample_count = 0;
+	m_frame_number = 0;
+	m_min_frame_size = 0;
+	m_max_frame_size = 0;
+	m_block_fill = 0;
+	m_left.resize(FLAC_BLOCK_SIZE);
+	m_right.resize(FLAC_BLOCK_SIZE);
+	m_mid.resize(FLAC_BLOCK_SIZE);
+	m_side.resize(FLAC_BLOCK_SIZE);
+	m_residual.resize(FLAC_BLOCK_SIZE);
+
+	WriteStreamInfo();
+	return true;
+}
+
+void FlacFileWriter::Stop()
+{
+	if (!m_file)
+		return;
+
+	if (m_block_fill)
+		EncodeBlock();
+
+	// Now that the stream is complete, fill in the length and frame sizes.
+	m_file.Seek(0, SEEK_SET);
+	WriteStreamInfo();
+	m_file.Close();
+}
+
+void FlacFileWriter::WriteStreamInfo()
+{
+	m_frame.clear();
+	BitWriter bits(m_frame);
+	bits.Write(0x664C6143, 32); // "fLaC"
+	bits.Write(1, 1);           // last metadata block
+	bits.Write(0, 7);           // STREAMINFO
+	bits.Write(STREAMINFO_SIZE, 24);
+	bits.Write(FLAC_BLOCK_SIZE, 16);
+	bits.Write(FLAC_BLOCK_SIZE, 16);
+	bits.Write(m_min_frame_size, 24);
+	bits.Write(m_max_frame_size, 24);
+	bits.Write(m_sample_rate, 20);
+	bits.Write(2 - 1, 3);  // channels
+	bits.Write(16 - 1, 5); // bits per sample
+	bits.Write((u32)(m_sample_count >> 32), 4);
+	bits.Write((u32)m_sample_count, 32);
+	// No MD5 signature.
+	for (int i = 0; i < 4; i++)
+		bits.Write(0, 32);
+	m_file.WriteBytes(m_frame.data(), m_frame.size());
+}
+
+void FlacFileWriter::AddStereoSamples(const short* sample_data, u32 count)
+{
+	if (!m_file)
+		PanicAlertT("FlacFileWriter - file not open.");
+
+	for (u32 i = 0; i < count; i++)
+	{
+		m_left[m_block_fill] = sample_data[2 * i];
+		m_right[m_block_fill] = sample_data[2 * i + 1];
+		if (++m_block_fill == FLAC_BLOCK_SIZE)
+			EncodeBlock();
+	}
+}
+
+void FlacFileWriter::EncodeBlock()
+{
+	const u32 count = m_block_fill;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		m_mid[i] = (m_left[i] + m_right[i]) >> 1;
+		m_side[i] = m_left[i] - m_right[i];
+	}
+
+	const u64 left = ChannelCost(m_left.data(), count);
+	const u64 right = ChannelCost(m_right.data(), count);
+	const u64 mid = ChannelCost(m_mid.data(), count);
+	const u64 side = ChannelCost(m_side.data(), count);
+
+	u32 mode = CHANNELS_INDEPENDENT;
+	u64 best = left + right;
+	if (left + side < best)
+	{
+		mode = CHANNELS_LEFT_SIDE;
+		best = left + side;
+	}
+	if (right + side < best)
+	{
+		mode = CHANNELS_RIGHT_SIDE;
+		best = right + side;
+	}
+	if (mid + side < best)
+		mode = CHANNELS_MID_SIDE;
+
+	m_frame.clear();
+	BitWriter bits(m_frame);
+
+	// Frame header
+	bits.Write(0x3FFE, 14);
+	bits.Write(0, 1);                                   // reserved
+	bits.Write(0, 1);                                   // fixed block size
+	bits.Write(count == FLAC_BLOCK_SIZE ? 0xC : 0x7, 4); // 4096, or a 16-bit size below
+	bits.Write(0, 4);                                   // sample rate from STREAMINFO
+	bits.Write(mode, 4);
+	bits.Write(0x4, 3);                                 // 16 bits per sample
+	bits.Write(0, 1);                                   // reserved
+
+	// The frame number is stored with UTF-8 style variable length coding.
+	if (m_frame_number < 0x80)
+	{
+		bits.Write(m_frame_number, 8);
+	}
+	else
+	{
+		u32 extra = 1;
+		while (extra < 5 && m_frame_number >= (1U << (5 * extra + 6)))
+			extra++;
+		bits.Write((0xFF00 >> (extra + 1)) | (m_frame_number >> (6 * extra)), 8);
+		for (u32 i = extra; i > 0; i--)
+			bits.Write(0x80 | ((m_frame_number >> (6 * (i - 1))) & 0x3F), 8);
+	}
+
+	if (count != FLAC_BLOCK_SIZE)
+		bits.Write(count - 1, 16);
+
+	bits.Write(CRC8(m_frame.data(), m_frame.size()), 8);
+
+	switch (mode)
+	{
+	case CHANNELS_INDEPENDENT:
+		EncodeSubframe(bits, m_left.data(), count, 16);
+		EncodeSubframe(bits, m_right.data(), count, 16);
+		break;
+	case CHANNELS_LEFT_SIDE:
+		EncodeSubframe(bits, m_left.data(), count, 16);
+		EncodeSubframe(bits, m_side.data(), count, 17);
+		break;
+	case CHANNELS_RIGHT_SIDE:
+		EncodeSubframe(bits, m_side.data(), count, 17);
+		EncodeSubframe(bits, m_right.data(), count, 16);
+		break;
+	case CHANNELS_MID_SIDE:
+		EncodeSubframe(bits, m_mid.data(), count, 16);
+		EncodeSubframe(bits, m_side.data(), count, 17);
+		break;
+	}
+
+	bits.AlignToByte();
+	bits.Write(CRC16(m_frame.data(), m_frame.size()), 16);
+
+	m_file.WriteBytes(m_frame.data(), m_frame.size());
+
+	const u32 frame_size = (u32)m_frame.size();
+	if (!m_min_frame_size || frame_size < m_min_frame_size)
+		m_min_frame_size = frame_size;
+	if (frame_size > m_max_frame_size)
+		m_max_frame_size = frame_size;
+
+	m_sample_count += count;
+	m_frame_number++;
+	m_block_fill = 0;
+}
+
+void FlacFileWriter::EncodeSubframe(BitWriter& bits, const s32* samples, u32 count, u32 bps)
+{
+	bool constant = true;
+	for (u32 i = 1; i < count && constant; i++)
+		constant = samples[i] == samples[0];
+
+	if (constant)
+	{
+		bits.Write(0x00, 8);
+		bits.Write(samples[0], bps);
+		return;
+	}
+
+	const u64 verbatim_bits = (u64)count * bps;
+
+	if (count > MAX_FIXED_ORDER)
+	{
+		u64 residual_sum;
+		const u32 order = BestFixedOrder(samples, count, &residual_sum);
+
+		u64 estimate;
+		RiceParameter(residual_sum * 2, count - order, &estimate);
+		if (order * bps + estimate < verbatim_bits)
+		{
+			for (u32 i = order; i < count; i++)
+			{
+				const s32* x = &samples[i];
+				s32 residual;
+				switch (order)
+				{
+				case 0: residual = x[0]; break;
+				case 1: residual = x[0] - x[-1]; break;
+				case 2: residual = x[0] - 2 * x[-1] + x[-2]; break;
+				case 3: residual = x[0] - 3 * x[-1] + 3 * x[-2] - x[-3]; break;
+				default: residual = x[0] - 4 * x[-1] + 6 * x[-2] - 4 * x[-3] + x[-4]; break;
+				}
+				m_residual[i - order] = ZigZag(residual);
+			}
+
+			bits.Write(0x10 | (order << 1), 8);
+			for (u32 i = 0; i < order; i++)
+				bits.Write(samples[i], bps);
+			EncodeResidual(bits, count, order);
+			return;
+		}
+	}
+
+	bits.Write(0x02, 8);
+	for (u32 i = 0; i < count; i++)
+		bits.Write(samples[i], bps);
+}
+
+void FlacFileWriter::EncodeResidual(BitWriter& bits, u32 count, u32 order)
+{
+	// Partition i covers samples [i * size, (i + 1) * size) of the block; the
+	// first one starts after the warm-up samples.
+	auto partition_sum = [&](u32 partition_order, u32 i, u32* n) {
+		const u32 size = count >> partition_order;
+		const u32 begin = i ? i * size : order;
+		const u32 end = (i + 1) * size;
+		u64 sum = 0;
+		for (u32 j = begin; j < end; j++)
+			sum += m_residual[j - order];
+		*n = end - begin;
+		return sum;
+	};
+
+	u32 max_order = 0;
+	while (max_order < MAX_PARTITION_ORDER && !(count & ((2U << max_order) - 1)) &&
+	       (count >> (max_order + 1)) > order)
+	{
+		max_order++;
+	}
+
+	u32 best_order = 0;
+	u64 best_bits = UINT64_MAX;
+	for (u32 partition_order = 0; partition_order <= max_order; partition_order++)
+	{
+		u64 total = 0;
+		for (u32 i = 0; i < (1U << partition_order); i++)
+		{
+			u32 n;
+			u64 sum = partition_sum(partition_order, i, &n);
+			u64 partition_bits;
+			RiceParameter(sum, n, &partition_bits);
+			total += 4 + partition_bits;
+		}
+		if (total < best_bits)
+		{
+			best_bits = total;
+			best_order = partition_order;
+		}
+	}
+
+	bits.Write(0, 2); // Rice coding with 4-bit parameters
+	bits.Write(best_order, 4);
+	const u32 size = count >> best_order;
+	for (u32 i = 0; i < (1U << best_order); i++)
+	{
+		u32 n;
+		u64 partition_bits;
+		const u64 sum = partition_sum(best_order, i, &n);
+		const u32 k = RiceParameter(sum, n, &partition_bits);
+		bits.Write(k, 4);
+
+		const u32 begin = i ? i * size : order;
+		for (u32 j = begin; j < (i + 1) * size; j++)
+			bits.WriteRice(m_residual[j - order], k);
+	}
+}
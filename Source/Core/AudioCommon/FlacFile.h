@@ -0,0 +1,65 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// ---------------------------------------------------------------------------------
+// Class: FlacFileWriter
+// Description: Streaming encoder for 16-bit stereo FLAC files, with the same
+// interface as WaveFileWriter.
+// Samples are gathered into fixed blocks of FLAC_BLOCK_SIZE frames. Each block is
+// stored with the cheapest stereo decorrelation mode and fixed predictor order, and
+// the residuals are Rice coded in adaptively sized partitions. No LPC or MD5.
+// Stop() flushes the last partial block and fills in the total sample count.
+// ---------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+
+enum
+{
+	FLAC_BLOCK_SIZE = 4096
+};
+
+class FlacFileWriter : NonCopyable
+{
+public:
+	FlacFileWriter();
+	~FlacFileWriter();
+
+	bool Start(const std::string& filename, unsigned int sample_rate);
+	void Stop();
+
+	void AddStereoSamples(const short* sample_data, u32 count);
+	u64 GetSampleCount() const { return m_sample_count; }
+
+private:
+	class BitWriter;
+
+	void WriteStreamInfo();
+	void EncodeBlock();
+	void EncodeSubframe(BitWriter& bits, const s32* samples, u32 count, u32 bps);
+	void EncodeResidual(BitWriter& bits, u32 count, u32 order);
+
+	File::IOFile m_file;
+	u32 m_sample_rate;
+	u64 m_sample_count;
+	u32 m_frame_number;
+	u32 m_min_frame_size;
+	u32 m_max_frame_size;
+
+	// Per-channel samples of the block being gathered.
+	std::vector<s32> m_left;
+	std::vector<s32> m_right;
+	u32 m_block_fill;
+
+	// Scratch space reused by every frame.
+	std::vector<s32> m_mid;
+	std::vector<s32> m_side;
+	std::vector<u32> m_residual;
+	std::vector<u8> m_frame;
+};
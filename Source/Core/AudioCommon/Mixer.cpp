@@ -2,6 +2,9 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cmath>
+
 #include "AudioCommon/AudioCommon.h"
 #include "AudioCommon/Mixer.h"
 #include "Common/CPUDetect.h"
@@ -18,6 +21,113 @@
 #include <tmmintrin.h>
 #endif
 
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+struct PolyphaseTable
+{
+	alignas(16) s16 taps[POLYPHASE_PHASES][POLYPHASE_TAPS];
+
+	PolyphaseTable()
+	{
+		// Blackman-windowed sinc with the cutoff just below the input Nyquist
+		// frequency. The mixers mostly upsample (32 kHz DMA and 3 kHz Wiimote
+		// speaker audio to the backend rate) so one fixed table is enough.
+		const double pi = 3.14159265358979323846;
+		const double cutoff = 0.9;
+		const double half_width = POLYPHASE_TAPS / 2;
+
+		for (int phase = 0; phase < POLYPHASE_PHASES; ++phase)
+		{
+			double mu = (double)phase / POLYPHASE_PHASES;
+			double h[POLYPHASE_TAPS];
+			double sum = 0.0;
+			for (int k = 0; k < POLYPHASE_TAPS; ++k)
+			{
+				// Tap k applies to the input sample k - (TAPS / 2 - 1) frames
+				// away from the current read position.
+				double x = k - (POLYPHASE_TAPS / 2 - 1) - mu;
+				double t = pi * cutoff * x;
+				double sinc = x == 0.0 ? 1.0 : std::sin(t) / t;
+				double w = 0.42 + 0.5 * std::cos(pi * x / half_width) +
+				           0.08 * std::cos(2.0 * pi * x / half_width);
+				h[k] = sinc * w;
+				sum += h[k];
+			}
+
+			// Normalize every phase to exactly unity DC gain so the filter does
+			// not add its own ripple at the phase rate. Rounding leftovers go
+			// to the largest tap.
+			int total = 0;
+			int largest = 0;
+			for (int k = 0; k < POLYPHASE_TAPS; ++k)
+			{
+				taps[phase][k] = (s16)std::lround(h[k] / sum * (1 << 14));
+				total += taps[phase][k];
+				if (taps[phase][k] > taps[phase][largest])
+					largest = k;
+			}
+			taps[phase][largest] += (1 << 14) - total;
+		}
+	}
+};
+
+const PolyphaseTable& GetPolyphaseTable()
+{
+	static const PolyphaseTable table;
+	return table;
+}
+
+// Filters one stereo frame out of POLYPHASE_TAPS big-endian interleaved
+// frames at window.
+inline void PolyphaseFilter(const short* window, const s16* taps, int* left, int* right)
+{
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	__m128i acc_l = _mm_setzero_si128();
+	__m128i acc_r = _mm_setzero_si128();
+	for (int k = 0; k < POLYPHASE_TAPS; k += 8)
+	{
+		__m128i v0 = _mm_loadu_si128((const __m128i*)(window + k * 2));
+		__m128i v1 = _mm_loadu_si128((const __m128i*)(window + k * 2 + 8));
+		v0 = _mm_or_si128(_mm_slli_epi16(v0, 8), _mm_srli_epi16(v0, 8));
+		v1 = _mm_or_si128(_mm_slli_epi16(v1, 8), _mm_srli_epi16(v1, 8));
+
+		// Split the interleaved frames into eight left and eight right samples.
+		__m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(v0, 16), 16),
+		                            _mm_srai_epi32(_mm_slli_epi32(v1, 16), 16));
+		__m128i r = _mm_packs_epi32(_mm_srai_epi32(v0, 16), _mm_srai_epi32(v1, 16));
+
+		__m128i c = _mm_load_si128((const __m128i*)(taps + k));
+		acc_l = _mm_add_epi32(acc_l, _mm_madd_epi16(l, c));
+		acc_r = _mm_add_epi32(acc_r, _mm_madd_epi16(r, c));
+	}
+
+	// Horizontal sums: after the unpacks, lanes 0/1 hold left and 2/3 right.
+	__m128i lo = _mm_unpacklo_epi64(acc_l, acc_r);
+	__m128i hi = _mm_unpackhi_epi64(acc_l, acc_r);
+	__m128i sums = _mm_add_epi32(lo, hi);
+	sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, _MM_SHUFFLE(2, 3, 0, 1)));
+	*left = _mm_cvtsi128_si32(sums) >> 14;
+	*right = _mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums)) >> 14;
+#else
+	int sum_l = 0;
+	int sum_r = 0;
+	for (int k = 0; k < POLYPHASE_TAPS; ++k)
+	{
+		sum_l += (s16)Common::swap16(window[k * 2]) * taps[k];
+		sum_r += (s16)Common::swap16(window[k * 2 + 1]) * taps[k];
+	}
+	*left = sum_l >> 14;
+	*right = sum_r >> 14;
+#endif
+}
+
+}  // namespace
+
 // Executed from sound stream thread
 unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
 {
@@ -30,12 +140,26 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, boo
 	// so we will just ignore new written data while interpolating.
 	// Without this cache, the compiler wouldn't be allowed to optimize the
 	// interpolation loop.
-	u32 indexR = m_indexR.load();
-	u32 indexW = m_indexW.load();
+	u32 indexR = m_indexR.load(std::memory_order_relaxed);
+	u32 indexW = m_indexW.load(std::memory_order_acquire);
+
+	// The FIFO is in use if samples were pushed within the latency window.
+	// Idle ones (no disc streaming, silent Wiimote speaker) are always empty,
+	// and so is one whose stream just stopped once it has been drained.
+	u32 pushes = m_pushes.load(std::memory_order_relaxed);
+	if (pushes != m_seen_pushes)
+	{
+		m_seen_pushes = pushes;
+		m_frames_since_push = 0;
+	}
+	const u32 latency_window = m_latency_target_ms.load(std::memory_order_relaxed) * m_mixer->m_sampleRate / 1000;
+	const bool in_use = m_frames_since_push < latency_window;
+	if (in_use)
+		m_frames_since_push += numSamples;
 
 	float numLeft = (float)(((indexW - indexR) & INDEX_MASK) / 2);
 	m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG-1)) / CONTROL_AVG;
-	float offset = (m_numLeftI - LOW_WATERMARK) * CONTROL_FACTOR;
+	float offset = (m_numLeftI - m_low_watermark.load(std::memory_order_relaxed)) * CONTROL_FACTOR;
 	if (offset > MAX_FREQ_SHIFT) offset = MAX_FREQ_SHIFT;
 	if (offset < -MAX_FREQ_SHIFT) offset = -MAX_FREQ_SHIFT;
 
@@ -55,7 +179,35 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, boo
 	s32 lvolume = m_LVolume.load();
 	s32 rvolume = m_RVolume.load();
 
-	// TODO: consider a higher-quality resampling algorithm.
+	if (SConfig::GetInstance().m_PolyphaseResampler)
+	{
+		const PolyphaseTable& table = GetPolyphaseTable();
+
+		// The window reaches POLYPHASE_TAPS / 2 frames ahead of indexR.
+		for (; currentSample < numSamples * 2 && ((indexW-indexR) & INDEX_MASK) > POLYPHASE_TAPS; currentSample += 2)
+		{
+			const short* window = &m_buffer[(indexR - (POLYPHASE_TAPS / 2 - 1) * 2) & INDEX_MASK];
+			const s16* taps = table.taps[m_frac >> (16 - POLYPHASE_PHASE_BITS)];
+
+			int sampleL, sampleR;
+			PolyphaseFilter(window, taps, &sampleL, &sampleR);
+
+			sampleL = (MathUtil::Clamp(sampleL, -32768, 32767) * lvolume) >> 8;
+			sampleL += samples[currentSample + 1];
+			samples[currentSample + 1] = MathUtil::Clamp(sampleL, -32767, 32767);
+
+			sampleR = (MathUtil::Clamp(sampleR, -32768, 32767) * rvolume) >> 8;
+			sampleR += samples[currentSample];
+			samples[currentSample] = MathUtil::Clamp(sampleR, -32767, 32767);
+
+			m_frac += ratio;
+			indexR += 2 * (u16)(m_frac >> 16);
+			m_frac &= 0xffff;
+		}
+	}
+
+	// Linear interpolation. With the polyphase resampler this only handles the
+	// last frames that are too close to indexW for the filter window.
 	for (; currentSample < numSamples * 2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample += 2)
 	{
 		u32 indexR2 = indexR + 2; //next sample
@@ -79,7 +231,10 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, boo
 		m_frac &= 0xffff;
 	}
 
-	// Padding
+	// Padding. Only count it as an underrun if the FIFO was in use.
+	if (in_use && currentSample < numSamples * 2)
+		m_underruns.fetch_add((numSamples * 2 - currentSample) / 2, std::memory_order_relaxed);
+
 	short s[2];
 	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
 	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
@@ -95,7 +250,7 @@ unsigned int CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, boo
 	}
 
 	// Flush cached variable
-	m_indexR.store(indexR);
+	m_indexR.store(indexR, std::memory_order_release);
 
 	return numSamples;
 }
@@ -124,12 +279,17 @@ void CMixer::MixerFifo::PushSamples(const short *samples, unsigned int num_sampl
 	// Cache access in non-volatile variable
 	// indexR isn't allowed to cache in the audio throttling loop as it
 	// needs to get updates to not deadlock.
-	u32 indexW = m_indexW.load();
+	u32 indexW = m_indexW.load(std::memory_order_relaxed);
+	m_pushes.fetch_add(1, std::memory_order_relaxed);
 
 	// Check if we have enough free space
 	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - m_indexR.load()) & INDEX_MASK) >= MAX_SAMPLES * 2)
+	// The polyphase filter also reads a few frames behind indexR, keep those.
+	if (num_samples * 2 + ((indexW - m_indexR.load(std::memory_order_acquire)) & INDEX_MASK) >= MAX_SAMPLES * 2 - POLYPHASE_TAPS)
+	{
+		m_overruns.fetch_add(num_samples, std::memory_order_relaxed);
 		return;
+	}
 
 	// AyuanX: Actual re-sampling work has been moved to sound thread
 	// to alleviate the workload on main thread
@@ -144,8 +304,9 @@ void CMixer::MixerFifo::PushSamples(const short *samples, unsigned int num_sampl
 	{
 		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
 	}
+	memcpy(&m_buffer[MAX_SAMPLES * 2], &m_buffer[0], POLYPHASE_TAPS * 2 * sizeof(short));
 
-	m_indexW.fetch_add(num_samples * 2);
+	m_indexW.store(indexW + num_samples * 2, std::memory_order_release);
 }
 
 void CMixer::PushSamples(const short *samples, unsigned int num_samples)
@@ -258,9 +419,41 @@ void CMixer::StopLogDSPAudio()
 	}
 }
 
+void CMixer::SetLatencyTarget(unsigned int ms)
+{
+	m_dma_mixer.SetLatencyTarget(ms);
+	m_streaming_mixer.SetLatencyTarget(ms);
+	m_wiimote_speaker_mixer.SetLatencyTarget(ms);
+}
+
+u64 CMixer::GetUnderrunCount() const
+{
+	return m_dma_mixer.GetUnderrunCount() + m_streaming_mixer.GetUnderrunCount() +
+	       m_wiimote_speaker_mixer.GetUnderrunCount();
+}
+
+u64 CMixer::GetOverrunCount() const
+{
+	return m_dma_mixer.GetOverrunCount() + m_streaming_mixer.GetOverrunCount() +
+	       m_wiimote_speaker_mixer.GetOverrunCount();
+}
+
 void CMixer::MixerFifo::SetInputSampleRate(unsigned int rate)
 {
 	m_input_sample_rate = rate;
+	UpdateWatermark();
+}
+
+void CMixer::MixerFifo::SetLatencyTarget(unsigned int ms)
+{
+	m_latency_target_ms.store(ms, std::memory_order_relaxed);
+	UpdateWatermark();
+}
+
+void CMixer::MixerFifo::UpdateWatermark()
+{
+	u32 frames = m_input_sample_rate * m_latency_target_ms.load(std::memory_order_relaxed) / 1000;
+	m_low_watermark.store(std::min<u32>(frames, MAX_WATERMARK), std::memory_order_relaxed);
 }
 
 void CMixer::MixerFifo::SetVolume(unsigned int lvolume, unsigned int rvolume)
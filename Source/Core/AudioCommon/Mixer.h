@@ -14,11 +14,17 @@
 #define MAX_SAMPLES     (1024 * 2) // 64ms
 #define INDEX_MASK      (MAX_SAMPLES * 2 - 1)
 
-#define LOW_WATERMARK   1280 // 40 ms
+#define DEFAULT_LATENCY_TARGET 40 // ms of buffered input the rate control aims for
+#define MAX_WATERMARK   1280 // frames, leaves room for bursts from the emulation thread
 #define MAX_FREQ_SHIFT  200  // per 32000 Hz
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
 
+// Windowed-sinc polyphase resampler. Taps are Q14 fixed point.
+#define POLYPHASE_TAPS        16
+#define POLYPHASE_PHASE_BITS  8
+#define POLYPHASE_PHASES      (1 << POLYPHASE_PHASE_BITS)
+
 class CMixer {
 
 public:
@@ -36,7 +42,8 @@ public:
 
 	virtual ~CMixer() {}
 
-	// Called from audio threads
+	// Called from audio threads. Never blocks: whatever is missing from the
+	// FIFOs is padded and counted as an underrun.
 	virtual unsigned int Mix(short* samples, unsigned int numSamples, bool consider_framelimit = true);
 
 	// Called from main thread
@@ -50,6 +57,12 @@ public:
 	void SetStreamingVolume(unsigned int lvolume, unsigned int rvolume);
 	void SetWiimoteSpeakerVolume(unsigned int lvolume, unsigned int rvolume);
 
+	// How much audio, in milliseconds, each FIFO tries to keep buffered.
+	void SetLatencyTarget(unsigned int ms);
+	// Frames padded with the last sample / dropped because a FIFO was full.
+	u64 GetUnderrunCount() const;
+	u64 GetOverrunCount() const;
+
 	void StartLogDTKAudio(const std::string& filename);
 	void StopLogDTKAudio();
 
@@ -60,6 +73,12 @@ public:
 	void UpdateSpeed(float val) { m_speed.store(val); }
 
 protected:
+	// Single producer, single consumer ring of big-endian stereo frames. The
+	// emulation thread is the only writer of m_indexW and the audio thread
+	// the only writer of m_indexR; each side publishes its index with a
+	// release store after touching the buffer and reads the other one with
+	// an acquire load. Neither side ever waits: a full ring drops the pushed
+	// samples and an empty one pads the output, and both are counted.
 	class MixerFifo {
 	public:
 		MixerFifo(CMixer *mixer, unsigned sample_rate)
@@ -71,17 +90,32 @@ protected:
 			, m_RVolume(256)
 			, m_numLeftI(0.0f)
 			, m_frac(0)
+			, m_latency_target_ms(DEFAULT_LATENCY_TARGET)
+			, m_low_watermark(0)
+			, m_underruns(0)
+			, m_overruns(0)
+			, m_pushes(0)
+			, m_seen_pushes(0)
+			, m_frames_since_push(UINT32_MAX)
 		{
 			memset(m_buffer, 0, sizeof(m_buffer));
+			UpdateWatermark();
 		}
 		void PushSamples(const short* samples, unsigned int num_samples);
 		unsigned int Mix(short* samples, unsigned int numSamples, bool consider_framelimit = true);
 		void SetInputSampleRate(unsigned int rate);
 		void SetVolume(unsigned int lvolume, unsigned int rvolume);
+		void SetLatencyTarget(unsigned int ms);
+		u64 GetUnderrunCount() const { return m_underruns.load(std::memory_order_relaxed); }
+		u64 GetOverrunCount() const { return m_overruns.load(std::memory_order_relaxed); }
 	private:
+		void UpdateWatermark();
+
 		CMixer *m_mixer;
 		unsigned m_input_sample_rate;
-		short m_buffer[MAX_SAMPLES * 2];
+		// The first POLYPHASE_TAPS * 2 samples are mirrored past the end so
+		// that the polyphase filter can always read its window contiguously.
+		short m_buffer[MAX_SAMPLES * 2 + POLYPHASE_TAPS * 2];
 		std::atomic<u32> m_indexW;
 		std::atomic<u32> m_indexR;
 		// Volume ranges from 0-256
@@ -89,6 +123,16 @@ protected:
 		std::atomic<s32> m_RVolume;
 		float m_numLeftI;
 		u32 m_frac;
+		std::atomic<u32> m_latency_target_ms;
+		// Fill level, in frames, that the rate control steers towards.
+		std::atomic<u32> m_low_watermark;
+		std::atomic<u64> m_underruns;
+		std::atomic<u64> m_overruns;
+		// Number of PushSamples calls, and the output frames mixed since Mix
+		// last saw it change, counted until they pass the latency window.
+		std::atomic<u32> m_pushes;
+		u32 m_seen_pushes;
+		u32 m_frames_since_push;
 	};
 	MixerFifo m_dma_mixer;
 	MixerFifo m_streaming_mixer;
@@ -3,11 +3,17 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
 #include "Common/CommonFuncs.h"
-#include "Common/CPUDetect.h"
 #include "Common/Hash.h"
 #include "Common/Intrinsics.h"
 
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <emmintrin.h>
+#elif defined(_M_ARM_64)
+#include <arm_neon.h>
+#endif
+
 static u64 (*ptrHashFunction)(const u8 *src, u32 len, u32 samples) = &GetMurmurHash3;
 
 // uint32_t
@@ -575,31 +581,202 @@ u64 GetHashHiresTexture(const u8 *src, u32 len, u32 samples)
 }
 #endif
 
-u64 GetHash64(const u8 *src, u32 len, u32 samples)
+// Modelled on XXH3: eight 64-bit accumulators each take one word of every
+// 64-byte stripe, mixed with a key that slides along with the position of the
+// stripe in its 1KB block, and are scrambled after every block. The lanes are
+// independent of each other, so SSE2 and NEON update two at a time. Other
+// hosts compute the same hash one lane at a time.
+static const u32 STRIPE_SIZE = 64;
+static const u32 STRIPES_PER_BLOCK = 16;
+static const u64 STRIPE_PRIME32 = 0x9E3779B1;
+static const u64 STRIPE_PRIME64 = 0x9E3779B185EBCA87;
+
+alignas(16) static const u64 s_stripe_keys[STRIPES_PER_BLOCK + 8] = {
+	0x99a4143d34585f45, 0xfc18d87fcc9ca7a3, 0x7220ff9660d13a72, 0x64ffc8847b7f23c0,
+	0x9e03b1a53ea6991e, 0x6a5c68246b38f20a, 0x0692240cde3fb540, 0xf49046fa81c712b0,
+	0x85401655ca9bd34b, 0x5647de666629f008, 0x86fa0e1d3407e694, 0x7ce6d53b1f66d366,
+	0x69ec4827738e2504, 0xf104eb6ca4d998a9, 0x19bfb4db3330eb58, 0xbf3581dfd63ca1b0,
+	0xc73eab9b9800b297, 0xbb8b089c39920c0d, 0x00a5fcfd19db4258, 0xacd97e3b799b28ec,
+	0x33aaea56ef3c9067, 0x6d65874ee5f59830, 0xbb1cda69b999dab2, 0x1ffb1d8bdc14d90e,
+};
+alignas(16) static const u64 s_scramble_keys[8] = {
+	0x508efc8784ead07d, 0xca838b3d9e091650, 0x2ad84895701635df, 0xa3510033031b0eed,
+	0x17d423eaefae4f37, 0x7342025217e23b56, 0x24c788ceaf79c499, 0xa9ebf13d3bcf66fe,
+};
+static const u64 s_merge_keys[8] = {
+	0x9e02bf13858d9da8, 0x72da6838d2d1569f, 0x9b4d257b39e5e377, 0xada409f069b53c23,
+	0x7c82c0e04481f215, 0xf0c96c83c783ea8b, 0x96bb30cf2c462516, 0x837e22a75ecea642,
+};
+
+static inline u64 StripeAvalanche(u64 h)
 {
-	return ptrHashFunction(src, len, samples);
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccd;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53;
+	h ^= h >> 33;
+	return h;
 }
 
-// sets the hash function used for the texture cache
-void SetHash64Function()
+static inline void AccumulateStripeGeneric(u64* acc, const u8* stripe, const u64* keys)
 {
-#if _M_SSE >= 0x402
-	if (cpu_info.bSSE4_2) // sse crc32 version
+	for (int i = 0; i < 8; i++)
 	{
-		ptrHashFunction = &GetCRC32;
+		u64 data, swapped;
+		std::memcpy(&data, stripe + i * 8, sizeof(u64));
+		std::memcpy(&swapped, stripe + (i ^ 1) * 8, sizeof(u64));
+		const u64 k = data ^ keys[i];
+		acc[i] += (k & 0xFFFFFFFF) * (k >> 32) + swapped;
 	}
-	else
+}
+
+// Accumulates num_stripes stripes which are step stripes apart.
+static void AccumulateStripes(u64* acc, const u8* src, u32 num_stripes, u32 step)
+{
+	const size_t stride = (size_t)step * STRIPE_SIZE;
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	__m128i a[4];
+	for (int j = 0; j < 4; j++)
+		a[j] = _mm_load_si128((const __m128i*)acc + j);
+	const __m128i prime = _mm_set1_epi32((u32)STRIPE_PRIME32);
+
+	for (u32 n = 0; n < num_stripes; n++, src += stride)
+	{
+		const u64* keys = s_stripe_keys + n % STRIPES_PER_BLOCK;
+		for (int j = 0; j < 4; j++)
+		{
+			const __m128i data = _mm_loadu_si128((const __m128i*)src + j);
+			const __m128i k = _mm_xor_si128(data, _mm_loadu_si128((const __m128i*)(keys + j * 2)));
+			const __m128i product = _mm_mul_epu32(k, _mm_srli_epi64(k, 32));
+			const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			a[j] = _mm_add_epi64(a[j], _mm_add_epi64(product, swapped));
+		}
+
+		if (n % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				__m128i x = _mm_xor_si128(a[j], _mm_srli_epi64(a[j], 47));
+				x = _mm_xor_si128(x, _mm_load_si128((const __m128i*)s_scramble_keys + j));
+				const __m128i lo = _mm_mul_epu32(x, prime);
+				const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+				a[j] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+			}
+		}
+	}
+
+	for (int j = 0; j < 4; j++)
+		_mm_store_si128((__m128i*)acc + j, a[j]);
 #elif defined(_M_ARM_64)
-	if (cpu_info.bCRC32)
+	uint64x2_t a[4];
+	for (int j = 0; j < 4; j++)
+		a[j] = vld1q_u64(acc + j * 2);
+	const uint32x2_t prime = vdup_n_u32((u32)STRIPE_PRIME32);
+
+	for (u32 n = 0; n < num_stripes; n++, src += stride)
 	{
-		ptrHashFunction = &GetCRC32;
+		const u64* keys = s_stripe_keys + n % STRIPES_PER_BLOCK;
+		for (int j = 0; j < 4; j++)
+		{
+			const uint64x2_t data = vreinterpretq_u64_u8(vld1q_u8(src + j * 16));
+			const uint64x2_t k = veorq_u64(data, vld1q_u64(keys + j * 2));
+			const uint64x2_t product = vmull_u32(vmovn_u64(k), vshrn_n_u64(k, 32));
+			const uint64x2_t swapped = vextq_u64(data, data, 1);
+			a[j] = vaddq_u64(a[j], vaddq_u64(product, swapped));
+		}
+
+		if (n % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				uint64x2_t x = veorq_u64(a[j], vshrq_n_u64(a[j], 47));
+				x = veorq_u64(x, vld1q_u64(s_scramble_keys + j * 2));
+				const uint64x2_t lo = vmull_u32(vmovn_u64(x), prime);
+				const uint64x2_t hi = vmull_u32(vshrn_n_u64(x, 32), prime);
+				a[j] = vaddq_u64(lo, vshlq_n_u64(hi, 32));
+			}
+		}
 	}
-	else
-#endif
+
+	for (int j = 0; j < 4; j++)
+		vst1q_u64(acc + j * 2, a[j]);
+#else
+	for (u32 n = 0; n < num_stripes; n++, src += stride)
 	{
-		ptrHashFunction = &GetMurmurHash3;
+		AccumulateStripeGeneric(acc, src, s_stripe_keys + n % STRIPES_PER_BLOCK);
+
+		if (n % STRIPES_PER_BLOCK == STRIPES_PER_BLOCK - 1)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				acc[i] ^= acc[i] >> 47;
+				acc[i] ^= s_scramble_keys[i];
+				acc[i] *= STRIPE_PRIME32;
+			}
+		}
 	}
+#endif
 }
 
+u64 GetStripeHash(const u8 *src, u32 len, u32 samples)
+{
+	u64 h = len * STRIPE_PRIME64;
+
+	if (len < STRIPE_SIZE)
+	{
+		u32 i = 0;
+		for (; i + 8 <= len; i += 8)
+		{
+			u64 data;
+			std::memcpy(&data, src + i, sizeof(u64));
+			h ^= StripeAvalanche(data ^ s_stripe_keys[i / 8]);
+			h = _rotl64(h, 27) * STRIPE_PRIME64;
+		}
+		if (i < len)
+		{
+			u64 data = 0;
+			std::memcpy(&data, src + i, len - i);
+			h ^= StripeAvalanche(data ^ s_stripe_keys[8]);
+			h = _rotl64(h, 27) * STRIPE_PRIME64;
+		}
+		return StripeAvalanche(h);
+	}
+
+	alignas(16) u64 acc[8] = {
+		STRIPE_PRIME32, STRIPE_PRIME64, s_merge_keys[0], s_merge_keys[1],
+		s_merge_keys[2], s_merge_keys[3], STRIPE_PRIME64, STRIPE_PRIME32,
+	};
+
+	// The last stripe, which may be partial, is handled separately.
+	u32 num_stripes = (len - 1) / STRIPE_SIZE;
+	u32 step = 1;
+	if (samples != 0)
+	{
+		// Each stripe covers eight of the 64-bit samples.
+		step = std::max(num_stripes * 8 / samples, 1u);
+		num_stripes = (num_stripes + step - 1) / step;
+	}
+	AccumulateStripes(acc, src, num_stripes, step);
+	AccumulateStripeGeneric(acc, src + len - STRIPE_SIZE, s_stripe_keys + STRIPES_PER_BLOCK);
+
+	for (int i = 0; i < 8; i++)
+	{
+		h ^= StripeAvalanche(acc[i] ^ s_merge_keys[i]);
+		h = _rotl64(h, 27) * STRIPE_PRIME64;
+	}
+	return StripeAvalanche(h);
+}
 
+u64 GetHash64(const u8 *src, u32 len, u32 samples)
+{
+	return ptrHashFunction(src, len, samples);
+}
 
+// sets the hash function used for the texture cache
+void SetHash64Function()
+{
+	// Unlike CRC32 and MurmurHash3, which this used to pick between, the
+	// stripe hash only needs SSE2 or NEON to be fast and gives the same
+	// results on every host.
+	ptrHashFunction = &GetStripeHash;
+}
@@ -14,5 +14,6 @@ u32 HashEctor(const u8* ptr, int length);            // JUNK. DO NOT USE FOR NEW
 u64 GetCRC32(const u8 *src, u32 len, u32 samples);   // SSE4.2 version of CRC32
 u64 GetHashHiresTexture(const u8 *src, u32 len, u32 samples = 0);
 u64 GetMurmurHash3(const u8 *src, u32 len, u32 samples);
+u64 GetStripeHash(const u8 *src, u32 len, u32 samples);  // SIMD, fastest
 u64 GetHash64(const u8 *src, u32 len, u32 samples);
 void SetHash64Function();
@@ -28,4 +28,13 @@
 # endif
 #endif
 
+// Lets a function use an instruction set the rest of the file is not built
+// for. Callers have to check cpu_info first. MSVC allows any intrinsic in any
+// function, and needs nothing.
+#if defined(_MSC_VER) || defined(__INTEL_COMPILER)
+#  define FUNCTION_TARGET_AVX2
+#else
+#  define FUNCTION_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
 #endif // _M_X86
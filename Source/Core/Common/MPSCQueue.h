@@ -0,0 +1,162 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a lockless thread-safe,
+// multiple writer, single reader queue
+//
+// Nodes come from a fixed pool through a lock-free free list, and are returned to it by the reader
+// as elements are popped, so the queue never allocates after construction. It holds at most
+// PoolSize - 1 elements, one node always being the stub the reader consumes after. When the pool
+// is exhausted, TryPush fails and Push waits for the reader to pop an element; otherwise both are
+// wait-free.
+//
+// Like all queues of this kind, a writer that is preempted in the middle of Push can hide the
+// elements pushed after it from the reader until it resumes. The elements are not lost; they
+// simply show up on a later Pop.
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+template <typename T, size_t PoolSize = 256>
+class MPSCQueue
+{
+public:
+	MPSCQueue()
+	{
+		static_assert(PoolSize > 1 && PoolSize < INVALID_INDEX, "bad MPSCQueue pool size");
+
+		for (u32 i = 0; i < PoolSize; ++i)
+		{
+			m_pool[i].index = i;
+			m_pool[i].free_next.store(i + 1 < PoolSize ? i + 1 : INVALID_INDEX, std::memory_order_relaxed);
+		}
+		m_free_head.store(0, std::memory_order_relaxed);
+
+		Node* stub = AllocateNode();
+		stub->next.store(nullptr, std::memory_order_relaxed);
+		m_head.store(stub, std::memory_order_relaxed);
+		m_tail = stub;
+	}
+
+	MPSCQueue(const MPSCQueue&) = delete;
+	MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+	// can be called from any number of threads; returns false if the queue is full
+	template <typename Arg>
+	bool TryPush(Arg&& t)
+	{
+		Node* node = AllocateNode();
+		if (!node)
+			return false;
+		Append(node, std::forward<Arg>(t));
+		return true;
+	}
+
+	// can be called from any number of threads, but not the reader's: if the queue is full, this
+	// waits until the reader has popped an element
+	template <typename Arg>
+	void Push(Arg&& t)
+	{
+		Node* node;
+		while (!(node = AllocateNode()))
+			std::this_thread::yield();
+		Append(node, std::forward<Arg>(t));
+	}
+
+	// reader thread only
+	bool Empty() const
+	{
+		return !m_tail->next.load(std::memory_order_acquire);
+	}
+
+	// reader thread only
+	bool Pop(T& t)
+	{
+		Node* tail = m_tail;
+		Node* next = tail->next.load(std::memory_order_acquire);
+		if (!next)
+			return false;
+
+		// next becomes the new stub, and the old stub goes back to the pool
+		t = std::move(next->value);
+		m_tail = next;
+		FreeNode(tail);
+		return true;
+	}
+
+private:
+	enum : u32
+	{
+		INVALID_INDEX = 0xFFFFFFFF
+	};
+
+	struct Node
+	{
+		T value;
+		std::atomic<Node*> next{nullptr};
+		// free list link, stored as a pool index
+		std::atomic<u32> free_next{INVALID_INDEX};
+		// position in m_pool
+		u32 index = INVALID_INDEX;
+	};
+
+	template <typename Arg>
+	void Append(Node* node, Arg&& t)
+	{
+		node->value = std::forward<Arg>(t);
+		node->next.store(nullptr, std::memory_order_relaxed);
+		Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	// The free list head packs a pool index with a counter that is bumped on every pop, so a
+	// writer that stalls between reading the head and swapping it can't be fooled by the same
+	// node being popped and pushed back in the meantime (the ABA problem).
+	static u32 HeadIndex(u64 head) { return (u32)head; }
+	static u64 MakeHead(u32 index, u64 old_head) { return ((old_head >> 32) + 1) << 32 | index; }
+
+	Node* AllocateNode()
+	{
+		u64 head = m_free_head.load(std::memory_order_acquire);
+		while (HeadIndex(head) != INVALID_INDEX)
+		{
+			Node* node = &m_pool[HeadIndex(head)];
+			u32 next = node->free_next.load(std::memory_order_relaxed);
+			if (m_free_head.compare_exchange_weak(head, MakeHead(next, head),
+			                                      std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return node;
+			}
+		}
+		return nullptr;
+	}
+
+	void FreeNode(Node* node)
+	{
+		u64 head = m_free_head.load(std::memory_order_relaxed);
+		do
+		{
+			node->free_next.store(HeadIndex(head), std::memory_order_relaxed);
+		} while (!m_free_head.compare_exchange_weak(head, MakeHead(node->index, head),
+		                                            std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	std::array<Node, PoolSize> m_pool;
+	std::atomic<u64> m_free_head;
+	// writers append at m_head, the reader consumes after m_tail
+	std::atomic<Node*> m_head;
+	Node* m_tail;
+};
+
+}
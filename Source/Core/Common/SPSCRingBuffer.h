@@ -0,0 +1,147 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a lockless ring buffer of bytes,
+// single writer, single reader
+//
+// The writer reserves contiguous space, fills it and commits it. The reader looks at the
+// committed bytes and releases them when it's done with them, which is when the writer may
+// reuse the space. Positions count every byte ever written, so they never wrap, and a full
+// buffer can't be mistaken for an empty one.
+//
+// A reservation never wraps around the end of the buffer. If it doesn't fit in front of the
+// end, the rest of the buffer is filled with the padding byte and skipped. A reader walking
+// the committed bytes has to be able to tell the padding apart from data; a reader that only
+// releases up to positions it got from the writer never sees it. If the reader has already
+// caught up, the writer moves both positions to the start of the buffer instead, so that the
+// reservation can use all of it without overwriting padding the reader hasn't seen yet.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+class SPSCRingBuffer
+{
+public:
+	// size has to be a power of two
+	SPSCRingBuffer(size_t size, u8 padding)
+		: m_buffer(size), m_mask(size - 1), m_padding(padding)
+	{
+	}
+
+	SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+	SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+	size_t Size() const { return m_buffer.size(); }
+
+	// writer thread only
+	// Returns size contiguous bytes, or nullptr until the reader has released enough.
+	u8* Reserve(size_t size)
+	{
+		if (size > m_buffer.size())
+			return nullptr;
+
+		u64 write = m_write.load(std::memory_order_relaxed);
+		const size_t offset = (size_t)(write & m_mask);
+		u64 start = write;
+		if (offset + size > m_buffer.size())
+			start += m_buffer.size() - offset;
+
+		u64 read = m_read.load(std::memory_order_acquire);
+		// The reader can't move while it has caught up, so it's safe to move it along with the
+		// write position. The reservation may then overlap where the padding would have been.
+		if (start != write && read == write &&
+		    m_read.compare_exchange_strong(read, start, std::memory_order_acq_rel))
+		{
+			m_write.store(start, std::memory_order_release);
+			write = read = start;
+		}
+
+		if (start + size - read > m_buffer.size())
+			return nullptr;
+
+		if (start != write)
+			memset(&m_buffer[offset], m_padding, (size_t)(start - write));
+		m_reserved = start;
+		return &m_buffer[(size_t)(start & m_mask)];
+	}
+
+	// writer thread only
+	// Hands the first size bytes of the last reservation to the reader.
+	void Commit(size_t size)
+	{
+		m_write.store(m_reserved + size, std::memory_order_release);
+	}
+
+	// writer thread only
+	// The position after the last committed byte.
+	u64 GetWritePosition() const
+	{
+		return m_write.load(std::memory_order_relaxed);
+	}
+
+	// reader thread only
+	// The committed bytes which haven't been released, up to the end of the buffer.
+	size_t Peek(const u8** data) const
+	{
+		// Load the write position first. The writer moves the read position before the write
+		// position when it skips the end of an empty buffer, so read can only be ahead then.
+		const u64 write = m_write.load(std::memory_order_acquire);
+		const u64 read = m_read.load(std::memory_order_acquire);
+		if (read >= write)
+			return 0;
+		const size_t offset = (size_t)(read & m_mask);
+		*data = &m_buffer[offset];
+		return (size_t)std::min<u64>(write - read, m_buffer.size() - offset);
+	}
+
+	// reader thread only
+	void Release(size_t size)
+	{
+		m_read.store(m_read.load(std::memory_order_relaxed) + size, std::memory_order_release);
+	}
+
+	// reader thread only
+	// Releases everything before a position from GetWritePosition(). Positions the writer has
+	// skipped past since are ignored.
+	void ReleaseTo(u64 position)
+	{
+		if (position > m_read.load(std::memory_order_relaxed))
+			m_read.store(position, std::memory_order_release);
+	}
+
+	// Only meaningful when the other thread is idle.
+	bool Empty() const
+	{
+		return m_read.load(std::memory_order_acquire) == m_write.load(std::memory_order_acquire);
+	}
+
+	// Neither thread may use the buffer meanwhile.
+	void Clear()
+	{
+		m_read.store(0, std::memory_order_relaxed);
+		m_write.store(0, std::memory_order_relaxed);
+	}
+
+private:
+	std::vector<u8> m_buffer;
+	const size_t m_mask;
+	const u8 m_padding;
+
+	std::atomic<u64> m_write{0};
+	std::atomic<u64> m_read{0};
+	// writer only
+	u64 m_reserved = 0;
+};
+
+}
@@ -42,13 +42,21 @@ static inline void __cpuid(int info[4], int function_id)
 }
 
 #define _XCR_XFEATURE_ENABLED_MASK 0
-static u64 _xgetbv(u32 index)
+// Current GCC declares _xgetbv in xsaveintrin.h, so the fallback needs a name of its own.
+static u64 XGetBV(u32 index)
 {
 	u32 eax, edx;
 	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
 	return ((u64)edx << 32) | eax;
 }
 
+#else
+
+static u64 XGetBV(u32 index)
+{
+	return _xgetbv(index);
+}
+
 #endif // ifndef _WIN32
 
 CPUInfo cpu_info;
@@ -134,7 +142,7 @@ void CPUInfo::Detect()
 		//  - XGETBV result has the XCR bit set.
 		if (((cpu_id[2] >> 28) & 1) && ((cpu_id[2] >> 27) & 1))
 		{
-			if ((_xgetbv(_XCR_XFEATURE_ENABLED_MASK) & 0x6) == 0x6)
+			if ((XGetBV(_XCR_XFEATURE_ENABLED_MASK) & 0x6) == 0x6)
 			{
 				bAVX = true;
 				if ((cpu_id[2] >> 12) & 1)
@@ -26,7 +26,7 @@ SConfig* SConfig::m_Instance;
 
 SConfig::SConfig()
 : bEnableDebugging(false), bAutomaticStart(false), bBootToPause(false),
-  bJITNoBlockCache(false), bJITNoBlockLinking(false),
+  bJITNoBlockCache(false), bJITNoBlockLinking(false), bJITWarmStart(false), bJITTiered(false),
   bJITOff(false),
   bJITLoadStoreOff(false), bJITLoadStorelXzOff(false),
   bJITLoadStorelwzOff(false), bJITLoadStorelbzxOff(false),
@@ -36,15 +36,15 @@ SConfig::SConfig()
   bJITBranchOff(false),
   bJITILTimeProfiling(false), bJITILOutputIR(false),
   bFPRF(false), bAccurateNaNs(false),
-  bCPUThread(true), bDSPThread(false), bDSPHLE(true),
+  bCPUThread(true), bDSPThread(false), bDSPHLE(true), bDSPHLEWorkerThread(false),
   bSkipIdle(true), bSyncGPUOnSkipIdleHack(true), bNTSC(false), bForceNTSCJ(false),
   bHLE_BS2(true), bEnableCheats(false),
   bEnableMemcardSdWriting(true),
   bDPL2Decoder(false), iLatency(14),
   bRunCompareServer(false), bRunCompareClient(false),
-  bMMU(false), bDCBZOFF(false),
+  bMMU(false), iSoftTLBSize(4096), bDCBZOFF(false),
   iBBDumpPort(0),
-  bFastDiscSpeed(false), bSyncGPU(false),
+  bFastDiscSpeed(false), bSyncGPU(false), bFifoPreprocessThread(false),
   SelectedLanguage(0), bOverrideGCLanguage(false), bWii(false),
   bConfirmStop(false), bHideCursor(false),
   bAutoHideCursor(false), bUsePanicHandlers(true), bOnScreenDisplayMessages(true),
@@ -225,12 +225,14 @@ void SConfig::SaveCoreSettings(IniFile& ini)
 	core->Set("Fastmem", bFastmem);
 	core->Set("CPUThread", bCPUThread);
 	core->Set("DSPHLE", bDSPHLE);
+	core->Set("DSPHLEWorkerThread", bDSPHLEWorkerThread);
 	core->Set("SkipIdle", bSkipIdle);
 	core->Set("SyncOnSkipIdle", bSyncGPUOnSkipIdleHack);
 	core->Set("SyncGPU", bSyncGPU);
 	core->Set("SyncGpuMaxDistance", iSyncGpuMaxDistance);
 	core->Set("SyncGpuMinDistance", iSyncGpuMinDistance);
 	core->Set("SyncGpuOverclock", fSyncGpuOverclock);
+	core->Set("FifoPreprocessThread", bFifoPreprocessThread);
 	core->Set("DefaultISO", m_strDefaultISO);
 	core->Set("DVDRoot", m_strDVDRoot);
 	core->Set("Apploader", m_strApploader);
@@ -288,6 +290,9 @@ void SConfig::SaveDSPSettings(IniFile& ini)
 	dsp->Set("DumpUCode", m_DumpUCode);
 	dsp->Set("Backend", sBackend);
 	dsp->Set("Volume", m_Volume);
+	dsp->Set("PolyphaseResampler", m_PolyphaseResampler);
+	dsp->Set("MixerLatency", m_MixerLatency);
+	dsp->Set("CapturePath", m_CapturePath);
 	dsp->Set("CaptureLog", m_DSPCaptureLog);
 }
 
@@ -479,6 +484,7 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 #endif
 	core->Get("Fastmem",           &bFastmem,      true);
 	core->Get("DSPHLE",            &bDSPHLE,       true);
+	core->Get("DSPHLEWorkerThread", &bDSPHLEWorkerThread, false);
 	core->Get("CPUThread",         &bCPUThread,    true);
 	core->Get("SkipIdle",          &bSkipIdle,     true);
 	core->Get("SyncOnSkipIdle",    &bSyncGPUOnSkipIdleHack, true);
@@ -511,11 +517,13 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("RunCompareServer",          &bRunCompareServer, false);
 	core->Get("RunCompareClient",          &bRunCompareClient, false);
 	core->Get("MMU",                       &bMMU,              false);
+	core->Get("SoftTLBSize",               &iSoftTLBSize,      4096);
 	core->Get("BBDumpPort",                &iBBDumpPort,       -1);
 	core->Get("SyncGPU",                   &bSyncGPU,          false);
 	core->Get("SyncGpuMaxDistance",        &iSyncGpuMaxDistance,  200000);
 	core->Get("SyncGpuMinDistance",        &iSyncGpuMinDistance, -200000);
 	core->Get("SyncGpuOverclock",          &fSyncGpuOverclock, 1.0);
+	core->Get("FifoPreprocessThread",      &bFifoPreprocessThread, false);
 	core->Get("FastDiscSpeed",             &bFastDiscSpeed,    false);
 	core->Get("DCBZ",                      &bDCBZOFF,          false);
 	core->Get("FrameLimit",                &m_Framelimit,                                  1); // auto frame limit by default
@@ -527,6 +535,8 @@ void SConfig::LoadCoreSettings(IniFile& ini)
 	core->Get("GameCubeAdapter",           &m_GameCubeAdapter,                             false);
 	core->Get("AdapterRumble",             &m_AdapterRumble,                               true);
 	core->Get("PerfMapDir",                &m_perfDir, "");
+	core->Get("JITWarmStart",              &bJITWarmStart,     false);
+	core->Get("JITTiered",                 &bJITTiered,        false);
 }
 
 void SConfig::LoadMovieSettings(IniFile& ini)
@@ -559,6 +569,9 @@ void SConfig::LoadDSPSettings(IniFile& ini)
 	dsp->Get("Backend", &sBackend, BACKEND_NULLSOUND);
 #endif
 	dsp->Get("Volume", &m_Volume, 100);
+	dsp->Get("PolyphaseResampler", &m_PolyphaseResampler, false);
+	dsp->Get("MixerLatency", &m_MixerLatency, 40);
+	dsp->Get("CapturePath", &m_CapturePath, "");
 	dsp->Get("CaptureLog", &m_DSPCaptureLog, false);
 
 	m_IsMuted = false;
@@ -597,13 +610,16 @@ void SConfig::LoadDefaults()
 	bSyncGPUOnSkipIdleHack = true;
 	bRunCompareServer = false;
 	bDSPHLE = true;
+	bDSPHLEWorkerThread = false;
 	bFastmem = true;
 	bFPRF = false;
 	bAccurateNaNs = false;
 	bMMU = false;
+	iSoftTLBSize = 4096;
 	bDCBZOFF = false;
 	iBBDumpPort = -1;
 	bSyncGPU = false;
+	bFifoPreprocessThread = false;
 	bFastDiscSpeed = false;
 	bEnableMemcardSdWriting = true;
 	SelectedLanguage = 0;
@@ -22,6 +22,7 @@
 #define BACKEND_PULSEAUDIO  "Pulse"
 #define BACKEND_XAUDIO2     "XAudio2"
 #define BACKEND_OPENSLES    "OpenSLES"
+#define BACKEND_CAPTURE     "Capture"
 
 enum GPUDeterminismMode
 {
@@ -62,6 +63,8 @@ struct SConfig : NonCopyable
 
 	// JIT (shared between JIT and JITIL)
 	bool bJITNoBlockCache, bJITNoBlockLinking;
+	bool bJITWarmStart;
+	bool bJITTiered;
 	bool bJITOff;
 	bool bJITLoadStoreOff, bJITLoadStorelXzOff, bJITLoadStorelwzOff, bJITLoadStorelbzxOff;
 	bool bJITLoadStoreFloatingOff;
@@ -81,6 +84,8 @@ struct SConfig : NonCopyable
 	bool bCPUThread;
 	bool bDSPThread;
 	bool bDSPHLE;
+	// Run AX HLE command lists on a worker thread (not used for movies/netplay).
+	bool bDSPHLEWorkerThread;
 	bool bSkipIdle;
 	bool bSyncGPUOnSkipIdleHack;
 	bool bNTSC;
@@ -96,6 +101,8 @@ struct SConfig : NonCopyable
 	bool bRunCompareClient;
 
 	bool bMMU;
+	// Entries in the JIT's host-side software TLB; 0 disables it.
+	int iSoftTLBSize;
 	bool bDCBZOFF;
 	int iBBDumpPort;
 	bool bFastDiscSpeed;
@@ -104,6 +111,9 @@ struct SConfig : NonCopyable
 	int iSyncGpuMaxDistance;
 	int iSyncGpuMinDistance;
 	float fSyncGpuOverclock;
+	// Decode the FIFO and run the vertex loaders on a thread of their own in
+	// dual core mode (not used with deterministic GPU threading).
+	bool bFifoPreprocessThread;
 
 	int SelectedLanguage;
 	bool bOverrideGCLanguage;
@@ -258,7 +268,13 @@ struct SConfig : NonCopyable
 	bool m_IsMuted;
 	bool m_DumpUCode;
 	int m_Volume;
+	// Resample with a windowed-sinc filter instead of linear interpolation.
+	bool m_PolyphaseResampler;
+	// Milliseconds of audio the mixer FIFOs try to keep buffered.
+	int m_MixerLatency;
 	std::string sBackend;
+	// Output file of the Capture backend, FLAC unless it ends in .wav.
+	std::string m_CapturePath;
 
 	// Input settings
 	bool m_BackgroundInput;
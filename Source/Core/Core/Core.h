@@ -49,6 +49,10 @@ bool IsRunningInCurrentThread(); // this tells us whether we are running in the
 bool IsCPUThread(); // this tells us whether we are the CPU thread.
 bool IsGPUThread();
 
+// Marks the calling thread as the CPU thread. Only for use by the CPU thread itself and by tests.
+void DeclareAsCPUThread();
+void UndeclareAsCPUThread();
+
 void SetState(EState _State);
 EState GetState();
 
@@ -2,13 +2,15 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
-#include <mutex>
+#include <functional>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "Common/ChunkFile.h"
-#include "Common/FifoQueue.h"
+#include "Common/MPSCQueue.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 
@@ -32,22 +34,36 @@ struct EventType
 
 static std::vector<EventType> event_types;
 
-struct BaseEvent
+struct Event
 {
 	s64 time;
+	u64 fifoOrder;
 	u64 userdata;
 	int type;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+// Sort by time, unless the times are the same, in which case sort by the order added to the queue.
+// This keeps events scheduled for the same cycle firing in the order they were scheduled, which is
+// what the old sorted linked list did.
+static bool operator>(const Event& left, const Event& right)
+{
+	return std::tie(left.time, left.fifoOrder) > std::tie(right.time, right.fifoOrder);
+}
 
-// STATE_TO_SAVE
-static Event *first;
-static std::mutex tsWriteLock;
-static Common::FifoQueue<BaseEvent, false> tsQueue;
+static bool operator<(const Event& left, const Event& right)
+{
+	return std::tie(left.time, left.fifoOrder) < std::tie(right.time, right.fifoOrder);
+}
 
-// event pools
-static Event *eventPool = nullptr;
+// STATE_TO_SAVE
+// The queue is a min-heap using std::make_heap/push_heap/pop_heap with std::greater, so the
+// next event to run is always eventQueue.front().
+static std::vector<Event> eventQueue;
+static u64 eventFifoId;
+// Events scheduled from other threads. Producers never block each other or the CPU thread, and
+// the queue's node pool means they don't allocate either. A producer only waits when a full pool
+// of events is pending, until the CPU thread moves them to eventQueue.
+static Common::MPSCQueue<Event> tsQueue;
 
 static float lastOCFactor;
 int slicelength;
@@ -63,22 +79,6 @@ u64 fakeTBStartTicks;
 
 static int ev_lost;
 
-static Event* GetNewEvent()
-{
-	if (!eventPool)
-		return new Event;
-
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
-}
-
-static void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
-}
-
 static void EmptyTimedCallback(u64 userdata, int cyclesLate) {}
 
 // Changing the CPU speed in Dolphin isn't actually done by changing the physical clock rate,
@@ -124,7 +124,7 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 
 void UnregisterAllEvents()
 {
-	if (first)
+	if (!eventQueue.empty())
 		PanicAlert("Cannot unregister events with events pending");
 	event_types.clear();
 }
@@ -136,26 +136,19 @@ void Init()
 	slicelength = maxSliceLength;
 	globalTimer = 0;
 	idledCycles = 0;
+	eventFifoId = 0;
 
 	ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
 }
 
 void Shutdown()
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
-
-	while (eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
 }
 
-static void EventDoState(PointerWrap &p, BaseEvent* ev)
+static void EventDoState(PointerWrap &p, Event* ev)
 {
 	p.Do(ev->time);
 
@@ -191,7 +184,6 @@ static void EventDoState(PointerWrap &p, BaseEvent* ev)
 
 void DoState(PointerWrap &p)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	p.Do(slicelength);
 	p.Do(globalTimer);
 	p.Do(idledCycles);
@@ -204,7 +196,40 @@ void DoState(PointerWrap &p)
 
 	MoveEvents();
 
-	p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+	// The events are stored in the same layout PointerWrap::DoLinkedList used for the old sorted
+	// list: a "shouldExist" byte followed by the event, in firing order, terminated by a zero byte.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		eventQueue.clear();
+		eventFifoId = 0;
+		while (true)
+		{
+			u8 shouldExist = 0;
+			p.Do(shouldExist);
+			if (shouldExist != 1)
+				break;
+
+			Event ev;
+			EventDoState(p, &ev);
+			ev.fifoOrder = eventFifoId++;
+			eventQueue.push_back(ev);
+		}
+		// The saved order is already sorted, which is a valid heap, but be defensive.
+		std::make_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
+	}
+	else
+	{
+		std::vector<Event> sorted(eventQueue);
+		std::sort(sorted.begin(), sorted.end());
+		for (Event& ev : sorted)
+		{
+			u8 shouldExist = 1;
+			p.Do(shouldExist);
+			EventDoState(p, &ev);
+		}
+		u8 shouldExist = 0;
+		p.Do(shouldExist);
+	}
 	p.DoMarker("CoreTimingEvents");
 }
 
@@ -229,9 +254,9 @@ void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata
 		                   "was active.  This is likely to cause a desync.",
 		                   event_types[event_type].name.c_str());
 	}
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	Event ne;
 	ne.time = globalTimer + cyclesIntoFuture;
+	ne.fifoOrder = 0;
 	ne.type = event_type;
 	ne.userdata = userdata;
 	tsQueue.Push(ne);
@@ -260,30 +285,23 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
+	eventQueue.clear();
 }
 
-static void AddEventToQueue(Event* ne)
+static void AddEventToQueue(Event ne)
 {
-	Event* prev = nullptr;
-	Event** pNext = &first;
-	for (;;)
-	{
-		Event*& next = *pNext;
-		if (!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	ne.fifoOrder = eventFifoId++;
+	eventQueue.push_back(ne);
+	std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
+}
+
+// Removes the next event from the queue and runs its callback.
+static void RunFirstEvent()
+{
+	std::pop_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
+	Event evt = eventQueue.back();
+	eventQueue.pop_back();
+	event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
 }
 
 // This must be run ONLY from within the CPU thread
@@ -293,40 +311,24 @@ void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
 {
 	_assert_msg_(POWERPC, Core::IsCPUThread() || Core::GetState() == Core::CORE_PAUSE,
 				 "ScheduleEvent from wrong thread");
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = globalTimer + cyclesIntoFuture;
+	Event ne;
+	ne.userdata = userdata;
+	ne.type = event_type;
+	ne.time = globalTimer + cyclesIntoFuture;
 	AddEventToQueue(ne);
 }
 
 void RemoveEvent(int event_type)
 {
-	while (first && first->type == event_type)
-	{
-		Event* next = first->next;
-		FreeEvent(first);
-		first = next;
-	}
-
-	if (!first)
-		return;
+	auto itr = std::remove_if(eventQueue.begin(), eventQueue.end(),
+	                          [&](const Event& e) { return e.type == event_type; });
 
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
+	// Removing arbitrary items breaks the heap invariant, so it has to be rebuilt. This is a
+	// single linear pass over the queue, and is skipped entirely when nothing matched.
+	if (itr != eventQueue.end())
 	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+		eventQueue.erase(itr, eventQueue.end());
+		std::make_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
 	}
 }
 
@@ -351,36 +353,15 @@ void ProcessFifoWaitEvents()
 {
 	MoveEvents();
 
-	if (!first)
-		return;
-
-	while (first)
-	{
-		if (first->time <= globalTimer)
-		{
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
-	}
+	while (!eventQueue.empty() && eventQueue.front().time <= globalTimer)
+		RunFirstEvent();
 }
 
 void MoveEvents()
 {
-	BaseEvent sevt;
+	Event sevt;
 	while (tsQueue.Pop(sevt))
-	{
-		Event *evt = GetNewEvent();
-		evt->time = sevt.time;
-		evt->userdata = sevt.userdata;
-		evt->type = sevt.type;
-		AddEventToQueue(evt);
-	}
+		AddEventToQueue(sevt);
 }
 
 void Advance()
@@ -392,24 +373,21 @@ void Advance()
 	lastOCFactor = SConfig::GetInstance().m_OCEnable ? SConfig::GetInstance().m_OCFactor : 1.0f;
 	PowerPC::ppcState.downcount = CyclesToDowncount(slicelength);
 
-	while (first && first->time <= globalTimer)
+	while (!eventQueue.empty() && eventQueue.front().time <= globalTimer)
 	{
 		//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-		//             event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
-		Event* evt = first;
-		first = first->next;
-		event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-		FreeEvent(evt);
+		//             event_types[eventQueue.front().type].name.c_str(), (u64)globalTimer, (u64)eventQueue.front().time);
+		RunFirstEvent();
 	}
 
-	if (!first)
+	if (eventQueue.empty())
 	{
 		WARN_LOG(POWERPC, "WARNING - no events in queue. Setting downcount to 10000");
 		PowerPC::ppcState.downcount += CyclesToDowncount(10000);
 	}
 	else
 	{
-		slicelength = (int)(first->time - globalTimer);
+		slicelength = (int)(eventQueue.front().time - globalTimer);
 		if (slicelength > maxSliceLength)
 			slicelength = maxSliceLength;
 		PowerPC::ppcState.downcount = CyclesToDowncount(slicelength);
@@ -418,11 +396,11 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
+	std::vector<Event> clone(eventQueue);
+	std::sort(clone.begin(), clone.end());
+	for (const Event& ev : clone)
 	{
-		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ev.time, ev.type);
 	}
 }
 
@@ -445,19 +423,20 @@ void Idle()
 
 std::string GetScheduledEventsSummary()
 {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr)
+
+	std::vector<Event> clone(eventQueue);
+	std::sort(clone.begin(), clone.end());
+	for (const Event& ev : clone)
 	{
-		unsigned int t = ptr->type;
+		unsigned int t = ev.type;
 		if (t >= event_types.size())
 			PanicAlertT("Invalid event type %i", t);
 
-		const std::string& name = event_types[ptr->type].name;
+		const std::string& name = event_types[ev.type].name;
 
-		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ptr->time, ptr->userdata);
-		ptr = ptr->next;
+		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ev.time, ev.userdata);
 	}
 	return text;
 }
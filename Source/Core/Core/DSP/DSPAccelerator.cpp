@@ -10,6 +10,69 @@
 #include "Core/DSP/DSPHost.h"
 #include "Core/DSP/DSPHWInterface.h"
 #include "Core/DSP/DSPInterpreter.h"
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <emmintrin.h>
+#endif
+
+void DecodeADPCM(s16* output, const u8* frame, u32 first, u32 count,
+                 u16 pred_scale, const s16* coefs, s16* yn1, s16* yn2)
+{
+	// Unpack and scale the whole frame up front. Only the predictor below has
+	// to run one sample at a time.
+	s32 deltas[16];
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	const __m128i bytes = _mm_loadl_epi64((const __m128i*)frame);
+	const __m128i nibble_mask = _mm_set1_epi8(0xF);
+	const __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask);
+	const __m128i low = _mm_and_si128(bytes, nibble_mask);
+	// The high nibble of each byte comes first.
+	const __m128i nibbles = _mm_unpacklo_epi8(high, low);
+	const __m128i shift = _mm_cvtsi32_si128(pred_scale & 0xF);
+
+	for (int half = 0; half < 2; half++)
+	{
+		__m128i words = half ? _mm_unpackhi_epi8(nibbles, _mm_setzero_si128())
+		                     : _mm_unpacklo_epi8(nibbles, _mm_setzero_si128());
+		words = _mm_slli_epi16(words, 12);
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 28);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 28);
+		_mm_storeu_si128((__m128i*)&deltas[half * 8], _mm_sll_epi32(lo, shift));
+		_mm_storeu_si128((__m128i*)&deltas[half * 8 + 4], _mm_sll_epi32(hi, shift));
+	}
+#else
+	const int scale = 1 << (pred_scale & 0xF);
+	for (u32 i = first; i < first + count; ++i)
+	{
+		int temp = (i & 1) ? (frame[i >> 1] & 0xF) : (frame[i >> 1] >> 4);
+		if (temp >= 8)
+			temp -= 16;
+		deltas[i] = scale * temp;
+	}
+#endif
+
+	const int coef_idx = (pred_scale >> 4) & 0x7;
+	const s32 coef1 = coefs[coef_idx * 2 + 0];
+	const s32 coef2 = coefs[coef_idx * 2 + 1];
+	s32 hist1 = *yn1;
+	s32 hist2 = *yn2;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		// 0x400 = 0.5  in 11-bit fixed point
+		int val = deltas[first + i] + ((0x400 + coef1 * hist1 + coef2 * hist2) >> 11);
+		val = MathUtil::Clamp(val, -0x7FFF, 0x7FFF);
+
+		hist2 = hist1;
+		hist1 = val;
+		output[i] = val;
+	}
+
+	*yn1 = hist1;
+	*yn2 = hist2;
+}
+
 // The hardware adpcm decoder :)
 static s16 ADPCM_Step(u32& _rSamplePos)
 {
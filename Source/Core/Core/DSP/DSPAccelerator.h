@@ -6,6 +6,21 @@
 
 #include "Common/CommonTypes.h"
 
+// An ADPCM frame is a predictor/scale byte followed by 14 4-bit samples, so
+// sample addresses are nibble addresses and nibbles 0 and 1 of every 16 are
+// the header.
+enum
+{
+	ADPCM_FRAME_SIZE = 8,
+	ADPCM_SAMPLES_PER_FRAME = 14,
+};
+
+// Decodes <count> samples from an 8-byte ADPCM frame starting at nibble
+// <first>, the way the accelerator does, and updates the history values.
+// first + count must not exceed 16.
+void DecodeADPCM(s16* output, const u8* frame, u32 first, u32 count,
+                 u16 pred_scale, const s16* coefs, s16* yn1, s16* yn2);
+
 u16 dsp_read_accelerator();
 
 u16 dsp_read_aram_d3();
@@ -5,6 +5,8 @@
 #include <array>
 
 #include "Core/DSP/DSPAnalyzer.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/DSP/DSPIntExtOps.h"
 #include "Core/DSP/DSPInterpreter.h"
 #include "Core/DSP/DSPMemoryMap.h"
 #include "Core/DSP/DSPTables.h"
@@ -62,11 +64,120 @@ const u16 idle_skip_sigs[NUM_IDLE_SIGS][MAX_IDLE_SIG_SIZE + 1] =
 	  0, 0 }
 };
 
+// Longest loop body, in code words, that FindIdleLoops will look at.
+#define MAX_IDLE_LOOP_SIZE 8
+
 static void Reset()
 {
 	code_flags.fill(0);
 }
 
+// Hardware registers that can be read without side effects. Reading the low
+// half of a mailbox acknowledges the mail and accelerator data reads advance
+// the stream, so these are not in the list.
+static bool IsPollableIFXRegister(u16 addr)
+{
+	switch (addr & 0xff)
+	{
+	case DSP_DMBH:
+	case DSP_CMBH:
+	case DSP_DSCR:
+	case DSP_ACCAH:
+	case DSP_ACCAL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Registers a load may write without side effects. Writing a stack register
+// pushes onto the stack, $sr holds the interrupt enables and $cr moves the
+// LRS/SRS window.
+static bool IsIdleLoadDestination(u16 reg)
+{
+	return !(reg >= DSP_REG_ST0 && reg <= DSP_REG_ST3) && reg != DSP_REG_CR && reg != DSP_REG_SR;
+}
+
+// Returns true for instructions that may appear in a loop which does nothing
+// but wait for the outside world: loads from DMEM or pollable registers, and
+// flag-only tests of what was loaded. Running any number of iterations of
+// such a loop leaves the DSP in the same state as running one.
+static bool IsIdleLoopInstruction(u16 addr, UDSPInstruction inst, const DSPOPCTemplate* opcode)
+{
+	if (opcode->extended)
+	{
+		const DSPOPCTemplate* ext = extOpTable[inst & ((inst >> 12) == 0x3 ? 0x7F : 0xFF)];
+		if (ext->intFunc != DSPInterpreter::Ext::nop)
+			return false;
+	}
+
+	// LRS reads ($cr << 8) | I; like the signatures above, assume $cr = 0xff.
+	if (opcode->intFunc == DSPInterpreter::lrs)
+		return IsPollableIFXRegister(inst & 0xff);
+
+	if (opcode->intFunc == DSPInterpreter::lr)
+	{
+		u16 mem_addr = dsp_imem_read(addr + 1);
+		return IsIdleLoadDestination(inst & 0x1f) && (mem_addr < 0xff00 || IsPollableIFXRegister(mem_addr));
+	}
+
+	return opcode->intFunc == DSPInterpreter::andf ||
+	       opcode->intFunc == DSPInterpreter::andcf ||
+	       opcode->intFunc == DSPInterpreter::tst ||
+	       opcode->intFunc == DSPInterpreter::tstaxh ||
+	       opcode->intFunc == DSPInterpreter::cmpi ||
+	       opcode->intFunc == DSPInterpreter::cmpis;
+}
+
+// Finds mail and DMA wait loops in any ucode: a short run of side effect free
+// instructions ending with a jump back to its start, optionally with
+// conditional jumps out of the loop. Must run after instruction starts have
+// been marked.
+static void FindIdleLoops(int start_addr, int end_addr)
+{
+	for (int addr = start_addr; addr < end_addr; addr++)
+	{
+		if (!(code_flags[addr] & CODE_START_OF_INST))
+			continue;
+
+		UDSPInstruction inst = dsp_imem_read(addr);
+		const DSPOPCTemplate *opcode = GetOpTemplate(inst);
+		if (opcode->intFunc != DSPInterpreter::jcc)
+			continue;
+
+		u16 loop_start = dsp_imem_read(addr + 1);
+		if (loop_start >= addr || addr - loop_start > MAX_IDLE_LOOP_SIZE ||
+		    loop_start < start_addr || !(code_flags[loop_start] & CODE_START_OF_INST))
+			continue;
+
+		bool idle = true;
+		for (int body = loop_start; body < addr && idle;)
+		{
+			UDSPInstruction body_inst = dsp_imem_read(body);
+			const DSPOPCTemplate *body_opcode = GetOpTemplate(body_inst);
+
+			if (body_opcode->intFunc == DSPInterpreter::jcc)
+			{
+				// Only conditional exits out of the loop are allowed.
+				u16 dest = dsp_imem_read(body + 1);
+				idle = !body_opcode->uncond_branch && (dest < loop_start || dest > addr);
+			}
+			else
+			{
+				idle = IsIdleLoopInstruction(body, body_inst, body_opcode);
+			}
+
+			body += body_opcode->size;
+		}
+
+		if (idle)
+		{
+			INFO_LOG(DSPLLE, "Idle loop found at %04x-%04x", loop_start, addr);
+			code_flags[loop_start] |= CODE_IDLE_SKIP;
+		}
+	}
+}
+
 static void AnalyzeRange(int start_addr, int end_addr)
 {
 	// First we run an extremely simplified version of a disassembler to find
@@ -149,6 +260,9 @@ static void AnalyzeRange(int start_addr, int end_addr)
 			}
 		}
 	}
+
+	FindIdleLoops(start_addr, end_addr);
+
 	INFO_LOG(DSPLLE, "Finished analysis.");
 }
 
@@ -58,6 +58,7 @@ void DSPEmitter::ClearIRAM()
 		blockLinks[i] = nullptr;
 		blockSize[i] = 0;
 		unresolvedJumps[i].clear();
+		optionalLinks[i].clear();
 	}
 	g_dsp.reset_dspjit_codespace = true;
 }
@@ -74,6 +75,7 @@ void DSPEmitter::ClearIRAMandDSPJITCodespaceReset()
 		blockLinks[i] = nullptr;
 		blockSize[i] = 0;
 		unresolvedJumps[i].clear();
+		optionalLinks[i].clear();
 	}
 	g_dsp.reset_dspjit_codespace = false;
 }
@@ -198,11 +200,52 @@ void DSPEmitter::EmitInstruction(UDSPInstruction inst)
 	}
 }
 
+// Jump straight into the block at dest, keeping the guest registers cached
+// in host registers, when there are enough cycles left to run it. If dest
+// has not been compiled yet, this block gets recompiled once it is. Blocks
+// that always end up at dest (unconditional JMP/CALL) can't be linked to
+// before then; optional links don't hold the block back.
+void DSPEmitter::WriteBlockLink(u16 dest, bool optional)
+{
+	// IRAM blocks are thrown away when new code is DMA'd in, but IROM never
+	// changes. So anything may link into IROM, while IRAM may only be linked
+	// to from IRAM (this also keeps us from compiling unmapped addresses).
+	bool dest_in_irom = (dest >> 12) == 8;
+	bool iram_to_iram = (dest >> 12) == 0 && (startAddr >> 12) == 0;
+	if (!dest_in_irom && !iram_to_iram)
+		return;
+
+	if (blockLinks[dest] != nullptr)
+	{
+		gpr.flushRegs();
+		// Check if we have enough cycles to execute the next block
+		MOV(16, R(ECX), M(&cyclesLeft));
+		CMP(16, R(ECX), Imm16(blockSize[startAddr] + blockSize[dest]));
+		FixupBranch notEnoughCycles = J_CC(CC_BE);
+
+		SUB(16, R(ECX), Imm16(blockSize[startAddr]));
+		MOV(16, M(&cyclesLeft), R(ECX));
+		JMP(blockLinks[dest], true);
+		SetJumpTarget(notEnoughCycles);
+	}
+	else if (optional)
+	{
+		optionalLinks[startAddr].push_back(dest);
+	}
+	else
+	{
+		// The destination has not been compiled yet.  Add it to the list
+		// of blocks that this block is waiting on.
+		unresolvedJumps[startAddr].push_back(dest);
+	}
+}
+
 void DSPEmitter::Compile(u16 start_addr)
 {
 	// Remember the current block address for later
 	startAddr = start_addr;
 	unresolvedJumps[start_addr].clear();
+	optionalLinks[start_addr].clear();
 
 	const u8 *entryPoint = AlignCode16();
 
@@ -238,6 +281,7 @@ void DSPEmitter::Compile(u16 start_addr)
 
 		// If the block was trying to link into itself, remove the link
 		unresolvedJumps[start_addr].remove(compilePC);
+		optionalLinks[start_addr].remove(compilePC);
 
 		fixup_pc = true;
 
@@ -324,6 +368,11 @@ void DSPEmitter::Compile(u16 start_addr)
 	if (fixup_pc)
 	{
 		MOV(16, M(&(g_dsp.pc)), Imm16(compilePC));
+
+		// Fall through into the next block. Idle skip blocks have to go
+		// back to the dispatcher to hand out their skipped cycles.
+		if (!(DSPAnalyzer::code_flags[start_addr] & DSPAnalyzer::CODE_IDLE_SKIP))
+			WriteBlockLink(compilePC, true);
 	}
 
 	blocks[start_addr] = (DSPCompiledCode)entryPoint;
@@ -336,12 +385,13 @@ void DSPEmitter::Compile(u16 start_addr)
 
 		for (u16 i = 0x0000; i < 0xffff; ++i)
 		{
-			if (!unresolvedJumps[i].empty())
+			if (!unresolvedJumps[i].empty() || !optionalLinks[i].empty())
 			{
 				// Check if there were any blocks waiting for this block to be linkable
-				size_t size = unresolvedJumps[i].size();
+				size_t size = unresolvedJumps[i].size() + optionalLinks[i].size();
 				unresolvedJumps[i].remove(start_addr);
-				if (unresolvedJumps[i].size() < size)
+				optionalLinks[i].remove(start_addr);
+				if (unresolvedJumps[i].size() + optionalLinks[i].size() < size)
 				{
 					// Mark the block to be recompiled again
 					blocks[i] = (DSPCompiledCode)stubEntryPoint;
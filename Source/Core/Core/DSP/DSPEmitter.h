@@ -120,6 +120,7 @@ public:
 
 	// Branch
 	void HandleLoop();
+	void WriteBlockLink(u16 dest, bool optional);
 	void jcc(const UDSPInstruction opc);
 	void jmprcc(const UDSPInstruction opc);
 	void call(const UDSPInstruction opc);
@@ -248,6 +249,11 @@ public:
 	Block *blockLinks;
 	u16 *blockSize;
 	std::list<u16> unresolvedJumps[MAX_BLOCKS];
+	// Not-yet-compiled targets of the links a block could only make on a
+	// conditional branch or its fall-through. Unlike unresolvedJumps these
+	// don't stop the block from being linked to; it just gets recompiled
+	// with the link once the target is compiled.
+	std::list<u16> optionalLinks[MAX_BLOCKS];
 
 	DSPJitRegCache gpr;
 private:
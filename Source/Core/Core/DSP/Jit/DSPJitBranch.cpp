@@ -90,41 +90,20 @@ static void WriteBranchExit(DSPEmitter& emitter)
 	emitter.gpr.flushRegs(c,false);
 }
 
-static void WriteBlockLink(DSPEmitter& emitter, u16 dest)
+static void WriteBranchLink(DSPEmitter& emitter, u16 dest, const UDSPInstruction opc)
 {
-	// Jump directly to the called block if it has already been compiled.
+	// Jumps back into the block being compiled go through the dispatcher.
 	if (!(dest >= emitter.startAddr && dest <= emitter.compilePC))
-	{
-		if (emitter.blockLinks[dest] != nullptr )
-		{
-			emitter.gpr.flushRegs();
-			// Check if we have enough cycles to execute the next block
-			emitter.MOV(16, R(ECX), M(&cyclesLeft));
-			emitter.CMP(16, R(ECX), Imm16(emitter.blockSize[emitter.startAddr] + emitter.blockSize[dest]));
-			FixupBranch notEnoughCycles = emitter.J_CC(CC_BE);
-
-			emitter.SUB(16, R(ECX), Imm16(emitter.blockSize[emitter.startAddr]));
-			emitter.MOV(16, M(&cyclesLeft), R(ECX));
-			emitter.JMP(emitter.blockLinks[dest], true);
-			emitter.SetJumpTarget(notEnoughCycles);
-		}
-		else
-		{
-			// The destination has not been compiled yet.  Add it to the list
-			// of blocks that this block is waiting on.
-			emitter.unresolvedJumps[emitter.startAddr].push_back(dest);
-		}
-	}
+		emitter.WriteBlockLink(dest, !GetOpTemplate(opc)->uncond_branch);
 }
 
 static void r_jcc(const UDSPInstruction opc, DSPEmitter& emitter)
 {
 	u16 dest = dsp_imem_read(emitter.compilePC + 1);
-	const DSPOPCTemplate *opcode = GetOpTemplate(opc);
 
-	// If the block is unconditional, attempt to link block
-	if (opcode->uncond_branch)
-		WriteBlockLink(emitter, dest);
+	// Attempt to link to the destination block (for a conditional branch,
+	// only the taken path gets here)
+	WriteBranchLink(emitter, dest, opc);
 	emitter.MOV(16, M(&(g_dsp.pc)), Imm16(dest));
 	WriteBranchExit(emitter);
 }
@@ -166,11 +145,10 @@ static void r_call(const UDSPInstruction opc, DSPEmitter& emitter)
 	emitter.MOV(16, R(DX), Imm16(emitter.compilePC + 2));
 	emitter.dsp_reg_store_stack(DSP_STACK_C);
 	u16 dest = dsp_imem_read(emitter.compilePC + 1);
-	const DSPOPCTemplate *opcode = GetOpTemplate(opc);
 
-	// If the block is unconditional, attempt to link block
-	if (opcode->uncond_branch)
-		WriteBlockLink(emitter, dest);
+	// Attempt to link to the destination block (for a conditional branch,
+	// only the taken path gets here)
+	WriteBranchLink(emitter, dest, opc);
 	emitter.MOV(16, M(&(g_dsp.pc)), Imm16(dest));
 	WriteBranchExit(emitter);
 }
@@ -7,6 +7,7 @@
 #include "Common/MathUtil.h"
 
 #include "Core/ConfigManager.h"
+#include "Core/Core.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/DSPHLE/UCodes/AX.h"
 
@@ -16,6 +17,8 @@
 AXUCode::AXUCode(DSPHLE* dsphle, u32 crc)
 	: UCodeInterface(dsphle, crc)
 	, m_cmdlist_size(0)
+	, m_worker_busy(false)
+	, m_work_end_pending(false)
 {
 	WARN_LOG(DSPHLE, "Instantiating AXUCode: crc=%08x", crc);
 	m_mail_handler.PushMail(DSP_INIT);
@@ -26,6 +29,7 @@ AXUCode::AXUCode(DSPHLE* dsphle, u32 crc)
 
 AXUCode::~AXUCode()
 {
+	StopWorker();
 	m_mail_handler.Clear();
 }
 
@@ -73,6 +77,74 @@ void AXUCode::SignalWorkEnd()
 	DSP::GenerateDSPInterruptFromDSPEmu(DSP::INT_DSP);
 }
 
+void AXUCode::WorkerThread()
+{
+	Common::SetCurrentThreadName("AX HLE worker");
+
+	while (true)
+	{
+		m_work_start_event.Wait();
+		if (m_worker_quit.IsSet())
+			return;
+
+		HandleCommandList();
+		m_work_done_event.Set();
+	}
+}
+
+void AXUCode::StartCommandList()
+{
+	// The worker lets the CPU touch RAM while the PBs are being processed,
+	// which is not reproducible, so keep it out of movies and netplay. Those
+	// can start while the ucode runs, so this is checked for every list.
+	if (!SConfig::GetInstance().bDSPHLEWorkerThread || Core::g_want_determinism)
+	{
+		HandleCommandList();
+		m_work_end_pending = true;
+		FinishCommandList();
+		return;
+	}
+
+	if (!m_worker.joinable())
+		m_worker = std::thread(&AXUCode::WorkerThread, this);
+
+	m_worker_busy = true;
+	m_work_end_pending = true;
+	m_work_done_event.Reset();
+	m_work_start_event.Set();
+}
+
+void AXUCode::WaitForWorker()
+{
+	if (!m_worker_busy)
+		return;
+
+	m_work_done_event.Wait();
+	m_worker_busy = false;
+}
+
+void AXUCode::FinishCommandList()
+{
+	if (!m_work_end_pending)
+		return;
+
+	WaitForWorker();
+	m_cmdlist_size = 0;
+	m_work_end_pending = false;
+	SignalWorkEnd();
+}
+
+void AXUCode::StopWorker()
+{
+	if (!m_worker.joinable())
+		return;
+
+	WaitForWorker();
+	m_worker_quit.Set();
+	m_work_start_event.Set();
+	m_worker.join();
+}
+
 void AXUCode::HandleCommandList()
 {
 	// Temp variables for addresses computation
@@ -603,12 +675,13 @@ void AXUCode::HandleMail(u32 mail)
 
 	bool set_next_is_cmdlist = false;
 
+	// Any new mail is a sync point for a command list still in flight.
+	FinishCommandList();
+
 	if (next_is_cmdlist)
 	{
 		CopyCmdList(mail, cmdlist_size);
-		HandleCommandList();
-		m_cmdlist_size = 0;
-		SignalWorkEnd();
+		StartCommandList();
 	}
 	else if (m_upload_setup_in_progress)
 	{
@@ -662,6 +735,8 @@ void AXUCode::CopyCmdList(u32 addr, u16 size)
 
 void AXUCode::Update()
 {
+	FinishCommandList();
+
 	// Used for UCode switching.
 	if (NeedsResumeMail())
 	{
@@ -672,8 +747,13 @@ void AXUCode::Update()
 
 void AXUCode::DoAXState(PointerWrap& p)
 {
+	// Let the worker finish writing its buffers; an unsent DSP_YIELD mail is
+	// part of the state.
+	WaitForWorker();
+
 	p.Do(m_cmdlist);
 	p.Do(m_cmdlist_size);
+	p.Do(m_work_end_pending);
 
 	p.Do(m_samples_left);
 	p.Do(m_samples_right);
@@ -12,6 +12,10 @@
 
 #pragma once
 
+#include <thread>
+
+#include "Common/Event.h"
+#include "Common/Flag.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
 
@@ -108,6 +112,24 @@ protected:
 	virtual void HandleCommandList();
 	void SignalWorkEnd();
 
+	// Optional worker thread running HandleCommandList. The CPU thread keeps
+	// going after posting a command list and the DSP_YIELD mail is only sent
+	// on the next Update(), so the mail timing does not depend on how fast
+	// the worker is.
+	bool m_worker_busy;
+	bool m_work_end_pending;
+	std::thread m_worker;
+	Common::Event m_work_start_event;
+	Common::Event m_work_done_event;
+	Common::Flag m_worker_quit;
+
+	void WorkerThread();
+	void StartCommandList();
+	void WaitForWorker();
+	void FinishCommandList();
+	// Must be called by the destructor of any class overriding HandleCommandList.
+	void StopWorker();
+
 	void SetupProcessing(u32 init_addr);
 	void DownloadAndMixWithVolume(u32 addr, u16 vol_main, u16 vol_auxa, u16 vol_auxb);
 	void ProcessPBList(u32 pb_addr);
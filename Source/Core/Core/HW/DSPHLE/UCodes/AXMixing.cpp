@@ -0,0 +1,129 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <emmintrin.h>
+#elif defined(_M_ARM_64)
+#include <arm_neon.h>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/HW/DSPHLE/UCodes/AXMixing.h"
+
+namespace AXMixing
+{
+// MixAdd scales this many samples at a time, which is a whole AX Wii frame.
+static const u32 MIX_CHUNK_SIZE = 96;
+
+// The product of a s16 sample and a u16 volume always fits in 32 bits, so the
+// vector versions below give exactly the same results as the scalar loop.
+u16 ApplyVolume(s16* output, const s16* input, u32 count, u16 volume, u16 volume_delta)
+{
+	// The vector loops handle whole groups of 8 samples, the scalar loop the rest.
+	const u32 vector_count = count & ~7u;
+	u32 i = 0;
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	const __m128i ramp = _mm_mullo_epi16(_mm_set1_epi16(volume_delta), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+	const __m128i min_sample = _mm_set1_epi16(-32767);
+	for (; i < vector_count; i += 8)
+	{
+		__m128i samples = _mm_loadu_si128((const __m128i*)&input[i]);
+		__m128i volumes = _mm_add_epi16(_mm_set1_epi16(volume), ramp);
+
+		// SSE2 only has a signed 16x16 multiply; volumes >= 0x8000 were read as
+		// volume - 0x10000, so add sample << 16 back to those products.
+		__m128i lo = _mm_mullo_epi16(samples, volumes);
+		__m128i hi = _mm_mulhi_epi16(samples, volumes);
+		hi = _mm_add_epi16(hi, _mm_and_si128(samples, _mm_srai_epi16(volumes, 15)));
+
+		__m128i products_lo = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+		__m128i products_hi = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+		__m128i result = _mm_max_epi16(_mm_packs_epi32(products_lo, products_hi), min_sample);
+		_mm_storeu_si128((__m128i*)&output[i], result);
+
+		volume += 8 * volume_delta;
+	}
+#elif defined(_M_ARM_64)
+	static const u16 lane_index[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+	const uint16x8_t ramp = vmulq_n_u16(vld1q_u16(lane_index), volume_delta);
+	const int16x8_t min_sample = vdupq_n_s16(-32767);
+	for (; i < vector_count; i += 8)
+	{
+		int16x8_t samples = vld1q_s16(&input[i]);
+		uint16x8_t volumes = vaddq_u16(vdupq_n_u16(volume), ramp);
+
+		int32x4_t products_lo = vmulq_s32(vmovl_s16(vget_low_s16(samples)),
+		                                  vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(volumes))));
+		int32x4_t products_hi = vmulq_s32(vmovl_s16(vget_high_s16(samples)),
+		                                  vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(volumes))));
+		int16x8_t result = vcombine_s16(vqmovn_s32(vshrq_n_s32(products_lo, 15)),
+		                                vqmovn_s32(vshrq_n_s32(products_hi, 15)));
+		vst1q_s16(&output[i], vmaxq_s16(result, min_sample));
+
+		volume += 8 * volume_delta;
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		output[i] = MathUtil::Clamp(((s32)input[i] * volume) >> 15, -32767, 32767);
+		volume += volume_delta;
+	}
+
+	return volume;
+}
+
+void AddSamples(int* out, const s16* input, u32 count)
+{
+	const u32 vector_count = count & ~7u;
+	u32 i = 0;
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	for (; i < vector_count; i += 8)
+	{
+		__m128i samples = _mm_loadu_si128((const __m128i*)&input[i]);
+		__m128i samples_lo = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		__m128i samples_hi = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+		__m128i* out_vec = (__m128i*)&out[i];
+		_mm_storeu_si128(out_vec, _mm_add_epi32(_mm_loadu_si128(out_vec), samples_lo));
+		_mm_storeu_si128(out_vec + 1, _mm_add_epi32(_mm_loadu_si128(out_vec + 1), samples_hi));
+	}
+#elif defined(_M_ARM_64)
+	for (; i < vector_count; i += 8)
+	{
+		int16x8_t samples = vld1q_s16(&input[i]);
+		vst1q_s32(&out[i], vaddw_s16(vld1q_s32(&out[i]), vget_low_s16(samples)));
+		vst1q_s32(&out[i + 4], vaddw_s16(vld1q_s32(&out[i + 4]), vget_high_s16(samples)));
+	}
+#endif
+
+	for (; i < count; ++i)
+		out[i] += input[i];
+}
+
+void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+	u16& volume = pvol[0];
+	u16 volume_delta = pvol[1];
+
+	// If volume ramping is disabled, set volume_delta to 0. That way, the
+	// mixing loop can avoid testing if volume ramping is enabled at each step,
+	// and just add volume_delta.
+	if (!ramp)
+		volume_delta = 0;
+
+	s16 scaled[MIX_CHUNK_SIZE];
+	for (u32 i = 0; i < count; i += MIX_CHUNK_SIZE)
+	{
+		u32 chunk = std::min<u32>(count - i, MIX_CHUNK_SIZE);
+		volume = ApplyVolume(scaled, input + i, chunk, volume, volume_delta);
+		AddSamples(out + i, scaled, chunk);
+		*dpop = scaled[chunk - 1];
+	}
+}
+}
@@ -0,0 +1,26 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+// Volume and mixing primitives shared by AX GC and AX Wii. Unlike the rest of
+// AXVoice.h, these don't depend on the PB layout, so they are built once.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+
+namespace AXMixing
+{
+// Multiplies <count> samples by a 1.15 volume that changes by <volume_delta>
+// after each sample, clamping to [-32767, 32767] (-32768 ?). Returns the volume
+// after the last sample. <output> may be the same as <input>.
+u16 ApplyVolume(s16* output, const s16* input, u32 count, u16 volume, u16 volume_delta);
+
+// Adds <count> samples to a 32-bit output buffer.
+void AddSamples(int* out, const s16* input, u32 count);
+
+// Add samples to an output buffer, with optional volume ramping. pvol holds
+// the volume and its delta; the volume is updated, and *dpop is set to the
+// last sample that was added.
+void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp);
+}
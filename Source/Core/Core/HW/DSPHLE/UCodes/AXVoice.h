@@ -12,13 +12,15 @@
 #error AXVoice.h included without specifying version
 #endif
 
-#include <functional>
+#include <algorithm>
 
 #include "Common/CommonTypes.h"
 #include "Common/MathUtil.h"
+#include "Core/DSP/DSPAccelerator.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/DSPHLE/UCodes/AX.h"
+#include "Core/HW/DSPHLE/UCodes/AXMixing.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 
 #ifdef AX_GC
@@ -29,6 +31,10 @@
 # define MAX_SAMPLES_PER_FRAME 96
 #endif
 
+// Sample rate ratios go up to 4.0, so a frame reads at most this many samples
+// from the accelerator.
+#define MAX_INPUT_SAMPLES_PER_FRAME (MAX_SAMPLES_PER_FRAME * 4)
+
 // Put all of that in an anonymous namespace to avoid stupid compilers merging
 // functions from AX GC and AX Wii.
 namespace {
@@ -143,6 +149,45 @@ void AcceleratorSetup(PB_TYPE* pb, u32* cur_addr)
 	acc_end_reached = false;
 }
 
+// Called when the accelerator reaches the end address.
+//
+// On real hardware, this would raise an interrupt that is handled by the
+// UCode. We simulate what this interrupt does here.
+void AcceleratorEndReached()
+{
+	// loop back to loop_addr.
+	*acc_cur_addr = acc_loop_addr;
+
+	if (acc_pb->audio_addr.looping)
+	{
+		// Set the ADPCM infos to continue processing at loop_addr.
+		//
+		// For some reason, yn1 and yn2 aren't set if the voice is not of
+		// stream type. This is what the AX UCode does and I don't really
+		// know why.
+		acc_pb->adpcm.pred_scale = acc_pb->adpcm_loop_info.pred_scale;
+		if (!acc_pb->is_stream)
+		{
+			acc_pb->adpcm.yn1 = acc_pb->adpcm_loop_info.yn1;
+			acc_pb->adpcm.yn2 = acc_pb->adpcm_loop_info.yn2;
+		}
+	}
+	else
+	{
+		// Non looping voice reached the end -> running = 0.
+		acc_pb->running = 0;
+
+#ifdef AX_WII
+		// One of the few meaningful differences between AXGC and AXWii:
+		// while AXGC handles non looping voices ending by having 0000
+		// samples at the loop address, AXWii has the 0000 samples
+		// internally in DRAM and use an internal pointer to it (loop addr
+		// does not contain 0000 samples on AXWii!).
+		acc_end_reached = true;
+#endif
+	}
+}
+
 // Reads a sample from the simulated accelerator. Also handles looping and
 // disabling streams that reached the end (this is done by an exception raised
 // by the accelerator on real hardware).
@@ -216,45 +261,61 @@ u16 AcceleratorGetSample()
 	}
 
 	// Have we reached the end address?
-	//
-	// On real hardware, this would raise an interrupt that is handled by the
-	// UCode. We simulate what this interrupt does here.
 	if (*acc_cur_addr == (acc_end_addr + step_size_bytes - 1))
+		AcceleratorEndReached();
+
+	return ret;
+}
+
+// Reads <count> samples from the simulated accelerator, like calling
+// AcceleratorGetSample() <count> times. ADPCM is decoded a frame at a time.
+void AcceleratorGetSamples(s16* output, u32 count)
+{
+	if (acc_pb->audio_addr.sample_format != 0x00)
 	{
-		// loop back to loop_addr.
-		*acc_cur_addr = acc_loop_addr;
+		for (u32 i = 0; i < count; ++i)
+			output[i] = AcceleratorGetSample();
+		return;
+	}
+
+	const u32 step_size_bytes = (acc_end_addr & 15) == 0 ? 1 : 2;
+	const u32 end_addr = acc_end_addr + step_size_bytes - 1;
 
-		if (acc_pb->audio_addr.looping)
+	u32 i = 0;
+	while (i < count)
+	{
+		if (acc_end_reached)
 		{
-			// Set the ADPCM infos to continue processing at loop_addr.
-			//
-			// For some reason, yn1 and yn2 aren't set if the voice is not of
-			// stream type. This is what the AX UCode does and I don't really
-			// know why.
-			acc_pb->adpcm.pred_scale = acc_pb->adpcm_loop_info.pred_scale;
-			if (!acc_pb->is_stream)
-			{
-				acc_pb->adpcm.yn1 = acc_pb->adpcm_loop_info.yn1;
-				acc_pb->adpcm.yn2 = acc_pb->adpcm_loop_info.yn2;
-			}
+			std::fill(output + i, output + count, 0);
+			return;
 		}
-		else
-		{
-			// Non looping voice reached the end -> running = 0.
-			acc_pb->running = 0;
 
-#ifdef AX_WII
-			// One of the few meaningful differences between AXGC and AXWii:
-			// while AXGC handles non looping voices ending by having 0000
-			// samples at the loop address, AXWii has the 0000 samples
-			// internally in DRAM and use an internal pointer to it (loop addr
-			// does not contain 0000 samples on AXWii!).
-			acc_end_reached = true;
-#endif
+		if ((*acc_cur_addr & 15) == 0)
+		{
+			acc_pb->adpcm.pred_scale = DSP::ReadARAM((*acc_cur_addr & ~15) >> 1);
+			*acc_cur_addr += 2;
 		}
-	}
 
-	return ret;
+		// Decode up to the end of the frame, but stop at the end address.
+		const u32 first = *acc_cur_addr & 15;
+		u32 run = std::min(16 - first, count - i);
+		const bool end_reached = end_addr - *acc_cur_addr - 1 < run;
+		if (end_reached)
+			run = end_addr - *acc_cur_addr;
+
+		u8 frame[ADPCM_FRAME_SIZE] = {};
+		const u32 frame_addr = (*acc_cur_addr & ~15) >> 1;
+		for (u32 j = first >> 1; j <= (first + run - 1) >> 1; ++j)
+			frame[j] = DSP::ReadARAM(frame_addr + j);
+
+		DecodeADPCM(output + i, frame, first, run, acc_pb->adpcm.pred_scale,
+		            acc_pb->adpcm.coefs, &acc_pb->adpcm.yn1, &acc_pb->adpcm.yn2);
+		*acc_cur_addr += run;
+		i += run;
+
+		if (end_reached)
+			AcceleratorEndReached();
+	}
 }
 
 // Reads samples from the input callback, resamples them to <count> samples at
@@ -277,7 +338,11 @@ u16 AcceleratorGetSample()
 // We start getting samples not from sample 0, but 0.<curr_pos_frac>. This
 // avoids discontinuities in the audio stream, especially with very low ratios
 // which interpolate a lot of values between two "real" samples.
-u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count,
+//
+// The callback is a template parameter rather than a std::function so that
+// reading from the accelerator gets inlined into the resampling loops.
+template <typename InputCallback>
+u32 ResampleAudio(InputCallback input_callback, s16* output, u32 count,
                   s16* last_samples, u32 curr_pos, u32 ratio, int srctype,
                   const s16* coeffs)
 {
@@ -402,10 +467,30 @@ void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 
 	if (coeffs)
 		coeffs += pb.coef_select * 0x200;
-	u32 curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); },
-	                             samples, count, pb.src.last_samples,
-	                             pb.src.cur_addr_frac, HILO_TO_32(pb.src.ratio),
-	                             pb.src_type, coeffs);
+
+	// The resampler reads one input sample each time the position crosses an
+	// integer, so the number of reads is known in advance. Decode them all at
+	// once unless the ratio is out of the documented range.
+	const u32 ratio = HILO_TO_32(pb.src.ratio);
+	u64 input_count = count;
+	if (pb.src_type == SRCTYPE_LINEAR || pb.src_type == SRCTYPE_POLYPHASE)
+		input_count = (pb.src.cur_addr_frac + (u64)ratio * count) >> 16;
+
+	u32 curr_pos;
+	if (input_count <= MAX_INPUT_SAMPLES_PER_FRAME)
+	{
+		s16 input[MAX_INPUT_SAMPLES_PER_FRAME];
+		AcceleratorGetSamples(input, (u32)input_count);
+		curr_pos = ResampleAudio([&input](u32 i) { return input[i]; },
+		                         samples, count, pb.src.last_samples,
+		                         pb.src.cur_addr_frac, ratio, pb.src_type, coeffs);
+	}
+	else
+	{
+		curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); },
+		                         samples, count, pb.src.last_samples,
+		                         pb.src.cur_addr_frac, ratio, pb.src_type, coeffs);
+	}
 	pb.src.cur_addr_frac = (curr_pos & 0xFFFF);
 
 	// Update current position in the PB.
@@ -413,32 +498,6 @@ void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 	pb.audio_addr.cur_addr_lo = (u16)(cur_addr & 0xFFFF);
 }
 
-// Add samples to an output buffer, with optional volume ramping.
-void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
-{
-	u16& volume = pvol[0];
-	u16 volume_delta = pvol[1];
-
-	// If volume ramping is disabled, set volume_delta to 0. That way, the
-	// mixing loop can avoid testing if volume ramping is enabled at each step,
-	// and just add volume_delta.
-	if (!ramp)
-		volume_delta = 0;
-
-	for (u32 i = 0; i < count; ++i)
-	{
-		s64 sample = input[i];
-		sample *= volume;
-		sample >>= 15;
-		sample = MathUtil::Clamp((s32)sample, -32767, 32767);	// -32768 ?
-
-		out[i] += (s16)sample;
-		volume += volume_delta;
-
-		*dpop = (s16)sample;
-	}
-}
-
 // Execute a low pass filter on the samples using one history value. Returns
 // the new history value.
 s16 LowPassFilter(s16* samples, u32 count, s16 yn1, u16 a0, u16 b0)
@@ -461,11 +520,8 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 	GetInputSamples(pb, samples, count, coeffs);
 
 	// Apply a global volume ramp using the volume envelope parameters.
-	for (u32 i = 0; i < count; ++i)
-	{
-		samples[i] = MathUtil::Clamp(((s32)samples[i] * pb.vol_env.cur_volume) >> 15, -32767, 32767);	// -32768 ?
-		pb.vol_env.cur_volume += pb.vol_env.cur_volume_delta;
-	}
+	pb.vol_env.cur_volume = AXMixing::ApplyVolume(samples, samples, count, pb.vol_env.cur_volume,
+	                                    pb.vol_env.cur_volume_delta);
 
 	// Optionally, execute a low pass filter
 	// TODO: LPF code is currently broken, causing Super Monkey Ball sound
@@ -482,33 +538,33 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 #define RAMP_ON(C) (0 != (mctrl & MIX_##C##_RAMP))
 
 	if (MIX_ON(L))
-		MixAdd(buffers.left, samples, count, &pb.mixer.left, &pb.dpop.left, RAMP_ON(L));
+		AXMixing::MixAdd(buffers.left, samples, count, &pb.mixer.left, &pb.dpop.left, RAMP_ON(L));
 	if (MIX_ON(R))
-		MixAdd(buffers.right, samples, count, &pb.mixer.right, &pb.dpop.right, RAMP_ON(R));
+		AXMixing::MixAdd(buffers.right, samples, count, &pb.mixer.right, &pb.dpop.right, RAMP_ON(R));
 	if (MIX_ON(S))
-		MixAdd(buffers.surround, samples, count, &pb.mixer.surround, &pb.dpop.surround, RAMP_ON(S));
+		AXMixing::MixAdd(buffers.surround, samples, count, &pb.mixer.surround, &pb.dpop.surround, RAMP_ON(S));
 
 	if (MIX_ON(AUXA_L))
-		MixAdd(buffers.auxA_left, samples, count, &pb.mixer.auxA_left, &pb.dpop.auxA_left, RAMP_ON(AUXA_L));
+		AXMixing::MixAdd(buffers.auxA_left, samples, count, &pb.mixer.auxA_left, &pb.dpop.auxA_left, RAMP_ON(AUXA_L));
 	if (MIX_ON(AUXA_R))
-		MixAdd(buffers.auxA_right, samples, count, &pb.mixer.auxA_right, &pb.dpop.auxA_right, RAMP_ON(AUXA_R));
+		AXMixing::MixAdd(buffers.auxA_right, samples, count, &pb.mixer.auxA_right, &pb.dpop.auxA_right, RAMP_ON(AUXA_R));
 	if (MIX_ON(AUXA_S))
-		MixAdd(buffers.auxA_surround, samples, count, &pb.mixer.auxA_surround, &pb.dpop.auxA_surround, RAMP_ON(AUXA_S));
+		AXMixing::MixAdd(buffers.auxA_surround, samples, count, &pb.mixer.auxA_surround, &pb.dpop.auxA_surround, RAMP_ON(AUXA_S));
 
 	if (MIX_ON(AUXB_L))
-		MixAdd(buffers.auxB_left, samples, count, &pb.mixer.auxB_left, &pb.dpop.auxB_left, RAMP_ON(AUXB_L));
+		AXMixing::MixAdd(buffers.auxB_left, samples, count, &pb.mixer.auxB_left, &pb.dpop.auxB_left, RAMP_ON(AUXB_L));
 	if (MIX_ON(AUXB_R))
-		MixAdd(buffers.auxB_right, samples, count, &pb.mixer.auxB_right, &pb.dpop.auxB_right, RAMP_ON(AUXB_R));
+		AXMixing::MixAdd(buffers.auxB_right, samples, count, &pb.mixer.auxB_right, &pb.dpop.auxB_right, RAMP_ON(AUXB_R));
 	if (MIX_ON(AUXB_S))
-		MixAdd(buffers.auxB_surround, samples, count, &pb.mixer.auxB_surround, &pb.dpop.auxB_surround, RAMP_ON(AUXB_S));
+		AXMixing::MixAdd(buffers.auxB_surround, samples, count, &pb.mixer.auxB_surround, &pb.dpop.auxB_surround, RAMP_ON(AUXB_S));
 
 #ifdef AX_WII
 	if (MIX_ON(AUXC_L))
-		MixAdd(buffers.auxC_left, samples, count, &pb.mixer.auxC_left, &pb.dpop.auxC_left, RAMP_ON(AUXC_L));
+		AXMixing::MixAdd(buffers.auxC_left, samples, count, &pb.mixer.auxC_left, &pb.dpop.auxC_left, RAMP_ON(AUXC_L));
 	if (MIX_ON(AUXC_R))
-		MixAdd(buffers.auxC_right, samples, count, &pb.mixer.auxC_right, &pb.dpop.auxC_right, RAMP_ON(AUXC_R));
+		AXMixing::MixAdd(buffers.auxC_right, samples, count, &pb.mixer.auxC_right, &pb.dpop.auxC_right, RAMP_ON(AUXC_R));
 	if (MIX_ON(AUXC_S))
-		MixAdd(buffers.auxC_surround, samples, count, &pb.mixer.auxC_surround, &pb.dpop.auxC_surround, RAMP_ON(AUXC_S));
+		AXMixing::MixAdd(buffers.auxC_surround, samples, count, &pb.mixer.auxC_surround, &pb.dpop.auxC_surround, RAMP_ON(AUXC_S));
 #endif
 
 #undef MIX_ON
@@ -543,21 +599,21 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 #define WMCHAN_MIX_RAMP(n) (0 != ((pb.remote_mixer_control >> (2 * n)) & 2))
 
 		if (WMCHAN_MIX_ON(0))
-			MixAdd(buffers.wm_main0, wm_samples, wm_count, &pb.remote_mixer.main0, &pb.remote_dpop.main0, WMCHAN_MIX_RAMP(0));
+			AXMixing::MixAdd(buffers.wm_main0, wm_samples, wm_count, &pb.remote_mixer.main0, &pb.remote_dpop.main0, WMCHAN_MIX_RAMP(0));
 		if (WMCHAN_MIX_ON(1))
-			MixAdd(buffers.wm_aux0, wm_samples, wm_count, &pb.remote_mixer.aux0, &pb.remote_dpop.aux0, WMCHAN_MIX_RAMP(1));
+			AXMixing::MixAdd(buffers.wm_aux0, wm_samples, wm_count, &pb.remote_mixer.aux0, &pb.remote_dpop.aux0, WMCHAN_MIX_RAMP(1));
 		if (WMCHAN_MIX_ON(2))
-			MixAdd(buffers.wm_main1, wm_samples, wm_count, &pb.remote_mixer.main1, &pb.remote_dpop.main1, WMCHAN_MIX_RAMP(2));
+			AXMixing::MixAdd(buffers.wm_main1, wm_samples, wm_count, &pb.remote_mixer.main1, &pb.remote_dpop.main1, WMCHAN_MIX_RAMP(2));
 		if (WMCHAN_MIX_ON(3))
-			MixAdd(buffers.wm_aux1, wm_samples, wm_count, &pb.remote_mixer.aux1, &pb.remote_dpop.aux1, WMCHAN_MIX_RAMP(3));
+			AXMixing::MixAdd(buffers.wm_aux1, wm_samples, wm_count, &pb.remote_mixer.aux1, &pb.remote_dpop.aux1, WMCHAN_MIX_RAMP(3));
 		if (WMCHAN_MIX_ON(4))
-			MixAdd(buffers.wm_main2, wm_samples, wm_count, &pb.remote_mixer.main2, &pb.remote_dpop.main2, WMCHAN_MIX_RAMP(4));
+			AXMixing::MixAdd(buffers.wm_main2, wm_samples, wm_count, &pb.remote_mixer.main2, &pb.remote_dpop.main2, WMCHAN_MIX_RAMP(4));
 		if (WMCHAN_MIX_ON(5))
-			MixAdd(buffers.wm_aux2, wm_samples, wm_count, &pb.remote_mixer.aux2, &pb.remote_dpop.aux2, WMCHAN_MIX_RAMP(5));
+			AXMixing::MixAdd(buffers.wm_aux2, wm_samples, wm_count, &pb.remote_mixer.aux2, &pb.remote_dpop.aux2, WMCHAN_MIX_RAMP(5));
 		if (WMCHAN_MIX_ON(6))
-			MixAdd(buffers.wm_main3, wm_samples, wm_count, &pb.remote_mixer.main3, &pb.remote_dpop.main3, WMCHAN_MIX_RAMP(6));
+			AXMixing::MixAdd(buffers.wm_main3, wm_samples, wm_count, &pb.remote_mixer.main3, &pb.remote_dpop.main3, WMCHAN_MIX_RAMP(6));
 		if (WMCHAN_MIX_ON(7))
-			MixAdd(buffers.wm_aux3, wm_samples, wm_count, &pb.remote_mixer.aux3, &pb.remote_dpop.aux3, WMCHAN_MIX_RAMP(7));
+			AXMixing::MixAdd(buffers.wm_aux3, wm_samples, wm_count, &pb.remote_mixer.aux3, &pb.remote_dpop.aux3, WMCHAN_MIX_RAMP(7));
 	}
 #undef WMCHAN_MIX_RAMP
 #undef WMCHAN_MIX_ON
@@ -2,12 +2,20 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <cstdlib>
+
 #include "Core/ConfigManager.h"
 #include "Core/HW/DSPHLE/MailHandler.h"
 #include "Core/HW/DSPHLE/UCodes/GBA.h"
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
 #include "Core/HW/DSPHLE/UCodes/Zelda.h"
 
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <emmintrin.h>
+#elif defined(_M_ARM_64)
+#include <arm_neon.h>
+#endif
+
 // Uncomment this to have a strict version of the HLE implementation, which
 // PanicAlerts on recoverable unknown behaviors instead of silently ignoring
 // them.  Recommended for development.
@@ -893,6 +901,224 @@ struct ReverbPB
 };
 #pragma pack(pop)
 
+s32 ZeldaAudioRenderer::AddBuffersWithVolumeRamp(s16* dst, const s16* src, size_t count, s32 vol, s32 step)
+{
+	if (!vol && !step)
+		return vol;
+
+	// The volume wraps around like the 32-bit accumulator of the DSP.
+	u32 uvol = (u32)vol;
+	size_t i = 0;
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	__m128i vol_lo = _mm_setr_epi32(uvol, uvol + step, uvol + 2 * step, uvol + 3 * step);
+	__m128i vol_hi = _mm_add_epi32(vol_lo, _mm_set1_epi32(4 * (u32)step));
+	const __m128i step8 = _mm_set1_epi32(8 * (u32)step);
+	for (; i < count / 8 * 8; i += 8)
+	{
+		// The volumes are in 16-bit range after the shift, so packing is exact,
+		// and mulhi is the (vol * sample) >> 16 of the scalar loop.
+		__m128i v = _mm_packs_epi32(_mm_srai_epi32(vol_lo, 16), _mm_srai_epi32(vol_hi, 16));
+		__m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+		__m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_add_epi16(d, _mm_mulhi_epi16(v, s)));
+		vol_lo = _mm_add_epi32(vol_lo, step8);
+		vol_hi = _mm_add_epi32(vol_hi, step8);
+	}
+	uvol += (u32)i * step;
+#elif defined(_M_ARM_64)
+	const s32 first[4] = { (s32)uvol, (s32)(uvol + step), (s32)(uvol + 2 * step), (s32)(uvol + 3 * step) };
+	int32x4_t vol_lo = vld1q_s32(first);
+	int32x4_t vol_hi = vaddq_s32(vol_lo, vdupq_n_s32(4 * (u32)step));
+	const int32x4_t step8 = vdupq_n_s32(8 * (u32)step);
+	for (; i < count / 8 * 8; i += 8)
+	{
+		int16x8_t s = vld1q_s16(&src[i]);
+		int16x4_t lo = vshrn_n_s32(vmull_s16(vshrn_n_s32(vol_lo, 16), vget_low_s16(s)), 16);
+		int16x4_t hi = vshrn_n_s32(vmull_s16(vshrn_n_s32(vol_hi, 16), vget_high_s16(s)), 16);
+		vst1q_s16(&dst[i], vaddq_s16(vld1q_s16(&dst[i]), vcombine_s16(lo, hi)));
+		vol_lo = vaddq_s32(vol_lo, step8);
+		vol_hi = vaddq_s32(vol_hi, step8);
+	}
+	uvol += (u32)i * step;
+#endif
+
+	for (; i < count; ++i)
+	{
+		dst[i] += (((s32)uvol >> 16) * src[i]) >> 16;
+		uvol += step;
+	}
+
+	return (s32)uvol;
+}
+
+void ZeldaAudioRenderer::AddBuffersWithVolume(s16* dst, const s16* src, size_t count, u16 vol)
+{
+	size_t i = 0;
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	// SSE2 only multiplies signed words: when the volume is 2.0 or more, its
+	// signed interpretation is off by 0x10000, so add the sample back to the
+	// high half of the product.
+	const __m128i v = _mm_set1_epi16((s16)vol);
+	const __m128i fixup = _mm_set1_epi16((vol & 0x8000) ? -1 : 0);
+	for (; i < count / 8 * 8; i += 8)
+	{
+		__m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+		__m128i lo = _mm_mullo_epi16(s, v);
+		__m128i hi = _mm_add_epi16(_mm_mulhi_epi16(s, v), _mm_and_si128(s, fixup));
+		__m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 15);
+		__m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 15);
+		__m128i d = _mm_loadu_si128((const __m128i*)&dst[i]);
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_add_epi16(d, _mm_packs_epi32(p0, p1)));
+	}
+#elif defined(_M_ARM_64)
+	for (; i < count / 8 * 8; i += 8)
+	{
+		int16x8_t s = vld1q_s16(&src[i]);
+		int32x4_t p0 = vmulq_n_s32(vmovl_s16(vget_low_s16(s)), vol);
+		int32x4_t p1 = vmulq_n_s32(vmovl_s16(vget_high_s16(s)), vol);
+		int16x8_t scaled = vcombine_s16(vqshrn_n_s32(p0, 15), vqshrn_n_s32(p1, 15));
+		vst1q_s16(&dst[i], vaddq_s16(vld1q_s16(&dst[i]), scaled));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		s32 vol_src = ((s32)src[i] * (s32)vol) >> 15;
+		dst[i] += MathUtil::Clamp(vol_src, -0x8000, 0x7FFF);
+	}
+}
+
+void ZeldaAudioRenderer::ApplyReverbFilter(s16* buffer, size_t count, const s16* coeffs)
+{
+	// Output i only reads inputs i to i + 7, so filtering in place is fine as
+	// long as a group of outputs is computed before it is stored.
+	size_t i = 0;
+
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	__m128i taps[8];
+	for (size_t j = 0; j < 8; ++j)
+		taps[j] = _mm_set1_epi16(coeffs[j]);
+	for (; i < count / 8 * 8; i += 8)
+	{
+		__m128i acc_lo = _mm_setzero_si128();
+		__m128i acc_hi = _mm_setzero_si128();
+		for (size_t j = 0; j < 8; ++j)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i*)&buffer[i + j]);
+			__m128i lo = _mm_mullo_epi16(x, taps[j]);
+			__m128i hi = _mm_mulhi_epi16(x, taps[j]);
+			acc_lo = _mm_add_epi32(acc_lo, _mm_unpacklo_epi16(lo, hi));
+			acc_hi = _mm_add_epi32(acc_hi, _mm_unpackhi_epi16(lo, hi));
+		}
+		__m128i out = _mm_packs_epi32(_mm_srai_epi32(acc_lo, 15), _mm_srai_epi32(acc_hi, 15));
+		_mm_storeu_si128((__m128i*)&buffer[i], out);
+	}
+#elif defined(_M_ARM_64)
+	for (; i < count / 8 * 8; i += 8)
+	{
+		int32x4_t acc_lo = vdupq_n_s32(0);
+		int32x4_t acc_hi = vdupq_n_s32(0);
+		for (size_t j = 0; j < 8; ++j)
+		{
+			int16x8_t x = vld1q_s16(&buffer[i + j]);
+			acc_lo = vmlal_n_s16(acc_lo, vget_low_s16(x), coeffs[j]);
+			acc_hi = vmlal_n_s16(acc_hi, vget_high_s16(x), coeffs[j]);
+		}
+		vst1q_s16(&buffer[i], vcombine_s16(vqshrn_n_s32(acc_lo, 15), vqshrn_n_s32(acc_hi, 15)));
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		s32 sample = 0;
+		for (size_t j = 0; j < 8; ++j)
+			sample += (s32)buffer[i + j] * coeffs[j];
+		sample >>= 15;
+		buffer[i] = MathUtil::Clamp(sample, -0x8000, 0x7FFF);
+	}
+}
+
+u32 ZeldaAudioRenderer::ResampleInterpolated(s16* dst, const s16* src, size_t count, u32 pos, u32 ratio,
+                                             const s16* coeffs, bool coeffs_fit_s32)
+{
+	// We have 0x40 * 4 coeffs that need to be selected based on the most
+	// significant bits of the fractional part of the position. 12 bits >> 6 =
+	// 6 bits = 0x40. Multiply by 4 since there are 4 consecutive coeffs.
+	auto taps = [&](u32 p) { return &coeffs[((p & 0xFFF) >> 6) * 4]; };
+	size_t i = 0;
+
+	// Each output is (2 * sum(coeff * input)) >> 16, which is the same as
+	// sum >> 15. When the taps of a set add up to at most 1.0 the sum cannot
+	// leave the 32-bit range, so it can be computed with 16-bit multiplies.
+	if (coeffs_fit_s32)
+	{
+#if defined(_M_X86) && !defined(_M_GENERIC)
+		for (; i < count / 4 * 4; i += 4)
+		{
+			__m128i m[2];
+			for (int k = 0; k < 2; ++k)
+			{
+				const u32 pos_a = pos + (u32)(2 * k) * ratio;
+				const u32 pos_b = pos_a + ratio;
+				__m128i x = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)&src[pos_a >> 12]),
+				                               _mm_loadl_epi64((const __m128i*)&src[pos_b >> 12]));
+				__m128i c = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)taps(pos_a)),
+				                               _mm_loadl_epi64((const __m128i*)taps(pos_b)));
+				m[k] = _mm_madd_epi16(x, c);
+			}
+			// m[k] holds two partial sums for each of two outputs; add them up
+			// so that the four outputs end up in order.
+			__m128 m0 = _mm_castsi128_ps(m[0]);
+			__m128 m1 = _mm_castsi128_ps(m[1]);
+			__m128i sum = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(m0, m1, _MM_SHUFFLE(2, 0, 2, 0))),
+			                            _mm_castps_si128(_mm_shuffle_ps(m0, m1, _MM_SHUFFLE(3, 1, 3, 1))));
+			sum = _mm_srai_epi32(sum, 15);
+			_mm_storel_epi64((__m128i*)&dst[i], _mm_packs_epi32(sum, sum));
+			pos += 4 * ratio;
+		}
+#elif defined(_M_ARM_64)
+		for (; i < count; ++i)
+		{
+			int32x4_t products = vmull_s16(vld1_s16(taps(pos)), vld1_s16(&src[pos >> 12]));
+			dst[i] = (s16)MathUtil::Clamp(vaddvq_s32(products) >> 15, -0x8000, 0x7FFF);
+			pos += ratio;
+		}
+#endif
+	}
+
+	for (; i < count; ++i)
+	{
+		const s16* c = taps(pos);
+		const s16* input = &src[pos >> 12];
+
+		s64 dst_sample_unclamped = 0;
+		for (size_t j = 0; j < 4; ++j)
+			dst_sample_unclamped += (s64)2 * c[j] * input[j];
+		dst_sample_unclamped >>= 16;
+
+		dst[i] = (s16)MathUtil::Clamp<s64>(dst_sample_unclamped, -0x8000, 0x7FFF);
+
+		pos += ratio;
+	}
+
+	return pos;
+}
+
+void ZeldaAudioRenderer::UpdateResamplingCoeffsRange()
+{
+	m_resampling_coeffs_fit_s32 = true;
+	for (size_t i = 0; i < m_resampling_coeffs.size(); i += 4)
+	{
+		s32 sum = 0;
+		for (size_t j = 0; j < 4; ++j)
+			sum += std::abs(m_resampling_coeffs[i + j]);
+		if (sum > 0x8000)
+			m_resampling_coeffs_fit_s32 = false;
+	}
+}
+
 void ZeldaAudioRenderer::PrepareFrame()
 {
 	if (m_prepared)
@@ -1009,14 +1235,7 @@ void ZeldaAudioRenderer::ApplyReverb(bool post_rendering)
 
 			auto ApplyFilter = [&]() {
 				// Filter the buffer using provided coefficients.
-				for (u16 i = 0; i < 0x50; ++i)
-				{
-					s32 sample = 0;
-					for (u16 j = 0; j < 8; ++j)
-						sample += (s32)buffer[i + j] * rpb.filter_coeffs[j];
-					sample >>= 15;
-					buffer[i] = MathUtil::Clamp(sample, -0x8000, 0x7FFF);
-				}
+				ApplyReverbFilter(buffer.data(), 0x50, rpb.filter_coeffs);
 			};
 
 			// LSB set -> pre-filtering.
@@ -1345,27 +1564,38 @@ void ZeldaAudioRenderer::LoadInputSamples(MixingBuffer* buffer, VPB* vpb)
 		{
 			const u16 PATTERN_SIZE = 0x40;
 
-			struct PatternInfo { u16 idx; bool variable_step; };
-			std::map<u16, PatternInfo> samples_source_to_pattern = {
-				{ VPB::SRC_CONST_PATTERN_0, {0, false} },
-				{ VPB::SRC_CONST_PATTERN_0_VARIABLE_STEP, {0, true} },
-				{ VPB::SRC_CONST_PATTERN_1, {1, false} },
-				{ VPB::SRC_CONST_PATTERN_2, {2, false} },
-				{ VPB::SRC_CONST_PATTERN_3, {3, false} },
-			};
-			auto& pattern_info = samples_source_to_pattern[vpb->samples_source_type];
-			u16 pattern_offset = pattern_info.idx * PATTERN_SIZE;
+			u16 pattern_idx;
+			switch (vpb->samples_source_type)
+			{
+				case VPB::SRC_CONST_PATTERN_1: pattern_idx = 1; break;
+				case VPB::SRC_CONST_PATTERN_2: pattern_idx = 2; break;
+				case VPB::SRC_CONST_PATTERN_3: pattern_idx = 3; break;
+				default: pattern_idx = 0; break;
+			}
+			u16 pattern_offset = pattern_idx * PATTERN_SIZE;
 			s16* pattern = m_const_patterns.data() + pattern_offset;
 
 			u32 pos = vpb->current_pos_frac << 6;  // log2(PATTERN_SIZE)
 			u32 step = vpb->resampling_ratio << 5;
 
-			for (size_t i = 0; i < buffer->size(); ++i)
+			// Only the variable step pattern needs a different loop; keep the
+			// check out of the per-sample path.
+			if (vpb->samples_source_type == VPB::SRC_CONST_PATTERN_0_VARIABLE_STEP)
 			{
-				(*buffer)[i] = pattern[pos >> 16];
-				pos = (pos + step) % (PATTERN_SIZE << 16);
-				if (pattern_info.variable_step)
+				for (size_t i = 0; i < buffer->size(); ++i)
+				{
+					(*buffer)[i] = pattern[pos >> 16];
+					pos = (pos + step) % (PATTERN_SIZE << 16);
 					pos = ((pos << 10) + m_buf_back_right[i] * vpb->resampling_ratio) >> 10;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < buffer->size(); ++i)
+				{
+					(*buffer)[i] = pattern[pos >> 16];
+					pos = (pos + step) % (PATTERN_SIZE << 16);
+				}
 			}
 
 			vpb->current_pos_frac = pos >> 6;
@@ -1430,25 +1660,8 @@ void ZeldaAudioRenderer::Resample(VPB* vpb, const s16* src, MixingBuffer* dst)
 	}
 	else
 	{
-		for (auto& dst_sample : *dst)
-		{
-			// We have 0x40 * 4 coeffs that need to be selected based on the
-			// most significant bits of the fractional part of the position. 12
-			// bits >> 6 = 6 bits = 0x40. Multiply by 4 since there are 4
-			// consecutive coeffs.
-			u32 coeffs_idx = ((pos & 0xFFF) >> 6) * 4;
-			const s16* coeffs = &m_resampling_coeffs[coeffs_idx];
-			const s16* input = &src[pos >> 12];
-
-			s64 dst_sample_unclamped = 0;
-			for (size_t i = 0; i < 4; ++i)
-				dst_sample_unclamped += (s64)2 * coeffs[i] * input[i];
-			dst_sample_unclamped >>= 16;
-
-			dst_sample = (s16)MathUtil::Clamp<s64>(dst_sample_unclamped, -0x8000, 0x7FFF);
-
-			pos += ratio;
-		}
+		pos = ResampleInterpolated(dst->data(), src, dst->size(), pos, ratio,
+		                           m_resampling_coeffs.data(), m_resampling_coeffs_fit_s32);
 	}
 
 	for (u32 i = 0; i < 4; ++i)
@@ -1771,6 +1984,8 @@ void ZeldaAudioRenderer::DoState(PointerWrap& p)
 	p.Do(m_buf_unk2);
 
 	p.Do(m_resampling_coeffs);
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		UpdateResamplingCoeffsRange();
 	p.Do(m_const_patterns);
 	p.Do(m_sine_table);
 	p.Do(m_afc_coeffs);
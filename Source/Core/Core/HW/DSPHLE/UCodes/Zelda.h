@@ -18,7 +18,11 @@ public:
 	void SetFlags(u32 flags) { m_flags = flags; }
 	void SetSineTable(std::array<s16, 0x80>&& sine_table) { m_sine_table = sine_table; }
 	void SetConstPatterns(std::array<s16, 0x100>&& patterns) { m_const_patterns = patterns; }
-	void SetResamplingCoeffs(std::array<s16, 0x100>&& coeffs) { m_resampling_coeffs = coeffs; }
+	void SetResamplingCoeffs(std::array<s16, 0x100>&& coeffs)
+	{
+		m_resampling_coeffs = coeffs;
+		UpdateResamplingCoeffsRange();
+	}
 	void SetAfcCoeffs(std::array<s16, 0x20>&& coeffs) { m_afc_coeffs = coeffs; }
 	void SetVPBBaseAddress(u32 addr) { m_vpb_base_addr = addr; }
 	void SetReverbPBBaseAddress(u32 addr) { m_reverb_pb_base_addr = addr; }
@@ -29,6 +33,30 @@ public:
 
 	void DoState(PointerWrap& p);
 
+	// Mixing primitives working on whole buffers, vectorized where the host
+	// allows it. They give the same results as the scalar loops of the UCode.
+
+	// Adds src to dst with a volume ramping from vol by step after each
+	// sample. The volume is in 1.31 format, of which only the top 16 bits are
+	// used. Returns the volume after the last sample.
+	static s32 AddBuffersWithVolumeRamp(s16* dst, const s16* src, size_t count, s32 vol, s32 step);
+
+	// Adds src to dst with a 1.15 volume (which can go up to 2.0 since it is
+	// unsigned), clamping the scaled samples.
+	static void AddBuffersWithVolume(s16* dst, const s16* src, size_t count, u16 vol);
+
+	// Applies the 8-tap reverb filter in place: buffer holds count + 8
+	// samples, of which the first count are replaced by the filtered output.
+	static void ApplyReverbFilter(s16* buffer, size_t count, const s16* coeffs);
+
+	// Resamples count samples with 4-tap interpolation, selecting the taps
+	// from coeffs (0x40 sets of 4) with the fractional part of pos. pos and
+	// ratio are 20.12 fixed point. Returns the position after the last sample.
+	// If coeffs_fit_s32 is set, the taps of every set have absolute values
+	// adding up to at most 0x8000, which allows 32-bit accumulation.
+	static u32 ResampleInterpolated(s16* dst, const s16* src, size_t count, u32 pos, u32 ratio,
+	                                const s16* coeffs, bool coeffs_fit_s32);
+
 private:
 	struct VPB;
 
@@ -71,27 +99,7 @@ private:
 	                             const std::array<s16, N>& src,
 	                             s32 vol, s32 step)
 	{
-		if (!vol && !step)
-			return vol;
-
-		for (size_t i = 0; i < N; ++i)
-		{
-			(*dst)[i] += ((vol >> 16) * src[i]) >> 16;
-			vol += step;
-		}
-
-		return vol;
-	}
-
-	// Does not use std::array because it needs to be able to process partial
-	// buffers. Volume is in 1.15 format.
-	void AddBuffersWithVolume(s16* dst, const s16* src, size_t count, u16 vol)
-	{
-		while (count--)
-		{
-			s32 vol_src = ((s32)*src++ * (s32)vol) >> 15;
-			*dst++ += MathUtil::Clamp(vol_src, -0x8000, 0x7FFF);
-		}
+		return AddBuffersWithVolumeRamp(dst->data(), src.data(), N, vol, step);
 	}
 
 	// Whether the frame needs to be prepared or not.
@@ -151,6 +159,12 @@ private:
 	// Coefficients used for resampling.
 	std::array<s16, 0x100> m_resampling_coeffs{};
 
+	// Whether the resampling coefficients are small enough for the resampler
+	// to accumulate in 32 bits, as expected of interpolation taps adding up to
+	// about 1.0.
+	bool m_resampling_coeffs_fit_s32 = false;
+	void UpdateResamplingCoeffsRange();
+
 	// If non zero, base MRAM address for sound data transfers from ARAM. On
 	// the Wii, this points to some MRAM location since there is no ARAM to be
 	// used. If zero, use the top of ARAM.
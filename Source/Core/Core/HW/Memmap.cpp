@@ -8,8 +8,16 @@
 // However, if a JITed instruction (for example lwz) wants to access a bad memory area that call
 // may be redirected here (for example to Read_U32()).
 
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Common/MemArena.h"
@@ -17,6 +25,7 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
+#include "Core/MemTools.h"
 #include "Core/Debugger/Debugger_SymbolMap.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HW/AudioInterface.h"
@@ -167,6 +176,32 @@ static MemoryView views[] =
 };
 static const int num_views = sizeof(views) / sizeof(MemoryView);
 
+// Write tracking state, one entry per tracked page. The pages are the host's,
+// since that is the granularity of the protection, but at least 4KB.
+static const u32 MIN_TRACKING_PAGE_SHIFT = 12;
+static const u32 MAX_TRACKED_PAGES = (RAM_SIZE + EXRAM_SIZE) >> MIN_TRACKING_PAGE_SHIFT;
+
+static std::atomic<bool> s_write_tracking(false);
+static u32 s_tracking_page_shift = MIN_TRACKING_PAGE_SHIFT;
+// Incremented on every recorded write; the pages remember the value of their
+// last write. Compared with serial number arithmetic, so that wrapping around
+// is harmless.
+static std::atomic<u32> s_write_counter(0);
+static std::atomic<u32> s_page_last_write[MAX_TRACKED_PAGES];
+static std::atomic<bool> s_page_protected[MAX_TRACKED_PAGES];
+// Held while protecting or unprotecting pages. A spinlock, since it is taken
+// by the exception handler too.
+static std::atomic_flag s_tracking_lock = ATOMIC_FLAG_INIT;
+// The number of HostWriteScopes, no pages are protected while there are any.
+// Only changed with s_tracking_lock held.
+static std::atomic<int> s_host_writes(0);
+
+static void ResetWriteTracking()
+{
+	for (std::atomic<bool>& p : s_page_protected)
+		p.store(false);
+}
+
 void Init()
 {
 	bool wii = SConfig::GetInstance().bWii;
@@ -219,6 +254,7 @@ void Shutdown()
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
 	MemoryMap_Shutdown(views, num_views, flags, &g_arena);
 	g_arena.ReleaseSHMSegment();
+	ResetWriteTracking();
 	physical_base = nullptr;
 	logical_base = nullptr;
 	delete mmio_mapping;
@@ -235,6 +271,253 @@ void Clear()
 		memset(m_pEXRAM, 0, EXRAM_SIZE);
 }
 
+namespace
+{
+class TrackingLock
+{
+public:
+	TrackingLock() { while (s_tracking_lock.test_and_set(std::memory_order_acquire)) {} }
+	~TrackingLock() { s_tracking_lock.clear(std::memory_order_release); }
+};
+}
+
+static u32 GetHostPageSize()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return (u32)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+// The first of the views of a region, the others being its mirrors.
+static int FindRegionView(u8** region)
+{
+	int i = 0;
+	while (views[i].out_ptr != region)
+		++i;
+	return i;
+}
+
+// Finds the views of the RAM or EXRAM region the address lies in, and the
+// offset and first tracked page of the address in it.
+static bool GetTrackedRegion(u32 address, int* first_view, u32* offset, u32* first_page)
+{
+	address &= 0x3FFFFFFF;
+	if (address < REALRAM_SIZE)
+	{
+		*first_view = FindRegionView(&m_pRAM);
+		*offset = address;
+		*first_page = 0;
+		return true;
+	}
+	if (SConfig::GetInstance().bWii && (address >> 28) == 0x1 && (address & 0x0fffffff) < EXRAM_SIZE)
+	{
+		*first_view = FindRegionView(&m_pEXRAM);
+		*offset = address & EXRAM_MASK;
+		*first_page = RAM_SIZE >> s_tracking_page_shift;
+		return true;
+	}
+	return false;
+}
+
+// Changes the protection of pages of a region in each of its views. The
+// mirrors only have their own mapping on 64-bit hosts.
+static void ProtectPages(int first_view, u32 offset, u32 size, bool protect)
+{
+	int i = first_view;
+	do
+	{
+		if (views[i].mapped_ptr)
+		{
+			u8* ptr = (u8*)views[i].mapped_ptr + offset;
+			if (protect)
+				WriteProtectMemory(ptr, size);
+			else
+				UnWriteProtectMemory(ptr, size);
+		}
+		++i;
+	} while (i < num_views && (views[i].flags & MV_MIRROR_PREVIOUS));
+}
+
+bool SetWriteTracking(bool enable)
+{
+	if (enable == s_write_tracking.load())
+		return true;
+
+	if (enable)
+	{
+		// The Mach exception handler only sees the faults of the CPU thread,
+		// but the GPU thread writes to RAM too.
+#if defined(__APPLE__) && !defined(USE_SIGACTION_ON_APPLE)
+		return false;
+#else
+		if (!EMM::g_exception_handlers_supported)
+			return false;
+		const u32 page_size = GetHostPageSize();
+		if (page_size & (page_size - 1) || page_size > EXRAM_SIZE)
+			return false;
+		s_tracking_page_shift = MIN_TRACKING_PAGE_SHIFT;
+		while ((1u << s_tracking_page_shift) < page_size)
+			++s_tracking_page_shift;
+
+		// The handler stays installed when tracking is turned off. Installing it
+		// again would allocate another signal stack every time.
+		static bool handler_installed = false;
+		if (!handler_installed)
+		{
+			EMM::InstallExceptionHandler();
+			handler_installed = true;
+		}
+		s_write_tracking.store(true);
+		INFO_LOG(MEMMAP, "Tracking RAM writes with %u byte pages", 1u << s_tracking_page_shift);
+		return true;
+#endif
+	}
+
+	TrackingLock lock;
+	if (m_IsInitialized)
+	{
+		const u32 page_size = 1u << s_tracking_page_shift;
+		const u32 ram_pages = RAM_SIZE >> s_tracking_page_shift;
+		for (u32 page = 0; page < MAX_TRACKED_PAGES; ++page)
+		{
+			if (!s_page_protected[page].load())
+				continue;
+			if (page < ram_pages)
+				ProtectPages(FindRegionView(&m_pRAM), page << s_tracking_page_shift, page_size, false);
+			else
+				ProtectPages(FindRegionView(&m_pEXRAM), (page - ram_pages) << s_tracking_page_shift, page_size, false);
+		}
+	}
+	ResetWriteTracking();
+	s_write_tracking.store(false);
+	return true;
+}
+
+bool IsWriteTrackingEnabled()
+{
+	return s_write_tracking.load();
+}
+
+u32 TrackWrites(u32 address, u32 size)
+{
+	int first_view;
+	u32 offset, first_page;
+	if (!s_write_tracking.load() || !m_IsInitialized || !size ||
+	    !GetTrackedRegion(address, &first_view, &offset, &first_page))
+		return s_write_counter.load();
+
+	TrackingLock lock;
+	const u32 token = s_write_counter.load();
+	// The pages stay unprotected, so WrittenSince doesn't trust the token.
+	if (!s_write_tracking.load() || s_host_writes.load() > 0)
+		return token;
+	const u32 shift = s_tracking_page_shift;
+	const u32 end_page = (offset + size - 1) >> shift;
+	for (u32 page = offset >> shift; page <= end_page; ++page)
+	{
+		// Consecutive unprotected pages are protected with one call.
+		if (s_page_protected[first_page + page].load())
+			continue;
+		u32 last = page;
+		while (last < end_page && !s_page_protected[first_page + last + 1].load())
+			++last;
+		ProtectPages(first_view, page << shift, (last - page + 1) << shift, true);
+		for (u32 p = page; p <= last; ++p)
+			s_page_protected[first_page + p].store(true);
+		page = last;
+	}
+	return token;
+}
+
+bool WrittenSince(u32 address, u32 size, u32 token)
+{
+	int first_view;
+	u32 offset, first_page;
+	if (!s_write_tracking.load() || !m_IsInitialized || !size ||
+	    !GetTrackedRegion(address, &first_view, &offset, &first_page))
+		return true;
+
+	const u32 shift = s_tracking_page_shift;
+	const u32 end_page = (offset + size - 1) >> shift;
+	for (u32 page = offset >> shift; page <= end_page; ++page)
+	{
+		if (!s_page_protected[first_page + page].load() ||
+		    (s32)(s_page_last_write[first_page + page].load() - token) > 0)
+			return true;
+	}
+	return false;
+}
+
+static void RecordWrite(int first_view, u32 page_index, u32 page_offset)
+{
+	s_page_last_write[page_index].store(s_write_counter.fetch_add(1) + 1);
+	if (s_page_protected[page_index].load())
+	{
+		ProtectPages(first_view, page_offset, 1u << s_tracking_page_shift, false);
+		s_page_protected[page_index].store(false);
+	}
+}
+
+bool HandleWriteFault(uintptr_t fault_address)
+{
+	// Not checking whether tracking is enabled: it could have been disabled
+	// while this fault was on its way. RAM is never protected otherwise.
+	if (!m_IsInitialized)
+		return false;
+
+	int region_view = -1;
+	for (int i = 0; i < num_views; ++i)
+	{
+		if (views[i].out_ptr == &m_pRAM || views[i].out_ptr == &m_pEXRAM)
+			region_view = i;
+		else if (!(views[i].flags & MV_MIRROR_PREVIOUS))
+			region_view = -1;
+
+		const uintptr_t base = (uintptr_t)views[i].mapped_ptr;
+		if (region_view < 0 || !base || fault_address < base || fault_address - base >= views[i].size)
+			continue;
+
+		const u32 offset = (u32)(fault_address - base) & ~((1u << s_tracking_page_shift) - 1);
+		u32 page = offset >> s_tracking_page_shift;
+		if (views[region_view].out_ptr == &m_pEXRAM)
+			page += RAM_SIZE >> s_tracking_page_shift;
+
+		TrackingLock lock;
+		RecordWrite(region_view, page, offset);
+		// Another thread could have lifted the protection already, in which
+		// case the write simply succeeds when retried.
+		return true;
+	}
+	return false;
+}
+
+HostWriteScope::HostWriteScope(u32 address, size_t size)
+{
+	TrackingLock lock;
+	s_host_writes++;
+
+	int first_view;
+	u32 offset, first_page;
+	if (!s_write_tracking.load() || !m_IsInitialized || !size ||
+	    !GetTrackedRegion(address, &first_view, &offset, &first_page))
+		return;
+
+	const u32 shift = s_tracking_page_shift;
+	const u32 end_page = std::min<u32>(offset + (u32)size - 1, views[first_view].size - 1) >> shift;
+	for (u32 page = offset >> shift; page <= end_page; ++page)
+		RecordWrite(first_view, first_page + page, page << shift);
+}
+
+HostWriteScope::~HostWriteScope()
+{
+	TrackingLock lock;
+	s_host_writes--;
+}
+
 bool AreMemoryBreakpointsActivated()
 {
 #ifdef ENABLE_MEM_CHECK
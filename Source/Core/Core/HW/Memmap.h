@@ -92,4 +92,35 @@ void Write_U64(const u64 var, const u32 address);
 void Write_U32_Swap(const u32 var, const u32 address);
 void Write_U64_Swap(const u64 var, const u32 address);
 
+// Write tracking, used by the texture cache to avoid rehashing textures whose
+// memory has not been written. Pages of RAM and EXRAM are write protected in
+// every view, and the first write to one afterwards is recorded by the
+// exception handler, which then lifts the protection.
+//
+// Returns whether tracking could be enabled; it needs an exception handler
+// which sees the faults of every thread.
+bool SetWriteTracking(bool enable);
+bool IsWriteTrackingEnabled();
+// Protects the pages covering the range and returns a token for WrittenSince.
+// Take the token before reading the memory.
+u32 TrackWrites(u32 address, u32 size);
+// Whether any page of the range may have been written after the token was
+// taken.
+bool WrittenSince(u32 address, u32 size, u32 token);
+bool HandleWriteFault(uintptr_t fault_address);
+// The kernel fails writes to protected pages instead of raising a fault, so
+// code passing emulated memory to a system call that writes into it (reading
+// files or sockets) has to hold one of these across the call. It lifts the
+// protection of the range, and keeps TrackWrites from protecting any page
+// until it is destroyed.
+class HostWriteScope
+{
+public:
+	HostWriteScope(u32 address, size_t size);
+	~HostWriteScope();
+
+	HostWriteScope(const HostWriteScope&) = delete;
+	HostWriteScope& operator=(const HostWriteScope&) = delete;
+};
+
 }
@@ -7,41 +7,75 @@
 #include "Common/MathUtil.h"
 #include "Core/HW/StreamADPCM.h"
 
+#if defined(_M_X86) && !defined(_M_GENERIC)
+#include <emmintrin.h>
+#endif
+
 // STATE_TO_SAVE (not saved yet!)
 static s32 histl1;
 static s32 histl2;
 static s32 histr1;
 static s32 histr2;
 
-static s16 ADPDecodeSample(s32 bits, s32 q, s32& hist1, s32& hist2)
+// Predictor coefficients for the filters a block header can select. Filters 4
+// to 15 don't predict at all, like filter 0.
+static const s32 s_filter_coefs[4][2] = {
+	{ 0x00,  0x00 },
+	{ 0x3c,  0x00 },
+	{ 0x73, -0x34 },
+	{ 0x62, -0x37 },
+};
+
+// Decodes one channel of a block. The header is only looked at once, and the
+// 4-bit samples are unpacked and shifted for the whole block before running
+// the predictor, which is the only part that depends on the previous sample.
+static void DecodeChannel(s16* pcm, const u8* adpcm, bool high_nibbles, u8 header, s32& hist1, s32& hist2)
 {
-	s32 hist = 0;
-	switch (q >> 4)
+	const u8* data = adpcm + (NGCADPCM::ONE_BLOCK_SIZE - NGCADPCM::SAMPLES_PER_BLOCK);
+	const int shift = header & 0xf;
+	s32 deltas[NGCADPCM::SAMPLES_PER_BLOCK];
+
+	int i = 0;
+#if defined(_M_X86) && !defined(_M_GENERIC)
+	const __m128i shift_count = _mm_cvtsi32_si128(shift);
+	for (; i + 8 <= NGCADPCM::SAMPLES_PER_BLOCK; i += 8)
 	{
-	case 0:
-		hist = 0;
-		break;
-	case 1:
-		hist = (hist1 * 0x3c);
-		break;
-	case 2:
-		hist = (hist1 * 0x73) - (hist2 * 0x34);
-		break;
-	case 3:
-		hist = (hist1 * 0x62) - (hist2 * 0x37);
-		break;
+		__m128i bytes = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&data[i]), _mm_setzero_si128());
+		// Move the nibble to the top of each word to sign extend it, as the
+		// (s16)(bits << 12) does below.
+		__m128i words = high_nibbles ? _mm_slli_epi16(_mm_srli_epi16(bytes, 4), 12) : _mm_slli_epi16(bytes, 12);
+		words = _mm_sra_epi16(words, shift_count);
+		__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+		__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+		_mm_storeu_si128((__m128i*)&deltas[i], _mm_slli_epi32(lo, 6));
+		_mm_storeu_si128((__m128i*)&deltas[i + 4], _mm_slli_epi32(hi, 6));
+	}
+#endif
+	for (; i < NGCADPCM::SAMPLES_PER_BLOCK; i++)
+	{
+		s32 bits = high_nibbles ? (data[i] >> 4) : (data[i] & 0xf);
+		deltas[i] = ((s16)(bits << 12) >> shift) * 64;
 	}
-	hist = MathUtil::Clamp((hist + 0x20) >> 6, -0x200000, 0x1fffff);
 
-	s32 cur = (((s16)(bits << 12) >> (q & 0xf)) << 6) + hist;
+	const int filter = header >> 4;
+	const s32 coef1 = filter < 4 ? s_filter_coefs[filter][0] : 0;
+	const s32 coef2 = filter < 4 ? s_filter_coefs[filter][1] : 0;
 
-	hist2 = hist1;
-	hist1 = cur;
+	for (i = 0; i < NGCADPCM::SAMPLES_PER_BLOCK; i++)
+	{
+		s32 hist = (hist1 * coef1) + (hist2 * coef2);
+		hist = MathUtil::Clamp((hist + 0x20) >> 6, -0x200000, 0x1fffff);
 
-	cur >>= 6;
-	cur = MathUtil::Clamp(cur, -0x8000, 0x7fff);
+		s32 cur = deltas[i] + hist;
 
-	return (s16)cur;
+		hist2 = hist1;
+		hist1 = cur;
+
+		cur >>= 6;
+		cur = MathUtil::Clamp(cur, -0x8000, 0x7fff);
+
+		pcm[i * 2] = (s16)cur;
+	}
 }
 
 void NGCADPCM::InitFilter()
@@ -54,9 +88,6 @@ void NGCADPCM::InitFilter()
 
 void NGCADPCM::DecodeBlock(s16 *pcm, const u8 *adpcm)
 {
-	for (int i = 0; i < SAMPLES_PER_BLOCK; i++)
-	{
-		pcm[i * 2]     = ADPDecodeSample(adpcm[i + (ONE_BLOCK_SIZE - SAMPLES_PER_BLOCK)] & 0xf, adpcm[0], histl1, histl2);
-		pcm[i * 2 + 1] = ADPDecodeSample(adpcm[i + (ONE_BLOCK_SIZE - SAMPLES_PER_BLOCK)] >> 4,  adpcm[1], histr1, histr2);
-	}
+	DecodeChannel(pcm, adpcm, false, adpcm[0], histl1, histl2);
+	DecodeChannel(pcm + 1, adpcm, true, adpcm[1], histr1, histr2);
 }
@@ -401,6 +401,7 @@ u32 CWII_IPC_HLE_Device_sdio_slot0::ExecuteCommand(u32 _BufferIn, u32 _BufferInS
 				ERROR_LOG(WII_IPC_SD, "Seek failed WTF");
 
 
+			Memory::HostWriteScope host_write(req.addr, size);
 			if (m_Card.ReadBytes(Memory::GetPointer(req.addr), size))
 			{
 				DEBUG_LOG(WII_IPC_SD, "Outbuffer size %i got %i", _rwBufferSize, size);
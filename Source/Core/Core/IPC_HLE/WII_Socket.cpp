@@ -491,9 +491,13 @@ void WiiSocket::Update(bool read, bool write, bool except)
 					}
 #endif
 					socklen_t addrlen = sizeof(sockaddr_in);
-					int ret = recvfrom(fd, data, data_len, flags,
-									BufferOutSize2 ? (struct sockaddr*) &local_name : nullptr,
-									BufferOutSize2 ? &addrlen : nullptr);
+					int ret;
+					{
+						Memory::HostWriteScope host_write(BufferOut, data_len);
+						ret = recvfrom(fd, data, data_len, flags,
+						               BufferOutSize2 ? (struct sockaddr*) &local_name : nullptr,
+						               BufferOutSize2 ? &addrlen : nullptr);
+					}
 					ReturnValue = WiiSockMan::GetNetErrorCode(ret, BufferOutSize2 ? "SO_RECVFROM" : "SO_RECV", true);
 
 					INFO_LOG(WII_IPC_NET, "%s(%d, %p) Socket: %08X, Flags: %08X, "
@@ -45,6 +45,11 @@ LONG NTAPI Handler(PEXCEPTION_POINTERS pPtrs)
 			uintptr_t badAddress = (uintptr_t)pPtrs->ExceptionRecord->ExceptionInformation[1];
 			CONTEXT *ctx = pPtrs->ContextRecord;
 
+			if (accessType == 1 && Memory::HandleWriteFault(badAddress))
+			{
+				return (DWORD)EXCEPTION_CONTINUE_EXECUTION;
+			}
+
 			if (JitInterface::HandleFault(badAddress, ctx))
 			{
 				return (DWORD)EXCEPTION_CONTINUE_EXECUTION;
@@ -237,6 +242,10 @@ static void sigsegv_handler(int sig, siginfo_t *info, void *raw_context)
 	}
 	uintptr_t bad_address = (uintptr_t)info->si_addr;
 
+	// Writes to RAM pages protected for write tracking.
+	if (sicode == SEGV_ACCERR && Memory::HandleWriteFault(bad_address))
+		return;
+
 	// Get all the information we can out of the context.
 	mcontext_t *ctx = &context->uc_mcontext;
 	// assume it's not a write
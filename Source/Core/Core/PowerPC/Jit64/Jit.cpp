@@ -2,6 +2,7 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -208,6 +209,14 @@ void Jit64::Init()
 	code_block.m_gpa = &js.gpa;
 	code_block.m_fpa = &js.fpa;
 	EnableOptimization();
+
+	// Branch following is decided per block, and saved with each block instead.
+	m_block_profile.Init(analyzer.GetOptions() & ~PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+
+	m_tiered = SConfig::GetInstance().bJITTiered && !SConfig::GetInstance().bEnableDebugging;
+	js.hotBlocks.clear();
+	js.traceBlocks.clear();
+	js.coldBlock = false;
 }
 
 void Jit64::ClearCache()
@@ -222,6 +231,8 @@ void Jit64::ClearCache()
 
 void Jit64::Shutdown()
 {
+	m_block_profile.Shutdown();
+
 	FreeStack();
 	FreeCodeSpace();
 
@@ -278,6 +289,19 @@ void Jit64::DoNothing(UGeckoInstruction _inst)
 	// Yup, just don't do anything.
 }
 
+// Number of runs after which a cold block gets recompiled normally, when tiered compilation is on.
+static const u32 TIER_UP_THRESHOLD = 64;
+// Number of runs after which a block counts as hot without tiered compilation. The block profile
+// then saves it, and it may become a trace.
+static const u32 HOT_THRESHOLD = TIER_UP_THRESHOLD;
+// A hot block becomes a trace if at least this many percent of its runs reached the unconditional
+// branch ending it. Otherwise following the branch would mostly compile code that doesn't run.
+static const u32 TRACE_BRANCH_PERCENT = 75;
+// Number of guest instructions checked and compiled from the block profile per dispatcher miss.
+static const u32 PRECOMPILE_BUDGET = 1024;
+// Maximum number of GPRs passed in host registers by direct links into a block
+static const size_t MAX_BOUND_GPRS = 4;
+
 static const bool ImHereDebug = false;
 static const bool ImHereLog = false;
 static std::map<u32, int> been_here;
@@ -344,6 +368,43 @@ void Jit64::WriteExit(u32 destination, bool bl, u32 after)
 	JustWriteExit(destination, bl, after);
 }
 
+void Jit64::FlushAndWriteExit(u32 destination, FlushMode mode, bool bl, u32 after)
+{
+	fpr.Flush(mode);
+
+	// Cleanup() calls out to C++, which would clobber the registers being passed.
+	bool needs_cleanup = (jo.optimizeGatherPipe && js.fifoBytesThisBlock > 0) || MMCR0.Hex || MMCR1.Hex;
+
+	const JitBlock* target = nullptr;
+	if (!bl && jo.enableBlocklink && !needs_cleanup)
+	{
+		if (destination == js.blockStart)
+		{
+			target = js.curBlock;
+		}
+		else
+		{
+			int block = blocks.GetBlockNumberFromStartAddress(destination);
+			if (block >= 0 && blocks.GetBlock(block)->boundEntry)
+			{
+				target = blocks.GetBlock(block);
+				js.curBlock->boundLinks.push_back(block);
+			}
+		}
+	}
+
+	if (!target || !target->boundEntry)
+	{
+		gpr.Flush(mode);
+		WriteExit(destination, bl, after);
+		return;
+	}
+
+	gpr.FlushToBinding(target->boundRegs, mode);
+	SUB(32, PPCSTATE(downcount), Imm32(js.downcountAmount));
+	JMP(target->boundEntry, true);
+}
+
 void Jit64::JustWriteExit(u32 destination, bool bl, u32 after)
 {
 	//If nobody has taken care of this yet (this can be removed when all branches are done)
@@ -510,6 +571,14 @@ void Jit64::Jit(u32 em_address)
 		ClearCache();
 	}
 
+	if (m_block_profile.IsActive())
+	{
+		PrecompileProfiledBlocks();
+		// The batch may well have included the block the dispatcher is asking for.
+		if (blocks.GetBlockNumberFromStartAddress(em_address) >= 0)
+			return;
+	}
+
 	int blockSize = code_buffer.GetSize();
 
 	if (SConfig::GetInstance().bEnableDebugging)
@@ -536,6 +605,9 @@ void Jit64::Jit(u32 em_address)
 		}
 	}
 
+	js.coldBlock = m_tiered && !js.hotBlocks.count(em_address);
+	UpdateBranchFollowing(em_address, blockSize);
+
 	// Analyze the block, collect all instructions it is made of (including inlining,
 	// if that is enabled), reorder instructions for optimal performance, and join joinable instructions.
 	u32 nextPC = analyzer.Analyze(em_address, &code_block, &code_buffer, blockSize);
@@ -550,9 +622,147 @@ void Jit64::Jit(u32 em_address)
 		return;
 	}
 
+	// With tiered compilation, a block that isn't cold has already run TIER_UP_THRESHOLD times,
+	// and a trace has only been formed for a block that turned out to be hot. Otherwise the block
+	// counts its runs to find out.
+	bool hot = m_tiered ? !js.coldBlock : js.traceBlocks.count(em_address) != 0;
+	m_count_runs = !hot && !m_tiered;
+
 	int block_num = blocks.AllocateBlock(em_address);
 	JitBlock *b = blocks.GetBlock(block_num);
 	blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(em_address, &code_buffer, b, nextPC));
+	m_count_runs = false;
+	// The profile only checks the code at the entry point; the rest of a trace is re-analyzed anyway.
+	m_block_profile.AddBlock(em_address, b->segments[0].second, analyzer.GetOptions());
+	if (hot)
+		m_block_profile.MarkHot(em_address);
+}
+
+static bool IsTraceWorthy(const JitBlock* b)
+{
+	return (u64)b->branchCount * 100 >= (u64)b->runCount * TRACE_BRANCH_PERCENT;
+}
+
+// Called from a block that isn't cold once it has hit HOT_THRESHOLD runs. If the block should be a
+// trace, it's retired so that the dispatcher recompiles it as one, and this returns nonzero.
+// Otherwise the block stays, and the block profile saves it.
+u32 Jit64::BlockTurnedHot(Jit64* jit64, u32 address)
+{
+	int block_num = jit64->blocks.GetBlockNumberFromStartAddress(address);
+	if (block_num >= 0 && IsTraceWorthy(jit64->blocks.GetBlock(block_num)))
+	{
+		// The trace is saved to the profile once it's compiled.
+		jit64->js.traceBlocks.insert(address);
+		jit64->blocks.RetireBlock(block_num);
+		return 1;
+	}
+
+	jit64->m_block_profile.MarkHot(address);
+	return 0;
+}
+
+// Called from a cold block that has hit TIER_UP_THRESHOLD runs. Destroying the block sends it and
+// everything linked to it back to the dispatcher, which then recompiles it hot.
+void Jit64::TierUpBlock(Jit64* jit64, u32 address)
+{
+	// Only the cold block itself goes away. Its code is unchanged, so hot traces that run through
+	// it stay compiled and stay hot, and the icache and FIFO write state are left as they are.
+	int block_num = jit64->blocks.GetBlockNumberFromStartAddress(address);
+	if (block_num >= 0)
+	{
+		if (IsTraceWorthy(jit64->blocks.GetBlock(block_num)))
+			jit64->js.traceBlocks.insert(address);
+		jit64->blocks.RetireBlock(block_num);
+	}
+	jit64->js.hotBlocks.insert(address);
+}
+
+// Lets direct links from other blocks pass the most used GPRs this block reads before writing in
+// host registers. The normal entry loads them from ppcState; the bound entry skips the loads.
+void Jit64::BindEntryRegisters(JitBlock* b)
+{
+	const PPCAnalyst::BlockRegStats& stats = js.gpa;
+	std::vector<size_t> pregs;
+	BitSet32 written;
+	for (size_t i = 0; i < 32; i++)
+	{
+		written[i] = stats.numWrites[i] > 0;
+		if (stats.firstRead[i] != -1 && (stats.firstWrite[i] == -1 || stats.firstRead[i] <= stats.firstWrite[i]))
+			pregs.push_back(i);
+	}
+	if (pregs.empty())
+		return;
+
+	std::stable_sort(pregs.begin(), pregs.end(), [&stats](size_t x, size_t y) {
+		return stats.GetTotalNumAccesses((int)x) > stats.GetTotalNumAccesses((int)y);
+	});
+	if (pregs.size() > MAX_BOUND_GPRS)
+		pregs.resize(MAX_BOUND_GPRS);
+
+	b->boundRegs = gpr.BindOnEntry(pregs, written);
+	const u8* bound_start = GetCodePtr();
+
+	SwitchToFarCode();
+		// The caller did the downcount subtraction, so do the check here too. doTiming and the
+		// dispatcher only look at ppcState.
+		b->boundEntry = GetCodePtr();
+		J_CC(CC_NBE, bound_start);
+		WriteBoundRegsBack(b->boundRegs);
+		MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+		JMP(asm_routines.doTiming, true);
+
+		b->boundSpill = GetCodePtr();
+		WriteBoundRegsBack(b->boundRegs);
+		MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+		JMP(asm_routines.dispatcher, true);
+	SwitchToNearCode();
+}
+
+void Jit64::WriteBoundRegsBack(const std::vector<JitBlock::BoundReg>& binding)
+{
+	for (const auto& reg : binding)
+	{
+		if (reg.dirty)
+			MOV(32, PPCSTATE(gpr[reg.guestReg]), R((X64Reg)reg.hostReg));
+	}
+}
+
+// Compiles a handful of the blocks recorded on previous runs. This is done a few at a time from
+// Jit() so that the work is spread over the dispatcher misses the game takes anyway, rather than
+// stalling in one go. PRECOMPILE_BUDGET bounds the work for each miss, including the hashing of
+// stale entries that get skipped.
+void Jit64::PrecompileProfiledBlocks()
+{
+	u32 budget = PRECOMPILE_BUDGET;
+	while (budget > 0)
+	{
+		// Never let precompilation be the reason the cache gets cleared.
+		if (IsAlmostFull() || farcode.IsAlmostFull() || trampolines.IsAlmostFull() || blocks.IsFull())
+			return;
+
+		u32 address, block_options;
+		if (!m_block_profile.PopPendingBlock(blocks, &budget, &address, &block_options))
+			return;
+
+		// The profile only has blocks that were hot on a previous run, so they go straight to the
+		// hot tier, and those that were traces become traces again.
+		if (m_tiered)
+			js.hotBlocks.insert(address);
+		if (block_options & PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW)
+			js.traceBlocks.insert(address);
+		js.coldBlock = m_tiered && !js.hotBlocks.count(address);
+		UpdateBranchFollowing(address, code_buffer.GetSize());
+
+		u32 nextPC = analyzer.Analyze(address, &code_block, &code_buffer, code_buffer.GetSize());
+		budget -= std::min(budget, code_block.m_num_instructions);
+		// Unlike Jit(), nothing is executing this address yet, so there's no exception to raise.
+		if (code_block.m_memory_exception)
+			continue;
+
+		int block_num = blocks.AllocateBlock(address);
+		JitBlock *b = blocks.GetBlock(block_num);
+		blocks.FinalizeBlock(block_num, jo.enableBlocklink, DoJit(address, &code_buffer, b, nextPC));
+	}
 }
 
 const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBlock *b, u32 nextPC)
@@ -570,6 +780,16 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	const u8 *start = AlignCode4(); // TODO: Test if this or AlignCode16 make a difference from GetCodePtr
 	b->checkedEntry = start;
 	b->runCount = 0;
+	b->branchCount = 0;
+
+	// Whether to count the runs that reach the unconditional branch ending the block, to decide
+	// whether to follow it once the block is hot.
+	bool count_branch = false;
+	if (m_can_trace && (js.coldBlock || m_count_runs) && code_block.m_num_instructions > 0)
+	{
+		UGeckoInstruction last = ops[code_block.m_num_instructions - 1].inst;
+		count_branch = last.OPCD == 18 && !last.LK;
+	}
 
 	// Downcount flag check. The last block decremented downcounter, and the flag should still be available.
 	FixupBranch skip = J_CC(CC_NBE);
@@ -598,6 +818,49 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 		// get start tic
 		PROFILER_QUERY_PERFORMANCE_COUNTER(&b->ticStart);
 	}
+	if (js.coldBlock)
+	{
+		// Count runs of the cold block, and tier it up once it turns out to be hot.
+		MOV(64, R(RSCRATCH), Imm64((u64)&b->runCount));
+		if (!Profiler::g_ProfileBlocks)
+			ADD(32, MatR(RSCRATCH), Imm8(1));
+		CMP(32, MatR(RSCRATCH), Imm32(TIER_UP_THRESHOLD));
+		FixupBranch hot = J_CC(CC_GE, true);
+
+		SwitchToFarCode();
+			SetJumpTarget(hot);
+			MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+			ABI_PushRegistersAndAdjustStack({}, 0);
+			ABI_CallFunctionPC((void *)&Jit64::TierUpBlock, this, js.blockStart);
+			ABI_PopRegistersAndAdjustStack({}, 0);
+			JMP(asm_routines.dispatcher, true);
+		SwitchToNearCode();
+	}
+	else if (m_count_runs && (count_branch || m_block_profile.IsActive()))
+	{
+		// Count runs, and once the block turns out to be hot, have the block profile save it or
+		// recompile it as a trace.
+		MOV(64, R(RSCRATCH), Imm64((u64)&b->runCount));
+		if (!Profiler::g_ProfileBlocks)
+			ADD(32, MatR(RSCRATCH), Imm8(1));
+		CMP(32, MatR(RSCRATCH), Imm32(HOT_THRESHOLD));
+		FixupBranch hot = J_CC(CC_E, true);
+
+		SwitchToFarCode();
+			SetJumpTarget(hot);
+			MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
+			ABI_PushRegistersAndAdjustStack({}, 0);
+			ABI_CallFunctionPC((void *)&Jit64::BlockTurnedHot, this, js.blockStart);
+			ABI_PopRegistersAndAdjustStack({}, 0);
+			TEST(32, R(ABI_RETURN), R(ABI_RETURN));
+			FixupBranch keep = J_CC(CC_Z, true);
+			JMP(asm_routines.dispatcher, true);
+			SetJumpTarget(keep);
+			FixupBranch back = J(true);
+		SwitchToNearCode();
+		SetJumpTarget(back);
+	}
+
 #if defined(_DEBUG) || defined(DEBUGFAST) || defined(NAN_CHECK)
 	// should help logged stack-traces become more accurate
 	MOV(32, PPCSTATE(pc), Imm32(js.blockStart));
@@ -645,6 +908,12 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 		}
 	}
 
+	if (!js.coldBlock && jo.enableBlocklink && !js.assumeNoPairedQuantize && !Profiler::g_ProfileBlocks &&
+	    !ImHereDebug && !SConfig::GetInstance().bEnableDebugging)
+	{
+		BindEntryRegisters(b);
+	}
+
 	// Translate instructions
 	for (u32 i = 0; i < code_block.m_num_instructions; i++)
 	{
@@ -671,6 +940,11 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 				PROFILER_UPDATE_TIME(b);
 				PROFILER_VPOP;
 			}
+			if (count_branch)
+			{
+				MOV(64, R(RSCRATCH), Imm64((u64)&b->branchCount));
+				ADD(32, MatR(RSCRATCH), Imm8(1));
+			}
 			js.isLastInstruction = true;
 		}
 
@@ -867,14 +1141,11 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	}
 
 	if (code_block.m_broken)
-	{
-		gpr.Flush();
-		fpr.Flush();
-		WriteExit(nextPC);
-	}
+		FlushAndWriteExit(nextPC, FLUSH_ALL);
 
 	b->codeSize = (u32)(GetCodePtr() - start);
 	b->originalSize = code_block.m_num_instructions;
+	b->segments = code_block.m_segments;
 
 #ifdef JIT_LOG_X86
 	LogGeneratedX86(code_block.m_num_instructions, code_buf, start, b);
@@ -903,6 +1174,19 @@ void Jit64::EnableBlockLink()
 		jo.enableBlocklink = false;
 }
 
+// Traces are only formed when every branch in them can be compiled; a branch falling back to the
+// interpreter would always end the block. Of those blocks, only the ones whose run and branch
+// counts showed them to be hot and usually reaching their final branch are compiled as traces.
+void Jit64::UpdateBranchFollowing(u32 address, int block_size)
+{
+	const SConfig& config = SConfig::GetInstance();
+	m_can_trace = block_size > 1 && !config.bEnableDebugging && !config.bJITOff && !config.bJITBranchOff;
+	if (m_can_trace && !js.coldBlock && js.traceBlocks.count(address))
+		analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+	else
+		analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+}
+
 void Jit64::EnableOptimization()
 {
 	analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
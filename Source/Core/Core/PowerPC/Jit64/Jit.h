@@ -18,6 +18,8 @@
 // ----------
 #pragma once
 
+#include <unordered_set>
+
 #include "Common/x64ABI.h"
 #include "Common/x64Analyzer.h"
 #include "Common/x64Emitter.h"
@@ -34,6 +36,7 @@
 #include "Core/PowerPC/Jit64/JitRegCache.h"
 #include "Core/PowerPC/JitCommon/Jit_Util.h"
 #include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/JitBlockProfile.h"
 #include "Core/PowerPC/JitCommon/JitCache.h"
 
 class Jit64 : public Jitx86Base
@@ -54,6 +57,25 @@ private:
 	bool m_clear_cache_asap;
 	u8* m_stack;
 
+	JitBlockProfile m_block_profile;
+	// Whether the block being compiled counts its runs, to find out whether it's hot.
+	bool m_count_runs = false;
+	// Whether the block being compiled may become a trace, should it turn out to be hot.
+	bool m_can_trace = false;
+
+	void PrecompileProfiledBlocks();
+	static u32 BlockTurnedHot(Jit64* jit64, u32 address);
+
+	void BindEntryRegisters(JitBlock* b);
+	void WriteBoundRegsBack(const std::vector<JitBlock::BoundReg>& binding);
+
+	// Tiered compilation. Blocks are first compiled cold, which is cheap to generate, and are
+	// recompiled normally once they've run often enough to be worth it.
+	// Which blocks are hot is tracked in js.hotBlocks, since invalidating a block resets it.
+	bool m_tiered;
+
+	static void TierUpBlock(Jit64* jit64, u32 address);
+
 public:
 	Jit64() : code_buffer(32000) {}
 	~Jit64() {}
@@ -61,6 +83,7 @@ public:
 	void Init() override;
 
 	void EnableOptimization();
+	void UpdateBranchFollowing(u32 address, int block_size);
 
 	void EnableBlockLink();
 
@@ -99,6 +122,9 @@ public:
 
 	void WriteExit(u32 destination, bool bl = false, u32 after = 0);
 	void JustWriteExit(u32 destination, bool bl, u32 after);
+	// Flushes the register caches and writes an exit to destination, passing GPRs in host
+	// registers if destination is a compiled block with a bound entry.
+	void FlushAndWriteExit(u32 destination, FlushMode mode, bool bl = false, u32 after = 0);
 	void WriteExitDestInRSCRATCH(bool bl = false, u32 after = 0);
 	void WriteBLRExit();
 	void WriteExceptionExit();
@@ -118,7 +144,7 @@ public:
 	Gen::OpArg ExtractFromReg(int reg, int offset);
 	void AndWithMask(Gen::X64Reg reg, u32 mask);
 	bool CheckMergedBranch(int crf);
-	void DoMergedBranch();
+	void DoMergedBranch(FlushMode mode);
 	void DoMergedBranchCondition();
 	void DoMergedBranchImmediate(s64 val);
 
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <cinttypes>
+#include <cmath>
 
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
@@ -48,6 +49,26 @@ void RegCache::Start()
 	//But only preload IF written OR reads >= 3
 }
 
+std::vector<JitBlock::BoundReg> RegCache::BindOnEntry(const std::vector<size_t>& pregs, BitSet32 written)
+{
+	std::vector<JitBlock::BoundReg> binding;
+	size_t count;
+	const X64Reg* order = GetAllocationOrder(&count);
+	for (size_t i = 0; i < pregs.size() && i < count; i++)
+	{
+		size_t preg = pregs[i];
+		X64Reg xr = order[i];
+		LoadRegister(preg, xr);
+		xregs[xr].free = false;
+		xregs[xr].ppcReg = preg;
+		xregs[xr].dirty = written[preg];
+		regs[preg].away = true;
+		regs[preg].location = ::Gen::R(xr);
+		binding.push_back({(u8)preg, (u8)xr, written[preg]});
+	}
+	return binding;
+}
+
 void RegCache::UnlockAll()
 {
 	for (auto& reg : regs)
@@ -226,6 +247,53 @@ void GPRRegCache::SetImmediate32(size_t preg, u32 immValue)
 	regs[preg].location = Imm32(immValue);
 }
 
+void GPRRegCache::FlushToBinding(const std::vector<JitBlock::BoundReg>& binding, FlushMode mode)
+{
+	std::array<const JitBlock::BoundReg*, 32> bound{};
+	for (const auto& reg : binding)
+		bound[reg.guestReg] = &reg;
+
+	// Write back everything the next block doesn't take over as it is. Nothing has been loaded
+	// yet, so every host register still holds what the cache says it does.
+	for (size_t i = 0; i < regs.size(); i++)
+	{
+		if (!regs[i].away)
+			continue;
+
+		const OpArg& loc = regs[i].location;
+		bool dirty = loc.IsSimpleReg() ? xregs[loc.GetSimpleReg()].dirty : true;
+		bool taken_over = bound[i] && bound[i]->dirty &&
+		                  (loc.IsSimpleReg((X64Reg)bound[i]->hostReg) || loc.IsImm());
+		if (dirty && !taken_over)
+			StoreRegister(i, GetDefaultLocation(i));
+	}
+
+	// Every host register now either holds what the next block wants in it or has been written
+	// back, so the rest can be loaded in any order.
+	for (const auto& reg : binding)
+	{
+		X64Reg xr = (X64Reg)reg.hostReg;
+		const PPCCachedReg& cached = regs[reg.guestReg];
+		if (cached.away && cached.location.IsSimpleReg(xr))
+			continue;
+
+		if (cached.away && cached.location.IsImm())
+			emit->MOV(32, ::Gen::R(xr), cached.location);
+		else
+			emit->MOV(32, ::Gen::R(xr), GetDefaultLocation(reg.guestReg));
+	}
+
+	if (mode == FLUSH_ALL)
+	{
+		for (size_t i = 0; i < regs.size(); i++)
+		{
+			DiscardRegContentsIfCached(i);
+			regs[i].away = false;
+			regs[i].location = GetDefaultLocation(i);
+		}
+	}
+}
+
 const X64Reg* GPRRegCache::GetAllocationOrder(size_t* count)
 {
 	static const X64Reg allocationOrder[] =
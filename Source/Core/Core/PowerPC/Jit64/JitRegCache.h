@@ -6,9 +6,11 @@
 
 #include <array>
 #include <cinttypes>
+#include <vector>
 
 #include "Common/x64Emitter.h"
 #include "Core/PowerPC/PPCAnalyst.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
 
 enum FlushMode
 {
@@ -82,6 +84,10 @@ public:
 	}
 
 	void Flush(FlushMode mode = FLUSH_ALL, BitSet32 regsToFlush = BitSet32::AllTrue(32));
+	// Loads pregs into host registers, in allocation order, at the start of a block that other
+	// blocks may also enter with them already loaded. The ones in written are marked dirty, so
+	// those blocks don't have to write them back. Returns the registers used.
+	std::vector<JitBlock::BoundReg> BindOnEntry(const std::vector<size_t>& pregs, BitSet32 written);
 	void Flush(PPCAnalyst::CodeOp *op) { Flush(); }
 	int SanityCheck() const;
 	void KillImmediate(size_t preg, bool doLoad, bool makeDirty);
@@ -178,6 +184,10 @@ public:
 	Gen::OpArg GetDefaultLocation(size_t reg) const override;
 	const Gen::X64Reg* GetAllocationOrder(size_t* count) override;
 	void SetImmediate32(size_t preg, u32 immValue);
+	// Like Flush(mode), but for a jump into a block's bound entry: the registers in binding are
+	// left in the host registers it names instead, and only written back if the block expects
+	// them clean.
+	void FlushToBinding(const std::vector<JitBlock::BoundReg>& binding, FlushMode mode);
 	BitSet32 GetRegUtilization() override;
 	BitSet32 CountRegsIn(size_t preg, u32 lookahead) override;
 };
@@ -72,9 +72,6 @@ void Jit64::bx(UGeckoInstruction inst)
 		return;
 	}
 
-	gpr.Flush();
-	fpr.Flush();
-
 	u32 destination;
 	if (inst.AA)
 		destination = SignExt26(inst.LI << 2);
@@ -92,7 +89,7 @@ void Jit64::bx(UGeckoInstruction inst)
 		// make idle loops go faster
 		js.downcountAmount += 8;
 	}
-	WriteExit(destination, inst.LK, js.compilerPC + 4);
+	FlushAndWriteExit(destination, FLUSH_ALL, inst.LK, js.compilerPC + 4);
 }
 
 // TODO - optimize to hell and beyond
@@ -131,9 +128,7 @@ void Jit64::bcx(UGeckoInstruction inst)
 	else
 		destination = js.compilerPC + SignExt16(inst.BD << 2);
 
-	gpr.Flush(FLUSH_MAINTAIN_STATE);
-	fpr.Flush(FLUSH_MAINTAIN_STATE);
-	WriteExit(destination, inst.LK, js.compilerPC + 4);
+	FlushAndWriteExit(destination, FLUSH_MAINTAIN_STATE, inst.LK, js.compilerPC + 4);
 
 	if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
 		SetJumpTarget(pConditionDontBranch);
@@ -141,11 +136,7 @@ void Jit64::bcx(UGeckoInstruction inst)
 		SetJumpTarget(pCTRDontBranch);
 
 	if (!analyzer.HasOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE))
-	{
-		gpr.Flush();
-		fpr.Flush();
-		WriteExit(js.compilerPC + 4);
-	}
+		FlushAndWriteExit(js.compilerPC + 4, FLUSH_ALL);
 }
 
 void Jit64::bcctrx(UGeckoInstruction inst)
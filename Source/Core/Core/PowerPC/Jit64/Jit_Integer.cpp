@@ -343,7 +343,7 @@ bool Jit64::CheckMergedBranch(int crf)
 	         (next.BI >> 2) == crf);
 }
 
-void Jit64::DoMergedBranch()
+void Jit64::DoMergedBranch(FlushMode mode)
 {
 	// Code that handles successful PPC branching.
 	const UGeckoInstruction& next = js.op[1].inst;
@@ -358,10 +358,12 @@ void Jit64::DoMergedBranch()
 			destination = SignExt16(next.BD << 2);
 		else
 			destination = nextPC + SignExt16(next.BD << 2);
-		WriteExit(destination, next.LK, nextPC + 4);
+		FlushAndWriteExit(destination, mode, next.LK, nextPC + 4);
 	}
 	else if ((next.OPCD == 19) && (next.SUBOP10 == 528)) // bcctrx
 	{
+		gpr.Flush(mode);
+		fpr.Flush(mode);
 		if (next.LK)
 			MOV(32, M(&LR), Imm32(nextPC + 4));
 		MOV(32, R(RSCRATCH), M(&CTR));
@@ -370,6 +372,8 @@ void Jit64::DoMergedBranch()
 	}
 	else if ((next.OPCD == 19) && (next.SUBOP10 == 16)) // bclrx
 	{
+		gpr.Flush(mode);
+		fpr.Flush(mode);
 		MOV(32, R(RSCRATCH), M(&LR));
 		if (!m_enable_blr_optimization)
 			AND(32, R(RSCRATCH), Imm32(0xFFFFFFFC));
@@ -404,19 +408,12 @@ void Jit64::DoMergedBranchCondition()
 	else  // SO bit, do not branch (we don't emulate SO for cmp).
 		pDontBranch = J(true);
 
-	gpr.Flush(FLUSH_MAINTAIN_STATE);
-	fpr.Flush(FLUSH_MAINTAIN_STATE);
-
-	DoMergedBranch();
+	DoMergedBranch(FLUSH_MAINTAIN_STATE);
 
 	SetJumpTarget(pDontBranch);
 
 	if (!analyzer.HasOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE))
-	{
-		gpr.Flush();
-		fpr.Flush();
-		WriteExit(nextPC + 4);
-	}
+		FlushAndWriteExit(nextPC + 4, FLUSH_ALL);
 }
 
 void Jit64::DoMergedBranchImmediate(s64 val)
@@ -441,17 +438,9 @@ void Jit64::DoMergedBranchImmediate(s64 val)
 		branch = false;
 
 	if (branch)
-	{
-		gpr.Flush();
-		fpr.Flush();
-		DoMergedBranch();
-	}
+		DoMergedBranch(FLUSH_ALL);
 	else if (!analyzer.HasOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE))
-	{
-		gpr.Flush();
-		fpr.Flush();
-		WriteExit(nextPC + 4);
-	}
+		FlushAndWriteExit(nextPC + 4, FLUSH_ALL);
 }
 
 void Jit64::cmpXX(UGeckoInstruction inst)
@@ -364,6 +364,17 @@ void JitArm64::Jit(u32)
 	{
 		ClearCache();
 	}
+	// Only blocks found to be hot, and to usually reach the branch ending them, start a trace. This
+	// JIT doesn't count block runs or branches yet, so it never adds any to traceBlocks itself. A
+	// branch falling back to the interpreter would always end the block, so only form traces when
+	// every branch can be compiled.
+	const SConfig& config = SConfig::GetInstance();
+	if (!config.bEnableDebugging && !config.bJITOff && !config.bJITBranchOff &&
+	    js.traceBlocks.count(PowerPC::ppcState.pc))
+		analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+	else
+		analyzer.ClearOption(PPCAnalyst::PPCAnalyzer::OPTION_BRANCH_FOLLOW);
+
 	int block_num = blocks.AllocateBlock(PowerPC::ppcState.pc);
 	JitBlock *b = blocks.GetBlock(block_num);
 	const u8* BlockPtr = DoJit(PowerPC::ppcState.pc, &code_buffer, b);
@@ -622,6 +633,7 @@ const u8* JitArm64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitB
 
 	b->codeSize = (u32)(GetCodePtr() - start);
 	b->originalSize = code_block.m_num_instructions;
+	b->segments = code_block.m_segments;
 
 	FlushIcache();
 	farcode.FlushIcache();
@@ -82,15 +82,6 @@ void JitArm64::bx(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITBranchOff);
 
-	gpr.Flush(FlushMode::FLUSH_ALL);
-	fpr.Flush(FlushMode::FLUSH_ALL);
-
-	u32 destination;
-	if (inst.AA)
-		destination = SignExt26(inst.LI << 2);
-	else
-		destination = js.compilerPC + SignExt26(inst.LI << 2);
-
 	if (inst.LK)
 	{
 		u32 Jumpto = js.compilerPC + 4;
@@ -100,6 +91,19 @@ void JitArm64::bx(UGeckoInstruction inst)
 		gpr.Unlock(WA);
 	}
 
+	// The analyzer followed this branch, so the code at the destination comes next in the block.
+	if (!js.isLastInstruction)
+		return;
+
+	gpr.Flush(FlushMode::FLUSH_ALL);
+	fpr.Flush(FlushMode::FLUSH_ALL);
+
+	u32 destination;
+	if (inst.AA)
+		destination = SignExt26(inst.LI << 2);
+	else
+		destination = js.compilerPC + SignExt26(inst.LI << 2);
+
 	if (destination == js.compilerPC)
 	{
 		// make idle loops go faster
@@ -84,5 +84,7 @@ void JitBase::UpdateMemoryOptions()
 	jo.memcheck = SConfig::GetInstance().bMMU ||
 	              any_watchpoints;
 	jo.alwaysUseMemFuncs = any_watchpoints;
+	jo.softTLB = SConfig::GetInstance().bMMU && !any_watchpoints &&
+	             PowerPC::GetSoftTLB() != nullptr;
 
 }
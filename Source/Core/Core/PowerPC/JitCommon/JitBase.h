@@ -50,7 +50,7 @@
 
 #define FALLBACK_IF(cond) do { if (cond) { FallBackToInterpreter(inst); return; } } while (0)
 
-#define JITDISABLE(setting) FALLBACK_IF(SConfig::GetInstance().bJITOff || \
+#define JITDISABLE(setting) FALLBACK_IF(SConfig::GetInstance().bJITOff || js.coldBlock || \
                                         SConfig::GetInstance().setting)
 
 class JitBase : public CPUCoreBase
@@ -64,6 +64,7 @@ protected:
 		bool fastmem;
 		bool memcheck;
 		bool alwaysUseMemFuncs;
+		bool softTLB;
 	};
 	struct JitState
 	{
@@ -86,6 +87,9 @@ protected:
 		int revertFprLoad;
 
 		bool assumeNoPairedQuantize;
+		// Set while compiling a block in the cold tier of tiered compilation: every instruction
+		// falls back to the interpreter, just like with bJITOff.
+		bool coldBlock = false;
 		bool firstFPInstructionFound;
 		bool isLastInstruction;
 		int skipInstructions;
@@ -104,6 +108,12 @@ protected:
 
 		std::unordered_set<u32> fifoWriteAddresses;
 		std::unordered_set<u32> pairedQuantizeAddresses;
+		// Entry addresses of the blocks which have tiered up, and get compiled hot from now on.
+		// A block starts cold again once its code is invalidated.
+		std::unordered_set<u32> hotBlocks;
+		// Entry addresses of the blocks which usually ran on through the unconditional branch
+		// ending them, and get compiled as traces from now on. Reset the same way.
+		std::unordered_set<u32> traceBlocks;
 	};
 
 	PPCAnalyst::CodeBlock code_block;
@@ -0,0 +1,233 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Common/Logging/Log.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/JitCommon/JitBlockProfile.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+// Don't bother recording or hashing anything bigger than this; the analyzer never produces
+// blocks anywhere near this size.
+static const u32 MAX_PROFILED_INSTRUCTIONS = 0x10000;
+
+// Each value holds the block's instruction count and the options it was compiled with.
+static const u32 VALUE_SIZE = 2;
+
+class JitBlockProfile::Reader : public LinearDiskCacheReader<Key, u32>
+{
+public:
+	explicit Reader(std::vector<Entry>* entries) : m_entries(entries) {}
+
+	void Read(const Key& key, const u32* value, u32 value_size) override
+	{
+		if (value_size != VALUE_SIZE || value[0] == 0 || value[0] > MAX_PROFILED_INSTRUCTIONS)
+			return;
+		m_entries->push_back({key, value[0], value[1]});
+	}
+
+private:
+	std::vector<Entry>* m_entries;
+};
+
+JitBlockProfile::JitBlockProfile()
+{
+}
+
+JitBlockProfile::~JitBlockProfile()
+{
+	Shutdown();
+}
+
+void JitBlockProfile::Init(u32 analyst_options)
+{
+	Shutdown();
+
+	const SConfig& config = SConfig::GetInstance();
+	// Precompiling relies on being able to read code without taking exceptions, and on nothing
+	// single-stepping through the blocks we compile behind its back.
+	if (!config.bJITWarmStart || config.bMMU || config.bEnableDebugging || config.m_strUniqueID.empty())
+		return;
+
+	std::string cache_dir = File::GetUserPath(D_CACHE_IDX);
+	if (!File::Exists(cache_dir))
+		File::CreateDir(cache_dir);
+	std::string filename = StringFromFormat("%sjit-%s-blocks.cache", cache_dir.c_str(),
+	                                        config.m_strUniqueID.c_str());
+
+	m_analyst_options = analyst_options;
+	m_active = true;
+	m_loaded = false;
+	m_joined = false;
+	m_load_thread = std::thread(&JitBlockProfile::LoadThread, this, filename);
+}
+
+void JitBlockProfile::Shutdown()
+{
+	if (!m_active)
+		return;
+
+	FinishLoading();
+	m_disk_cache.Sync();
+	m_disk_cache.Close();
+
+	m_active = false;
+	m_pending.clear();
+	m_known.clear();
+	m_compiled.clear();
+	m_unsaved.clear();
+}
+
+void JitBlockProfile::LoadThread(std::string filename)
+{
+	Common::SetCurrentThreadName("JIT profile loader");
+
+	std::vector<Entry> entries;
+	Reader reader(&entries);
+	m_disk_cache.OpenAndRead(filename, reader);
+
+	// A block is saved again when it's compiled with different options, e.g. when it
+	// becomes the start of a trace. Keep it where it was first saved, but with the options it was
+	// saved with last.
+	std::vector<Entry> blocks;
+	std::map<Key, size_t> block_indices;
+	for (const Entry& entry : entries)
+	{
+		auto result = block_indices.emplace(entry.key, blocks.size());
+		if (result.second)
+			blocks.push_back(entry);
+		else
+			blocks[result.first->second].block_options = entry.block_options;
+	}
+
+	for (const Entry& entry : blocks)
+		m_known[entry.key] = entry.block_options;
+
+	// Oldest entries were recorded first, which is roughly the order the game needs them in.
+	// PopPendingBlock takes from the back, so flip them around.
+	m_pending.reserve(blocks.size());
+	for (auto it = blocks.rbegin(); it != blocks.rend(); ++it)
+	{
+		if (it->key.analyst_options == m_analyst_options)
+			m_pending.push_back(*it);
+	}
+
+	INFO_LOG(DYNA_REC, "Loaded %zu profiled JIT blocks from %s", m_pending.size(), filename.c_str());
+	m_loaded.store(true, std::memory_order_release);
+}
+
+void JitBlockProfile::FinishLoading()
+{
+	if (m_joined)
+		return;
+
+	m_load_thread.join();
+	m_joined = true;
+
+	for (const Entry& entry : m_unsaved)
+		Append(entry);
+	m_unsaved.clear();
+}
+
+bool JitBlockProfile::HashCode(u32 address, u32 num_instructions, u32* hash)
+{
+	if (num_instructions == 0 || num_instructions > MAX_PROFILED_INSTRUCTIONS)
+		return false;
+
+	u32 last = address + (num_instructions - 1) * 4;
+	if (last < address || !PowerPC::HostIsRAMAddress(address) || !PowerPC::HostIsRAMAddress(last))
+		return false;
+
+	std::vector<u32> code(num_instructions);
+	for (u32 i = 0; i < num_instructions; ++i)
+		code[i] = PowerPC::HostRead_U32(address + i * 4);
+
+	*hash = HashAdler32(reinterpret_cast<const u8*>(code.data()), code.size() * sizeof(u32));
+	return true;
+}
+
+void JitBlockProfile::Append(const Entry& entry)
+{
+	auto known = m_known.find(entry.key);
+	if (known != m_known.end() && known->second == entry.block_options)
+		return;
+
+	m_known[entry.key] = entry.block_options;
+	const u32 value[VALUE_SIZE] = {entry.num_instructions, entry.block_options};
+	m_disk_cache.Append(entry.key, value, VALUE_SIZE);
+}
+
+void JitBlockProfile::AddBlock(u32 address, u32 num_instructions, u32 block_options)
+{
+	if (!m_active)
+		return;
+
+	Entry entry;
+	entry.key.address = address;
+	entry.key.analyst_options = m_analyst_options;
+	entry.num_instructions = num_instructions;
+	entry.block_options = block_options;
+	// The hash is taken now, while the code in memory is what the block was compiled from.
+	if (HashCode(address, num_instructions, &entry.key.code_hash))
+		m_compiled[address] = entry;
+	else
+		m_compiled.erase(address);
+}
+
+void JitBlockProfile::MarkHot(u32 address)
+{
+	auto it = m_compiled.find(address);
+	if (it == m_compiled.end())
+		return;
+
+	Save(it->second);
+	m_compiled.erase(it);
+}
+
+void JitBlockProfile::Save(const Entry& entry)
+{
+	if (m_loaded.load(std::memory_order_acquire))
+	{
+		FinishLoading();
+		Append(entry);
+	}
+	else
+	{
+		m_unsaved.push_back(entry);
+	}
+}
+
+bool JitBlockProfile::PopPendingBlock(JitBaseBlockCache& blocks, u32* budget, u32* address, u32* block_options)
+{
+	if (!m_active || !m_loaded.load(std::memory_order_acquire))
+		return false;
+
+	FinishLoading();
+
+	while (!m_pending.empty() && *budget > 0)
+	{
+		Entry entry = m_pending.back();
+		m_pending.pop_back();
+
+		// The game got there first.
+		if (blocks.GetBlockNumberFromStartAddress(entry.key.address) >= 0)
+			continue;
+
+		*budget -= std::min(*budget, entry.num_instructions);
+		u32 hash;
+		if (HashCode(entry.key.address, entry.num_instructions, &hash) && hash == entry.key.code_hash)
+		{
+			*address = entry.key.address;
+			*block_options = entry.block_options;
+			return true;
+		}
+	}
+	return false;
+}
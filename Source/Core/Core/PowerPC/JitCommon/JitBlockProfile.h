@@ -0,0 +1,107 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+// Remembers which blocks turned out to be hot on previous runs of a game, so that a JIT can
+// compile them ahead of time instead of taking a dispatcher miss for each one during the first
+// minutes of play. Blocks are only saved once the JIT reports them hot, so code that runs a
+// handful of times while booting doesn't make it into the profile.
+//
+// The profile lives in the user Cache dir, one file per game ID. Each entry is keyed by the
+// block's entry address, a hash of its code and the analyzer options shared by every block, and
+// also holds the options that particular block was compiled with. An entry is only handed out
+// for precompilation if the block isn't compiled already and the code currently in memory still
+// hashes the same, so overlays and self-modifying code just skip stale entries. Blocks compiled
+// from the profile are ordinary blocks in the JitBaseBlockCache and are invalidated the same way.
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/LinearDiskCache.h"
+
+class JitBaseBlockCache;
+
+class JitBlockProfile final
+{
+public:
+	JitBlockProfile();
+	~JitBlockProfile();
+
+	// Starts reading the profile for the running game on a background thread. Entries recorded
+	// with different analyst_options are ignored.
+	// Does nothing unless the JITWarmStart option is enabled.
+	void Init(u32 analyst_options);
+	void Shutdown();
+
+	bool IsActive() const { return m_active; }
+
+	// Notes a block compiled by the JIT, along with the analyzer options it was compiled with.
+	// It's only saved if MarkHot is called for its address before the address gets recompiled.
+	// CPU thread only.
+	void AddBlock(u32 address, u32 num_instructions, u32 block_options);
+
+	// Saves the block last added at address, since it has run often enough to be worth
+	// precompiling next time.
+	// CPU thread only.
+	void MarkHot(u32 address);
+
+	// Gets the next profiled block which isn't in blocks yet and whose code is still in memory.
+	// Checking an entry costs its number of instructions from budget; once that runs out, no more
+	// entries are looked at.
+	// CPU thread only.
+	bool PopPendingBlock(JitBaseBlockCache& blocks, u32* budget, u32* address, u32* block_options);
+
+private:
+	struct Key
+	{
+		u32 address;
+		u32 code_hash;
+		u32 analyst_options;
+
+		bool operator<(const Key& other) const
+		{
+			return std::tie(address, code_hash, analyst_options) <
+			       std::tie(other.address, other.code_hash, other.analyst_options);
+		}
+	};
+
+	struct Entry
+	{
+		Key key;
+		u32 num_instructions;
+		u32 block_options;
+	};
+
+	class Reader;
+
+	static bool HashCode(u32 address, u32 num_instructions, u32* hash);
+
+	void LoadThread(std::string filename);
+	void FinishLoading();
+	void Save(const Entry& entry);
+	void Append(const Entry& entry);
+
+	LinearDiskCache<Key, u32> m_disk_cache;
+	std::thread m_load_thread;
+	std::atomic<bool> m_loaded{false};
+	bool m_active = false;
+	bool m_joined = false;
+	u32 m_analyst_options = 0;
+
+	// Filled by the load thread, consumed from the back by PopPendingBlock.
+	std::vector<Entry> m_pending;
+	// The block options last saved for each key.
+	std::map<Key, u32> m_known;
+	// Blocks which have been compiled, but haven't been reported hot yet.
+	std::unordered_map<u32, Entry> m_compiled;
+	// Blocks compiled before the profile finished loading, appended once it has.
+	std::vector<Entry> m_unsaved;
+};
@@ -9,6 +9,7 @@
 // performance hit, it's not enabled by default, but it's useful for
 // locating performance issues.
 
+#include <algorithm>
 #include <cstring>
 #include "disasm.h"
 
@@ -67,12 +68,14 @@ using namespace Gen;
 #endif
 		jit->js.fifoWriteAddresses.clear();
 		jit->js.pairedQuantizeAddresses.clear();
+		jit->js.hotBlocks.clear();
+		jit->js.traceBlocks.clear();
 		for (int i = 0; i < num_blocks; i++)
 		{
 			DestroyBlock(i, false);
 		}
 		links_to.clear();
-		block_map.clear();
+		block_range_map.clear();
 
 		valid_block.ClearAll();
 
@@ -102,6 +105,12 @@ using namespace Gen;
 		b.invalid = false;
 		b.originalAddress = em_address;
 		b.linkData.clear();
+		b.segments.clear();
+		b.boundEntry = nullptr;
+		b.boundSpill = nullptr;
+		b.boundRegs.clear();
+		b.boundLinks.clear();
+		b.boundSources.clear();
 		num_blocks++; //commit the current block
 		return num_blocks - 1;
 	}
@@ -113,25 +122,44 @@ using namespace Gen;
 
 		std::memcpy(GetICachePtr(b.originalAddress), &block_num, sizeof(u32));
 
-		// Convert the logical address to a physical address for the block map
-		u32 pAddr = b.originalAddress & 0x1FFFFFFF;
+		if (b.segments.empty())
+			b.segments.emplace_back(b.originalAddress, b.originalSize);
+
+		for (const auto& segment : b.segments)
+		{
+			// Convert the logical address to a physical address for the block map
+			u32 pAddr = segment.first & 0x1FFFFFFF;
 
-		for (u32 block = pAddr / 32; block <= (pAddr + (b.originalSize - 1) * 4) / 32; ++block)
-			valid_block.Set(block);
+			for (u32 block = pAddr / 32; block <= (pAddr + (segment.second - 1) * 4) / 32; ++block)
+				valid_block.Set(block);
 
-		block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
+			u32 pEnd = pAddr + 4 * segment.second;
+			for (u32 range = pAddr & ~BLOCK_RANGE_MAP_MASK; range < pEnd; range += BLOCK_RANGE_MAP_ELEMENTS)
+			{
+				// Segments of a trace can share a range, but the block only goes in once.
+				std::vector<int>& bucket = block_range_map[range];
+				if (bucket.empty() || bucket.back() != block_num)
+					bucket.push_back(block_num);
+			}
+		}
 
 		if (block_link)
 		{
 			for (const auto& e : b.linkData)
 			{
-				links_to.emplace(e.exitAddress, block_num);
+				links_to[e.exitAddress].push_back(block_num);
 			}
 
 			LinkBlock(block_num);
 			LinkBlockExits(block_num);
 		}
 
+		for (int destination : b.boundLinks)
+		{
+			if (destination != block_num)
+				blocks[destination].boundSources.push_back(block_num);
+		}
+
 		JitRegister::Register(blockCodePointers[block_num], b.codeSize,
 			"JIT_PPC_%08x", b.originalAddress);
 	}
@@ -144,12 +172,12 @@ using namespace Gen;
 	u8* JitBaseBlockCache::GetICachePtr(u32 addr)
 	{
 		if (addr & JIT_ICACHE_VMEM_BIT)
-			return &jit->GetBlockCache()->iCacheVMEM[addr & JIT_ICACHE_MASK];
+			return &iCacheVMEM[addr & JIT_ICACHE_MASK];
 
 		if (addr & JIT_ICACHE_EXRAM_BIT)
-			return &jit->GetBlockCache()->iCacheEx[addr & JIT_ICACHEEX_MASK];
+			return &iCacheEx[addr & JIT_ICACHEEX_MASK];
 
-		return &jit->GetBlockCache()->iCache[addr & JIT_ICACHE_MASK];
+		return &iCache[addr & JIT_ICACHE_MASK];
 	}
 
 	int JitBaseBlockCache::GetBlockNumberFromStartAddress(u32 addr)
@@ -206,38 +234,56 @@ using namespace Gen;
 	{
 		LinkBlockExits(i);
 		JitBlock &b = blocks[i];
-		// equal_range(b) returns pair<iterator,iterator> representing the range
-		// of element with key b
-		auto ppp = links_to.equal_range(b.originalAddress);
+		auto it = links_to.find(b.originalAddress);
 
-		if (ppp.first == ppp.second)
+		if (it == links_to.end())
 			return;
 
-		for (auto iter = ppp.first; iter != ppp.second; ++iter)
+		for (int source : it->second)
 		{
-			// PanicAlert("Linking block %i to block %i", iter->second, i);
-			LinkBlockExits(iter->second);
+			// PanicAlert("Linking block %i to block %i", source, i);
+			LinkBlockExits(source);
 		}
 	}
 
 	void JitBaseBlockCache::UnlinkBlock(int i)
 	{
 		JitBlock &b = blocks[i];
-		auto ppp = links_to.equal_range(b.originalAddress);
+		auto it = links_to.find(b.originalAddress);
 
-		if (ppp.first == ppp.second)
+		if (it == links_to.end())
 			return;
 
-		for (auto iter = ppp.first; iter != ppp.second; ++iter)
+		for (int source : it->second)
 		{
-			JitBlock &sourceBlock = blocks[iter->second];
+			JitBlock &sourceBlock = blocks[source];
 			for (auto& e : sourceBlock.linkData)
 			{
 				if (e.exitAddress == b.originalAddress)
 					e.linkStatus = false;
 			}
 		}
-		links_to.erase(b.originalAddress);
+		// The sources stay in links_to, so that they get relinked when the address is recompiled.
+	}
+
+	void JitBaseBlockCache::RemoveBlockFromLinks(int block_num)
+	{
+		for (const auto& e : blocks[block_num].linkData)
+		{
+			auto it = links_to.find(e.exitAddress);
+			if (it == links_to.end())
+				continue;
+
+			std::vector<int>& sources = it->second;
+			auto pos = std::find(sources.begin(), sources.end(), block_num);
+			if (pos != sources.end())
+			{
+				*pos = sources.back();
+				sources.pop_back();
+			}
+			if (sources.empty())
+				links_to.erase(it);
+		}
 	}
 
 	void JitBaseBlockCache::DestroyBlock(int block_num, bool invalidate)
@@ -258,11 +304,51 @@ using namespace Gen;
 		std::memcpy(GetICachePtr(b.originalAddress), &JIT_ICACHE_INVALID_WORD, sizeof(u32));
 
 		UnlinkBlock(block_num);
+		RemoveBlockFromLinks(block_num);
 
 		// Send anyone who tries to run this block back to the dispatcher.
 		// Not entirely ideal, but .. pretty good.
-		// Spurious entrances from previously linked blocks can only come through checkedEntry
+		// Spurious entrances from previously linked blocks can only come through checkedEntry,
+		// or through boundEntry, which first has to put the registers it was passed back.
 		WriteDestroyBlock(b.checkedEntry, b.originalAddress);
+		if (b.boundEntry)
+			WriteDestroyBoundEntry(b.boundEntry, b.boundSpill);
+
+		for (int source : b.boundSources)
+		{
+			if (blocks[source].invalid)
+				continue;
+			DestroyBlock(source, invalidate);
+			RemoveBlockFromRangeMap(source);
+		}
+		b.boundSources.clear();
+	}
+
+	void JitBaseBlockCache::RemoveBlockFromRangeMap(int block_num)
+	{
+		const JitBlock &b = blocks[block_num];
+		for (const auto& segment : b.segments)
+		{
+			u32 pAddr = segment.first & 0x1FFFFFFF;
+			u32 pEnd = pAddr + 4 * segment.second;
+			for (u32 range = pAddr & ~BLOCK_RANGE_MAP_MASK; range < pEnd; range += BLOCK_RANGE_MAP_ELEMENTS)
+			{
+				auto it = block_range_map.find(range);
+				if (it == block_range_map.end())
+					continue;
+
+				std::vector<int>& bucket = it->second;
+				auto pos = std::find(bucket.begin(), bucket.end(), block_num);
+				if (pos != bucket.end())
+				{
+					// Order within a bucket doesn't matter, so don't shift the tail down.
+					*pos = bucket.back();
+					bucket.pop_back();
+				}
+				if (bucket.empty())
+					block_range_map.erase(it);
+			}
+		}
 	}
 
 	void JitBaseBlockCache::InvalidateICache(u32 address, const u32 length, bool forced)
@@ -281,21 +367,42 @@ using namespace Gen;
 		}
 
 		// destroy JIT blocks
-		// !! this works correctly under assumption that any two overlapping blocks end at the same address
 		if (destroy_block)
 		{
-			std::map<std::pair<u32,u32>, u32>::iterator it1 = block_map.lower_bound(std::make_pair(pAddr, 0)), it2 = it1;
-			while (it2 != block_map.end() && it2->first.second < pAddr + length)
+			// Collect every block overlapping the invalidated memory first, since destroying a block
+			// removes it from the buckets we're looking at. A block spanning several ranges shows up
+			// more than once, which is fine as destroyed blocks are skipped below.
+			u32 pEnd = pAddr + length;
+			std::vector<int> victims;
+			for (u32 range = pAddr & ~BLOCK_RANGE_MAP_MASK; range < pEnd; range += BLOCK_RANGE_MAP_ELEMENTS)
 			{
-				JitBlock &b = blocks[it2->second];
-				std::memcpy(GetICachePtr(b.originalAddress), &JIT_ICACHE_INVALID_WORD, sizeof(u32));
+				auto it = block_range_map.find(range);
+				if (it == block_range_map.end())
+					continue;
 
-				DestroyBlock(it2->second, true);
-				++it2;
+				for (int block_num : it->second)
+				{
+					for (const auto& segment : blocks[block_num].segments)
+					{
+						u32 bStart = segment.first & 0x1FFFFFFF;
+						u32 bEnd = bStart + 4 * segment.second;
+						if (bStart < pEnd && bEnd > pAddr)
+						{
+							victims.push_back(block_num);
+							break;
+						}
+					}
+				}
 			}
-			if (it1 != it2)
+
+			for (int block_num : victims)
 			{
-				block_map.erase(it1, it2);
+				if (blocks[block_num].invalid)
+					continue;
+
+				OnBlockInvalidated(blocks[block_num].originalAddress);
+				DestroyBlock(block_num, true);
+				RemoveBlockFromRangeMap(block_num);
 			}
 
 			// If the code was actually modified, we need to clear the relevant entries from the
@@ -313,6 +420,12 @@ using namespace Gen;
 		}
 	}
 
+	void JitBaseBlockCache::RetireBlock(int block_num)
+	{
+		DestroyBlock(block_num, true);
+		RemoveBlockFromRangeMap(block_num);
+	}
+
 	void JitBlockCache::WriteLinkBlock(u8* location, const u8* address)
 	{
 		XEmitter emit(location);
@@ -339,3 +452,16 @@ using namespace Gen;
 		emit.MOV(32, PPCSTATE(pc), Imm32(address));
 		emit.JMP(jit->GetAsmRoutines()->dispatcher, true);
 	}
+
+	void JitBlockCache::WriteDestroyBoundEntry(const u8* location, const u8* spill)
+	{
+		XEmitter emit((u8 *)location);
+		emit.JMP(spill, true);
+	}
+
+	void JitBlockCache::OnBlockInvalidated(u32 address)
+	{
+		// New code has to earn its way into the hot tier again.
+		jit->js.hotBlocks.erase(address);
+		jit->js.traceBlocks.erase(address);
+	}
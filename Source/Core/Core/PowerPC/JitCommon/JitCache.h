@@ -6,8 +6,9 @@
 
 #include <array>
 #include <bitset>
-#include <map>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Core/PowerPC/Gekko.h"
@@ -33,9 +34,34 @@ struct JitBlock
 	u32 codeSize;
 	u32 originalSize;
 	int runCount;  // for profiling.
+	// Jit64 only: how many of those runs reached the unconditional branch ending the block.
+	int branchCount;
 
 	bool invalid;
 
+	// Start address and number of instructions of each run of guest code the block was compiled
+	// from. Filled in by FinalizeBlock from originalAddress/originalSize if the JIT leaves it empty.
+	std::vector<std::pair<u32, u32>> segments;
+
+	// Jit64 only: an entry for direct links from blocks that pass some guest GPRs in host
+	// registers rather than through ppcState, and the registers it expects.
+	struct BoundReg
+	{
+		u8 guestReg;
+		u8 hostReg;
+		// The block writes the register back itself, so the caller doesn't have to.
+		bool dirty;
+	};
+	const u8 *boundEntry;
+	// Where boundEntry is redirected to when the block is destroyed.
+	const u8 *boundSpill;
+	std::vector<BoundReg> boundRegs;
+	// Blocks this block jumps to through their bound entry, and blocks that jump to ours.
+	// Those links are compiled against one particular register binding, so they are never
+	// relinked; the source blocks are destroyed along with the destination instead.
+	std::vector<int> boundLinks;
+	std::vector<int> boundSources;
+
 	struct LinkData
 	{
 		u8 *exitPtrs;    // to be able to rewrite the exit jum
@@ -98,13 +124,20 @@ class JitBaseBlockCache
 	enum
 	{
 		MAX_NUM_BLOCKS = 65536 * 2,
+		// Granularity of block_range_map, in bytes of physical memory.
+		BLOCK_RANGE_MAP_ELEMENTS = 0x100,
+		BLOCK_RANGE_MAP_MASK = BLOCK_RANGE_MAP_ELEMENTS - 1,
 	};
 
 	std::array<const u8*, MAX_NUM_BLOCKS> blockCodePointers;
 	std::array<JitBlock, MAX_NUM_BLOCKS> blocks;
 	int num_blocks;
-	std::multimap<u32, int> links_to;
-	std::map<std::pair<u32, u32>, u32> block_map; // (end_addr, start_addr) -> number
+	// exit address -> blocks that have an exit to it
+	// This is only looked up once per link and once per destroyed block, with one bucket per
+	// address, so the standard hash table is good enough here.
+	std::unordered_map<u32, std::vector<int>> links_to;
+	// (physical address & ~BLOCK_RANGE_MAP_MASK) -> blocks that overlap that range
+	std::unordered_map<u32, std::vector<int>> block_range_map;
 	ValidBlockBitSet valid_block;
 
 	bool m_initialized;
@@ -112,6 +145,8 @@ class JitBaseBlockCache
 	void LinkBlockExits(int i);
 	void LinkBlock(int i);
 	void UnlinkBlock(int i);
+	void RemoveBlockFromLinks(int block_num);
+	void RemoveBlockFromRangeMap(int block_num);
 
 	u8* GetICachePtr(u32 addr);
 	void DestroyBlock(int block_num, bool invalidate);
@@ -119,6 +154,9 @@ class JitBaseBlockCache
 	// Virtual for overloaded
 	virtual void WriteLinkBlock(u8* location, const u8* address) = 0;
 	virtual void WriteDestroyBlock(const u8* location, u32 address) = 0;
+	virtual void WriteDestroyBoundEntry(const u8* location, const u8* spill) {}
+	// Called by InvalidateICache for each block it destroys, whose code may have changed.
+	virtual void OnBlockInvalidated(u32 address) {}
 
 public:
 	JitBaseBlockCache() : num_blocks(0), m_initialized(false)
@@ -152,8 +190,10 @@ public:
 
 	CompiledCode GetCompiledCodeFromBlock(int block_num);
 
-	// DOES NOT WORK CORRECTLY WITH INLINING
 	void InvalidateICache(u32 address, const u32 length, bool forced);
+	// Destroys just this block, whose code is still valid, so that it can be compiled again.
+	// Unlike InvalidateICache, blocks that merely overlap it are left alone.
+	void RetireBlock(int block_num);
 
 	u32* GetBlockBitSet() const
 	{
@@ -167,4 +207,6 @@ class JitBlockCache : public JitBaseBlockCache
 private:
 	void WriteLinkBlock(u8* location, const u8* address) override;
 	void WriteDestroyBlock(const u8* location, u32 address) override;
+	void WriteDestroyBoundEntry(const u8* location, const u8* spill) override;
+	void OnBlockInvalidated(u32 address) override;
 };
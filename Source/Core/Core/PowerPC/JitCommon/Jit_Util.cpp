@@ -2,9 +2,12 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <cstddef>
+
 #include "Common/CommonTypes.h"
 #include "Common/Intrinsics.h"
 #include "Common/MathUtil.h"
+#include "Common/x64ABI.h"
 
 #include "Core/HW/MMIO.h"
 #include "Core/PowerPC/JitCommon/Jit_Util.h"
@@ -12,6 +15,59 @@
 
 using namespace Gen;
 
+bool GetSoftTLBScratchRegs(BitSet32 registers_in_use, BitSet32 excluded, X64Reg* scratch, X64Reg* scratch2)
+{
+	BitSet32 candidates = BitSet32(ABI_ALL_CALLER_SAVED) & BitSet32(0xFFFF) & ~registers_in_use & ~excluded;
+	int found = 0;
+	for (int reg : candidates)
+	{
+		if (reg == RSP)
+			continue;
+		if (found++ == 0)
+		{
+			*scratch = (X64Reg)reg;
+		}
+		else
+		{
+			*scratch2 = (X64Reg)reg;
+			return true;
+		}
+	}
+	return false;
+}
+
+FixupBranch EmitSoftTLBLookup(XEmitter* emit, X64Reg reg_addr, s32 offset, int accessSize, bool write,
+                              X64Reg scratch, X64Reg scratch2)
+{
+	static_assert(sizeof(PowerPC::soft_tlb_entry) == 16, "soft_tlb_entry is indexed with a shift");
+	int tag_offset = write ? offsetof(PowerPC::soft_tlb_entry, write_tag) : offsetof(PowerPC::soft_tlb_entry, read_tag);
+
+	emit->LEA(32, scratch, MDisp(reg_addr, offset));
+	emit->SHR(32, R(scratch), Imm8(HW_PAGE_INDEX_SHIFT));
+	emit->AND(32, R(scratch), Imm32(PowerPC::GetSoftTLBMask()));
+	emit->SHL(32, R(scratch), Imm8(4));
+	emit->MOV(64, R(scratch2), ImmPtr(PowerPC::GetSoftTLB()));
+	emit->ADD(64, R(scratch), R(scratch2));
+
+	// The tag is compared against the page of the last byte accessed, so
+	// accesses that cross a page boundary always miss.
+	emit->LEA(32, scratch2, MDisp(reg_addr, offset + accessSize / 8 - 1));
+	emit->SHR(32, R(scratch2), Imm8(HW_PAGE_INDEX_SHIFT));
+	// The table only holds page translations, which don't apply in real mode
+	// (MSR.DR clear). Make the tag one that never matches there.
+	emit->TEST(32, PPCSTATE(msr), Imm32(1 << (31 - 27)));
+	FixupBranch translated = emit->J_CC(CC_NZ);
+	emit->OR(32, R(scratch2), Imm32(0x80000000));
+	emit->SetJumpTarget(translated);
+	emit->CMP(32, R(scratch2), MDisp(scratch, tag_offset));
+	FixupBranch miss = emit->J_CC(CC_NE);
+
+	// As with UnsafeLoadToReg, an offset that wraps the address around isn't
+	// handled here.
+	emit->MOV(64, R(scratch), MDisp(scratch, offsetof(PowerPC::soft_tlb_entry, host_base)));
+	return miss;
+}
+
 void EmuCodeBlock::MemoryExceptionCheck()
 {
 	if (jit->jo.memcheck && !jit->js.fastmemLoadStore && !jit->js.fixupExceptionHandler)
@@ -298,7 +354,8 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 		LEA(32, RSCRATCH, MDisp(opAddress.GetSimpleReg(), offset));
 	}
 
-	FixupBranch exit;
+	FixupBranch exit, tlb_exit;
+	bool soft_tlb = false;
 	if (!jit->jo.alwaysUseMemFuncs)
 	{
 		FixupBranch slow = CheckIfSafeAddress(R(reg_value), reg_addr, registersInUse, mem_mask);
@@ -308,6 +365,20 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 		else
 			exit = J(true);
 		SetJumpTarget(slow);
+
+		X64Reg tlb_base, tlb_scratch;
+		BitSet32 tlb_excluded;
+		tlb_excluded[reg_value] = true;
+		tlb_excluded[reg_addr] = true;
+		if (jit->jo.softTLB &&
+		    GetSoftTLBScratchRegs(registersInUse, tlb_excluded, &tlb_base, &tlb_scratch))
+		{
+			FixupBranch miss = EmitSoftTLBLookup(this, reg_addr, 0, accessSize, false, tlb_base, tlb_scratch);
+			LoadAndSwap(accessSize, reg_value, MRegSum(tlb_base, reg_addr), signExtend);
+			tlb_exit = J(true);
+			SetJumpTarget(miss);
+			soft_tlb = true;
+		}
 	}
 	size_t rsp_alignment = (flags & SAFE_LOADSTORE_NO_PROLOG) ? 8 : 0;
 	ABI_PushRegistersAndAdjustStack(registersInUse, rsp_alignment);
@@ -347,6 +418,8 @@ void EmuCodeBlock::SafeLoadToReg(X64Reg reg_value, const Gen::OpArg & opAddress,
 			SwitchToNearCode();
 		}
 		SetJumpTarget(exit);
+		if (soft_tlb)
+			SetJumpTarget(tlb_exit);
 	}
 }
 
@@ -504,7 +577,7 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
 
 	bool swap = !(flags & SAFE_LOADSTORE_NO_SWAP);
 
-	FixupBranch slow, exit;
+	FixupBranch slow, exit, tlb_exit;
 	slow = CheckIfSafeAddress(reg_value, reg_addr, registersInUse, mem_mask);
 	UnsafeWriteRegToReg(reg_value, reg_addr, accessSize, 0, swap);
 	if (farcode.Enabled())
@@ -513,6 +586,27 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
 		exit = J(true);
 	SetJumpTarget(slow);
 
+	X64Reg tlb_base, tlb_scratch;
+	BitSet32 tlb_excluded;
+	tlb_excluded[reg_addr] = true;
+	if (reg_value.IsSimpleReg())
+		tlb_excluded[reg_value.GetSimpleReg()] = true;
+	bool soft_tlb = jit->jo.softTLB &&
+	                GetSoftTLBScratchRegs(registersInUse, tlb_excluded, &tlb_base, &tlb_scratch);
+	if (soft_tlb)
+	{
+		FixupBranch miss = EmitSoftTLBLookup(this, reg_addr, 0, accessSize, true, tlb_base, tlb_scratch);
+		OpArg dest = MRegSum(tlb_base, reg_addr);
+		if (reg_value.IsImm())
+			MOV(accessSize, dest, swap ? SwapImmediate(accessSize, reg_value) : reg_value);
+		else if (swap)
+			SwapAndStore(accessSize, dest, reg_value.GetSimpleReg());
+		else
+			MOV(accessSize, dest, reg_value);
+		tlb_exit = J(true);
+		SetJumpTarget(miss);
+	}
+
 	// PC is used by memory watchpoints (if enabled) or to print accurate PC locations in debug logs
 	MOV(32, PPCSTATE(pc), Imm32(jit->js.compilerPC));
 
@@ -553,6 +647,8 @@ void EmuCodeBlock::SafeWriteRegToReg(OpArg reg_value, X64Reg reg_addr, int acces
 		SwitchToNearCode();
 	}
 	SetJumpTarget(exit);
+	if (soft_tlb)
+		SetJumpTarget(tlb_exit);
 }
 
 void EmuCodeBlock::WriteToConstRamAddress(int accessSize, OpArg arg, u32 address, bool swap)
@@ -46,6 +46,18 @@ static const int FARCODE_SIZE_MMU = 1024 * 1024 * 48;
 static const int TRAMPOLINE_CODE_SIZE = 1024 * 1024 * 8;
 static const int TRAMPOLINE_CODE_SIZE_MMU = 1024 * 1024 * 32;
 
+// Software TLB probes (see PowerPC::soft_tlb_entry), shared by the safe
+// load/store slow paths and the fastmem trampolines.
+// Picks two registers a probe may clobber: caller-saved registers that are
+// neither in use nor excluded.  Returns false if there aren't two.
+bool GetSoftTLBScratchRegs(BitSet32 registers_in_use, BitSet32 excluded, Gen::X64Reg* scratch, Gen::X64Reg* scratch2);
+// Looks up the page of [reg_addr + offset] in the software TLB.  On a hit,
+// falls through with scratch set up so that MComplex(scratch, reg_addr,
+// SCALE_1, offset) is the host address of the access; on a miss, or if the
+// access crosses into another page, takes the returned branch.
+Gen::FixupBranch EmitSoftTLBLookup(Gen::XEmitter* emit, Gen::X64Reg reg_addr, s32 offset, int accessSize, bool write,
+                                   Gen::X64Reg scratch, Gen::X64Reg scratch2);
+
 // Like XCodeBlock but has some utilities for memory access.
 class EmuCodeBlock : public Gen::X64CodeBlock
 {
@@ -61,6 +61,22 @@ const u8* TrampolineCache::GenerateReadTrampoline(const InstructionInfo &info, B
 	else if (info.displacement)
 		ADD(32, R(ABI_PARAM1), Imm32(info.displacement));
 
+	X64Reg tlb_base, tlb_scratch;
+	BitSet32 tlb_excluded;
+	tlb_excluded[ABI_PARAM1] = true;
+	tlb_excluded[addrReg] = true;
+	tlb_excluded[dataReg] = true;
+	if (jit->jo.softTLB &&
+	    GetSoftTLBScratchRegs(registersInUse, tlb_excluded, &tlb_base, &tlb_scratch))
+	{
+		FixupBranch miss = EmitSoftTLBLookup(this, ABI_PARAM1, 0, info.operandSize * 8, false, tlb_base, tlb_scratch);
+		LoadAndSwap(info.operandSize * 8, dataReg, MRegSum(tlb_base, ABI_PARAM1), info.signExtend);
+		if (push_param1)
+			POP(ABI_PARAM1);
+		JMP(returnPtr, true);
+		SetJumpTarget(miss);
+	}
+
 	ABI_PushRegistersAndAdjustStack(registersInUse, stack_offset);
 
 	switch (info.operandSize)
@@ -114,6 +130,41 @@ const u8* TrampolineCache::GenerateWriteTrampoline(const InstructionInfo &info,
 	// Don't treat FIFO writes specially for now because they require a burst
 	// check anyway.
 
+	X64Reg tlb_base, tlb_scratch;
+	BitSet32 tlb_excluded;
+	tlb_excluded[addrReg] = true;
+	if (!info.hasImmediate)
+		tlb_excluded[dataReg] = true;
+	if (jit->jo.softTLB && !(info.hasImmediate && info.operandSize == 8) &&
+	    GetSoftTLBScratchRegs(registersInUse, tlb_excluded, &tlb_base, &tlb_scratch))
+	{
+		FixupBranch miss = EmitSoftTLBLookup(this, addrReg, info.displacement, info.operandSize * 8, true, tlb_base, tlb_scratch);
+		OpArg dest = MComplex(tlb_base, addrReg, SCALE_1, info.displacement);
+		// The immediate is already in memory byte order, and the backpatcher
+		// has swapped a BSWAP-ed register back.
+		if (info.hasImmediate)
+		{
+			switch (info.operandSize)
+			{
+			case 4:
+				MOV(32, dest, Imm32((u32)info.immediate));
+				break;
+			case 2:
+				MOV(16, dest, Imm16((u16)info.immediate));
+				break;
+			case 1:
+				MOV(8, dest, Imm8((u8)info.immediate));
+				break;
+			}
+		}
+		else
+		{
+			SwapAndStore(info.operandSize * 8, dest, dataReg);
+		}
+		JMP(returnPtr, true);
+		SetJumpTarget(miss);
+	}
+
 	// PC is used by memory watchpoints (if enabled) or to print accurate PC locations in debug logs
 	MOV(32, PPCSTATE(pc), Imm32(pc));
 
@@ -2,6 +2,8 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <vector>
+
 #include "Common/Atomic.h"
 #include "Common/BitSet.h"
 #include "Common/CommonTypes.h"
@@ -62,6 +64,8 @@ enum XCheckTLBFlag
 	FLAG_OPCODE,
 };
 template <const XCheckTLBFlag flag> static u32 TranslateAddress(const u32 address);
+static void UpdateSoftTLB(const XCheckTLBFlag flag, const u32 address, const u32 physical_address);
+static void InvalidateSoftTLBEntry(u32 tag);
 
 // Nasty but necessary. Super Mario Galaxy pointer relies on this stuff.
 static u32 EFB_Read(const u32 addr)
@@ -220,6 +224,7 @@ __forceinline static T ReadFromHardware(const u32 em_address)
 	}
 
 	// The easy case!
+	UpdateSoftTLB(flag, em_address, tlb_addr);
 	return bswap(*(const T*)&Memory::physical_base[tlb_addr]);
 }
 
@@ -367,6 +372,7 @@ __forceinline static void WriteToHardware(u32 em_address, const T data)
 	}
 
 	// The easy case!
+	UpdateSoftTLB(flag, em_address, tlb_addr);
 	*(T*)&Memory::physical_base[tlb_addr] = bswap(data);
 }
 // =====================
@@ -974,7 +980,12 @@ static __forceinline TLBLookupResult LookupTLBPageAddress(const XCheckTLBFlag fl
 		}
 
 		if (flag != FLAG_NO_EXCEPTION)
+		{
+			// A software TLB hit doesn't update recent, so only the most recently used way may stay in it.
+			if (flag != FLAG_OPCODE && tlbe->recent != 0)
+				InvalidateSoftTLBEntry(tlbe->tag[1]);
 			tlbe->recent = 0;
+		}
 
 		*paddr = tlbe->paddr[0] | (vpa & 0xfff);
 
@@ -996,7 +1007,11 @@ static __forceinline TLBLookupResult LookupTLBPageAddress(const XCheckTLBFlag fl
 		}
 
 		if (flag != FLAG_NO_EXCEPTION)
+		{
+			if (flag != FLAG_OPCODE && tlbe->recent != 1)
+				InvalidateSoftTLBEntry(tlbe->tag[0]);
 			tlbe->recent = 1;
+		}
 
 		*paddr = tlbe->paddr[1] | (vpa & 0xfff);
 
@@ -1005,6 +1020,84 @@ static __forceinline TLBLookupResult LookupTLBPageAddress(const XCheckTLBFlag fl
 	return TLB_NOTFOUND;
 }
 
+static std::vector<soft_tlb_entry> s_soft_tlb;
+static u32 s_soft_tlb_mask;
+
+void InitSoftTLB(u32 size)
+{
+	while (size & (size - 1))
+		size &= size - 1;
+
+	s_soft_tlb.assign(size, soft_tlb_entry());
+	s_soft_tlb_mask = size ? size - 1 : 0;
+	ClearSoftTLB();
+}
+
+void ClearSoftTLB()
+{
+	for (soft_tlb_entry& entry : s_soft_tlb)
+	{
+		entry.read_tag = TLB_TAG_INVALID;
+		entry.write_tag = TLB_TAG_INVALID;
+		entry.host_base = 0;
+	}
+}
+
+const soft_tlb_entry* GetSoftTLB()
+{
+	return s_soft_tlb.empty() ? nullptr : s_soft_tlb.data();
+}
+
+u32 GetSoftTLBMask()
+{
+	return s_soft_tlb_mask;
+}
+
+static void InvalidateSoftTLBEntry(u32 tag)
+{
+	if (s_soft_tlb.empty() || tag == TLB_TAG_INVALID)
+		return;
+
+	soft_tlb_entry& entry = s_soft_tlb[tag & s_soft_tlb_mask];
+	if (entry.read_tag == tag)
+	{
+		entry.read_tag = TLB_TAG_INVALID;
+		entry.write_tag = TLB_TAG_INVALID;
+	}
+}
+
+// Called after a data access was translated through the guest TLB. An entry
+// only mirrors the most recently used way of its guest TLB set, since a hit
+// can't update the set's recent bit; it is dropped again as soon as the way
+// stops being the most recent one, or is replaced or invalidated.
+static void UpdateSoftTLB(const XCheckTLBFlag flag, const u32 address, const u32 physical_address)
+{
+	if (s_soft_tlb.empty() || (flag != FLAG_READ && flag != FLAG_WRITE))
+		return;
+
+	u32 tag = address >> HW_PAGE_INDEX_SHIFT;
+	const PowerPC::tlb_entry& tlbe = PowerPC::ppcState.tlb[0][tag & HW_PAGE_INDEX_MASK];
+	// Not the case after a write which only set the C bit of an entry.
+	if (tlbe.tag[tlbe.recent] != tag)
+		return;
+
+	// Only cache pages backed by RAM, which the JIT can access directly.
+	u32 physical_page = physical_address & ~(HW_PAGE_SIZE - 1);
+	bool is_ram = physical_page < Memory::REALRAM_SIZE ||
+	              (Memory::m_pEXRAM && physical_page >= 0x10000000 && physical_page < 0x10000000 + Memory::EXRAM_SIZE);
+	if (!is_ram)
+		return;
+
+	soft_tlb_entry& entry = s_soft_tlb[tag & s_soft_tlb_mask];
+	if (entry.read_tag != tag)
+		entry.write_tag = TLB_TAG_INVALID;
+	entry.read_tag = tag;
+	// A successful write translation has set the C bit.
+	if (flag == FLAG_WRITE)
+		entry.write_tag = tag;
+	entry.host_base = (u64)(Memory::physical_base + physical_page) - (address & ~(HW_PAGE_SIZE - 1));
+}
+
 static __forceinline void UpdateTLBEntry(const XCheckTLBFlag flag, UPTE2 PTE2, const u32 address)
 {
 	if (flag == FLAG_NO_EXCEPTION)
@@ -1013,6 +1106,12 @@ static __forceinline void UpdateTLBEntry(const XCheckTLBFlag flag, UPTE2 PTE2, c
 	int tag = address >> HW_PAGE_INDEX_SHIFT;
 	PowerPC::tlb_entry *tlbe = &PowerPC::ppcState.tlb[flag == FLAG_OPCODE][tag & HW_PAGE_INDEX_MASK];
 	int index = tlbe->recent == 0 && tlbe->tag[0] != TLB_TAG_INVALID;
+	if (flag != FLAG_OPCODE)
+	{
+		// The replaced way goes, and the other one is no longer the most recent.
+		InvalidateSoftTLBEntry(tlbe->tag[0]);
+		InvalidateSoftTLBEntry(tlbe->tag[1]);
+	}
 	tlbe->recent = index;
 	tlbe->paddr[index] = PTE2.RPN << HW_PAGE_INDEX_SHIFT;
 	tlbe->pte[index] = PTE2.Hex;
@@ -1022,6 +1121,8 @@ static __forceinline void UpdateTLBEntry(const XCheckTLBFlag flag, UPTE2 PTE2, c
 void InvalidateTLBEntry(u32 address)
 {
 	PowerPC::tlb_entry *tlbe = &PowerPC::ppcState.tlb[0][(address >> HW_PAGE_INDEX_SHIFT) & HW_PAGE_INDEX_MASK];
+	InvalidateSoftTLBEntry(tlbe->tag[0]);
+	InvalidateSoftTLBEntry(tlbe->tag[1]);
 	tlbe->tag[0] = TLB_TAG_INVALID;
 	tlbe->tag[1] = TLB_TAG_INVALID;
 	PowerPC::tlb_entry *tlbe_i = &PowerPC::ppcState.tlb[1][(address >> HW_PAGE_INDEX_SHIFT) & HW_PAGE_INDEX_MASK];
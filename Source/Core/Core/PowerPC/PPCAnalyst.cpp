@@ -10,6 +10,7 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/GeckoCode.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PPCAnalyst.h"
@@ -34,6 +35,8 @@ namespace PPCAnalyst
 static const int CODEBUFFER_SIZE = 32000;
 // 0 does not perform block merging
 static const u32 FUNCTION_FOLLOWING_THRESHOLD = 16;
+// Maximum number of unconditional branches followed into one trace
+static const u32 BRANCH_FOLLOWING_THRESHOLD = 8;
 
 CodeBuffer::CodeBuffer(int size)
 {
@@ -623,6 +626,23 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInf
 	}
 }
 
+// Only follow a branch to code that isn't in the trace already, so that loops stay loops
+// instead of getting unrolled, and that can be read without faulting.
+static bool CanFollowBranch(const CodeBlock *block, u32 destination)
+{
+	for (const auto& segment : block->m_segments)
+	{
+		if (destination >= segment.first && destination - segment.first < segment.second * 4)
+			return false;
+	}
+
+	if (HLE::GetFunctionIndex(destination) != 0)
+		return false;
+
+	auto result = PowerPC::TryReadInstruction(destination);
+	return result.valid && result.from_bat;
+}
+
 u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32 blockSize)
 {
 	// Clear block stats
@@ -643,12 +663,15 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 	block->m_memory_exception = false;
 	block->m_num_instructions = 0;
 	block->m_gqr_used = BitSet8(0);
+	block->m_segments.clear();
+	block->m_segments.emplace_back(address, 0);
 
 	CodeOp *code = buffer->codebuffer;
 
 	bool found_exit = false;
 	u32 return_address = 0;
 	u32 numFollows = 0;
+	u32 numBranchFollows = 0;
 	u32 num_inst = 0;
 	bool prev_inst_from_bat = true;
 
@@ -674,6 +697,7 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 		prev_inst_from_bat = result.from_bat;
 
 		num_inst++;
+		block->m_segments.back().second++;
 		memset(&code[i], 0, sizeof(CodeOp));
 		GekkoOPInfo *opinfo = GetOpInfo(inst);
 
@@ -768,7 +792,25 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 			}
 		}
 
-		if (!follow)
+		bool follow_branch = false;
+		if (HasOption(OPTION_BRANCH_FOLLOW) && !follow && inst.OPCD == 18 && !inst.LK &&
+		    numBranchFollows < BRANCH_FOLLOWING_THRESHOLD && i + 1 < blockSize && result.from_bat)
+		{
+			if (inst.AA)
+				destination = SignExt26(inst.LI << 2);
+			else
+				destination = address + SignExt26(inst.LI << 2);
+			follow_branch = CanFollowBranch(block, destination);
+		}
+
+		if (follow_branch)
+		{
+			// The branch itself stays in the block; it just doesn't end it.
+			numBranchFollows++;
+			address = destination;
+			block->m_segments.emplace_back(address, 0);
+		}
+		else if (!follow)
 		{
 			address += 4;
 			if (!conditional_continue && opinfo->flags & FL_ENDBLOCK) //right now we stop early
@@ -792,6 +834,8 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 	}
 
 	block->m_num_instructions = num_inst;
+	if (block->m_segments.size() > 1 && block->m_segments.back().second == 0)
+		block->m_segments.pop_back();
 
 	if (block->m_num_instructions > 1)
 		ReorderInstructions(block->m_num_instructions, code);
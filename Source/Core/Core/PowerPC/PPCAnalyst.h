@@ -8,6 +8,7 @@
 #include <cstdlib>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Common/BitSet.h"
@@ -164,6 +165,10 @@ struct CodeBlock
 
 	// Which GQRs this block modifies, if any.
 	BitSet8 m_gqr_modified;
+
+	// Start address and number of instructions of each run of contiguous code in the block.
+	// Blocks only have more than one if OPTION_BRANCH_FOLLOW is set.
+	std::vector<std::pair<u32, u32>> m_segments;
 };
 
 class PPCAnalyzer
@@ -221,6 +226,11 @@ public:
 
 		// Reorder cror instructions next to their associated fcmp.
 		OPTION_CROR_MERGE =  (1 << 6),
+
+		// Keep going at the target of unconditional branches (b, not bl), so that a chain of
+		// blocks becomes one trace with side exits at its conditional branches.
+		// The JIT must not emit an exit for a branch that isn't the last instruction.
+		OPTION_BRANCH_FOLLOW = (1 << 7),
 	};
 
 
@@ -230,6 +240,7 @@ public:
 	void SetOption(AnalystOption option) { m_options |= option; }
 	void ClearOption(AnalystOption option) { m_options &= ~(option); }
 	bool HasOption(AnalystOption option) const { return !!(m_options & option); }
+	u32 GetOptions() const { return m_options; }
 
 	u32 Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32 blockSize);
 };
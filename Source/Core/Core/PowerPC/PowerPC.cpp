@@ -2,12 +2,15 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include "Common/ChunkFile.h"
 #include "Common/CommonTypes.h"
 #include "Common/Event.h"
 #include "Common/FPURoundMode.h"
 #include "Common/MathUtil.h"
 
+#include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/Host.h"
@@ -20,6 +23,7 @@
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PowerPC.h"
 #include "Core/PowerPC/PPCTables.h"
+#include "Core/PowerPC/Profiler.h"
 #include "Core/PowerPC/Interpreter/Interpreter.h"
 
 
@@ -70,6 +74,10 @@ void DoState(PointerWrap &p)
 
 	p.DoPOD(ppcState);
 
+	// The software TLB mirrors the guest TLB we just replaced.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		ClearSoftTLB();
+
 	// SystemTimers::DecrementerSet();
 	// SystemTimers::TimeBaseSet();
 
@@ -135,9 +143,11 @@ void Init(int cpu_core)
 			}
 		}
 	}
+	InitSoftTLB(std::max(SConfig::GetInstance().iSoftTLBSize, 0));
 
 	ResetRegisters();
 	PPCTables::InitTables(cpu_core);
+	Profiler::Init();
 
 	// We initialize the interpreter because
 	// it is used on boot and code window independently.
@@ -177,8 +187,10 @@ void Init(int cpu_core)
 
 void Shutdown()
 {
+	Profiler::Shutdown();
 	JitInterface::Shutdown();
 	interpreter->Shutdown();
+	InitSoftTLB(0);
 	cpu_core_base = nullptr;
 	state = CPU_POWERDOWN;
 }
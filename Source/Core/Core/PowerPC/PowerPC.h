@@ -56,6 +56,21 @@ struct tlb_entry
 	u8 recent;
 };
 
+// Host-side software TLB: a direct-mapped cache of the data translations
+// currently held by the guest TLB, indexed by effective page number.  The JIT
+// probes it inline before calling the Read_U*/Write_U* functions, only while
+// MSR.DR is set.  It only ever mirrors the most recently used way of each
+// ppcState.tlb set, so it isn't part of the saved state.
+struct soft_tlb_entry
+{
+	u32 read_tag;
+	// Only set once the page's C bit is set, so a hit never needs to update it.
+	u32 write_tag;
+	// Host pointer to the start of the physical page, minus the effective
+	// address of the page.
+	u64 host_base;
+};
+
 // This contains the entire state of the emulated PowerPC "Gekko" CPU.
 struct PowerPCState
 {
@@ -265,6 +280,13 @@ void ClearCacheLine(const u32 address); // Zeroes 32 bytes; address should be 32
 void SDRUpdated();
 void InvalidateTLBEntry(u32 address);
 
+// Software TLB.  size is rounded down to a power of two; 0 disables it.
+void InitSoftTLB(u32 size);
+void ClearSoftTLB();
+// Returns nullptr if the software TLB is disabled.
+const soft_tlb_entry* GetSoftTLB();
+u32 GetSoftTLBMask();
+
 // Result changes based on the BAT registers and MSR.DR.  Returns whether
 // it's safe to optimize a read or write to this address to an unguarded
 // memory access.  Does not consider page tables.
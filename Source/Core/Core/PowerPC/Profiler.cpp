@@ -2,8 +2,21 @@
 // Licensed under GPLv2+
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
+
+#include "Common/FileUtil.h"
+#include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Core/CoreTiming.h"
 #include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/PPCSymbolDB.h"
 #include "Core/PowerPC/Profiler.h"
 
 namespace Profiler
@@ -11,9 +24,156 @@ namespace Profiler
 
 bool g_ProfileBlocks;
 
+static int s_event_sample;
+static std::atomic<bool> s_sampling;
+// Bumped by every StartSampling. The sample events carry the generation that
+// scheduled them, so a chain left over from before a restart ends instead of
+// running alongside the new one. They carry their interval too (in the upper
+// half of the userdata), so the CPU thread never reads the GUI thread's setting.
+static std::atomic<u32> s_generation;
+
+// Stacks are stored innermost first, as function start addresses (or the
+// raw address where no symbol is known), and named when they're written.
+static std::mutex s_samples_lock;
+static std::map<std::vector<u32>, u64> s_samples;
+// The interval the samples above were taken at, in cycles.
+static u32 s_samples_interval = DEFAULT_SAMPLE_INTERVAL;
+
 void WriteProfileResults(const std::string& filename)
 {
 	JitInterface::WriteProfileResults(filename);
 }
 
+static u32 GetFrameID(u32 address)
+{
+	Symbol* symbol = g_symbolDB.GetSymbolFromAddr(address);
+	return symbol ? symbol->address : address;
+}
+
+static void PushFrame(std::vector<u32>* stack, u32 address)
+{
+	// Merge consecutive frames in the same function; LR and the saved return
+	// address of the current frame usually name the same caller.
+	u32 id = GetFrameID(address);
+	if (stack->empty() || stack->back() != id)
+		stack->push_back(id);
+}
+
+static bool IsStackBottom(u32 address)
+{
+	return !address || !PowerPC::HostIsRAMAddress(address);
+}
+
+static void RecordSample()
+{
+	std::vector<u32> stack;
+	PushFrame(&stack, PC);
+
+	// Leaf functions don't save LR, so their caller only shows up there.
+	if (LR)
+		PushFrame(&stack, LR - 4);
+
+	u32 sp = PowerPC::ppcState.gpr[1];
+	if (!IsStackBottom(sp))
+	{
+		u32 frame = PowerPC::HostRead_U32(sp);
+		for (size_t depth = 0;
+		     depth < MAX_SAMPLE_DEPTH && !IsStackBottom(frame) && !IsStackBottom(frame + 4);
+		     depth++)
+		{
+			u32 return_address = PowerPC::HostRead_U32(frame + 4);
+			if (!return_address)
+				break;
+			PushFrame(&stack, return_address - 4);
+			frame = PowerPC::HostRead_U32(frame);
+		}
+	}
+
+	std::lock_guard<std::mutex> lk(s_samples_lock);
+	s_samples[stack]++;
+}
+
+static void SampleCallback(u64 userdata, int cycles_late)
+{
+	u32 generation = (u32)userdata;
+	u32 interval = (u32)(userdata >> 32);
+	if (!s_sampling || generation != s_generation)
+		return;
+
+	RecordSample();
+	CoreTiming::ScheduleEvent(std::max<int>((int)interval - cycles_late, 0), s_event_sample, userdata);
+}
+
+void Init()
+{
+	s_event_sample = CoreTiming::RegisterEvent("ProfilerSample", SampleCallback);
+	s_sampling = false;
+}
+
+void Shutdown()
+{
+	s_sampling = false;
+}
+
+void StartSampling(u32 interval)
+{
+	interval = std::max<u32>(interval, 1);
+	{
+		std::lock_guard<std::mutex> lk(s_samples_lock);
+		s_samples.clear();
+		s_samples_interval = interval;
+	}
+
+	s_sampling = true;
+	CoreTiming::ScheduleEvent_Threadsafe(interval, s_event_sample, (u64)interval << 32 | ++s_generation);
+}
+
+void StopSampling()
+{
+	// A sample that is already scheduled sees the flag, or a newer generation
+	// if sampling was restarted in the meantime, and doesn't reschedule.
+	s_sampling = false;
+}
+
+bool IsSampling()
+{
+	return s_sampling;
+}
+
+static std::string GetFrameName(u32 id)
+{
+	Symbol* symbol = g_symbolDB.GetSymbolFromAddr(id);
+	std::string name = (symbol && symbol->address == id) ? symbol->name : StringFromFormat("%08x", id);
+	// ';' separates frames in the collapsed format.
+	std::replace(name.begin(), name.end(), ';', ':');
+	return name;
+}
+
+void WriteCollapsedStacks(const std::string& filename)
+{
+	File::IOFile f(filename, "w");
+	if (!f)
+	{
+		PanicAlert("Failed to open %s", filename.c_str());
+		return;
+	}
+
+	std::lock_guard<std::mutex> lk(s_samples_lock);
+	std::map<std::string, u64> lines;
+	for (const auto& sample : s_samples)
+	{
+		std::string line;
+		for (auto it = sample.first.rbegin(); it != sample.first.rend(); ++it)
+		{
+			if (!line.empty())
+				line += ';';
+			line += GetFrameName(*it);
+		}
+		lines[line] += sample.second;
+	}
+
+	for (const auto& line : lines)
+		fprintf(f.GetHandle(), "%s %" PRIu64 "\n", line.first.c_str(), line.second * s_samples_interval);
+}
+
 }  // namespace
@@ -69,4 +69,23 @@ namespace Profiler
 extern bool g_ProfileBlocks;
 
 void WriteProfileResults(const std::string& filename);
+
+// Sampling profiler.  Every interval emulated cycles, a CoreTiming event
+// records the guest call stack (the current function, LR and the stack's back
+// chain), resolved to functions through g_symbolDB.  Samples are taken in
+// emulated time, so the same movie or FIFO log gives the same profile.
+static const u32 DEFAULT_SAMPLE_INTERVAL = 50000;
+static const size_t MAX_SAMPLE_DEPTH = 32;
+
+void Init();
+void Shutdown();
+
+// Discards the previous samples.  Safe to call from any thread.
+void StartSampling(u32 interval = DEFAULT_SAMPLE_INTERVAL);
+void StopSampling();
+bool IsSampling();
+
+// Writes one "outer;...;inner cycles" line per distinct call stack, the
+// collapsed format read by flamegraph.pl and similar tools.
+void WriteCollapsedStacks(const std::string& filename);
 }
@@ -66,7 +66,7 @@ static Common::Event g_compressAndDumpStateSyncEvent;
 static std::thread g_save_thread;
 
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 47; // Last changed in PR 3045
+static const u32 STATE_VERSION = 48; // Last changed: AX HLE deferred work end
 
 // Maps savestate versions to Dolphin versions.
 // Versions after 42 don't need to be added to this list,
@@ -35,6 +35,7 @@ void AudioConfigPane::InitializeGUI()
 
 	m_dsp_engine_radiobox = new wxRadioBox(this, wxID_ANY, _("DSP Emulator Engine"), wxDefaultPosition, wxDefaultSize, m_dsp_engine_strings, 0, wxRA_SPECIFY_ROWS);
 	m_dpl2_decoder_checkbox = new wxCheckBox(this, wxID_ANY, _("Dolby Pro Logic II decoder"));
+	m_polyphase_resampler_checkbox = new wxCheckBox(this, wxID_ANY, _("High quality resampling"));
 	m_volume_slider = new wxSlider(this, wxID_ANY, 0, 0, 100, wxDefaultPosition, wxDefaultSize, wxSL_VERTICAL | wxSL_INVERSE);
 	m_volume_text = new wxStaticText(this, wxID_ANY, "");
 	m_audio_backend_choice = new wxChoice(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, m_audio_backend_strings);
@@ -42,6 +43,7 @@ void AudioConfigPane::InitializeGUI()
 
 	m_dsp_engine_radiobox->Bind(wxEVT_RADIOBOX, &AudioConfigPane::OnDSPEngineRadioBoxChanged, this);
 	m_dpl2_decoder_checkbox->Bind(wxEVT_CHECKBOX, &AudioConfigPane::OnDPL2DecoderCheckBoxChanged, this);
+	m_polyphase_resampler_checkbox->Bind(wxEVT_CHECKBOX, &AudioConfigPane::OnPolyphaseResamplerCheckBoxChanged, this);
 	m_volume_slider->Bind(wxEVT_SLIDER, &AudioConfigPane::OnVolumeSliderChanged, this);
 	m_audio_backend_choice->Bind(wxEVT_CHOICE, &AudioConfigPane::OnAudioBackendChanged, this);
 	m_audio_latency_spinctrl->Bind(wxEVT_SPINCTRL, &AudioConfigPane::OnLatencySpinCtrlChanged, this);
@@ -53,10 +55,12 @@ void AudioConfigPane::InitializeGUI()
 #else
 	m_dpl2_decoder_checkbox->SetToolTip(_("Enables Dolby Pro Logic II emulation using 5.1 surround. OpenAL or Pulse backends only."));
 #endif
+	m_polyphase_resampler_checkbox->SetToolTip(_("Uses a windowed-sinc filter instead of linear interpolation when converting audio to the output sample rate. Sounds cleaner but costs a little more CPU."));
 
 	wxStaticBoxSizer* const dsp_engine_sizer = new wxStaticBoxSizer(wxVERTICAL, this, _("Sound Settings"));
 	dsp_engine_sizer->Add(m_dsp_engine_radiobox, 0, wxALL | wxEXPAND, 5);
 	dsp_engine_sizer->Add(m_dpl2_decoder_checkbox, 0, wxALL, 5);
+	dsp_engine_sizer->Add(m_polyphase_resampler_checkbox, 0, wxALL, 5);
 
 	wxStaticBoxSizer* const volume_sizer = new wxStaticBoxSizer(wxVERTICAL, this, _("Volume"));
 	volume_sizer->Add(m_volume_slider, 1, wxLEFT | wxRIGHT, 13);
@@ -102,6 +106,7 @@ void AudioConfigPane::LoadGUIValues()
 	m_dpl2_decoder_checkbox->Enable(std::string(SConfig::GetInstance().sBackend) == BACKEND_OPENAL
 		|| std::string(SConfig::GetInstance().sBackend) == BACKEND_PULSEAUDIO);
 	m_dpl2_decoder_checkbox->SetValue(startup_params.bDPL2Decoder);
+	m_polyphase_resampler_checkbox->SetValue(startup_params.m_PolyphaseResampler);
 
 	m_audio_latency_spinctrl->Enable(std::string(SConfig::GetInstance().sBackend) == BACKEND_OPENAL);
 	m_audio_latency_spinctrl->SetValue(startup_params.iLatency);
@@ -130,6 +135,11 @@ void AudioConfigPane::OnDPL2DecoderCheckBoxChanged(wxCommandEvent&)
 	SConfig::GetInstance().bDPL2Decoder = m_dpl2_decoder_checkbox->IsChecked();
 }
 
+void AudioConfigPane::OnPolyphaseResamplerCheckBoxChanged(wxCommandEvent&)
+{
+	SConfig::GetInstance().m_PolyphaseResampler = m_polyphase_resampler_checkbox->IsChecked();
+}
+
 void AudioConfigPane::OnVolumeSliderChanged(wxCommandEvent& event)
 {
 	SConfig::GetInstance().m_Volume = m_volume_slider->GetValue();
@@ -182,6 +182,11 @@ void CCodeWindow::CreateMenuSymbols(wxMenuBar *pMenuBar)
 	pProfilerMenu->Append(IDM_PROFILE_BLOCKS, _("&Profile blocks"), wxEmptyString, wxITEM_CHECK);
 	pProfilerMenu->AppendSeparator();
 	pProfilerMenu->Append(IDM_WRITE_PROFILE, _("&Write to profile.txt, show"));
+	pProfilerMenu->AppendSeparator();
+	pProfilerMenu->Append(IDM_PROFILE_FUNCTIONS, _("&Sample functions"),
+		_("Periodically record the emulated call stack. The samples are taken in emulated time, so replaying the same movie gives the same profile."),
+		wxITEM_CHECK);
+	pProfilerMenu->Append(IDM_WRITE_FLAMEGRAPH, _("Write &flame graph stacks to profiler.folded"));
 	pMenuBar->Append(pProfilerMenu, _("&Profiler"));
 }
 
@@ -223,6 +228,21 @@ void CCodeWindow::OnProfilerMenu(wxCommandEvent& event)
 			}
 		}
 		break;
+	case IDM_PROFILE_FUNCTIONS:
+		if (GetMenuBar()->IsChecked(IDM_PROFILE_FUNCTIONS) && Core::IsRunning())
+			Profiler::StartSampling();
+		else
+			Profiler::StopSampling();
+		GetMenuBar()->Check(IDM_PROFILE_FUNCTIONS, Profiler::IsSampling());
+		break;
+	case IDM_WRITE_FLAMEGRAPH:
+		{
+			std::string filename = File::GetUserPath(D_DUMP_IDX) + "Debug/profiler.folded";
+			File::CreateFullPath(filename);
+			Profiler::WriteCollapsedStacks(filename);
+			Parent->StatusBarMessage("Wrote %s", filename.c_str());
+		}
+		break;
 	}
 }
 
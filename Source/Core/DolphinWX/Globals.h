@@ -243,6 +243,8 @@ enum
 	// Profiler
 	IDM_PROFILE_BLOCKS,
 	IDM_WRITE_PROFILE,
+	IDM_PROFILE_FUNCTIONS,
+	IDM_WRITE_FLAMEGRAPH,
 	// --------------------------------------------------------------
 
 	// --------------------------------------------------------------
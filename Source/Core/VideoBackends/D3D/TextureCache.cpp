@@ -139,10 +139,10 @@ void TextureCache::TCacheEntry::CopyRectangleFromTexture(
 	g_renderer->RestoreAPIState();
 }
 
-void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
+void TextureCache::TCacheEntry::Load(const u8* buffer, unsigned int width, unsigned int height,
 	unsigned int expanded_width, unsigned int level)
 {
-	D3D::ReplaceRGBATexture2D(texture->GetTex(), TextureCache::temp, width, height, expanded_width, level, usage);
+	D3D::ReplaceRGBATexture2D(texture->GetTex(), buffer, width, height, expanded_width, level, usage);
 }
 
 TextureCache::TCacheEntryBase* TextureCache::CreateTexture(const TCacheEntryConfig& config)
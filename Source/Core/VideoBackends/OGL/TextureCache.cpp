@@ -190,7 +190,7 @@ void TextureCache::TCacheEntry::CopyRectangleFromTexture(
 	g_renderer->RestoreAPIState();
 }
 
-void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
+void TextureCache::TCacheEntry::Load(const u8* buffer, unsigned int width, unsigned int height,
 	unsigned int expanded_width, unsigned int level)
 {
 	if (level >= config.levels)
@@ -205,7 +205,7 @@ void TextureCache::TCacheEntry::Load(unsigned int width, unsigned int height,
 	if (expanded_width != width)
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, expanded_width);
 
-	glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, width, height, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, temp);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA, width, height, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, buffer);
 
 	if (expanded_width != width)
 		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
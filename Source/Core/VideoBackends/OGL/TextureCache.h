@@ -38,7 +38,7 @@ private:
 			const MathUtil::Rectangle<int> &srcrect,
 			const MathUtil::Rectangle<int> &dstrect) override;
 
-		void Load(unsigned int width, unsigned int height,
+		void Load(const u8* buffer, unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int level) override;
 
 		void FromRenderTarget(u8 *dst, unsigned int dstFormat, u32 dstStride,
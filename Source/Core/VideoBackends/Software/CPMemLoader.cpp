@@ -55,6 +55,7 @@ void SWLoadCPReg(u32 sub_cmd, u32 value)
 
 	case 0xB0:
 		g_main_cp_state.array_strides[sub_cmd & 0xF] = value & 0xFF;
+		g_main_cp_state.bases_dirty = true;
 		break;
 	}
 }
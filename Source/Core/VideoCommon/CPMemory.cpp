@@ -23,8 +23,10 @@ void DoCPState(PointerWrap& p)
 	p.DoMarker("CP Memory");
 	if (p.mode == PointerWrap::MODE_READ)
 	{
-		CopyPreprocessCPStateFromMain();
+		// Before the copy, the preprocess state resolves the vertex arrays as
+		// well when there is a FIFO preprocessor thread.
 		g_main_cp_state.bases_dirty = true;
+		CopyPreprocessCPStateFromMain();
 	}
 }
 
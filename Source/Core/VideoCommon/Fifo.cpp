@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <atomic>
+#include <thread>
 
 #include "Common/Atomic.h"
 #include "Common/BlockingLoop.h"
@@ -24,6 +25,7 @@
 #include "VideoCommon/CPMemory.h"
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/Fifo.h"
+#include "VideoCommon/FifoPreprocessor.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/VertexLoaderManager.h"
@@ -34,6 +36,13 @@ bool g_bSkipCurrentFrame = false;
 
 static Common::BlockingLoop s_gpu_mainloop;
 
+// With bFifoPreprocessThread, the FIFO is read on a thread of its own, and the
+// GPU thread executes what FifoPreprocessor passes on.
+static bool s_use_preprocess_thread;
+static Common::BlockingLoop s_preprocess_loop;
+static std::thread s_preprocess_thread;
+static std::atomic<bool> s_preprocess_idle;
+
 static std::atomic<bool> s_emu_running_state;
 
 // Most of this array is unlikely to be faulted in...
@@ -102,14 +111,23 @@ void Fifo_Init()
 	ResetVideoBuffer();
 	if (SConfig::GetInstance().bCPUThread)
 		s_gpu_mainloop.Prepare();
+	s_use_preprocess_thread = SConfig::GetInstance().bCPUThread && SConfig::GetInstance().bFifoPreprocessThread;
+	if (s_use_preprocess_thread)
+	{
+		s_preprocess_loop.Prepare();
+		FifoPreprocessor::Init(&s_gpu_mainloop);
+	}
 	s_sync_ticks.store(0);
 }
 
 void Fifo_Shutdown()
 {
-	if (s_gpu_mainloop.IsRunning())
+	if (s_gpu_mainloop.IsRunning() || s_preprocess_loop.IsRunning())
 		PanicAlert("Fifo shutting down while active");
 
+	if (s_use_preprocess_thread)
+		FifoPreprocessor::Shutdown();
+
 	FreeMemoryPages(s_video_buffer, FIFO_SIZE + 4);
 	s_video_buffer = nullptr;
 	s_video_buffer_write_ptr = nullptr;
@@ -135,12 +153,15 @@ void ExitGpuLoop()
 
 	// Terminate GPU thread loop
 	s_emu_running_state.store(true);
+	s_preprocess_loop.Stop(false);
 	s_gpu_mainloop.Stop(false);
 }
 
 void EmulatorState(bool running)
 {
 	s_emu_running_state.store(running);
+	if (s_use_preprocess_thread)
+		s_preprocess_loop.Wakeup();
 	s_gpu_mainloop.Wakeup();
 }
 
@@ -275,6 +296,105 @@ void ResetVideoBuffer()
 }
 
 
+// Reads and runs the FIFO until it's empty or has to wait for the CPU, on the
+// GPU thread or on the preprocessor thread.
+static void ReadFifo()
+{
+	const SConfig& param = SConfig::GetInstance();
+	SCPFifoStruct &fifo = CommandProcessor::fifo;
+
+	CommandProcessor::SetCPStatusFromGPU();
+
+	// check if we are able to run this buffer
+	while (!CommandProcessor::IsInterruptWaiting() && fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint())
+	{
+		if (param.bSyncGPU && s_sync_ticks.load() < param.iSyncGpuMinDistance)
+			break;
+
+		u32 cyclesExecuted = 0;
+		u32 readPtr = fifo.CPReadPointer;
+		ReadDataFromFifo(readPtr);
+
+		if (readPtr == fifo.CPEnd)
+			readPtr = fifo.CPBase;
+		else
+			readPtr += 32;
+
+		_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0 ,
+			"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce instability in the game. Please report it.", fifo.CPReadWriteDistance - 32);
+
+		u8* write_ptr = s_video_buffer_write_ptr;
+		if (s_use_preprocess_thread)
+		{
+			bool sync;
+			s_video_buffer_read_ptr = FifoPreprocessor::Run(DataReader(s_video_buffer_read_ptr, write_ptr), &cyclesExecuted, &sync);
+			s_gpu_mainloop.Wakeup();
+
+			// Let the GPU thread catch up before the CPU can see the interrupt, or
+			// the breakpoint, which are when games expect the commands before them
+			// to have been executed.
+			if (sync || (fifo.bFF_BPEnable && readPtr == fifo.CPBreakpoint))
+				FifoPreprocessor::WaitForExecution();
+		}
+		else
+		{
+			s_video_buffer_read_ptr = OpcodeDecoder_Run(DataReader(s_video_buffer_read_ptr, write_ptr), &cyclesExecuted, false);
+		}
+
+		Common::AtomicStore(fifo.CPReadPointer, readPtr);
+		Common::AtomicAdd(fifo.CPReadWriteDistance, -32);
+		if ((write_ptr - s_video_buffer_read_ptr) == 0)
+			Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
+
+		CommandProcessor::SetCPStatusFromGPU();
+
+		if (param.bSyncGPU)
+		{
+			cyclesExecuted = (int)(cyclesExecuted / param.fSyncGpuOverclock);
+			int old = s_sync_ticks.fetch_sub(cyclesExecuted);
+			if (old > 0 && old - (int)cyclesExecuted <= 0)
+				s_sync_wakeup_event.Set();
+		}
+
+		// This call is pretty important in DualCore mode and must be called in the FIFO Loop.
+		// If we don't, s_swapRequested or s_efbAccessRequested won't be set to false
+		// leading the CPU thread to wait in Video_BeginField or Video_AccessEFB thus slowing things down.
+		// The GPU thread does it between the batches it executes when there is a preprocessor.
+		if (!s_use_preprocess_thread)
+			AsyncRequests::GetInstance()->PullEvents();
+	}
+
+	// fast skip remaining GPU time if fifo is empty
+	if (s_sync_ticks.load() > 0)
+	{
+		int old = s_sync_ticks.exchange(0);
+		if (old > 0)
+			s_sync_wakeup_event.Set();
+	}
+}
+
+static void PreprocessFifo()
+{
+	// Do nothing while paused
+	if (!s_emu_running_state.load() || g_use_deterministic_gpu_thread)
+		return;
+
+	s_preprocess_idle.store(false);
+	ReadFifo();
+	s_preprocess_idle.store(true);
+
+	// for the final VertexManager::Flush
+	s_gpu_mainloop.Wakeup();
+}
+
+static void PreprocessorThread()
+{
+	Common::SetCurrentThreadName("FIFO preprocessor");
+	FPURoundMode::LoadDefaultSIMDState();
+
+	s_preprocess_loop.Run(PreprocessFifo, 100);
+}
+
 // Description: Main FIFO update loop
 // Purpose: Keep the Core HW updated about the CPU-GPU distance
 void RunGpuLoop()
@@ -283,15 +403,21 @@ void RunGpuLoop()
 	AsyncRequests::GetInstance()->SetEnable(true);
 	AsyncRequests::GetInstance()->SetPassthrough(false);
 
+	if (s_use_preprocess_thread)
+		s_preprocess_thread = std::thread(PreprocessorThread);
+
 	s_gpu_mainloop.Run(
 	[] {
-		const SConfig& param = SConfig::GetInstance();
-
 		g_video_backend->PeekMessages();
 
-		// Do nothing while paused
+		// Do nothing while paused, but for executing what the preprocessor
+		// has decoded, it may be waiting for room to finish its work.
 		if (!s_emu_running_state.load())
+		{
+			if (s_use_preprocess_thread && !g_use_deterministic_gpu_thread)
+				while (FifoPreprocessor::Execute()) {}
 			return;
+		}
 
 		if (g_use_deterministic_gpu_thread)
 		{
@@ -309,68 +435,35 @@ void RunGpuLoop()
 		}
 		else
 		{
-			SCPFifoStruct &fifo = CommandProcessor::fifo;
-
 			AsyncRequests::GetInstance()->PullEvents();
 
-			CommandProcessor::SetCPStatusFromGPU();
-
-			// check if we are able to run this buffer
-			while (!CommandProcessor::IsInterruptWaiting() && fifo.bFF_GPReadEnable && fifo.CPReadWriteDistance && !AtBreakpoint())
+			if (s_use_preprocess_thread)
 			{
-				if (param.bSyncGPU && s_sync_ticks.load() < param.iSyncGpuMinDistance)
-					break;
-
-				u32 cyclesExecuted = 0;
-				u32 readPtr = fifo.CPReadPointer;
-				ReadDataFromFifo(readPtr);
-
-				if (readPtr == fifo.CPEnd)
-					readPtr = fifo.CPBase;
-				else
-					readPtr += 32;
-
-				_assert_msg_(COMMANDPROCESSOR, (s32)fifo.CPReadWriteDistance - 32 >= 0 ,
-					"Negative fifo.CPReadWriteDistance = %i in FIFO Loop !\nThat can produce instability in the game. Please report it.", fifo.CPReadWriteDistance - 32);
-
-				u8* write_ptr = s_video_buffer_write_ptr;
-				s_video_buffer_read_ptr = OpcodeDecoder_Run(DataReader(s_video_buffer_read_ptr, write_ptr), &cyclesExecuted, false);
-
-				Common::AtomicStore(fifo.CPReadPointer, readPtr);
-				Common::AtomicAdd(fifo.CPReadWriteDistance, -32);
-				if ((write_ptr - s_video_buffer_read_ptr) == 0)
-					Common::AtomicStore(fifo.SafeCPReadPointer, fifo.CPReadPointer);
-
-				CommandProcessor::SetCPStatusFromGPU();
-
-				if (param.bSyncGPU)
-				{
-					cyclesExecuted = (int)(cyclesExecuted / param.fSyncGpuOverclock);
-					int old = s_sync_ticks.fetch_sub(cyclesExecuted);
-					if (old > 0 && old - (int)cyclesExecuted <= 0)
-						s_sync_wakeup_event.Set();
-				}
-
-				// This call is pretty important in DualCore mode and must be called in the FIFO Loop.
-				// If we don't, s_swapRequested or s_efbAccessRequested won't be set to false
-				// leading the CPU thread to wait in Video_BeginField or Video_AccessEFB thus slowing things down.
-				AsyncRequests::GetInstance()->PullEvents();
+				while (FifoPreprocessor::Execute())
+					AsyncRequests::GetInstance()->PullEvents();
 			}
-
-			// fast skip remaining GPU time if fifo is empty
-			if (s_sync_ticks.load() > 0)
+			else
 			{
-				int old = s_sync_ticks.exchange(0);
-				if (old > 0)
-					s_sync_wakeup_event.Set();
+				ReadFifo();
 			}
 
 			// The fifo is empty and it's unlikely we will get any more work in the near future.
 			// Make sure VertexManager finishes drawing any primitives it has stored in it's buffer.
-			VertexManager::Flush();
+			if (!s_use_preprocess_thread || s_preprocess_idle.load())
+				VertexManager::Flush();
 		}
 	}, 100);
 
+	if (s_use_preprocess_thread)
+	{
+		// The GPU thread won't execute anything more, so a blocked preprocessor
+		// has to be woken up.
+		s_preprocess_loop.Stop(false);
+		FifoPreprocessor::Abort();
+		s_preprocess_thread.join();
+		FifoPreprocessor::Reset();
+	}
+
 	AsyncRequests::GetInstance()->SetEnable(false);
 	AsyncRequests::GetInstance()->SetPassthrough(true);
 }
@@ -382,11 +475,16 @@ void FlushGpu()
 	if (!param.bCPUThread || g_use_deterministic_gpu_thread)
 		return;
 
+	// The preprocessor wakes the GPU thread, so the GPU thread is done after it.
+	if (s_use_preprocess_thread)
+		s_preprocess_loop.Wait();
 	s_gpu_mainloop.Wait();
 }
 
 void GpuMaySleep()
 {
+	if (s_use_preprocess_thread)
+		s_preprocess_loop.AllowSleep();
 	s_gpu_mainloop.AllowSleep();
 }
 
@@ -444,6 +542,8 @@ void RunGpu()
 	// wake up GPU thread
 	if (param.bCPUThread)
 	{
+		if (s_use_preprocess_thread)
+			s_preprocess_loop.Wakeup();
 		s_gpu_mainloop.Wakeup();
 	}
 }
@@ -490,6 +590,14 @@ void Fifo_UpdateWantDeterminism(bool want)
 	}
 }
 
+bool Fifo_CanRecord()
+{
+	if (!s_use_preprocess_thread || g_use_deterministic_gpu_thread)
+		return true;
+
+	return FifoPreprocessor::IsExecutingPassedThrough();
+}
+
 int Fifo_Update(int ticks)
 {
 	const SConfig& param = SConfig::GetInstance();
@@ -501,7 +609,8 @@ int Fifo_Update(int ticks)
 	}
 
 	// GPU is sleeping, so no need for synchronization
-	if (s_gpu_mainloop.IsDone() || g_use_deterministic_gpu_thread)
+	Common::BlockingLoop& fifo_loop = s_use_preprocess_thread ? s_preprocess_loop : s_gpu_mainloop;
+	if (fifo_loop.IsDone() || g_use_deterministic_gpu_thread)
 	{
 		if (s_sync_ticks.load() < 0)
 		{
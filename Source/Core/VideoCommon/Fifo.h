@@ -51,3 +51,7 @@ bool AtBreakpoint();
 void ResetVideoBuffer();
 void Fifo_SetRendering(bool bEnabled);
 int Fifo_Update(int ticks);
+
+// Whether the GPU thread sees the commands as they are in the FIFO, which
+// FifoRecorder needs for a recording to start.
+bool Fifo_CanRecord();
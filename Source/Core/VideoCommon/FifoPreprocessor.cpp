@@ -0,0 +1,537 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+#include "Common/BlockingLoop.h"
+#include "Common/CommonTypes.h"
+#include "Common/Event.h"
+#include "Common/SPSCRingBuffer.h"
+#include "Core/FifoPlayer/FifoRecorder.h"
+#include "Core/HW/Memmap.h"
+#include "VideoCommon/BPMemory.h"
+#include "VideoCommon/CPMemory.h"
+#include "VideoCommon/DataReader.h"
+#include "VideoCommon/Fifo.h"
+#include "VideoCommon/FifoPreprocessor.h"
+#include "VideoCommon/OpcodeDecoding.h"
+#include "VideoCommon/Statistics.h"
+#include "VideoCommon/VertexLoaderBase.h"
+#include "VideoCommon/VertexLoaderManager.h"
+#include "VideoCommon/VertexManagerBase.h"
+#include "VideoCommon/XFMemory.h"
+
+namespace FifoPreprocessor
+{
+
+// The command ring holds the register loads as they were in the FIFO, and
+// these commands of its own. It is padded with GX_NOP.
+enum
+{
+	CMD_PRELOADED_PRIMITIVES = 0xC0, // followed by a PreloadedPrimitives
+	CMD_BEGIN_DISPLAY_LIST   = 0xC1,
+	CMD_END_DISPLAY_LIST     = 0xC2,
+	CMD_BEGIN_PASS_THROUGH   = 0xC3,
+	CMD_PASSED_THROUGH       = 0xC4, // followed by a u32 size and a FIFO command
+};
+
+struct PreloadedPrimitives
+{
+	VertexLoaderBase* loader;
+	const u8* vertices;
+	// the position in the vertex ring after the vertices
+	u64 vertices_end;
+	u32 count;
+	u32 primitive;
+	VertexLoaderManager::PositionCache positions;
+};
+
+static std::unique_ptr<Common::SPSCRingBuffer> s_commands;
+static std::unique_ptr<Common::SPSCRingBuffer> s_vertices;
+static Common::BlockingLoop* s_gpu_loop;
+
+// Set by the preprocessor thread before it waits for the GPU thread to
+// release space or to catch up.
+static std::atomic<bool> s_waiting;
+static std::atomic<bool> s_aborted;
+static Common::Event s_released_event;
+
+// FifoRecorder needs the commands as they are in the FIFO, and records them on
+// the GPU thread along with the memory they use. While it might, the commands
+// are passed through to OpcodeDecoder_Run on the GPU thread, which runs the
+// vertex loaders as well then.
+static bool s_passing_through;
+// GPU thread
+static bool s_executing_passed_through;
+
+void Init(Common::BlockingLoop* gpu_loop)
+{
+	// A command passed through can take up most of the video buffer.
+	s_commands.reset(new Common::SPSCRingBuffer(FIFO_SIZE * 2, GX_NOP));
+	s_vertices.reset(new Common::SPSCRingBuffer(VertexManager::MAXVBUFFERSIZE, 0));
+	s_gpu_loop = gpu_loop;
+	Reset();
+}
+
+void Shutdown()
+{
+	s_commands.reset();
+	s_vertices.reset();
+	s_gpu_loop = nullptr;
+}
+
+void Abort()
+{
+	s_aborted.store(true);
+	s_released_event.Set();
+}
+
+void Reset()
+{
+	s_commands->Clear();
+	s_vertices->Clear();
+	s_waiting.store(false);
+	s_aborted.store(false);
+	s_released_event.Reset();
+	s_passing_through = false;
+	s_executing_passed_through = false;
+}
+
+// The preprocessor thread calls this before checking its condition for the
+// last time and waiting for s_released_event, the GPU thread calls
+// NotifyReleased after releasing anything. Either the check sees the release,
+// or the event is set.
+static void AnnounceWait()
+{
+	s_waiting.store(true);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	s_gpu_loop->Wakeup();
+}
+
+static void NotifyReleased()
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (s_waiting.load() && s_waiting.exchange(false))
+		s_released_event.Set();
+}
+
+// Returns nullptr only when aborted.
+static u8* Reserve(Common::SPSCRingBuffer* ring, size_t size)
+{
+	u8* p = ring->Reserve(size);
+	while (!p && !s_aborted.load())
+	{
+		AnnounceWait();
+		p = ring->Reserve(size);
+		if (!p)
+			s_released_event.Wait();
+	}
+	return p;
+}
+
+void WaitForExecution()
+{
+	while (!s_commands->Empty() && !s_aborted.load())
+	{
+		AnnounceWait();
+		if (!s_commands->Empty())
+			s_released_event.Wait();
+	}
+}
+
+static void WriteCommand(const u8* command, size_t size)
+{
+	u8* p = Reserve(s_commands.get(), size);
+	if (!p)
+		return;
+	memcpy(p, command, size);
+	s_commands->Commit(size);
+}
+
+static void WriteMarker(u8 cmd)
+{
+	WriteCommand(&cmd, 1);
+}
+
+static void PassThrough(const u8* command, u32 size)
+{
+	u8* p = Reserve(s_commands.get(), 1 + sizeof(u32) + size);
+	if (!p)
+		return;
+	p[0] = CMD_PASSED_THROUGH;
+	memcpy(p + 1, &size, sizeof(u32));
+	memcpy(p + 1 + sizeof(u32), command, size);
+	s_commands->Commit(1 + sizeof(u32) + size);
+}
+
+// Returns -1 if the vertices aren't all in src yet, else the amount of bytes consumed.
+static int LoadVertices(int vtx_attr_group, int primitive, int count, DataReader src, bool pass_through)
+{
+	if (!count)
+		return 0;
+
+	VertexLoaderBase* loader = VertexLoaderManager::RefreshPreprocessLoader(vtx_attr_group);
+
+	int size = count * loader->m_VertexSize;
+	if ((int)src.size() < size)
+		return -1;
+
+	if (g_bSkipCurrentFrame || pass_through)
+		return size;
+
+	VertexLoaderManager::UpdatePreprocessVertexArrayPointers();
+
+	// The vertex loaders may write a few bytes past the last vertex.
+	const u32 stride = loader->m_native_vtx_decl.stride;
+	u8* vertices = Reserve(s_vertices.get(), count * stride + 4);
+	if (!vertices)
+		return size;
+
+	PreloadedPrimitives primitives;
+	primitives.loader = loader;
+	primitives.vertices = vertices;
+	primitives.count = loader->RunVertices(src, DataReader(vertices, nullptr), count);
+	primitives.primitive = primitive;
+	VertexLoaderManager::SavePositionCache(&primitives.positions);
+
+	s_vertices->Commit(primitives.count * stride);
+	primitives.vertices_end = s_vertices->GetWritePosition();
+
+	u8* p = Reserve(s_commands.get(), 1 + sizeof(primitives));
+	if (p)
+	{
+		p[0] = CMD_PRELOADED_PRIMITIVES;
+		memcpy(p + 1, &primitives, sizeof(primitives));
+		s_commands->Commit(1 + sizeof(primitives));
+	}
+	return size;
+}
+
+static bool RaisesInterrupt(u32 bp_cmd)
+{
+	switch (bp_cmd >> 24)
+	{
+	case BPMEM_SETDRAWDONE:
+		return (bp_cmd & 0xff) == 0x02;
+	case BPMEM_PE_TOKEN_INT_ID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static u8* Decode(DataReader src, u32* cycles, bool* sync, bool in_display_list, bool pass_through);
+
+static u32 DecodeDisplayList(u32 address, u32 size, bool* sync, bool pass_through)
+{
+	u8* startAddress = Memory::GetPointer(address);
+
+	u32 cycles = 0;
+
+	// Avoid the crash if Memory::GetPointer failed ..
+	if (startAddress != nullptr)
+	{
+		// When passing through, the display list only has to be decoded for
+		// g_preprocess_cp_state, OpcodeDecoder_Run executes it again.
+		if (!pass_through)
+			WriteMarker(CMD_BEGIN_DISPLAY_LIST);
+		Decode(DataReader(startAddress, startAddress + size), &cycles, sync, true, pass_through);
+		if (!pass_through)
+			WriteMarker(CMD_END_DISPLAY_LIST);
+	}
+
+	return cycles;
+}
+
+// Follows OpcodeDecoder_Run, except that it passes the commands on instead
+// of executing them.
+static u8* Decode(DataReader src, u32* cycles, bool* sync, bool in_display_list, bool pass_through)
+{
+	u32 totalCycles = 0;
+	u8* opcodeStart;
+	while (true)
+	{
+		opcodeStart = src.GetPointer();
+
+		if (!src.size())
+			goto end;
+
+		u8 cmd_byte = src.Read<u8>();
+		switch (cmd_byte)
+		{
+		case GX_NOP:
+			totalCycles += 6; // Hm, this means that we scan over nop streams pretty slowly...
+			break;
+
+		case GX_UNKNOWN_RESET:
+			totalCycles += 6; // Datel software uses this command
+			DEBUG_LOG(VIDEO, "GX Reset?: %08x", cmd_byte);
+			break;
+
+		case GX_LOAD_CP_REG:
+			{
+				if (src.size() < 1 + 4)
+					goto end;
+				totalCycles += 12;
+				u8 sub_cmd = src.Read<u8>();
+				u32 value = src.Read<u32>();
+				LoadCPReg(sub_cmd, value, true);
+				if (!pass_through)
+					WriteCommand(opcodeStart, src.GetPointer() - opcodeStart);
+			}
+			break;
+
+		case GX_LOAD_XF_REG:
+			{
+				if (src.size() < 4)
+					goto end;
+				u32 Cmd2 = src.Read<u32>();
+				int transfer_size = ((Cmd2 >> 16) & 15) + 1;
+				if (src.size() < transfer_size * sizeof(u32))
+					goto end;
+				totalCycles += 18 + 6 * transfer_size;
+				src.Skip<u32>(transfer_size);
+				if (!pass_through)
+					WriteCommand(opcodeStart, src.GetPointer() - opcodeStart);
+			}
+			break;
+
+		case GX_LOAD_INDX_A:
+		case GX_LOAD_INDX_B:
+		case GX_LOAD_INDX_C:
+		case GX_LOAD_INDX_D:
+			if (src.size() < 4)
+				goto end;
+			totalCycles += 6;
+			src.Skip<u32>();
+			if (!pass_through)
+				WriteCommand(opcodeStart, src.GetPointer() - opcodeStart);
+			break;
+
+		case GX_CMD_CALL_DL:
+			{
+				if (src.size() < 8)
+					goto end;
+				u32 address = src.Read<u32>();
+				u32 count = src.Read<u32>();
+
+				if (in_display_list)
+				{
+					totalCycles += 6;
+					WARN_LOG(VIDEO,"recursive display list detected");
+				}
+				else
+				{
+					totalCycles += 6 + DecodeDisplayList(address, count, sync, pass_through);
+				}
+			}
+			break;
+
+		case GX_CMD_UNKNOWN_METRICS: // zelda 4 swords calls it and checks the metrics registers after that
+			totalCycles += 6;
+			DEBUG_LOG(VIDEO, "GX 0x44: %08x", cmd_byte);
+			break;
+
+		case GX_CMD_INVL_VC: // Invalidate Vertex Cache
+			totalCycles += 6;
+			DEBUG_LOG(VIDEO, "Invalidate (vertex cache?)");
+			break;
+
+		case GX_LOAD_BP_REG:
+			{
+				if (src.size() < 4)
+					goto end;
+				totalCycles += 12;
+				u32 bp_cmd = src.Read<u32>();
+				if (RaisesInterrupt(bp_cmd))
+					*sync = true;
+				if (!pass_through)
+					WriteCommand(opcodeStart, src.GetPointer() - opcodeStart);
+			}
+			break;
+
+		// draw primitives
+		default:
+			if ((cmd_byte & 0xC0) == 0x80)
+			{
+				// load vertices
+				if (src.size() < 2)
+					goto end;
+				u16 num_vertices = src.Read<u16>();
+				int bytes = LoadVertices(
+					cmd_byte & GX_VAT_MASK,   // Vertex loader index (0 - 7)
+					(cmd_byte & GX_PRIMITIVE_MASK) >> GX_PRIMITIVE_SHIFT,
+					num_vertices,
+					src,
+					pass_through);
+
+				if (bytes < 0)
+					goto end;
+
+				src.Skip(bytes);
+
+				// 4 GPU ticks per vertex, 3 CPU ticks per GPU tick
+				totalCycles += num_vertices * 4 * 3 + 6;
+			}
+			else
+			{
+				// OpcodeDecoder_Run reports it when passing through
+				if (!pass_through)
+					OpcodeDecoder_ReportUnknownOpcode(cmd_byte, opcodeStart, true);
+				totalCycles += 1;
+			}
+			break;
+		}
+
+		if (pass_through && !in_display_list)
+			PassThrough(opcodeStart, u32(src.GetPointer() - opcodeStart));
+	}
+
+end:
+	if (cycles)
+	{
+		*cycles = totalCycles;
+	}
+	return opcodeStart;
+}
+
+u8* Run(DataReader src, u32* cycles, bool* sync)
+{
+	// Passing through from before the frame which starts the recording until
+	// after the one which ends it.
+	bool pass_through = FifoRecorder::GetInstance().IsRecording() || g_bRecordFifoData;
+	if (pass_through != s_passing_through)
+	{
+		if (pass_through)
+		{
+			WriteMarker(CMD_BEGIN_PASS_THROUGH);
+		}
+		else
+		{
+			// The vertex loaders may still be running on the GPU thread.
+			WaitForExecution();
+			g_preprocess_cp_state.bases_dirty = true;
+		}
+		s_passing_through = pass_through;
+	}
+
+	*sync = false;
+	return Decode(src, cycles, sync, false, pass_through);
+}
+
+bool IsExecutingPassedThrough()
+{
+	return s_executing_passed_through;
+}
+
+bool Execute()
+{
+	const u8* data;
+	size_t size = s_commands->Peek(&data);
+	if (!size)
+		return false;
+
+	// Only whole commands are committed, so the batch doesn't end in one.
+	DataReader src(const_cast<u8*>(data), const_cast<u8*>(data) + size);
+	while (src.size())
+	{
+		u8 cmd_byte = src.Read<u8>();
+		int refarray;
+		switch (cmd_byte)
+		{
+		case GX_NOP:
+			break;
+
+		case GX_LOAD_CP_REG:
+			{
+				u8 sub_cmd = src.Read<u8>();
+				u32 value = src.Read<u32>();
+				LoadCPReg(sub_cmd, value);
+				INCSTAT(stats.thisFrame.numCPLoads);
+			}
+			break;
+
+		case GX_LOAD_XF_REG:
+			{
+				u32 Cmd2 = src.Read<u32>();
+				int transfer_size = ((Cmd2 >> 16) & 15) + 1;
+				u32 xf_address = Cmd2 & 0xFFFF;
+				LoadXFReg(transfer_size, xf_address, src);
+				INCSTAT(stats.thisFrame.numXFLoads);
+				src.Skip<u32>(transfer_size);
+			}
+			break;
+
+		case GX_LOAD_INDX_A: //used for position matrices
+			refarray = 0xC;
+			goto load_indx;
+		case GX_LOAD_INDX_B: //used for normal matrices
+			refarray = 0xD;
+			goto load_indx;
+		case GX_LOAD_INDX_C: //used for postmatrices
+			refarray = 0xE;
+			goto load_indx;
+		case GX_LOAD_INDX_D: //used for lights
+			refarray = 0xF;
+			goto load_indx;
+		load_indx:
+			LoadIndexedXF(src.Read<u32>(), refarray);
+			break;
+
+		case GX_LOAD_BP_REG:
+			LoadBPReg(src.Read<u32>());
+			INCSTAT(stats.thisFrame.numBPLoads);
+			break;
+
+		case CMD_PRELOADED_PRIMITIVES:
+			{
+				PreloadedPrimitives primitives;
+				memcpy(&primitives, src.GetPointer(), sizeof(primitives));
+				src.Skip(sizeof(primitives));
+				VertexLoaderManager::DrawPreloadedVertices(primitives.loader, primitives.primitive,
+					primitives.count, primitives.vertices, primitives.positions);
+				s_vertices->ReleaseTo(primitives.vertices_end);
+			}
+			break;
+
+		case CMD_BEGIN_DISPLAY_LIST:
+			// temporarily swap dl and non-dl (small "hack" for the stats)
+			Statistics::SwapDL();
+			break;
+
+		case CMD_END_DISPLAY_LIST:
+			INCSTAT(stats.thisFrame.numDListsCalled);
+			// un-swap
+			Statistics::SwapDL();
+			break;
+
+		case CMD_BEGIN_PASS_THROUGH:
+			// The vertex arrays were last resolved for g_preprocess_cp_state.
+			g_main_cp_state.bases_dirty = true;
+			break;
+
+		case CMD_PASSED_THROUGH:
+			{
+				u32 command_size = src.Read<u32, false>();
+				s_executing_passed_through = true;
+				OpcodeDecoder_Run(DataReader(src.GetPointer(), src.GetPointer() + command_size), nullptr, false);
+				s_executing_passed_through = false;
+				src.Skip(command_size);
+			}
+			break;
+
+		default:
+			_assert_msg_(VIDEO, false, "FIFO preprocessor: bad command 0x%02x", cmd_byte);
+			break;
+		}
+	}
+
+	s_commands->Release(size);
+	NotifyReleased();
+	return true;
+}
+
+}
@@ -0,0 +1,60 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/DataReader.h"
+
+namespace Common
+{
+class BlockingLoop;
+}
+
+// Splits the GPU thread's work in dual core mode, when deterministic GPU
+// threading isn't in use.
+//
+// The FIFO preprocessor thread reads the FIFO, decodes the commands and runs
+// the vertex loaders on g_preprocess_cp_state, straight into a ring of
+// loaded vertices. The register loads and the loaded primitives are passed on
+// to the GPU thread through a ring of commands, and the GPU thread executes
+// them in order: it loads the registers, generates the indices and draws.
+//
+// While FifoRecorder is recording, the commands are passed through to
+// OpcodeDecoder_Run on the GPU thread instead.
+//
+// Indexed XF loads still read emulated RAM on the GPU thread. Vertex arrays
+// are read when the primitive is decoded, ahead of the register loads and
+// draws which came before it.
+namespace FifoPreprocessor
+{
+// gpu_loop is woken whenever there are commands to execute.
+void Init(Common::BlockingLoop* gpu_loop);
+void Shutdown();
+
+// preprocessor thread
+// Like OpcodeDecoder_Run, returns where the last complete command ended.
+// sync is set when a command which raises a CP interrupt has been decoded,
+// the FIFO shouldn't be read further until it has been executed.
+u8* Run(DataReader src, u32* cycles, bool* sync);
+
+// preprocessor thread
+// Blocks until the GPU thread has executed every command.
+void WaitForExecution();
+
+// GPU thread
+// Executes the commands decoded so far. Returns false if there were none.
+bool Execute();
+
+// GPU thread
+// Whether the command being executed was passed through as it is in the FIFO,
+// in which case the commands after it are as well while FifoRecorder is
+// recording.
+bool IsExecutingPassedThrough();
+
+// Makes a blocked Run or WaitForExecution return, for shutting down.
+void Abort();
+// Undoes Abort, when neither thread is running.
+void Reset();
+}
@@ -123,6 +123,14 @@ static void UnknownOpcode(u8 cmd_byte, void *buffer, bool preprocess)
 	}
 }
 
+void OpcodeDecoder_ReportUnknownOpcode(u8 cmd_byte, void* buffer, bool preprocess)
+{
+	if (!s_bFifoErrorSeen)
+		UnknownOpcode(cmd_byte, buffer, preprocess);
+	ERROR_LOG(VIDEO, "FIFO: Unknown Opcode(0x%02x @ %p, preprocessing = %s)", cmd_byte, buffer, preprocess ? "yes" : "no");
+	s_bFifoErrorSeen = true;
+}
+
 void OpcodeDecoder_Init()
 {
 	s_bFifoErrorSeen = false;
@@ -291,10 +299,7 @@ u8* OpcodeDecoder_Run(DataReader src, u32* cycles, bool in_display_list)
 			}
 			else
 			{
-				if (!s_bFifoErrorSeen)
-					UnknownOpcode(cmd_byte, opcodeStart, is_preprocess);
-				ERROR_LOG(VIDEO, "FIFO: Unknown Opcode(0x%02x @ %p, preprocessing = %s)", cmd_byte, opcodeStart, is_preprocess ? "yes" : "no");
-				s_bFifoErrorSeen = true;
+				OpcodeDecoder_ReportUnknownOpcode(cmd_byte, opcodeStart, is_preprocess);
 				totalCycles += 1;
 			}
 			break;
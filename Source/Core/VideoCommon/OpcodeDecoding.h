@@ -43,5 +43,8 @@ extern bool g_bRecordFifoData;
 void OpcodeDecoder_Init();
 void OpcodeDecoder_Shutdown();
 
+// Alerts on the first unknown opcode, and logs every one.
+void OpcodeDecoder_ReportUnknownOpcode(u8 cmd_byte, void* buffer, bool preprocess);
+
 template <bool is_preprocess = false>
 u8* OpcodeDecoder_Run(DataReader src, u32* cycles, bool in_display_list);
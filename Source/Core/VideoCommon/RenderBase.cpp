@@ -568,7 +568,9 @@ void Renderer::SetWindowSize(int width, int height)
 void Renderer::CheckFifoRecording()
 {
 	bool wasRecording = g_bRecordFifoData;
-	g_bRecordFifoData = FifoRecorder::GetInstance().IsRecording();
+	// With the FIFO preprocessor, the recording starts with the first frame
+	// whose commands are passed through.
+	g_bRecordFifoData = FifoRecorder::GetInstance().IsRecording() && (wasRecording || Fifo_CanRecord());
 
 	if (g_bRecordFifoData)
 	{
@@ -8,9 +8,15 @@
 #include "Common/StringUtil.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderManager.h"
+#include "VideoCommon/VideoConfig.h"
 
 Statistics stats;
 
+static int Percentage(int part, int total)
+{
+	return total ? part * 100 / total : 0;
+}
+
 void Statistics::ResetFrame()
 {
 	memset(&thisFrame, 0, sizeof(ThisFrame));
@@ -29,7 +35,14 @@ std::string Statistics::ToString()
 	std::string str;
 	str += StringFromFormat("Textures created: %i\n", stats.numTexturesCreated);
 	str += StringFromFormat("Textures uploaded: %i\n", stats.numTexturesUploaded);
+	str += StringFromFormat("Textures decoded async: %i\n", stats.numTexturesDecodedAsync);
 	str += StringFromFormat("Textures alive: %i\n", stats.numTexturesAlive);
+	str += StringFromFormat("Texture lookups: %i (%i%% hits)\n", stats.thisFrame.numTextureLookups,
+		Percentage(stats.thisFrame.numTextureHits, stats.thisFrame.numTextureLookups));
+	str += StringFromFormat("Texture allocations: %i (%i%% from pool)\n", stats.thisFrame.numTextureAllocations,
+		Percentage(stats.thisFrame.numTexturePoolReuses, stats.thisFrame.numTextureAllocations));
+	if (g_ActiveConfig.bTrackTextureWrites)
+		str += StringFromFormat("Texture hashes skipped: %i\n", stats.thisFrame.numTextureHashesSkipped);
 	str += StringFromFormat("pshaders created: %i\n", stats.numPixelShadersCreated);
 	str += StringFromFormat("pshaders alive: %i\n", stats.numPixelShadersAlive);
 	str += StringFromFormat("vshaders created: %i\n", stats.numVertexShadersCreated);
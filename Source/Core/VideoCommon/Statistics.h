@@ -19,6 +19,7 @@ struct Statistics
 
 	int numTexturesCreated;
 	int numTexturesUploaded;
+	int numTexturesDecodedAsync;
 	int numTexturesAlive;
 
 	int numVertexLoaders;
@@ -54,6 +55,12 @@ struct Statistics
 		int bytesVertexStreamed;
 		int bytesIndexStreamed;
 		int bytesUniformStreamed;
+
+		int numTextureLookups;
+		int numTextureHits;
+		int numTextureAllocations;
+		int numTexturePoolReuses;
+		int numTextureHashesSkipped;
 	};
 	ThisFrame thisFrame;
 	void ResetFrame();
@@ -19,21 +19,29 @@
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/TextureCacheBase.h"
+#include "VideoCommon/TextureDecodePool.h"
 #include "VideoCommon/VideoConfig.h"
 
 static const u64 TEXHASH_INVALID = 0;
 static const int TEXTURE_KILL_THRESHOLD = 64; // Sonic the Fighters (inside Sonic Gems Collection) loops a 64 frames animation
 static const int TEXTURE_POOL_KILL_THRESHOLD = 3;
 static const int FRAMECOUNT_INVALID = 0;
+// Textures with fewer texels over all levels decode on the GPU thread, as
+// splitting them up would cost more than it saves.
+static const u32 PARALLEL_DECODE_MIN_TEXELS = 256 * 256;
 
 TextureCache* g_texture_cache;
 
 alignas(16) u8* TextureCache::temp = nullptr;
 size_t TextureCache::temp_size;
 
-TextureCache::TexCache TextureCache::textures_by_address;
-TextureCache::TexCache TextureCache::textures_by_hash;
-TextureCache::TexPool TextureCache::texture_pool;
+TextureCache::TexAddressIndex TextureCache::textures_by_address;
+TextureCache::TexHashIndex TextureCache::textures_by_hash;
+TextureCache::EfbCopyIndex TextureCache::efb_copies;
+TextureCache::TexList TextureCache::textures_lru;
+u32 TextureCache::lru_generation;
+TextureCache::TexAddressIndex TextureCache::texture_pool;
+TextureCache::TexList TextureCache::texture_pool_lru;
 TextureCache::TCacheEntryBase* TextureCache::bound_textures[8];
 
 TextureCache::BackupConfig TextureCache::backup_config;
@@ -63,8 +71,11 @@ TextureCache::TextureCache()
 	TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
 
 	HiresTexture::Init();
+	TextureDecodePool::Init();
 
 	SetHash64Function();
+	if (g_ActiveConfig.bTrackTextureWrites && !Memory::SetWriteTracking(true))
+		WARN_LOG(VIDEO, "Texture write tracking is not supported on this platform");
 
 	invalidate_texture_cache_requested = false;
 }
@@ -78,23 +89,34 @@ void TextureCache::Invalidate()
 {
 	UnbindTextures();
 
-	for (auto& tex : textures_by_address)
+	TCacheEntryBase* entry = textures_lru.Front();
+	while (entry)
 	{
-		delete tex.second;
+		TCacheEntryBase* next = TexList::Next(entry);
+		delete entry;
+		entry = next;
 	}
-	textures_by_address.clear();
-	textures_by_hash.clear();
+	textures_by_address.Clear();
+	textures_by_hash.Clear();
+	efb_copies.Clear();
+	textures_lru.Clear();
 
-	for (auto& rt : texture_pool)
+	entry = texture_pool_lru.Front();
+	while (entry)
 	{
-		delete rt.second;
+		TCacheEntryBase* next = TexList::Next(entry);
+		delete entry;
+		entry = next;
 	}
-	texture_pool.clear();
+	texture_pool.Clear();
+	texture_pool_lru.Clear();
 }
 
 TextureCache::~TextureCache()
 {
 	HiresTexture::Shutdown();
+	TextureDecodePool::Shutdown();
+	Memory::SetWriteTracking(false);
 	Invalidate();
 	FreeAlignedMemory(temp);
 	temp = nullptr;
@@ -110,6 +132,18 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 			HiresTexture::Update();
 		}
 
+		if (config.iTextureDecodingThreads != backup_config.s_texture_decoding_threads)
+		{
+			TextureDecodePool::Shutdown();
+			TextureDecodePool::Init();
+		}
+
+		if (config.bTrackTextureWrites != backup_config.s_track_texture_writes &&
+			!Memory::SetWriteTracking(config.bTrackTextureWrites))
+		{
+			WARN_LOG(VIDEO, "Texture write tracking is not supported on this platform");
+		}
+
 		// TODO: Invalidating texcache is really stupid in some of these cases
 		if (config.iSafeTextureCache_ColorSamples != backup_config.s_colorsamples ||
 			config.bTexFmtOverlayEnable != backup_config.s_texfmt_overlay ||
@@ -137,65 +171,57 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 	backup_config.s_texfmt_overlay_center = config.bTexFmtOverlayCenter;
 	backup_config.s_hires_textures = config.bHiresTextures;
 	backup_config.s_cache_hires_textures = config.bCacheHiresTextures;
+	backup_config.s_texture_decoding_threads = config.iTextureDecodingThreads;
 	backup_config.s_stereo_3d = config.iStereoMode > 0;
 	backup_config.s_efb_mono_depth = config.bStereoEFBMonoDepth;
+	backup_config.s_track_texture_writes = config.bTrackTextureWrites;
 }
 
 void TextureCache::Cleanup(int _frameCount)
 {
-	TexCache::iterator iter = textures_by_address.begin();
-	TexCache::iterator tcend = textures_by_address.end();
-	while (iter != tcend)
+	// Entries used since the last cleanup are at the front of the list. Stamp
+	// them with the current frame, except for EFB copies which have been
+	// applied as partial texture updates and are stamped already.
+	for (TCacheEntryBase* entry = textures_lru.Front(); entry && entry->lru_generation == lru_generation;
+	     entry = TexList::Next(entry))
 	{
-		if (iter->second->frameCount == FRAMECOUNT_INVALID)
-		{
-			iter->second->frameCount = _frameCount;
-			++iter;
-		}
-		else if (_frameCount > TEXTURE_KILL_THRESHOLD + iter->second->frameCount)
+		if (entry->frameCount == FRAMECOUNT_INVALID)
+			entry->frameCount = _frameCount;
+	}
+	++lru_generation;
+
+	// Then walk from the back, where the entries unused for the longest time
+	// are, up to the first one which has not expired yet.
+	TCacheEntryBase* entry = textures_lru.Back();
+	while (entry && _frameCount > TEXTURE_KILL_THRESHOLD + entry->frameCount)
+	{
+		TCacheEntryBase* prev = TexList::Prev(entry);
+		if (entry->IsEfbCopy())
 		{
-			if (iter->second->IsEfbCopy())
-			{
-				// Only remove EFB copies when they wouldn't be used anymore(changed hash), because EFB copies living on the
-				// host GPU are unrecoverable. Perform this check only every TEXTURE_KILL_THRESHOLD for performance reasons
-				if ((_frameCount - iter->second->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
-					iter->second->hash != GetHash64(Memory::GetPointer(iter->second->addr), iter->second->size_in_bytes, g_ActiveConfig.iSafeTextureCache_ColorSamples))
-				{
-					iter = FreeTexture(iter);
-				}
-				else
-				{
-					++iter;
-				}
-			}
-			else
+			// Only remove EFB copies when they wouldn't be used anymore(changed hash), because EFB copies living on the
+			// host GPU are unrecoverable. Perform this check only every TEXTURE_KILL_THRESHOLD for performance reasons
+			if ((_frameCount - entry->frameCount) % TEXTURE_KILL_THRESHOLD == 1 &&
+				entry->hash != GetHash64(Memory::GetPointer(entry->addr), entry->size_in_bytes, g_ActiveConfig.iSafeTextureCache_ColorSamples))
 			{
-				iter = FreeTexture(iter);
+				FreeTexture(entry);
 			}
 		}
 		else
 		{
-			++iter;
+			FreeTexture(entry);
 		}
+		entry = prev;
 	}
 
-	TexPool::iterator iter2 = texture_pool.begin();
-	TexPool::iterator tcend2 = texture_pool.end();
-	while (iter2 != tcend2)
+	// Pooled entries are stamped when they are freed, so the list is in order.
+	entry = texture_pool_lru.Back();
+	while (entry && _frameCount > TEXTURE_POOL_KILL_THRESHOLD + entry->frameCount)
 	{
-		if (iter2->second->frameCount == FRAMECOUNT_INVALID)
-		{
-			iter2->second->frameCount = _frameCount;
-		}
-		if (_frameCount > TEXTURE_POOL_KILL_THRESHOLD + iter2->second->frameCount)
-		{
-			delete iter2->second;
-			iter2 = texture_pool.erase(iter2);
-		}
-		else
-		{
-			++iter2;
-		}
+		TCacheEntryBase* prev = TexList::Prev(entry);
+		texture_pool.Remove(entry);
+		texture_pool_lru.Remove(entry);
+		delete entry;
+		entry = prev;
 	}
 }
 
@@ -210,9 +236,8 @@ bool TextureCache::TCacheEntryBase::OverlapsMemoryRange(u32 range_address, u32 r
 	return true;
 }
 
-TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::iterator iter_t)
+TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TCacheEntryBase* entry_to_update)
 {
-	TCacheEntryBase* entry_to_update = iter_t->second;
 	const bool isPaletteTexture = (entry_to_update->format == GX_TF_C4
 		|| entry_to_update->format == GX_TF_C8
 		|| entry_to_update->format == GX_TF_C14X2
@@ -231,19 +256,23 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 
 	u32 numBlocksX = (entry_to_update->native_width + block_width - 1) / block_width;
 
-	TexCache::iterator iter = textures_by_address.lower_bound(entry_to_update->addr);
-	TexCache::iterator iterend = textures_by_address.upper_bound(entry_to_update->addr + entry_to_update->size_in_bytes);
+	auto iter = efb_copies.LowerBound(entry_to_update->addr);
 	bool entry_need_scaling = true;
-	while (iter != iterend)
+	for (; iter != efb_copies.end() && iter->address <= entry_to_update->addr + entry_to_update->size_in_bytes; ++iter)
 	{
-		TCacheEntryBase* entry = iter->second;
-		if (entry != entry_to_update
-			&& entry->IsEfbCopy()
-			&& entry_to_update->addr <= entry->addr
+		TCacheEntryBase* entry = iter->element;
+		if (entry_to_update->addr <= entry->addr
 			&& entry->addr + entry->size_in_bytes <= entry_to_update->addr + entry_to_update->size_in_bytes
 			&& entry->frameCount == FRAMECOUNT_INVALID
 			&& entry->memory_stride == numBlocksX * block_size)
 		{
+			// The copy has to land on top of the decoded data, not the placeholder.
+			if (entry_to_update->pending_decode)
+			{
+				entry_to_update->pending_decode->Wait();
+				UploadDecodedTexture(entry_to_update);
+			}
+
 			u32 block_offset = (entry->addr - entry_to_update->addr) / block_size;
 			u32 block_x = block_offset % numBlocksX;
 			u32 block_y = block_offset / numBlocksX;
@@ -262,10 +291,7 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 				u32 h = entry_to_update->native_height * entry->config.height / entry->native_height;
 				u32 max = g_renderer->GetMaxTextureSize();
 				if (max < w || max < h)
-				{
-					iter++;
 					continue;
-				}
 				if (entry_to_update->config.width != w || entry_to_update->config.height != h)
 				{
 					TextureCache::TCacheEntryConfig newconfig;
@@ -283,10 +309,9 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 					dstrect.right = w;
 					dstrect.bottom = h;
 					newentry->CopyRectangleFromTexture(entry_to_update, srcrect, dstrect);
+					FreeTexture(entry_to_update);
 					entry_to_update = newentry;
-					u64 key = iter_t->first;
-					iter_t = FreeTexture(iter_t);
-					textures_by_address.emplace(key, entry_to_update);
+					InsertTexture(entry_to_update);
 				}
 			}
 			srcrect.right = entry->config.width;
@@ -296,10 +321,11 @@ TextureCache::TCacheEntryBase* TextureCache::DoPartialTextureUpdates(TexCache::i
 			dstrect.right = (x + entry->native_width) * entry_to_update->config.width / entry_to_update->native_width;
 			dstrect.bottom = (y + entry->native_height) * entry_to_update->config.height / entry_to_update->native_height;
 			entry_to_update->CopyRectangleFromTexture(entry, srcrect, dstrect);
-			// Mark the texture update as used, so it isn't applied more than once
+			// Mark the texture update as used, so it isn't applied more than once. The new stamp
+			// has to match its place in the LRU list, or Cleanup() stops early at it.
 			entry->frameCount = frameCount;
+			TouchTexture(entry);
 		}
-		++iter;
 	}
 	return entry_to_update;
 }
@@ -331,6 +357,10 @@ static u32 CalculateLevelSize(u32 level_0_size, u32 level)
 // Used by TextureCache::Load
 TextureCache::TCacheEntryBase* TextureCache::ReturnEntry(unsigned int stage, TCacheEntryBase* entry)
 {
+	if (entry->pending_decode && entry->pending_decode->IsDone())
+		UploadDecodedTexture(entry);
+
+	TouchTexture(entry);
 	entry->frameCount = FRAMECOUNT_INVALID;
 	bound_textures[stage] = entry;
 
@@ -339,6 +369,18 @@ TextureCache::TCacheEntryBase* TextureCache::ReturnEntry(unsigned int stage, TCa
 	return entry;
 }
 
+void TextureCache::UploadDecodedTexture(TCacheEntryBase* entry)
+{
+	const TextureDecodeJob& job = *entry->pending_decode;
+	for (u32 level = 0; level < job.GetLevelCount(); ++level)
+	{
+		const TextureDecodeJob::Level& l = job.GetLevel(level);
+		entry->Load(l.dst, CalculateLevelSize(entry->config.width, level),
+		            CalculateLevelSize(entry->config.height, level), l.width, level);
+	}
+	entry->pending_decode.reset();
+}
+
 void TextureCache::BindTextures()
 {
 	for (int i = 0; i < 8; ++i)
@@ -402,8 +444,34 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	else
 		src_data = Memory::GetPointer(address);
 
+	// With write tracking, the hash of an entry at the address is still valid
+	// when none of the pages it covers have been written since it was taken.
+	// Otherwise the pages are protected again before hashing, so that writes
+	// racing with the hashing are noticed next time.
+	const bool write_tracked = !from_tmem && Memory::IsWriteTrackingEnabled();
+	u32 write_token = 0;
+	bool hash_known = false;
+	if (write_tracked)
+	{
+		for (TCacheEntryBase* entry = textures_by_address.Find(address); entry; entry = TexAddressIndex::Next(entry))
+		{
+			if (entry->write_tracked && entry->size_in_bytes == texture_size &&
+				!Memory::WrittenSince(address, texture_size, entry->write_token))
+			{
+				base_hash = entry->base_hash;
+				write_token = entry->write_token;
+				hash_known = true;
+				INCSTAT(stats.thisFrame.numTextureHashesSkipped);
+				break;
+			}
+		}
+		if (!hash_known)
+			write_token = Memory::TrackWrites(address, texture_size);
+	}
+
 	// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
-	base_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+	if (!hash_known)
+		base_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
 	u32 palette_size = 0;
 	if (isPaletteTexture)
 	{
@@ -445,15 +513,15 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	//
 	// For efb copies, the entry created in CopyRenderTargetToTexture always has to be used, or else it was
 	// done in vain.
-	std::pair<TexCache::iterator, TexCache::iterator> iter_range = textures_by_address.equal_range((u64)address);
-	TexCache::iterator iter = iter_range.first;
-	TexCache::iterator oldest_entry = iter;
+	INCSTAT(stats.thisFrame.numTextureLookups);
+	TCacheEntryBase* iter = textures_by_address.Find(address);
+	TCacheEntryBase* oldest_entry = nullptr;
 	int temp_frameCount = 0x7fffffff;
-	TexCache::iterator unconverted_copy = textures_by_address.end();
+	TCacheEntryBase* unconverted_copy = nullptr;
 
-	while (iter != iter_range.second)
+	while (iter)
 	{
-		TCacheEntryBase* entry = iter->second;
+		TCacheEntryBase* entry = iter;
 		if (entry->IsEfbCopy())
 		{
 			// EFB copies have slightly different rules as EFB copy formats have different
@@ -466,7 +534,10 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 				// texture formats. I'm not sure what effect checking width/height/levels
 				// would have.
 				if (!isPaletteTexture || !g_Config.backend_info.bSupportsPaletteConversion)
+				{
+					INCSTAT(stats.thisFrame.numTextureHits);
 					return ReturnEntry(stage, entry);
+				}
 
 				// Note that we found an unconverted EFB copy, then continue.  We'll
 				// perform the conversion later.  Currently, we only convert EFB copies to
@@ -480,7 +551,8 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 				// never be useful again.  It's theoretically possible for a game to do
 				// something weird where the copy could become useful in the future, but in
 				// practice it doesn't happen.
-				iter = FreeTexture(iter);
+				iter = TexAddressIndex::Next(iter);
+				FreeTexture(entry);
 				continue;
 			}
 		}
@@ -490,8 +562,11 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 			if (entry->hash == full_hash && entry->format == full_format && entry->native_levels >= tex_levels &&
 				entry->native_width == nativeW && entry->native_height == nativeH)
 			{
-				entry = DoPartialTextureUpdates(iter);
+				entry->write_tracked = write_tracked;
+				entry->write_token = write_token;
+				entry = DoPartialTextureUpdates(entry);
 
+				INCSTAT(stats.thisFrame.numTextureHits);
 				return ReturnEntry(stage, entry);
 			}
 		}
@@ -504,15 +579,15 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 			!(isPaletteTexture && entry->base_hash == base_hash))
 		{
 			temp_frameCount = entry->frameCount;
-			oldest_entry = iter;
+			oldest_entry = entry;
 		}
-		++iter;
+		iter = TexAddressIndex::Next(iter);
 	}
 
-	if (unconverted_copy != textures_by_address.end())
+	if (unconverted_copy)
 	{
 		// Perform palette decoding.
-		TCacheEntryBase *entry = unconverted_copy->second;
+		TCacheEntryBase *entry = unconverted_copy;
 
 		TCacheEntryConfig config;
 		config.rendertarget = true;
@@ -528,7 +603,8 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 		decoded_entry->is_efb_copy = false;
 
 		g_texture_cache->ConvertTexture(decoded_entry, entry, &texMem[tlutaddr], (TlutFormat)tlutfmt);
-		textures_by_address.emplace((u64)address, decoded_entry);
+		InsertTexture(decoded_entry);
+		INCSTAT(stats.thisFrame.numTextureHits);
 		return ReturnEntry(stage, decoded_entry);
 	}
 
@@ -539,20 +615,17 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
 		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
 	{
-		iter_range = textures_by_hash.equal_range(full_hash);
-		iter = iter_range.first;
-		while (iter != iter_range.second)
+		for (TCacheEntryBase* entry = textures_by_hash.Find(full_hash); entry; entry = TexHashIndex::Next(entry))
 		{
-			TCacheEntryBase* entry = iter->second;
 			// All parameters, except the address, need to match here
 			if (entry->format == full_format && entry->native_levels >= tex_levels &&
 				entry->native_width == nativeW && entry->native_height == nativeH)
 			{
-				entry = DoPartialTextureUpdates(iter);
+				entry = DoPartialTextureUpdates(entry);
 
+				INCSTAT(stats.thisFrame.numTextureHits);
 				return ReturnEntry(stage, entry);
 			}
-			++iter;
 		}
 	}
 
@@ -588,23 +661,111 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 		}
 	}
 
+	// how many levels the allocated texture shall have
+	const u32 texLevels = hires_tex ? (u32)hires_tex->m_levels.size() : tex_levels;
+
+	// Work out where each level is read from, and where it goes in the
+	// decoded data.
+	struct DecodedLevel
+	{
+		const u8* src;
+		u32 width, height;
+		u32 expanded_width, expanded_height;
+		size_t offset;
+	};
+	std::vector<DecodedLevel> levels;
+	size_t source_size = 0;
+	size_t decoded_size = 0;
+	u32 decoded_texels = 0;
 	if (!hires_tex)
 	{
-		if (!(texformat == GX_TF_RGBA8 && from_tmem))
+		// Mipmaps in tmem alternate between the even and odd banks.
+		// TODO: Loading mipmaps from tmem is untested!
+		const u8* ptr_ram = src_data;
+		const u8* ptr_even = src_data + texture_size;
+		const u8* ptr_odd = nullptr;
+		if (from_tmem)
+			ptr_odd = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
+
+		for (u32 level = 0; level != texLevels; ++level)
+		{
+			DecodedLevel l;
+			l.width = CalculateLevelSize(width, level);
+			l.height = CalculateLevelSize(height, level);
+			l.expanded_width = ROUND_UP(l.width, bsw);
+			l.expanded_height = ROUND_UP(l.height, bsh);
+			l.offset = decoded_size;
+
+			const u8*& level_src = (from_tmem && level != 0)
+				? ((level % 2) ? ptr_odd : ptr_even)
+				: ptr_ram;
+			l.src = level_src;
+			const u32 level_size = TexDecoder_GetTextureSizeInBytes(l.expanded_width, l.expanded_height, texformat);
+			level_src += level_size;
+
+			source_size += level_size;
+			decoded_size += l.expanded_width * l.expanded_height * 4;
+			decoded_texels += l.expanded_width * l.expanded_height;
+			levels.push_back(l);
+		}
+	}
+
+	// Large textures are split into strips that decode on the worker threads.
+	// The format overlay would be drawn on every strip, so it keeps the old path.
+	const bool rgba8_from_tmem = texformat == GX_TF_RGBA8 && from_tmem;
+	const bool decode_in_parallel = !hires_tex && !rgba8_from_tmem && TextureDecodePool::IsRunning() &&
+	                                !g_ActiveConfig.bTexFmtOverlayEnable &&
+	                                decoded_texels >= PARALLEL_DECODE_MIN_TEXELS;
+
+	// With async decoding, the texture gets a placeholder and is uploaded by
+	// ReturnEntry once the job is done. Textures that EFB copies are written
+	// into are excluded, since the late upload would overwrite the copies.
+	const bool decode_async = decode_in_parallel && g_ActiveConfig.bAsyncTextureDecoding &&
+	                          !from_tmem && !g_ActiveConfig.bDumpTextures &&
+	                          !efb_copies.Overlaps(address, (u32)source_size);
+
+	const u8* tlut = &texMem[tlutaddr];
+	std::shared_ptr<TextureDecodeJob> decode_job;
+	if (decode_async)
+	{
+		decode_job = std::make_shared<TextureDecodeJob>(texformat, tlut, (TlutFormat)tlutfmt);
+		decode_job->CopySource(src_data, source_size, palette_size);
+		decode_job->AllocateOutput(decoded_size);
+		for (const DecodedLevel& l : levels)
 		{
-			const u8* tlut = &texMem[tlutaddr];
-			TexDecoder_Decode(temp, src_data, expandedWidth, expandedHeight, texformat, tlut, (TlutFormat)tlutfmt);
+			decode_job->AddLevel(decode_job->GetOutput() + l.offset, decode_job->GetSource() + (l.src - src_data),
+			                     l.expanded_width, l.expanded_height);
 		}
-		else
+		TextureDecodePool::Submit(decode_job);
+	}
+	else if (decode_in_parallel)
+	{
+		CheckTempSize(decoded_size);
+		decode_job = std::make_shared<TextureDecodeJob>(texformat, tlut, (TlutFormat)tlutfmt);
+		for (const DecodedLevel& l : levels)
+			decode_job->AddLevel(temp + l.offset, l.src, l.expanded_width, l.expanded_height);
+		TextureDecodePool::Submit(decode_job);
+		decode_job->Wait();
+		decode_job.reset();
+	}
+	else if (!hires_tex)
+	{
+		CheckTempSize(decoded_size);
+		for (u32 level = 0; level != texLevels; ++level)
 		{
-			u8* src_data_gb = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
-			TexDecoder_DecodeRGBA8FromTmem(temp, src_data, src_data_gb, expandedWidth, expandedHeight);
+			const DecodedLevel& l = levels[level];
+			if (level == 0 && rgba8_from_tmem)
+			{
+				u8* src_data_gb = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
+				TexDecoder_DecodeRGBA8FromTmem(temp, src_data, src_data_gb, l.expanded_width, l.expanded_height);
+			}
+			else
+			{
+				TexDecoder_Decode(temp + l.offset, l.src, l.expanded_width, l.expanded_height, texformat, tlut, (TlutFormat)tlutfmt);
+			}
 		}
 	}
 
-	// how many levels the allocated texture shall have
-	const u32 texLevels = hires_tex ? (u32)hires_tex->m_levels.size() : tex_levels;
-
 	// create the entry/texture
 	TCacheEntryConfig config;
 	config.width = width;
@@ -614,73 +775,63 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	TCacheEntryBase* entry = AllocateTexture(config);
 	GFX_DEBUGGER_PAUSE_AT(NEXT_NEW_TEXTURE, true);
 
-	iter = textures_by_address.emplace((u64)address, entry);
-	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
-		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
-	{
-		entry->textures_by_hash_iter = textures_by_hash.emplace(full_hash, entry);
-	}
-
 	entry->SetGeneralParameters(address, texture_size, full_format);
 	entry->SetDimensions(nativeW, nativeH, tex_levels);
 	entry->SetHashes(base_hash, full_hash);
 	entry->is_efb_copy = false;
 	entry->is_custom_tex = hires_tex != nullptr;
+	entry->write_tracked = write_tracked;
+	entry->write_token = write_token;
 
-	// load texture
-	entry->Load(width, height, expandedWidth, 0);
-
-	std::string basename = "";
-	if (g_ActiveConfig.bDumpTextures && !hires_tex)
+	InsertTexture(entry);
+	if (g_ActiveConfig.iSafeTextureCache_ColorSamples == 0 ||
+		std::max(texture_size, palette_size) <= (u32)g_ActiveConfig.iSafeTextureCache_ColorSamples * 8)
 	{
-		basename = HiresTexture::GenBaseName(
-			src_data, texture_size,
-			&texMem[tlutaddr], palette_size,
-			width, height,
-			texformat, use_mipmaps,
-			true
-		);
-		DumpTexture(entry, basename, 0);
+		textures_by_hash.Insert(full_hash, entry);
 	}
 
 	if (hires_tex)
 	{
-		for (u32 level = 1; level != texLevels; ++level)
+		for (u32 level = 0; level != texLevels; ++level)
 		{
 			auto& l = hires_tex->m_levels[level];
-			CheckTempSize(l.data_size);
-			memcpy(temp, l.data, l.data_size);
-			entry->Load(l.width, l.height, l.width, level);
+			if (level != 0)
+			{
+				CheckTempSize(l.data_size);
+				memcpy(temp, l.data, l.data_size);
+			}
+			entry->Load(temp, l.width, l.height, l.width, level);
 		}
 	}
+	else if (decode_async)
+	{
+		// Blank levels until the decoded data is uploaded.
+		const DecodedLevel& l = levels[0];
+		CheckTempSize(l.expanded_width * l.expanded_height * 4);
+		memset(temp, 0, l.expanded_width * l.expanded_height * 4);
+		for (u32 level = 0; level != texLevels; ++level)
+			entry->Load(temp, levels[level].width, levels[level].height, levels[level].expanded_width, level);
+		entry->pending_decode = decode_job;
+		INCSTAT(stats.numTexturesDecodedAsync);
+	}
 	else
 	{
-		// load mips - TODO: Loading mipmaps from tmem is untested!
-		src_data += texture_size;
-
-		const u8* ptr_even = nullptr;
-		const u8* ptr_odd = nullptr;
-		if (from_tmem)
+		std::string basename = "";
+		if (g_ActiveConfig.bDumpTextures)
 		{
-			ptr_even = &texMem[bpmem.tex[stage / 4].texImage1[stage % 4].tmem_even * TMEM_LINE_SIZE + texture_size];
-			ptr_odd = &texMem[bpmem.tex[stage / 4].texImage2[stage % 4].tmem_odd * TMEM_LINE_SIZE];
+			basename = HiresTexture::GenBaseName(
+				src_data, texture_size,
+				&texMem[tlutaddr], palette_size,
+				width, height,
+				texformat, use_mipmaps,
+				true
+			);
 		}
 
-		for (u32 level = 1; level != texLevels; ++level)
+		for (u32 level = 0; level != texLevels; ++level)
 		{
-			const u32 mip_width = CalculateLevelSize(width, level);
-			const u32 mip_height = CalculateLevelSize(height, level);
-			const u32 expanded_mip_width = ROUND_UP(mip_width, bsw);
-			const u32 expanded_mip_height = ROUND_UP(mip_height, bsh);
-
-			const u8*& mip_src_data = from_tmem
-				? ((level % 2) ? ptr_odd : ptr_even)
-				: src_data;
-			const u8* tlut = &texMem[tlutaddr];
-			TexDecoder_Decode(temp, mip_src_data, expanded_mip_width, expanded_mip_height, texformat, tlut, (TlutFormat)tlutfmt);
-			mip_src_data += TexDecoder_GetTextureSizeInBytes(expanded_mip_width, expanded_mip_height, texformat);
-
-			entry->Load(mip_width, mip_height, expanded_mip_width, level);
+			const DecodedLevel& l = levels[level];
+			entry->Load(temp + l.offset, l.width, l.height, l.expanded_width, level);
 
 			if (g_ActiveConfig.bDumpTextures)
 				DumpTexture(entry, basename, level);
@@ -688,9 +839,9 @@ TextureCache::TCacheEntryBase* TextureCache::Load(const u32 stage)
 	}
 
 	INCSTAT(stats.numTexturesUploaded);
-	SETSTAT(stats.numTexturesAlive, textures_by_address.size());
+	SETSTAT(stats.numTexturesAlive, textures_lru.Size());
 
-	entry = DoPartialTextureUpdates(iter);
+	entry = DoPartialTextureUpdates(entry);
 
 	return ReturnEntry(stage, entry);
 }
@@ -1007,12 +1158,8 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 
 	// remove all texture cache entries at dstAddr
 	{
-		std::pair<TexCache::iterator, TexCache::iterator> iter_range = textures_by_address.equal_range((u64)dstAddr);
-		TexCache::iterator iter = iter_range.first;
-		while (iter != iter_range.second)
-		{
-			iter = FreeTexture(iter);
-		}
+		while (TCacheEntryBase* entry = textures_by_address.Find(dstAddr))
+			FreeTexture(entry);
 	}
 
 	// create the texture
@@ -1041,13 +1188,13 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	// we might be able to do a partial texture update on.
 	if (entry->memory_stride == entry->CacheLinesPerRow() * 32)
 	{
-		TexCache::iterator iter = textures_by_address.begin();
-		while (iter != textures_by_address.end())
+		TCacheEntryBase* iter = textures_lru.Front();
+		while (iter)
 		{
-			if (iter->second->OverlapsMemoryRange(dstAddr, entry->size_in_bytes))
-				iter = FreeTexture(iter);
-			else
-				++iter;
+			TCacheEntryBase* next = TexList::Next(iter);
+			if (iter->OverlapsMemoryRange(dstAddr, entry->size_in_bytes))
+				FreeTexture(iter);
+			iter = next;
 		}
 	}
 
@@ -1058,17 +1205,18 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 			count++), 0);
 	}
 
-	textures_by_address.emplace((u64)dstAddr, entry);
+	InsertTexture(entry);
 }
 
 TextureCache::TCacheEntryBase* TextureCache::AllocateTexture(const TCacheEntryConfig& config)
 {
-	TexPool::iterator iter = texture_pool.find(config);
-	TextureCache::TCacheEntryBase* entry;
-	if (iter != texture_pool.end())
+	TextureCache::TCacheEntryBase* entry = texture_pool.Find(config.GetKey());
+	INCSTAT(stats.thisFrame.numTextureAllocations);
+	if (entry)
 	{
-		entry = iter->second;
-		texture_pool.erase(iter);
+		texture_pool.Remove(entry);
+		texture_pool_lru.Remove(entry);
+		INCSTAT(stats.thisFrame.numTexturePoolReuses);
 	}
 	else
 	{
@@ -1076,24 +1224,41 @@ TextureCache::TCacheEntryBase* TextureCache::AllocateTexture(const TCacheEntryCo
 		INCSTAT(stats.numTexturesCreated);
 	}
 
-	entry->textures_by_hash_iter = textures_by_hash.end();
+	entry->frameCount = FRAMECOUNT_INVALID;
+	entry->write_tracked = false;
 	return entry;
 }
 
-TextureCache::TexCache::iterator TextureCache::FreeTexture(TexCache::iterator iter)
+void TextureCache::InsertTexture(TCacheEntryBase* entry)
 {
-	TCacheEntryBase* entry = iter->second;
+	textures_by_address.Insert(entry->addr, entry);
+	if (entry->IsEfbCopy())
+		efb_copies.Insert(entry->addr, entry->size_in_bytes, entry);
 
-	if (entry->textures_by_hash_iter != textures_by_hash.end())
-	{
-		textures_by_hash.erase(entry->textures_by_hash_iter);
-		entry->textures_by_hash_iter = textures_by_hash.end();
-	}
+	entry->lru_generation = lru_generation;
+	textures_lru.PushFront(entry);
+}
 
-	entry->frameCount = FRAMECOUNT_INVALID;
-	texture_pool.emplace(entry->config, entry);
+void TextureCache::TouchTexture(TCacheEntryBase* entry)
+{
+	entry->lru_generation = lru_generation;
+	textures_lru.MoveToFront(entry);
+}
 
-	return textures_by_address.erase(iter);
+void TextureCache::FreeTexture(TCacheEntryBase* entry)
+{
+	textures_by_address.Remove(entry);
+	if (TexHashIndex::Contains(entry))
+		textures_by_hash.Remove(entry);
+	if (entry->IsEfbCopy())
+		efb_copies.Remove(entry->addr, entry);
+	textures_lru.Remove(entry);
+
+	// Stamped with the frame it was freed in, for Cleanup().
+	entry->frameCount = frameCount;
+	entry->pending_decode.reset();
+	texture_pool.Insert(entry->config.GetKey(), entry);
+	texture_pool_lru.PushFront(entry);
 }
 
 u32 TextureCache::TCacheEntryBase::CacheLinesPerRow() const
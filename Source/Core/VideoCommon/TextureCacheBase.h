@@ -4,14 +4,15 @@
 
 #pragma once
 
-#include <functional>
-#include <map>
-#include <unordered_map>
+#include <memory>
+#include <string>
 
 #include "Common/CommonTypes.h"
 #include "Common/Thread.h"
 
 #include "VideoCommon/BPMemory.h"
+#include "VideoCommon/TextureCacheIndex.h"
+#include "VideoCommon/TextureDecodePool.h"
 #include "VideoCommon/TextureDecoder.h"
 #include "VideoCommon/VideoCommon.h"
 
@@ -33,14 +34,11 @@ public:
 			return width == b.width && height == b.height && levels == b.levels && layers == b.layers && rendertarget == b.rendertarget;
 		}
 
-		struct Hasher : std::hash<u64>
+		// Identifies the config in the texture pool.
+		u64 GetKey() const
 		{
-			size_t operator()(const TextureCache::TCacheEntryConfig& c) const
-			{
-				u64 id = (u64)c.rendertarget << 63 | (u64)c.layers << 48 | (u64)c.levels << 32 | (u64)c.height << 16 | (u64)c.width;
-				return std::hash<u64>::operator()(id);
-			}
-		};
+			return (u64)rendertarget << 63 | (u64)layers << 48 | (u64)levels << 32 | (u64)height << 16 | (u64)width;
+		}
 	};
 	struct TCacheEntryBase
 	{
@@ -62,8 +60,22 @@ public:
 		// used to delete textures which haven't been used for TEXTURE_KILL_THRESHOLD frames
 		int frameCount;
 
-		// Keep an iterator to the entry in textures_by_hash, so it does not need to be searched when removing the cache entry
-		std::multimap<u64, TCacheEntryBase*>::iterator textures_by_hash_iter;
+		// Links into the cache's indices. While the entry sits in the texture
+		// pool, address_link and lru_link are used for the pool instead.
+		IntrusiveLink<TCacheEntryBase> address_link;
+		IntrusiveLink<TCacheEntryBase> hash_link;
+		IntrusiveLink<TCacheEntryBase> lru_link;
+		// The Cleanup() generation in which the entry was last used.
+		u32 lru_generation;
+
+		// With write tracking, whether the memory hashed into base_hash has
+		// been written since write_token was taken.
+		bool write_tracked;
+		u32 write_token;
+
+		// Set while the texture holds a placeholder and its data is still being
+		// decoded asynchronously.
+		std::shared_ptr<TextureDecodeJob> pending_decode;
 
 		void SetGeneralParameters(u32 _addr, u32 _size, u32 _format)
 		{
@@ -99,7 +111,7 @@ public:
 			const MathUtil::Rectangle<int> &srcrect,
 			const MathUtil::Rectangle<int> &dstrect) = 0;
 
-		virtual void Load(unsigned int width, unsigned int height,
+		virtual void Load(const u8* buffer, unsigned int width, unsigned int height,
 			unsigned int expanded_width, unsigned int level) = 0;
 		virtual void FromRenderTarget(u8* dst, unsigned int dstFormat, u32 dstStride,
 			PEControl::PixelFormat srcFormat, const EFBRectangle& srcRect,
@@ -148,20 +160,35 @@ protected:
 	static size_t temp_size;
 
 private:
-	typedef std::multimap<u64, TCacheEntryBase*> TexCache;
-	typedef std::unordered_multimap<TCacheEntryConfig, TCacheEntryBase*, TCacheEntryConfig::Hasher> TexPool;
-	static TCacheEntryBase* DoPartialTextureUpdates(TexCache::iterator iter);
+	typedef IntrusiveHashIndex<TCacheEntryBase, &TCacheEntryBase::address_link> TexAddressIndex;
+	typedef IntrusiveHashIndex<TCacheEntryBase, &TCacheEntryBase::hash_link> TexHashIndex;
+	typedef IntrusiveList<TCacheEntryBase, &TCacheEntryBase::lru_link> TexList;
+	typedef AddressRangeIndex<TCacheEntryBase> EfbCopyIndex;
+
+	static TCacheEntryBase* DoPartialTextureUpdates(TCacheEntryBase* entry_to_update);
 	static void DumpTexture(TCacheEntryBase* entry, std::string basename, unsigned int level);
 	static void CheckTempSize(size_t required_size);
 
 	static TCacheEntryBase* AllocateTexture(const TCacheEntryConfig& config);
-	static TexCache::iterator FreeTexture(TexCache::iterator t_iter);
+	static void FreeTexture(TCacheEntryBase* entry);
+	static void InsertTexture(TCacheEntryBase* entry);
+	static void TouchTexture(TCacheEntryBase* entry);
 
 	static TCacheEntryBase* ReturnEntry(unsigned int stage, TCacheEntryBase* entry);
-
-	static TexCache textures_by_address;
-	static TexCache textures_by_hash;
-	static TexPool texture_pool;
+	static void UploadDecodedTexture(TCacheEntryBase* entry);
+
+	// Every live entry by address, and the fully hashed ones by hash.
+	static TexAddressIndex textures_by_address;
+	static TexHashIndex textures_by_hash;
+	// Live EFB copies sorted by address, for the range queries on them.
+	static EfbCopyIndex efb_copies;
+	// Live entries, most recently used first. Cleanup() walks it from the
+	// back to find expired entries.
+	static TexList textures_lru;
+	static u32 lru_generation;
+	// Unused entries by config, and most recently freed first.
+	static TexAddressIndex texture_pool;
+	static TexList texture_pool_lru;
 	static TCacheEntryBase* bound_textures[8];
 
 	// Backup configuration values
@@ -172,9 +199,11 @@ private:
 		bool s_texfmt_overlay_center;
 		bool s_hires_textures;
 		bool s_cache_hires_textures;
+		int s_texture_decoding_threads;
 		bool s_copy_cache_enable;
 		bool s_stereo_3d;
 		bool s_efb_mono_depth;
+		bool s_track_texture_writes;
 	} backup_config;
 };
 
@@ -0,0 +1,312 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+// Containers for the texture cache which never allocate per element: the
+// elements embed one IntrusiveLink for every container they can be in, and
+// can be unlinked in constant time without invalidating any other element.
+
+template <typename T>
+struct IntrusiveLink
+{
+	T* prev = nullptr;
+	T* next = nullptr;
+	u64 key = 0;
+	bool linked = false;
+};
+
+// A doubly linked list threaded through the link member L of its elements.
+template <typename T, IntrusiveLink<T> T::*L>
+class IntrusiveList
+{
+public:
+	T* Front() const { return m_head; }
+	T* Back() const { return m_tail; }
+	static T* Next(const T* e) { return (e->*L).next; }
+	static T* Prev(const T* e) { return (e->*L).prev; }
+
+	bool Empty() const { return m_head == nullptr; }
+	size_t Size() const { return m_size; }
+
+	void PushFront(T* e)
+	{
+		IntrusiveLink<T>& link = e->*L;
+		link.prev = nullptr;
+		link.next = m_head;
+		link.linked = true;
+		if (m_head)
+			(m_head->*L).prev = e;
+		else
+			m_tail = e;
+		m_head = e;
+		++m_size;
+	}
+
+	void Remove(T* e)
+	{
+		IntrusiveLink<T>& link = e->*L;
+		if (link.prev)
+			(link.prev->*L).next = link.next;
+		else
+			m_head = link.next;
+		if (link.next)
+			(link.next->*L).prev = link.prev;
+		else
+			m_tail = link.prev;
+		link.prev = link.next = nullptr;
+		link.linked = false;
+		--m_size;
+	}
+
+	void MoveToFront(T* e)
+	{
+		if (e == m_head)
+			return;
+		Remove(e);
+		PushFront(e);
+	}
+
+	// Forgets every element without touching them, for when they have been
+	// destroyed already.
+	void Clear()
+	{
+		m_head = m_tail = nullptr;
+		m_size = 0;
+	}
+
+private:
+	T* m_head = nullptr;
+	T* m_tail = nullptr;
+	size_t m_size = 0;
+};
+
+// Maps u64 keys to the elements inserted with them, like a std::multimap
+// without the ordering.
+//
+// The table is open addressed with linear probing and holds one slot per
+// distinct key. The elements sharing a key are chained through the link
+// member L in insertion order, so a lookup hashes to a slot and walks a short
+// run of adjacent slots instead of chasing tree nodes, and removing one
+// element leaves the others where they are. Slots are removed by shifting
+// the rest of their run back, which keeps the table free of tombstones.
+template <typename T, IntrusiveLink<T> T::*L>
+class IntrusiveHashIndex
+{
+public:
+	// The first element inserted with the key, or nullptr.
+	T* Find(u64 key) const
+	{
+		if (m_slots.empty())
+			return nullptr;
+		return m_slots[FindSlot(key)].head;
+	}
+
+	// The element inserted with the same key after e, or nullptr.
+	static T* Next(const T* e) { return (e->*L).next; }
+
+	static bool Contains(const T* e) { return (e->*L).linked; }
+
+	size_t Size() const { return m_size; }
+
+	void Insert(u64 key, T* e)
+	{
+		if ((m_used_slots + 1) * 2 > m_slots.size())
+			Grow();
+
+		Slot& slot = m_slots[FindSlot(key)];
+		IntrusiveLink<T>& link = e->*L;
+		link.key = key;
+		link.prev = slot.tail;
+		link.next = nullptr;
+		link.linked = true;
+		if (slot.head)
+		{
+			(slot.tail->*L).next = e;
+		}
+		else
+		{
+			slot.key = key;
+			slot.head = e;
+			++m_used_slots;
+		}
+		slot.tail = e;
+		++m_size;
+	}
+
+	void Remove(T* e)
+	{
+		IntrusiveLink<T>& link = e->*L;
+		if (!link.prev || !link.next)
+		{
+			const size_t index = FindSlot(link.key);
+			Slot& slot = m_slots[index];
+			if (!link.prev)
+				slot.head = link.next;
+			if (!link.next)
+				slot.tail = link.prev;
+			if (!slot.head)
+			{
+				EraseSlot(index);
+				--m_used_slots;
+			}
+		}
+		if (link.prev)
+			(link.prev->*L).next = link.next;
+		if (link.next)
+			(link.next->*L).prev = link.prev;
+		link.prev = link.next = nullptr;
+		link.linked = false;
+		--m_size;
+	}
+
+	// Forgets every element without touching them, for when they have been
+	// destroyed already.
+	void Clear()
+	{
+		for (Slot& slot : m_slots)
+			slot = Slot();
+		m_used_slots = 0;
+		m_size = 0;
+	}
+
+private:
+	struct Slot
+	{
+		u64 key = 0;
+		T* head = nullptr;
+		T* tail = nullptr;
+	};
+
+	static const size_t INITIAL_SLOTS = 1024;
+
+	// Fibonacci hashing, which takes the top bits of the product. Texture
+	// addresses are aligned, so their low bits would make for a bad index.
+	size_t HomeSlot(u64 key) const
+	{
+		return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> m_shift);
+	}
+
+	// The slot holding the key, or the empty slot where it would go.
+	size_t FindSlot(u64 key) const
+	{
+		const size_t mask = m_slots.size() - 1;
+		size_t i = HomeSlot(key);
+		while (m_slots[i].head && m_slots[i].key != key)
+			i = (i + 1) & mask;
+		return i;
+	}
+
+	void EraseSlot(size_t hole)
+	{
+		const size_t mask = m_slots.size() - 1;
+		size_t i = (hole + 1) & mask;
+		while (m_slots[i].head)
+		{
+			// Slots whose home lies between the hole and themselves have to
+			// stay, the others move back into the hole.
+			const size_t home = HomeSlot(m_slots[i].key);
+			if (((i - home) & mask) >= ((i - hole) & mask))
+			{
+				m_slots[hole] = m_slots[i];
+				hole = i;
+			}
+			i = (i + 1) & mask;
+		}
+		m_slots[hole] = Slot();
+	}
+
+	void Grow()
+	{
+		std::vector<Slot> old_slots(m_slots.empty() ? INITIAL_SLOTS : m_slots.size() * 2);
+		m_slots.swap(old_slots);
+
+		m_shift = 64;
+		for (size_t size = m_slots.size(); size > 1; size >>= 1)
+			--m_shift;
+
+		for (const Slot& slot : old_slots)
+		{
+			if (slot.head)
+				m_slots[FindSlot(slot.key)] = slot;
+		}
+	}
+
+	std::vector<Slot> m_slots;
+	u32 m_shift = 64;
+	size_t m_used_slots = 0;
+	size_t m_size = 0;
+};
+
+// Elements covering ranges of memory, sorted by start address, for finding
+// the ones that overlap a range. The ranges can overlap each other.
+template <typename T>
+class AddressRangeIndex
+{
+public:
+	struct Entry
+	{
+		u32 address;
+		u32 size;
+		T* element;
+	};
+	typedef typename std::vector<Entry>::const_iterator Iterator;
+
+	Iterator begin() const { return m_entries.begin(); }
+	Iterator end() const { return m_entries.end(); }
+
+	// The first element starting at or after the address.
+	Iterator LowerBound(u32 address) const
+	{
+		return std::lower_bound(m_entries.begin(), m_entries.end(), address,
+			[](const Entry& entry, u32 a) { return entry.address < a; });
+	}
+
+	void Insert(u32 address, u32 size, T* e)
+	{
+		auto pos = std::upper_bound(m_entries.begin(), m_entries.end(), address,
+			[](u32 a, const Entry& entry) { return a < entry.address; });
+		m_entries.insert(pos, Entry{ address, size, e });
+		m_max_size = std::max(m_max_size, size);
+	}
+
+	// The element has to be in the index, at the address it was inserted with.
+	void Remove(u32 address, T* e)
+	{
+		auto pos = m_entries.begin() + (LowerBound(address) - m_entries.begin());
+		while (pos->element != e)
+			++pos;
+		m_entries.erase(pos);
+	}
+
+	// Whether any element overlaps [address, address + size). Elements
+	// starting before the address can reach into the range too, but none
+	// starts further back than the largest size inserted since the last Clear.
+	bool Overlaps(u32 address, u32 size) const
+	{
+		const u32 first = address > m_max_size ? address - m_max_size : 0;
+		for (auto iter = LowerBound(first); iter != m_entries.end() && iter->address < address + size; ++iter)
+		{
+			if (iter->address + iter->size > address)
+				return true;
+		}
+		return false;
+	}
+
+	void Clear()
+	{
+		m_entries.clear();
+		m_max_size = 0;
+	}
+
+private:
+	std::vector<Entry> m_entries;
+	u32 m_max_size = 0;
+};
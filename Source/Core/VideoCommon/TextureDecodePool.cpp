@@ -0,0 +1,200 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <thread>
+
+#include "Common/MathUtil.h"
+#include "Common/MemoryUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/Thread.h"
+#include "Common/Logging/Log.h"
+
+#include "VideoCommon/TextureDecodePool.h"
+#include "VideoCommon/VideoConfig.h"
+
+// Strips are made of whole block rows and hold at least this many texels,
+// which keeps the queueing overhead small next to the decoding itself.
+static const u32 STRIP_TEXELS = 32 * 1024;
+
+// Upper bound for the automatic thread count. The GPU thread decodes too while
+// it waits, and texture loads rarely have enough strips to keep more busy.
+static const int MAX_AUTO_THREADS = 4;
+
+namespace
+{
+struct Strip
+{
+	std::shared_ptr<TextureDecodeJob> job;
+	u32 level;
+	u32 first_row;
+	u32 num_rows;
+};
+}
+
+static std::vector<std::thread> s_workers;
+static std::mutex s_queue_mutex;
+static std::condition_variable s_queue_cond;
+static std::deque<Strip> s_queue;
+static bool s_stopping;
+
+TextureDecodeJob::TextureDecodeJob(int texformat, const u8* tlut, TlutFormat tlutfmt)
+	: m_texformat(texformat), m_tlut(tlut), m_tlutfmt(tlutfmt), m_pending_strips(0)
+{
+}
+
+TextureDecodeJob::~TextureDecodeJob()
+{
+	FreeAlignedMemory(m_output);
+}
+
+void TextureDecodeJob::CopySource(const u8* src, size_t size, size_t tlut_size)
+{
+	m_source.resize(size + tlut_size);
+	memcpy(m_source.data(), src, size);
+	if (tlut_size)
+	{
+		memcpy(m_source.data() + size, m_tlut, tlut_size);
+		m_tlut = m_source.data() + size;
+	}
+}
+
+void TextureDecodeJob::AllocateOutput(size_t size)
+{
+	FreeAlignedMemory(m_output);
+	m_output = (u8*)AllocateAlignedMemory(size, 16);
+}
+
+void TextureDecodeJob::AddLevel(u8* dst, const u8* src, u32 width, u32 height)
+{
+	m_levels.push_back({ dst, src, width, height });
+	m_texel_count += width * height;
+}
+
+void TextureDecodeJob::DecodeStrip(u32 level, u32 first_row, u32 num_rows)
+{
+	const Level& l = m_levels[level];
+	u8* dst = l.dst + (size_t)first_row * l.width * 4;
+	const u8* src = l.src + TexDecoder_GetTextureSizeInBytes(l.width, first_row, m_texformat);
+	// Straight to the implementation: the format overlay of TexDecoder_Decode
+	// would be drawn on every strip. The texture cache does not use the pool
+	// when the overlay is enabled.
+	_TexDecoder_DecodeImpl((u32*)dst, src, l.width, num_rows, m_texformat, m_tlut, m_tlutfmt);
+}
+
+void TextureDecodeJob::FinishStrip()
+{
+	if (m_pending_strips.fetch_sub(1) == 1)
+	{
+		std::lock_guard<std::mutex> lk(m_done_mutex);
+		m_done.notify_all();
+	}
+}
+
+void TextureDecodeJob::Wait()
+{
+	while (!IsDone())
+	{
+		if (TextureDecodePool::RunQueuedStrip())
+			continue;
+
+		// Everything left is being decoded by the workers.
+		std::unique_lock<std::mutex> lk(m_done_mutex);
+		m_done.wait(lk, [this] { return IsDone(); });
+	}
+}
+
+void TextureDecodePool::Init()
+{
+	int num_threads = g_ActiveConfig.iTextureDecodingThreads;
+	if (num_threads < 0)
+		num_threads = std::min<int>(std::thread::hardware_concurrency() / 2, MAX_AUTO_THREADS);
+
+	s_stopping = false;
+	for (int i = 0; i < num_threads; ++i)
+		s_workers.emplace_back(WorkerThread, i);
+
+	if (num_threads)
+		INFO_LOG(VIDEO, "Decoding textures with %d worker threads", num_threads);
+}
+
+void TextureDecodePool::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lk(s_queue_mutex);
+		s_stopping = true;
+	}
+	s_queue_cond.notify_all();
+
+	for (std::thread& worker : s_workers)
+		worker.join();
+	s_workers.clear();
+}
+
+bool TextureDecodePool::IsRunning()
+{
+	return !s_workers.empty();
+}
+
+void TextureDecodePool::Submit(std::shared_ptr<TextureDecodeJob> job)
+{
+	const int block_height = TexDecoder_GetBlockHeightInTexels(job->m_texformat);
+
+	std::vector<Strip> strips;
+	for (u32 level = 0; level < job->m_levels.size(); ++level)
+	{
+		const TextureDecodeJob::Level& l = job->m_levels[level];
+		const u32 rows_per_strip = std::max<u32>(ROUND_UP(STRIP_TEXELS / l.width, block_height), block_height);
+		for (u32 row = 0; row < l.height; row += rows_per_strip)
+			strips.push_back({ job, level, row, std::min(rows_per_strip, l.height - row) });
+	}
+	job->m_pending_strips = (u32)strips.size();
+
+	{
+		std::lock_guard<std::mutex> lk(s_queue_mutex);
+		s_queue.insert(s_queue.end(), strips.begin(), strips.end());
+	}
+	s_queue_cond.notify_all();
+}
+
+bool TextureDecodePool::RunQueuedStrip()
+{
+	Strip strip;
+	{
+		std::lock_guard<std::mutex> lk(s_queue_mutex);
+		if (s_queue.empty())
+			return false;
+		strip = std::move(s_queue.front());
+		s_queue.pop_front();
+	}
+
+	strip.job->DecodeStrip(strip.level, strip.first_row, strip.num_rows);
+	strip.job->FinishStrip();
+	return true;
+}
+
+void TextureDecodePool::WorkerThread(int index)
+{
+	Common::SetCurrentThreadName(StringFromFormat("Texture decoder %d", index).c_str());
+
+	while (true)
+	{
+		Strip strip;
+		{
+			std::unique_lock<std::mutex> lk(s_queue_mutex);
+			s_queue_cond.wait(lk, [] { return s_stopping || !s_queue.empty(); });
+			// Jobs waited on by the GPU thread could be in the queue, so it
+			// is drained before stopping.
+			if (s_queue.empty())
+				return;
+			strip = std::move(s_queue.front());
+			s_queue.pop_front();
+		}
+
+		strip.job->DecodeStrip(strip.level, strip.first_row, strip.num_rows);
+		strip.job->FinishStrip();
+	}
+}
@@ -0,0 +1,102 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// The decoding of one texture: a list of levels sharing a format and palette.
+//
+// Once submitted to TextureDecodePool, each level is split into strips of
+// whole block rows which the worker threads decode independently. IsDone()
+// is the fence the texture cache checks before handing the decoded data to
+// the backend.
+class TextureDecodeJob
+{
+public:
+	struct Level
+	{
+		u8* dst;
+		const u8* src;
+		u32 width;
+		u32 height;
+	};
+
+	TextureDecodeJob(int texformat, const u8* tlut, TlutFormat tlutfmt);
+	~TextureDecodeJob();
+
+	// Copies the source data and palette into the job, so that it does not
+	// depend on emulated memory staying unchanged until it is done.
+	void CopySource(const u8* src, size_t size, size_t tlut_size);
+	const u8* GetSource() const { return m_source.data(); }
+
+	// Allocates an output buffer owned by the job, 16-byte aligned like the
+	// decoders expect.
+	void AllocateOutput(size_t size);
+	u8* GetOutput() const { return m_output; }
+
+	// width and height are the expanded dimensions of the level. Every level
+	// must be added before the job is submitted.
+	void AddLevel(u8* dst, const u8* src, u32 width, u32 height);
+
+	u32 GetLevelCount() const { return (u32)m_levels.size(); }
+	const Level& GetLevel(u32 level) const { return m_levels[level]; }
+	u32 GetTexelCount() const { return m_texel_count; }
+
+	bool IsDone() const { return m_pending_strips.load() == 0; }
+
+	// Blocks until every strip has been decoded, decoding queued strips on
+	// the calling thread in the meantime.
+	void Wait();
+
+private:
+	friend class TextureDecodePool;
+
+	void DecodeStrip(u32 level, u32 first_row, u32 num_rows);
+	void FinishStrip();
+
+	int m_texformat;
+	const u8* m_tlut;
+	TlutFormat m_tlutfmt;
+	std::vector<Level> m_levels;
+	u32 m_texel_count = 0;
+
+	std::vector<u8> m_source;
+	u8* m_output = nullptr;
+
+	std::atomic<u32> m_pending_strips;
+	std::mutex m_done_mutex;
+	std::condition_variable m_done;
+};
+
+class TextureDecodePool
+{
+public:
+	// Starts the worker threads, as many as configured by
+	// iTextureDecodingThreads.
+	static void Init();
+	// Decodes whatever is still queued and stops the workers.
+	static void Shutdown();
+
+	static bool IsRunning();
+
+	// Queues the strips of every level of the job. Returns immediately; use
+	// the job's IsDone() or Wait() to know when the data is ready.
+	static void Submit(std::shared_ptr<TextureDecodeJob> job);
+
+private:
+	friend class TextureDecodeJob;
+
+	static void WorkerThread(int index);
+
+	// Runs one queued strip, if there is any. Used by waiting jobs to help.
+	static bool RunQueuedStrip();
+};
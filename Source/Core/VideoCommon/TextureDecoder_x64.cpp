@@ -222,6 +222,419 @@ static void DecodeDXTBlock(u32 *dst, const DXTBlock *src, int pitch)
 }
 #endif
 
+// AVX2 decoders, used instead of everything below when the CPU has it. Each
+// store writes eight texels: the formats with 8 texel wide blocks are decoded
+// a block row at a time, the ones with 4 texel wide blocks from the rows of
+// two neighbouring blocks. C4 palettes fit in two registers and are indexed
+// with vpermd, C8 and C14X2 palettes are read with gathers.
+
+// The converters take the raw 16-bit value of each texel or palette entry, as
+// it is in memory, in the low half of each 32-bit lane.
+FUNCTION_TARGET_AVX2 static inline __m256i Swap16_AVX2(__m256i raw)
+{
+	const __m256i mask = _mm256_setr_epi8(
+		1, 0, -128, -128, 5, 4, -128, -128, 9, 8, -128, -128, 13, 12, -128, -128,
+		1, 0, -128, -128, 5, 4, -128, -128, 9, 8, -128, -128, 13, 12, -128, -128);
+	return _mm256_shuffle_epi8(raw, mask);
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i Expand5To8_AVX2(__m256i v)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, 3), _mm256_srli_epi32(v, 2));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i Expand4To8_AVX2(__m256i v)
+{
+	return _mm256_or_si256(_mm256_slli_epi32(v, 4), v);
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i MakeRGBA_AVX2(__m256i r, __m256i g, __m256i b, __m256i a)
+{
+	return _mm256_or_si256(_mm256_or_si256(r, _mm256_slli_epi32(g, 8)),
+	                       _mm256_or_si256(_mm256_slli_epi32(b, 16), _mm256_slli_epi32(a, 24)));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i ConvertIA8_AVX2(__m256i raw)
+{
+	// (AI) -> (IIIA)
+	const __m256i mask = _mm256_setr_epi8(
+		1, 1, 1, 0, 5, 5, 5, 4, 9, 9, 9, 8, 13, 13, 13, 12,
+		1, 1, 1, 0, 5, 5, 5, 4, 9, 9, 9, 8, 13, 13, 13, 12);
+	return _mm256_shuffle_epi8(raw, mask);
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i ConvertRGB565_AVX2(__m256i raw)
+{
+	const __m256i v = Swap16_AVX2(raw);
+	const __m256i r = Expand5To8_AVX2(_mm256_srli_epi32(v, 11));
+	const __m256i g6 = _mm256_and_si256(_mm256_srli_epi32(v, 5), _mm256_set1_epi32(0x3f));
+	const __m256i g = _mm256_or_si256(_mm256_slli_epi32(g6, 2), _mm256_srli_epi32(g6, 4));
+	const __m256i b = Expand5To8_AVX2(_mm256_and_si256(v, _mm256_set1_epi32(0x1f)));
+	return MakeRGBA_AVX2(r, g, b, _mm256_set1_epi32(0xff));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i ConvertRGB5A3_AVX2(__m256i raw)
+{
+	const __m256i v = Swap16_AVX2(raw);
+	const __m256i mask5 = _mm256_set1_epi32(0x1f);
+	const __m256i mask4 = _mm256_set1_epi32(0x0f);
+
+	// Both decodings, blended by the top bit.
+	const __m256i rgb555 = MakeRGBA_AVX2(
+		Expand5To8_AVX2(_mm256_and_si256(_mm256_srli_epi32(v, 10), mask5)),
+		Expand5To8_AVX2(_mm256_and_si256(_mm256_srli_epi32(v, 5), mask5)),
+		Expand5To8_AVX2(_mm256_and_si256(v, mask5)),
+		_mm256_set1_epi32(0xff));
+
+	const __m256i a3 = _mm256_and_si256(_mm256_srli_epi32(v, 12), _mm256_set1_epi32(0x7));
+	const __m256i a = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(a3, 5), _mm256_slli_epi32(a3, 2)),
+	                                  _mm256_srli_epi32(a3, 1));
+	const __m256i rgb4a3 = MakeRGBA_AVX2(
+		Expand4To8_AVX2(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask4)),
+		Expand4To8_AVX2(_mm256_and_si256(_mm256_srli_epi32(v, 4), mask4)),
+		Expand4To8_AVX2(_mm256_and_si256(v, mask4)),
+		a);
+
+	const __m256i opaque = _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 31);
+	return _mm256_blendv_epi8(rgb4a3, rgb555, opaque);
+}
+
+template <TlutFormat tlutfmt>
+FUNCTION_TARGET_AVX2 static inline __m256i ConvertTlutEntries_AVX2(__m256i raw)
+{
+	switch (tlutfmt)
+	{
+	case GX_TL_IA8:
+		return ConvertIA8_AVX2(raw);
+	case GX_TL_RGB565:
+		return ConvertRGB565_AVX2(raw);
+	default:
+		return ConvertRGB5A3_AVX2(raw);
+	}
+}
+
+template <TlutFormat tlutfmt>
+FUNCTION_TARGET_AVX2 static inline void DecodeTlut_AVX2(u32* colors, const u8* tlut, int count)
+{
+	for (int i = 0; i < count; i += 8)
+	{
+		const __m256i raw = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(tlut + 2 * i)));
+		_mm256_store_si256((__m256i*)(colors + i), ConvertTlutEntries_AVX2<tlutfmt>(raw));
+	}
+}
+
+// The 4-bit values of a row of an 8 texel wide block, high nibble first.
+FUNCTION_TARGET_AVX2 static inline __m256i UnpackNibbles_AVX2(const u8* src)
+{
+	const __m256i shifts = _mm256_setr_epi32(4, 0, 12, 8, 20, 16, 28, 24);
+	const __m256i bits = _mm256_set1_epi32(*(const s32*)src);
+	return _mm256_and_si256(_mm256_srlv_epi32(bits, shifts), _mm256_set1_epi32(0xf));
+}
+
+FUNCTION_TARGET_AVX2 static inline __m256i UnpackBytes_AVX2(const u8* src)
+{
+	return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+}
+
+// Formats with 4x4 blocks of 16-bit texels. The converter is a functor, as
+// lambdas do not inherit the target of the function they are in.
+template <typename Convert>
+FUNCTION_TARGET_AVX2 static void Decode4x4Blocks16_AVX2(u32* dst, const u8* src, int width, int height, Convert convert)
+{
+	const int Wsteps4 = (width + 3) / 4;
+	for (int y = 0; y < height; y += 4)
+	{
+		const u8* row_src = src + 32 * (y / 4) * Wsteps4;
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			const u8* block = row_src + 8 * x;
+			for (int iy = 0; iy < 4; iy++)
+			{
+				const __m128i texels = _mm_unpacklo_epi64(
+					_mm_loadl_epi64((const __m128i*)(block + 8 * iy)),
+					_mm_loadl_epi64((const __m128i*)(block + 32 + 8 * iy)));
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), convert(_mm256_cvtepu16_epi32(texels)));
+			}
+		}
+		// An odd block at the end of the row.
+		if (x < width)
+		{
+			const u8* block = row_src + 8 * x;
+			for (int iy = 0; iy < 4; iy++)
+			{
+				const __m128i texels = _mm_loadl_epi64((const __m128i*)(block + 8 * iy));
+				const __m256i rgba = convert(_mm256_cvtepu16_epi32(texels));
+				_mm_storeu_si128((__m128i*)(dst + (y + iy) * width + x), _mm256_castsi256_si128(rgba));
+			}
+		}
+	}
+}
+
+struct ConvertIA8Functor_AVX2
+{
+	FUNCTION_TARGET_AVX2 __m256i operator()(__m256i raw) const { return ConvertIA8_AVX2(raw); }
+};
+
+struct ConvertRGB565Functor_AVX2
+{
+	FUNCTION_TARGET_AVX2 __m256i operator()(__m256i raw) const { return ConvertRGB565_AVX2(raw); }
+};
+
+struct ConvertRGB5A3Functor_AVX2
+{
+	FUNCTION_TARGET_AVX2 __m256i operator()(__m256i raw) const { return ConvertRGB5A3_AVX2(raw); }
+};
+
+template <TlutFormat tlutfmt>
+struct ConvertC14X2Functor_AVX2
+{
+	const u8* tlut;
+
+	FUNCTION_TARGET_AVX2 __m256i operator()(__m256i raw) const
+	{
+		const __m256i index = _mm256_and_si256(Swap16_AVX2(raw), _mm256_set1_epi32(0x3fff));
+		// Gathers the aligned pair each entry is in, which keeps the last
+		// entry from reading past the palette.
+		const __m256i pairs = _mm256_i32gather_epi32((const int*)tlut, _mm256_srli_epi32(index, 1), 4);
+		const __m256i shifts = _mm256_slli_epi32(_mm256_and_si256(index, _mm256_set1_epi32(1)), 4);
+		const __m256i entries = _mm256_and_si256(_mm256_srlv_epi32(pairs, shifts), _mm256_set1_epi32(0xffff));
+		return ConvertTlutEntries_AVX2<tlutfmt>(entries);
+	}
+};
+
+template <TlutFormat tlutfmt>
+FUNCTION_TARGET_AVX2 static void DecodePaletted_AVX2(u32* dst, const u8* src, int width, int height, int texformat, const u8* tlut)
+{
+	const int Wsteps8 = (width + 7) / 8;
+
+	switch (texformat)
+	{
+	case GX_TF_C4:
+		{
+			alignas(32) u32 colors[16];
+			DecodeTlut_AVX2<tlutfmt>(colors, tlut, 16);
+			const __m256i colors_lo = _mm256_load_si256((const __m256i*)colors);
+			const __m256i colors_hi = _mm256_load_si256((const __m256i*)(colors + 8));
+			const __m256i seven = _mm256_set1_epi32(7);
+			for (int y = 0; y < height; y += 8)
+				for (int x = 0, yStep = (y / 8) * Wsteps8; x < width; x += 8, yStep++)
+					for (int iy = 0; iy < 8; iy++)
+					{
+						const __m256i index = UnpackNibbles_AVX2(src + 32 * yStep + 4 * iy);
+						const __m256i rgba = _mm256_blendv_epi8(
+							_mm256_permutevar8x32_epi32(colors_lo, index),
+							_mm256_permutevar8x32_epi32(colors_hi, index),
+							_mm256_cmpgt_epi32(index, seven));
+						_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), rgba);
+					}
+		}
+		break;
+	case GX_TF_C8:
+		{
+			alignas(32) u32 colors[256];
+			DecodeTlut_AVX2<tlutfmt>(colors, tlut, 256);
+			for (int y = 0; y < height; y += 4)
+				for (int x = 0, yStep = (y / 4) * Wsteps8; x < width; x += 8, yStep++)
+					for (int iy = 0; iy < 4; iy++)
+					{
+						const __m256i index = UnpackBytes_AVX2(src + 32 * yStep + 8 * iy);
+						const __m256i rgba = _mm256_i32gather_epi32((const int*)colors, index, 4);
+						_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), rgba);
+					}
+		}
+		break;
+	case GX_TF_C14X2:
+		// Decoding the whole palette would mean 16384 entries, usually for a
+		// lot less texels, so the entries are converted as they are read.
+		Decode4x4Blocks16_AVX2(dst, src, width, height, ConvertC14X2Functor_AVX2<tlutfmt>{ tlut });
+		break;
+	}
+}
+
+static inline void GetDXTColors(u32* colors, const DXTBlock* block)
+{
+	const u16 c1 = Common::swap16(block->color1);
+	const u16 c2 = Common::swap16(block->color2);
+	const int blue1 = Convert5To8(c1 & 0x1F);
+	const int blue2 = Convert5To8(c2 & 0x1F);
+	const int green1 = Convert6To8((c1 >> 5) & 0x3F);
+	const int green2 = Convert6To8((c2 >> 5) & 0x3F);
+	const int red1 = Convert5To8((c1 >> 11) & 0x1F);
+	const int red2 = Convert5To8((c2 >> 11) & 0x1F);
+	colors[0] = red1 | (green1 << 8) | (blue1 << 16) | (0xFF << 24);
+	colors[1] = red2 | (green2 << 8) | (blue2 << 16) | (0xFF << 24);
+	if (c1 > c2)
+	{
+		const int blue3 = ((blue2 - blue1) >> 1) - ((blue2 - blue1) >> 3);
+		const int green3 = ((green2 - green1) >> 1) - ((green2 - green1) >> 3);
+		const int red3 = ((red2 - red1) >> 1) - ((red2 - red1) >> 3);
+		colors[2] = (red1 + red3) | ((green1 + green3) << 8) | ((blue1 + blue3) << 16) | (0xFF << 24);
+		colors[3] = (red2 - red3) | ((green2 - green3) << 8) | ((blue2 - blue3) << 16) | (0xFF << 24);
+	}
+	else
+	{
+		colors[2] = ((red1 + red2 + 1) / 2) | (((green1 + green2 + 1) / 2) << 8) | (((blue1 + blue2 + 1) / 2) << 16) | (0xFF << 24);
+		// Color2, but transparent
+		colors[3] = red2 | (green2 << 8) | (blue2 << 16);
+	}
+}
+
+FUNCTION_TARGET_AVX2 static void DecodeCMPR_AVX2(u32* dst, const u8* src, int width, int height)
+{
+	// The 2-bit selectors of a row of the left and right DXT blocks, which are
+	// in the low and high byte, turned into indices into both palettes.
+	const __m256i shifts = _mm256_setr_epi32(6, 4, 2, 0, 14, 12, 10, 8);
+	const __m256i offsets = _mm256_setr_epi32(0, 0, 0, 0, 4, 4, 4, 4);
+	const __m256i three = _mm256_set1_epi32(3);
+	const int Wsteps8 = (width + 7) / 8;
+
+	for (int y = 0; y < height; y += 8)
+		for (int x = 0, yStep = (y / 8) * Wsteps8; x < width; x += 8, yStep++)
+		{
+			const DXTBlock* blocks = (const DXTBlock*)(src + 32 * yStep);
+			for (int half = 0; half < 2; half++)
+			{
+				const DXTBlock* left = &blocks[2 * half];
+				const DXTBlock* right = &blocks[2 * half + 1];
+				alignas(32) u32 colors[8];
+				GetDXTColors(colors, left);
+				GetDXTColors(colors + 4, right);
+				const __m256i palette = _mm256_load_si256((const __m256i*)colors);
+
+				for (int iy = 0; iy < 4; iy++)
+				{
+					const __m256i lines = _mm256_set1_epi32(left->lines[iy] | (right->lines[iy] << 8));
+					const __m256i index = _mm256_add_epi32(_mm256_and_si256(_mm256_srlv_epi32(lines, shifts), three), offsets);
+					_mm256_storeu_si256((__m256i*)(dst + (y + 4 * half + iy) * width + x),
+					                    _mm256_permutevar8x32_epi32(palette, index));
+				}
+			}
+		}
+}
+
+FUNCTION_TARGET_AVX2 static void DecodeRGBA8_AVX2(u32* dst, const u8* src, int width, int height)
+{
+	// (ARGB) -> (RGBA)
+	const __m256i mask = _mm256_setr_epi8(
+		1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12,
+		1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12);
+	const int Wsteps4 = (width + 3) / 4;
+
+	for (int y = 0; y < height; y += 4)
+	{
+		// Blocks are 64 bytes, the AR halves of the texels before the GB ones.
+		const u8* row_src = src + 64 * (y / 4) * Wsteps4;
+		int x = 0;
+		for (; x + 8 <= width; x += 8)
+		{
+			const u8* block = row_src + 16 * x;
+			for (int iy = 0; iy < 4; iy++)
+			{
+				const __m128i ar = _mm_unpacklo_epi64(
+					_mm_loadl_epi64((const __m128i*)(block + 8 * iy)),
+					_mm_loadl_epi64((const __m128i*)(block + 64 + 8 * iy)));
+				const __m128i gb = _mm_unpacklo_epi64(
+					_mm_loadl_epi64((const __m128i*)(block + 32 + 8 * iy)),
+					_mm_loadl_epi64((const __m128i*)(block + 96 + 8 * iy)));
+				const __m256i argb = _mm256_inserti128_si256(
+					_mm256_castsi128_si256(_mm_unpacklo_epi16(ar, gb)), _mm_unpackhi_epi16(ar, gb), 1);
+				_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), _mm256_shuffle_epi8(argb, mask));
+			}
+		}
+		if (x < width)
+		{
+			const u8* block = row_src + 16 * x;
+			for (int iy = 0; iy < 4; iy++)
+			{
+				const __m128i ar = _mm_loadl_epi64((const __m128i*)(block + 8 * iy));
+				const __m128i gb = _mm_loadl_epi64((const __m128i*)(block + 32 + 8 * iy));
+				const __m128i rgba = _mm_shuffle_epi8(_mm_unpacklo_epi16(ar, gb), _mm256_castsi256_si128(mask));
+				_mm_storeu_si128((__m128i*)(dst + (y + iy) * width + x), rgba);
+			}
+		}
+	}
+}
+
+FUNCTION_TARGET_AVX2 static void TexDecoder_DecodeImpl_AVX2(u32* dst, const u8* src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt)
+{
+	const int Wsteps8 = (width + 7) / 8;
+
+	switch (texformat)
+	{
+	case GX_TF_C4:
+	case GX_TF_C8:
+	case GX_TF_C14X2:
+		if (tlutfmt == GX_TL_IA8)
+			DecodePaletted_AVX2<GX_TL_IA8>(dst, src, width, height, texformat, tlut);
+		else if (tlutfmt == GX_TL_RGB565)
+			DecodePaletted_AVX2<GX_TL_RGB565>(dst, src, width, height, texformat, tlut);
+		else if (tlutfmt == GX_TL_RGB5A3)
+			DecodePaletted_AVX2<GX_TL_RGB5A3>(dst, src, width, height, texformat, tlut);
+		break;
+	case GX_TF_I4:
+		{
+			// Multiplying by 0x11111111 replicates the nibble into every one.
+			const __m256i replicate = _mm256_set1_epi32(0x11111111);
+			for (int y = 0; y < height; y += 8)
+				for (int x = 0, yStep = (y / 8) * Wsteps8; x < width; x += 8, yStep++)
+					for (int iy = 0; iy < 8; iy++)
+					{
+						const __m256i i4 = UnpackNibbles_AVX2(src + 32 * yStep + 4 * iy);
+						_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), _mm256_mullo_epi32(i4, replicate));
+					}
+		}
+		break;
+	case GX_TF_I8:
+		{
+			// Each byte of the row into every byte of its texel.
+			const __m256i mask = _mm256_setr_epi8(
+				0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+				4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+			for (int y = 0; y < height; y += 4)
+				for (int x = 0, yStep = (y / 4) * Wsteps8; x < width; x += 8, yStep++)
+					for (int iy = 0; iy < 4; iy++)
+					{
+						const __m256i row = _mm256_broadcastq_epi64(_mm_loadl_epi64((const __m128i*)(src + 32 * yStep + 8 * iy)));
+						_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), _mm256_shuffle_epi8(row, mask));
+					}
+		}
+		break;
+	case GX_TF_IA4:
+		{
+			const __m256i replicate_i = _mm256_set1_epi32(0x00111111);
+			const __m256i replicate_a = _mm256_set1_epi32(0x11000000);
+			const __m256i mask = _mm256_set1_epi32(0xf);
+			for (int y = 0; y < height; y += 4)
+				for (int x = 0, yStep = (y / 4) * Wsteps8; x < width; x += 8, yStep++)
+					for (int iy = 0; iy < 4; iy++)
+					{
+						const __m256i ia4 = UnpackBytes_AVX2(src + 32 * yStep + 8 * iy);
+						const __m256i rgba = _mm256_or_si256(
+							_mm256_mullo_epi32(_mm256_and_si256(ia4, mask), replicate_i),
+							_mm256_mullo_epi32(_mm256_srli_epi32(ia4, 4), replicate_a));
+						_mm256_storeu_si256((__m256i*)(dst + (y + iy) * width + x), rgba);
+					}
+		}
+		break;
+	case GX_TF_IA8:
+		Decode4x4Blocks16_AVX2(dst, src, width, height, ConvertIA8Functor_AVX2());
+		break;
+	case GX_TF_RGB565:
+		Decode4x4Blocks16_AVX2(dst, src, width, height, ConvertRGB565Functor_AVX2());
+		break;
+	case GX_TF_RGB5A3:
+		Decode4x4Blocks16_AVX2(dst, src, width, height, ConvertRGB5A3Functor_AVX2());
+		break;
+	case GX_TF_RGBA8:
+		DecodeRGBA8_AVX2(dst, src, width, height);
+		break;
+	case GX_TF_CMPR:
+		DecodeCMPR_AVX2(dst, src, width, height);
+		break;
+	}
+}
+
 // JSD 01/06/11:
 // TODO: we really should ensure BOTH the source and destination addresses are aligned to 16-byte boundaries to
 // squeeze out a little more performance. _mm_loadu_si128/_mm_storeu_si128 is slower than _mm_load_si128/_mm_store_si128
@@ -232,6 +645,12 @@ static void DecodeDXTBlock(u32 *dst, const DXTBlock *src, int pitch)
 
 void _TexDecoder_DecodeImpl(u32 * dst, const u8 * src, int width, int height, int texformat, const u8* tlut, TlutFormat tlutfmt)
 {
+	if (cpu_info.bAVX2)
+	{
+		TexDecoder_DecodeImpl_AVX2(dst, src, width, height, texformat, tlut, tlutfmt);
+		return;
+	}
+
 	const int Wsteps4 = (width + 3) / 4;
 	const int Wsteps8 = (width + 7) / 8;
 
@@ -389,7 +389,7 @@ void VertexLoaderARM64::GenerateVertexLoader()
 		MOV(skipped_reg, WZR);
 	MOV(saved_count, count_reg);
 
-	MOVI2R(stride_reg, (u64)&g_main_cp_state.array_strides);
+	MOVI2R(stride_reg, (u64)&VertexLoaderManager::cached_arraystrides);
 	MOVI2R(arraybase_reg, (u64)&VertexLoaderManager::cached_arraybases);
 
 	if (need_scale)
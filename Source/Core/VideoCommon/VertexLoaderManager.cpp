@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -28,6 +29,7 @@ namespace VertexLoaderManager
 
 float position_cache[3][4];
 u32 position_matrix_index[3];
+PositionCache drawn_position_cache;
 
 typedef std::unordered_map<PortableVertexDeclaration, std::unique_ptr<NativeVertexFormat>> NativeVertexFormatMap;
 static NativeVertexFormatMap s_native_vertex_map;
@@ -39,6 +41,7 @@ static VertexLoaderMap s_vertex_loader_map;
 // TODO - change into array of pointers. Keep a map of all seen so far.
 
 u8 *cached_arraybases[12];
+u32 cached_arraystrides[12];
 
 void Init()
 {
@@ -57,10 +60,10 @@ void Shutdown()
 	s_native_vertex_map.clear();
 }
 
-void UpdateVertexArrayPointers()
+static void UpdateVertexArrayPointers(CPState* state)
 {
 	// Anything to update?
-	if (!g_main_cp_state.bases_dirty)
+	if (!state->bases_dirty)
 		return;
 
 	// Some games such as Burnout 2 can put invalid addresses into
@@ -71,11 +74,17 @@ void UpdateVertexArrayPointers()
 	for (int i = 0; i < 12; i++)
 	{
 		// Only update the array base if the vertex description states we are going to use it.
-		if (g_main_cp_state.vtx_desc.GetVertexArrayStatus(i) >= 0x2)
-			cached_arraybases[i] = Memory::GetPointer(g_main_cp_state.array_bases[i]);
+		if (state->vtx_desc.GetVertexArrayStatus(i) >= 0x2)
+			cached_arraybases[i] = Memory::GetPointer(state->array_bases[i]);
+		cached_arraystrides[i] = state->array_strides[i];
 	}
 
-	g_main_cp_state.bases_dirty = false;
+	state->bases_dirty = false;
+}
+
+void UpdateVertexArrayPointers()
+{
+	UpdateVertexArrayPointers(&g_main_cp_state);
 }
 
 namespace
@@ -118,6 +127,24 @@ void MarkAllDirty()
 {
 	g_main_cp_state.attr_dirty = BitSet32::AllTrue(8);
 	g_preprocess_cp_state.attr_dirty = BitSet32::AllTrue(8);
+	// The resolved vertex arrays are shared by both states.
+	g_main_cp_state.bases_dirty = true;
+	g_preprocess_cp_state.bases_dirty = true;
+}
+
+// Must be called with s_vertex_loader_map_lock held.
+static void AssignNativeVertexFormat(VertexLoaderBase* loader)
+{
+	// search for a cached native vertex format
+	const PortableVertexDeclaration& format = loader->m_native_vtx_decl;
+	std::unique_ptr<NativeVertexFormat>& native = s_native_vertex_map[format];
+	if (!native)
+	{
+		native.reset(g_vertex_manager->CreateNativeVertexFormat());
+		native->Initialize(format);
+		native->m_components = loader->m_native_components;
+	}
+	loader->m_native_vertex_format = native.get();
 }
 
 static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = false)
@@ -145,18 +172,7 @@ static VertexLoaderBase* RefreshLoader(int vtx_attr_group, bool preprocess = fal
 			INCSTAT(stats.numVertexLoaders);
 		}
 		if (check_for_native_format)
-		{
-			// search for a cached native vertex format
-			const PortableVertexDeclaration& format = loader->m_native_vtx_decl;
-			std::unique_ptr<NativeVertexFormat>& native = s_native_vertex_map[format];
-			if (!native)
-			{
-				native.reset(g_vertex_manager->CreateNativeVertexFormat());
-				native->Initialize(format);
-				native->m_components = loader->m_native_components;
-			}
-			loader->m_native_vertex_format = native.get();
-		}
+			AssignNativeVertexFormat(loader);
 		state->vertex_loaders[vtx_attr_group] = loader;
 		state->attr_dirty[vtx_attr_group] = false;
 	} else {
@@ -197,6 +213,7 @@ int RunVertices(int vtx_attr_group, int primitive, int count, DataReader src, bo
 			loader->m_native_vtx_decl.stride, cullall);
 
 	count = loader->RunVertices(src, dst, count);
+	SavePositionCache(&drawn_position_cache);
 
 	IndexGenerator::AddIndices(primitive, count);
 
@@ -212,6 +229,52 @@ NativeVertexFormat* GetCurrentVertexFormat()
 	return s_current_vtx_fmt;
 }
 
+void SavePositionCache(PositionCache* cache)
+{
+	memcpy(cache->positions, position_cache, sizeof(position_cache));
+	memcpy(cache->matrix_indices, position_matrix_index, sizeof(position_matrix_index));
+}
+
+VertexLoaderBase* RefreshPreprocessLoader(int vtx_attr_group)
+{
+	return RefreshLoader(vtx_attr_group, true);
+}
+
+void UpdatePreprocessVertexArrayPointers()
+{
+	UpdateVertexArrayPointers(&g_preprocess_cp_state);
+}
+
+void DrawPreloadedVertices(VertexLoaderBase* loader, int primitive, int count, const u8* data,
+                           const PositionCache& positions)
+{
+	// The preprocessing thread can't create native vertex formats, it is
+	// done here on first use.
+	if (!loader->m_native_vertex_format)
+	{
+		std::lock_guard<std::mutex> lk(s_vertex_loader_map_lock);
+		AssignNativeVertexFormat(loader);
+	}
+
+	if (loader->m_native_vertex_format != s_current_vtx_fmt)
+		VertexManager::Flush();
+	s_current_vtx_fmt = loader->m_native_vertex_format;
+
+	bool cullall = (bpmem.genMode.cullmode == GenMode::CULL_ALL && primitive < 5);
+
+	const u32 stride = loader->m_native_vtx_decl.stride;
+	DataReader dst = VertexManager::PrepareForAdditionalData(primitive, count, stride, cullall);
+	memcpy(dst.GetPointer(), data, count * stride);
+	drawn_position_cache = positions;
+
+	IndexGenerator::AddIndices(primitive, count);
+
+	VertexManager::FlushData(count, stride);
+
+	ADDSTAT(stats.thisFrame.numPrims, count);
+	INCSTAT(stats.thisFrame.numPrimitiveJoins);
+}
+
 }  // namespace
 
 void LoadCPReg(u32 sub_cmd, u32 value, bool is_preprocess)
@@ -270,6 +333,7 @@ void LoadCPReg(u32 sub_cmd, u32 value, bool is_preprocess)
 
 	case 0xB0:
 		state->array_strides[sub_cmd & 0xF] = value & 0xFF;
+		state->bases_dirty = true;
 		break;
 	}
 }
@@ -10,6 +10,8 @@
 #include "VideoCommon/DataReader.h"
 #include "VideoCommon/NativeVertexFormat.h"
 
+class VertexLoaderBase;
+
 namespace VertexLoaderManager
 {
 	void Init();
@@ -25,13 +27,33 @@ namespace VertexLoaderManager
 
 	NativeVertexFormat* GetCurrentVertexFormat();
 
-	// Resolved pointers to array bases. Used by vertex loaders.
+	// Resolved pointers to array bases, and the array strides. Used by vertex loaders.
 	extern u8 *cached_arraybases[12];
+	extern u32 cached_arraystrides[12];
 	void UpdateVertexArrayPointers();
 
 	// Position cache for zfreeze (3 vertices, 4 floats each to allow SIMD overwrite).
 	// These arrays are in reverse order.
 	extern float position_cache[3][4];
 	extern u32 position_matrix_index[3];
+
+	struct PositionCache
+	{
+		float positions[3][4];
+		u32 matrix_indices[3];
+	};
+	void SavePositionCache(PositionCache* cache);
+
+	// The position cache as of the vertices last handed to the VertexManager,
+	// which is what the zfreeze slope is calculated from.
+	extern PositionCache drawn_position_cache;
+
+	// The FIFO preprocessing thread runs the vertex loaders ahead of the GPU
+	// thread, on g_preprocess_cp_state, and hands the loaded vertices over
+	// with a copy of the position cache (see FifoPreprocessor.h).
+	VertexLoaderBase* RefreshPreprocessLoader(int vtx_attr_group);
+	void UpdatePreprocessVertexArrayPointers();
+	void DrawPreloadedVertices(VertexLoaderBase* loader, int primitive, int count, const u8* data,
+	                           const PositionCache& positions);
 }
 
@@ -21,7 +21,7 @@ static const X64Reg count_reg = R10;
 static const X64Reg skipped_reg = R11;
 static const X64Reg base_reg = RBX;
 
-static const u8* memory_base_ptr = (u8*)&g_main_cp_state.array_strides;
+static const u8* memory_base_ptr = (u8*)&VertexLoaderManager::cached_arraystrides;
 
 static OpArg MPIC(const void* ptr, X64Reg scale_reg, int scale = SCALE_1)
 {
@@ -61,7 +61,7 @@ OpArg VertexLoaderX64::GetVertexAddr(int array, u64 attribute)
 			CMP(bits, R(scratch1), Imm8(-1));
 			m_skip_vertex = J_CC(CC_E, true);
 		}
-		IMUL(32, scratch1, MPIC(&g_main_cp_state.array_strides[array]));
+		IMUL(32, scratch1, MPIC(&VertexLoaderManager::cached_arraystrides[array]));
 		MOV(64, R(scratch2), MPIC(&VertexLoaderManager::cached_arraybases[array]));
 		return MRegSum(scratch1, scratch2);
 	}
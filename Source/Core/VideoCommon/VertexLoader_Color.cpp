@@ -109,7 +109,7 @@ template <typename I>
 void Color_ReadIndex_16b_565(VertexLoader* loader)
 {
 	auto const Index = DataRead<I>();
-	const u8* const address = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * g_main_cp_state.array_strides[ARRAY_COLOR + loader->m_colIndex]);
+	const u8* const address = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * VertexLoaderManager::cached_arraystrides[ARRAY_COLOR + loader->m_colIndex]);
 
 	u16 value;
 	std::memcpy(&value, address, sizeof(u16));
@@ -121,7 +121,7 @@ template <typename I>
 void Color_ReadIndex_24b_888(VertexLoader* loader)
 {
 	auto const Index = DataRead<I>();
-	const u8 *iAddress = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * g_main_cp_state.array_strides[ARRAY_COLOR + loader->m_colIndex]);
+	const u8 *iAddress = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * VertexLoaderManager::cached_arraystrides[ARRAY_COLOR + loader->m_colIndex]);
 	SetCol(loader, Read24(iAddress));
 }
 
@@ -129,7 +129,7 @@ template <typename I>
 void Color_ReadIndex_32b_888x(VertexLoader* loader)
 {
 	auto const Index = DataRead<I>();
-	const u8 *iAddress = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * g_main_cp_state.array_strides[ARRAY_COLOR + loader->m_colIndex]);
+	const u8 *iAddress = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * VertexLoaderManager::cached_arraystrides[ARRAY_COLOR + loader->m_colIndex]);
 	SetCol(loader, Read24(iAddress));
 }
 
@@ -137,7 +137,7 @@ template <typename I>
 void Color_ReadIndex_16b_4444(VertexLoader* loader)
 {
 	auto const Index = DataRead<I>();
-	const u8* const address = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * g_main_cp_state.array_strides[ARRAY_COLOR + loader->m_colIndex]);
+	const u8* const address = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * VertexLoaderManager::cached_arraystrides[ARRAY_COLOR + loader->m_colIndex]);
 
 	u16 value;
 	std::memcpy(&value, address, sizeof(u16));
@@ -149,7 +149,7 @@ template <typename I>
 void Color_ReadIndex_24b_6666(VertexLoader* loader)
 {
 	auto const Index = DataRead<I>();
-	const u8* pData = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * g_main_cp_state.array_strides[ARRAY_COLOR + loader->m_colIndex]) - 1;
+	const u8* pData = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * VertexLoaderManager::cached_arraystrides[ARRAY_COLOR + loader->m_colIndex]) - 1;
 	u32 val = Common::swap32(pData);
 	SetCol6666(loader, val);
 }
@@ -158,7 +158,7 @@ template <typename I>
 void Color_ReadIndex_32b_8888(VertexLoader* loader)
 {
 	auto const Index = DataRead<I>();
-	const u8 *iAddress = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * g_main_cp_state.array_strides[ARRAY_COLOR + loader->m_colIndex]);
+	const u8 *iAddress = VertexLoaderManager::cached_arraybases[ARRAY_COLOR + loader->m_colIndex] + (Index * VertexLoaderManager::cached_arraystrides[ARRAY_COLOR + loader->m_colIndex]);
 	SetCol(loader, Read32(iAddress));
 }
 
@@ -74,7 +74,7 @@ __forceinline void Normal_Index_Offset()
 
 	auto const index = DataRead<I>();
 	auto const data = reinterpret_cast<const T*>(VertexLoaderManager::cached_arraybases[ARRAY_NORMAL]
-	                + (index * g_main_cp_state.array_strides[ARRAY_NORMAL]) + sizeof(T) * 3 * Offset);
+	                + (index * VertexLoaderManager::cached_arraystrides[ARRAY_NORMAL]) + sizeof(T) * 3 * Offset);
 	ReadIndirect<T, N * 3>(data);
 }
 
@@ -53,7 +53,7 @@ void Pos_ReadIndex(VertexLoader* loader)
 
 	auto const index = DataRead<I>();
 	loader->m_vertexSkip = index == std::numeric_limits<I>::max();
-	auto const data = reinterpret_cast<const T*>(VertexLoaderManager::cached_arraybases[ARRAY_POSITION] + (index * g_main_cp_state.array_strides[ARRAY_POSITION]));
+	auto const data = reinterpret_cast<const T*>(VertexLoaderManager::cached_arraybases[ARRAY_POSITION] + (index * VertexLoaderManager::cached_arraystrides[ARRAY_POSITION]));
 	auto const scale = loader->m_posScale;
 	DataReader dst(g_vertex_manager_write_ptr, nullptr);
 
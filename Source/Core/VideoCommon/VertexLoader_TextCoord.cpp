@@ -70,7 +70,7 @@ void TexCoord_ReadIndex(VertexLoader* loader)
 
 	auto const index = DataRead<I>();
 	auto const data = reinterpret_cast<const T*>(VertexLoaderManager::cached_arraybases[ARRAY_TEXCOORD0 + loader->m_tcIndex]
-	                + (index * g_main_cp_state.array_strides[ARRAY_TEXCOORD0 + loader->m_tcIndex]));
+	                + (index * VertexLoaderManager::cached_arraystrides[ARRAY_TEXCOORD0 + loader->m_tcIndex]));
 	auto const scale = loader->m_tcScale[loader->m_tcIndex];
 	DataReader dst(g_vertex_manager_write_ptr, nullptr);
 
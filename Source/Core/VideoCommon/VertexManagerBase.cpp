@@ -296,16 +296,17 @@ void VertexManager::CalculateZSlope(NativeVertexFormat* format)
 	// Lookup vertices of the last rendered triangle and software-transform them
 	// This allows us to determine the depth slope, which will be used if z-freeze
 	// is enabled in the following flush.
+	VertexLoaderManager::PositionCache& cache = VertexLoaderManager::drawn_position_cache;
 	for (unsigned int i = 0; i < 3; ++i)
 	{
 		// If this vertex format has per-vertex position matrix IDs, look it up.
 		if (vert_decl.posmtx.enable)
-			mtxIdx = VertexLoaderManager::position_matrix_index[2 - i];
+			mtxIdx = cache.matrix_indices[2 - i];
 
 		if (vert_decl.position.components == 2)
-			VertexLoaderManager::position_cache[2 - i][2] = 0;
+			cache.positions[2 - i][2] = 0;
 
-		VertexShaderManager::TransformToClipSpace(&VertexLoaderManager::position_cache[2 - i][0], &out[i * 4], mtxIdx);
+		VertexShaderManager::TransformToClipSpace(&cache.positions[2 - i][0], &out[i * 4], mtxIdx);
 
 		// Transform to Screenspace
 		float inv_w = 1.0f / out[3 + i * 4];
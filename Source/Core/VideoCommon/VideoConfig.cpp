@@ -77,6 +77,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	settings->Get("UseFFV1", &bUseFFV1, 0);
 	settings->Get("EnablePixelLighting", &bEnablePixelLighting, 0);
 	settings->Get("FastDepthCalc", &bFastDepthCalc, true);
+	settings->Get("TextureDecodingThreads", &iTextureDecodingThreads, -1);
 	settings->Get("MSAA", &iMultisampleMode, 0);
 	settings->Get("SSAA", &bSSAA, false);
 	settings->Get("EFBScale", &iEFBScale, (int)SCALE_1X); // native
@@ -103,6 +104,8 @@ void VideoConfig::Load(const std::string& ini_file)
 	hacks->Get("EFBToTextureEnable", &bSkipEFBCopyToRam, true);
 	hacks->Get("EFBScaledCopy", &bCopyEFBScaled, true);
 	hacks->Get("EFBEmulateFormatChanges", &bEFBEmulateFormatChanges, false);
+	hacks->Get("AsyncTextureDecoding", &bAsyncTextureDecoding, false);
+	hacks->Get("TrackTextureWrites", &bTrackTextureWrites, false);
 
 	// hacks which are disabled by default
 	iPhackvalue[0] = 0;
@@ -210,6 +213,8 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Hacks", "EFBToTextureEnable", bSkipEFBCopyToRam);
 	CHECK_SETTING("Video_Hacks", "EFBScaledCopy", bCopyEFBScaled);
 	CHECK_SETTING("Video_Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
+	CHECK_SETTING("Video_Hacks", "AsyncTextureDecoding", bAsyncTextureDecoding);
+	CHECK_SETTING("Video_Hacks", "TrackTextureWrites", bTrackTextureWrites);
 
 	CHECK_SETTING("Video", "ProjectionHack", iPhackvalue[0]);
 	CHECK_SETTING("Video", "PH_SZNear", iPhackvalue[1]);
@@ -273,6 +278,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	settings->Set("UseFFV1", bUseFFV1);
 	settings->Set("EnablePixelLighting", bEnablePixelLighting);
 	settings->Set("FastDepthCalc", bFastDepthCalc);
+	settings->Set("TextureDecodingThreads", iTextureDecodingThreads);
 	settings->Set("ShowEFBCopyRegions", bShowEFBCopyRegions);
 	settings->Set("MSAA", iMultisampleMode);
 	settings->Set("SSAA", bSSAA);
@@ -300,6 +306,8 @@ void VideoConfig::Save(const std::string& ini_file)
 	hacks->Set("EFBToTextureEnable", bSkipEFBCopyToRam);
 	hacks->Set("EFBScaledCopy", bCopyEFBScaled);
 	hacks->Set("EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
+	hacks->Set("AsyncTextureDecoding", bAsyncTextureDecoding);
+	hacks->Set("TrackTextureWrites", bTrackTextureWrites);
 
 	iniFile.Save(ini_file);
 }
@@ -123,6 +123,11 @@ struct VideoConfig final
 	float fAspectRatioHackW, fAspectRatioHackH;
 	bool bEnablePixelLighting;
 	bool bFastDepthCalc;
+
+	// Texture decoding
+	int iTextureDecodingThreads; // -1 picks a count from the host's cores, 0 decodes on the GPU thread only
+	bool bAsyncTextureDecoding;  // Show large new textures blank until their decoding is done
+	bool bTrackTextureWrites;    // Only rehash textures whose RAM pages have been written since
 	int iLog; // CONF_ bits
 	int iSaveTargetId; // TODO: Should be dropped
 
@@ -0,0 +1,90 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "AudioCommon/CaptureSoundStream.h"
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+
+namespace
+{
+
+const u64 TICKS_PER_SECOND = 486000000;
+const u64 WAVE_HEADER_SIZE = 44;
+
+class CaptureSoundTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		m_dir = File::CreateTempDir();
+		SConfig::GetInstance().m_CapturePath = m_dir + DIR_SEP "capture.wav";
+	}
+
+	void TearDown() override
+	{
+		File::DeleteDirRecursively(m_dir);
+		SConfig::Shutdown();
+	}
+
+	u64 CapturedFrames() const
+	{
+		return (File::GetSize(SConfig::GetInstance().m_CapturePath) - WAVE_HEADER_SIZE) / 4;
+	}
+
+	// Captures for duration ticks, updating every step ticks.
+	u64 Capture(u64 duration, u64 step)
+	{
+		CaptureSound capture;
+		EXPECT_TRUE(capture.Start());
+		u64 ticks = 1000;
+		capture.RenderUntil(ticks, TICKS_PER_SECOND);
+		for (u64 end = ticks + duration; ticks < end;)
+		{
+			ticks = std::min(ticks + step, end);
+			capture.RenderUntil(ticks, TICKS_PER_SECOND);
+		}
+		capture.Stop();
+		return CapturedFrames();
+	}
+
+	std::string m_dir;
+};
+
+}  // namespace
+
+TEST_F(CaptureSoundTest, LengthFollowsEmulatedTime)
+{
+	// One update per 32 kHz AI DMA, and per 48 kHz one.
+	EXPECT_EQ(96000u, Capture(TICKS_PER_SECOND * 2, TICKS_PER_SECOND / 4000));
+	EXPECT_EQ(96000u, Capture(TICKS_PER_SECOND * 2, TICKS_PER_SECOND / 6000));
+}
+
+TEST_F(CaptureSoundTest, CarriesFractionalFrames)
+{
+	// Every step is shorter than a frame.
+	EXPECT_EQ(48000u, Capture(TICKS_PER_SECOND, 7919));
+}
+
+TEST_F(CaptureSoundTest, SkipsStateLoads)
+{
+	CaptureSound capture;
+	EXPECT_TRUE(capture.Start());
+	capture.RenderUntil(TICKS_PER_SECOND * 10, TICKS_PER_SECOND);
+	capture.RenderUntil(TICKS_PER_SECOND * 10 + TICKS_PER_SECOND / 2, TICKS_PER_SECOND);
+	// Going back in time, and far ahead of it.
+	capture.RenderUntil(TICKS_PER_SECOND, TICKS_PER_SECOND);
+	capture.RenderUntil(TICKS_PER_SECOND + TICKS_PER_SECOND / 2, TICKS_PER_SECOND);
+	capture.RenderUntil(TICKS_PER_SECOND * 60, TICKS_PER_SECOND);
+	capture.RenderUntil(TICKS_PER_SECOND * 60 + TICKS_PER_SECOND / 2, TICKS_PER_SECOND);
+	capture.Stop();
+
+	EXPECT_EQ(3u * 24000, CapturedFrames());
+}
@@ -0,0 +1,86 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "AudioCommon/DPL2Decoder.h"
+
+namespace
+{
+
+// Interleaved stereo with a common tone and a phase-inverted one, so that
+// every output channel carries something.
+std::vector<float> MakeInput(int num_frames, float front_freq, float rear_freq)
+{
+	std::vector<float> input(num_frames * 2);
+	for (int i = 0; i < num_frames; ++i)
+	{
+		const float front = 0.4f * std::sin(2 * 3.14159265f * front_freq * i / 48000);
+		const float rear = 0.3f * std::sin(2 * 3.14159265f * rear_freq * i / 48000);
+		input[i * 2] = front + rear;
+		input[i * 2 + 1] = front - rear;
+	}
+	return input;
+}
+
+std::vector<float> Decode(std::vector<float> input, int chunk)
+{
+	const int num_frames = (int)input.size() / 2;
+	std::vector<float> output(num_frames * 6);
+	DPL2Reset();
+	for (int i = 0; i < num_frames; i += chunk)
+		DPL2Decode(&input[i * 2], std::min(chunk, num_frames - i), &output[i * 6]);
+	return output;
+}
+
+}  // namespace
+
+TEST(DPL2Decoder, ChunkSizeDoesNotMatter)
+{
+	const std::vector<float> input = MakeInput(10000, 440.0f, 90.0f);
+	const std::vector<float> whole = Decode(input, 10000);
+
+	for (int chunk : { 1, 37, 240, 256, 1000 })
+		EXPECT_TRUE(Decode(input, chunk) == whole) << "chunk size " << chunk;
+}
+
+TEST(DPL2Decoder, LFEIsLowPassed)
+{
+	auto lfe_peak = [](float freq) {
+		const std::vector<float> output = Decode(MakeInput(24000, freq, freq), 512);
+		float peak = 0.0f;
+		// Skip the first half while the AGC settles.
+		for (size_t i = output.size() / 2 + 3; i < output.size(); i += 6)
+			peak = std::max(peak, std::fabs(output[i]));
+		return peak;
+	};
+
+	const float low = lfe_peak(50.0f);
+	const float high = lfe_peak(2000.0f);
+	EXPECT_GT(low, 0.05f);
+	EXPECT_LT(high, low * 0.05f);
+}
+
+TEST(DPL2Decoder, DISABLED_Benchmark)
+{
+	// Not a pass/fail test, just the throughput of the decoder.
+	const int num_frames = 48000 * 10;
+	std::vector<float> input = MakeInput(num_frames, 440.0f, 90.0f);
+	std::vector<float> output(num_frames * 6);
+
+	DPL2Reset();
+	const int chunk = 1024;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < num_frames; i += chunk)
+		DPL2Decode(&input[i * 2], std::min(chunk, num_frames - i), &output[i * 6]);
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	printf("DPL2 decoder: %.2f Msamples/s (%.0fx real time at 48 kHz)\n",
+	       num_frames / elapsed.count() / 1e6, num_frames / elapsed.count() / 48000.0);
+}
@@ -0,0 +1,301 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "AudioCommon/FlacFile.h"
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+
+namespace
+{
+
+class BitReader
+{
+public:
+	explicit BitReader(const std::string& data) : m_data(data), m_pos(0) {}
+
+	u32 Read(u32 bits)
+	{
+		u32 value = 0;
+		for (u32 i = 0; i < bits; i++, m_pos++)
+			value = (value << 1) | ((m_data[m_pos / 8] >> (7 - m_pos % 8)) & 1);
+		return value;
+	}
+
+	s32 ReadSigned(u32 bits)
+	{
+		u32 value = Read(bits);
+		return (s32)(value << (32 - bits)) >> (32 - bits);
+	}
+
+	u32 ReadUnary()
+	{
+		u32 zeros = 0;
+		while (!Read(1))
+			zeros++;
+		return zeros;
+	}
+
+	void Align() { m_pos = (m_pos + 7) & ~7; }
+	bool AtEnd() const { return m_pos >= m_data.size() * 8; }
+
+private:
+	const std::string& m_data;
+	size_t m_pos;
+};
+
+struct DecodedStream
+{
+	u32 sample_rate;
+	u64 total_samples;
+	u32 frames;
+	std::vector<short> samples;
+};
+
+void DecodeSubframe(BitReader& bits, u32 block_size, u32 bps, s32* out)
+{
+	ASSERT_EQ(0u, bits.Read(1));
+	const u32 type = bits.Read(6);
+	ASSERT_EQ(0u, bits.Read(1));
+
+	if (type == 0x00)
+	{
+		const s32 value = bits.ReadSigned(bps);
+		for (u32 i = 0; i < block_size; i++)
+			out[i] = value;
+	}
+	else if (type == 0x01)
+	{
+		for (u32 i = 0; i < block_size; i++)
+			out[i] = bits.ReadSigned(bps);
+	}
+	else
+	{
+		ASSERT_EQ(0x08u, type & 0x38);
+		const u32 order = type & 7;
+		ASSERT_LE(order, 4u);
+		for (u32 i = 0; i < order; i++)
+			out[i] = bits.ReadSigned(bps);
+
+		ASSERT_EQ(0u, bits.Read(2));
+		const u32 partition_order = bits.Read(4);
+		u32 sample = order;
+		for (u32 p = 0; p < (1U << partition_order); p++)
+		{
+			const u32 k = bits.Read(4);
+			ASSERT_NE(15u, k);
+			const u32 n = (block_size >> partition_order) - (p ? 0 : order);
+			for (u32 i = 0; i < n; i++, sample++)
+			{
+				const u32 q = bits.ReadUnary();
+				const u32 u = (q << k) | bits.Read(k);
+				const s32 residual = (s32)(u >> 1) ^ -(s32)(u & 1);
+				const s32* x = &out[sample];
+				s32 prediction = 0;
+				switch (order)
+				{
+				case 1: prediction = x[-1]; break;
+				case 2: prediction = 2 * x[-1] - x[-2]; break;
+				case 3: prediction = 3 * x[-1] - 3 * x[-2] + x[-3]; break;
+				case 4: prediction = 4 * x[-1] - 6 * x[-2] + 4 * x[-3] - x[-4]; break;
+				}
+				out[sample] = prediction + residual;
+			}
+		}
+		ASSERT_EQ(block_size, sample);
+	}
+}
+
+// A minimal decoder for the subset of FLAC that FlacFileWriter produces.
+void Decode(const std::string& data, DecodedStream* stream)
+{
+	BitReader bits(data);
+	ASSERT_EQ(0x664C6143u, bits.Read(32));
+	ASSERT_EQ(1u, bits.Read(1));
+	ASSERT_EQ(0u, bits.Read(7));
+	ASSERT_EQ(34u, bits.Read(24));
+	ASSERT_EQ((u32)FLAC_BLOCK_SIZE, bits.Read(16));
+	ASSERT_EQ((u32)FLAC_BLOCK_SIZE, bits.Read(16));
+	const u32 min_frame_size = bits.Read(24);
+	const u32 max_frame_size = bits.Read(24);
+	stream->sample_rate = bits.Read(20);
+	ASSERT_EQ(1u, bits.Read(3));
+	ASSERT_EQ(15u, bits.Read(5));
+	stream->total_samples = (u64)bits.Read(4) << 32;
+	stream->total_samples |= bits.Read(32);
+	for (int i = 0; i < 4; i++)
+		bits.Read(32);
+
+	stream->frames = 0;
+	std::vector<s32> channels[2];
+	channels[0].resize(FLAC_BLOCK_SIZE);
+	channels[1].resize(FLAC_BLOCK_SIZE);
+
+	while (!bits.AtEnd())
+	{
+		ASSERT_EQ(0x3FFEu, bits.Read(14));
+		ASSERT_EQ(0u, bits.Read(2));
+		const u32 block_size_code = bits.Read(4);
+		ASSERT_EQ(0u, bits.Read(4));
+		const u32 mode = bits.Read(4);
+		ASSERT_EQ(4u, bits.Read(3));
+		ASSERT_EQ(0u, bits.Read(1));
+
+		u32 frame_number = bits.Read(8);
+		u32 extra = 0;
+		if (frame_number & 0x80)
+		{
+			while (frame_number & (0x40 >> extra))
+				extra++;
+			frame_number &= 0x3F >> extra;
+		}
+		for (u32 i = 0; i < extra; i++)
+			frame_number = (frame_number << 6) | (bits.Read(8) & 0x3F);
+		EXPECT_EQ(stream->frames, frame_number);
+
+		u32 block_size = FLAC_BLOCK_SIZE;
+		if (block_size_code == 0x7)
+			block_size = bits.Read(16) + 1;
+		else
+			ASSERT_EQ(0xCu, block_size_code);
+		bits.Read(8); // CRC-8
+
+		const u32 side_channel = mode == 0x9 ? 0 : 1;
+		for (u32 c = 0; c < 2; c++)
+		{
+			const u32 bps = (mode != 0x1 && c == side_channel) ? 17 : 16;
+			DecodeSubframe(bits, block_size, bps, channels[c].data());
+			if (::testing::Test::HasFatalFailure())
+				return;
+		}
+		bits.Align();
+		bits.Read(16); // CRC-16
+
+		for (u32 i = 0; i < block_size; i++)
+		{
+			s32 left = channels[0][i];
+			s32 right = channels[1][i];
+			switch (mode)
+			{
+			case 0x8: right = left - right; break;
+			case 0x9: left += right; break;
+			case 0xA:
+			{
+				const s32 mid = (left << 1) | (right & 1);
+				left = (mid + right) >> 1;
+				right = (mid - right) >> 1;
+				break;
+			}
+			}
+			stream->samples.push_back((short)left);
+			stream->samples.push_back((short)right);
+		}
+		stream->frames++;
+	}
+
+	EXPECT_NE(0u, min_frame_size);
+	EXPECT_LE(min_frame_size, max_frame_size);
+}
+
+std::vector<short> MakeInput(u32 num_frames)
+{
+	std::vector<short> input(num_frames * 2);
+	u32 seed = 12345;
+	for (u32 i = 0; i < num_frames; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		const s32 noise = (s32)((seed >> 16) & 0xFF) - 128;
+		const u32 section = i / 3000 % 4;
+		if (section == 0)
+		{
+			// Correlated tones, where stereo decorrelation pays off.
+			const s32 tone = (s32)std::lround(12000 * std::sin(i * 0.031));
+			input[i * 2] = (short)(tone + noise);
+			input[i * 2 + 1] = (short)(tone - noise);
+		}
+		else if (section == 1)
+		{
+			// Silence
+		}
+		else if (section == 2)
+		{
+			// Full scale square waves, which need the 17-bit side channel.
+			input[i * 2] = (i & 1) ? 32767 : -32768;
+			input[i * 2 + 1] = (i & 1) ? -32768 : 32767;
+		}
+		else
+		{
+			// White noise, which is cheaper to store verbatim.
+			input[i * 2] = (short)(seed >> 8);
+			input[i * 2 + 1] = (short)(seed >> 3);
+		}
+	}
+	return input;
+}
+
+std::string Encode(const std::vector<short>& input, u32 chunk_frames)
+{
+	const std::string dir = File::CreateTempDir();
+	const std::string path = dir + DIR_SEP "test.flac";
+
+	{
+		FlacFileWriter writer;
+		EXPECT_TRUE(writer.Start(path, 32000));
+		const u32 num_frames = (u32)input.size() / 2;
+		for (u32 i = 0; i < num_frames; i += chunk_frames)
+			writer.AddStereoSamples(&input[i * 2], std::min(chunk_frames, num_frames - i));
+		writer.Stop();
+	}
+
+	std::string data;
+	EXPECT_TRUE(File::ReadFileToString(path, data));
+	File::DeleteDirRecursively(dir);
+	return data;
+}
+
+}  // namespace
+
+TEST(FlacFile, RoundTrip)
+{
+	// More than 128 frames, so that frame numbers need two bytes.
+	const u32 num_frames = FLAC_BLOCK_SIZE * 130 + 1234;
+	const std::vector<short> input = MakeInput(num_frames);
+	const std::string data = Encode(input, 333);
+
+	DecodedStream stream;
+	Decode(data, &stream);
+	if (HasFatalFailure())
+		return;
+
+	EXPECT_EQ(32000u, stream.sample_rate);
+	EXPECT_EQ(num_frames, stream.total_samples);
+	EXPECT_EQ(131u, stream.frames);
+	ASSERT_EQ(input.size(), stream.samples.size());
+	for (size_t i = 0; i < input.size(); i++)
+		ASSERT_EQ(input[i], stream.samples[i]) << "at sample " << i;
+}
+
+TEST(FlacFile, CompressesTones)
+{
+	const u32 num_frames = 48000;
+	std::vector<short> input(num_frames * 2);
+	for (u32 i = 0; i < num_frames; i++)
+	{
+		input[i * 2] = (short)std::lround(10000 * std::sin(i * 0.02));
+		input[i * 2 + 1] = (short)std::lround(8000 * std::sin(i * 0.05));
+	}
+
+	const std::string data = Encode(input, FLAC_BLOCK_SIZE);
+	EXPECT_LT(data.size(), input.size() * sizeof(short) / 3);
+
+	DecodedStream stream;
+	Decode(data, &stream);
+	EXPECT_TRUE(stream.samples == input);
+}
@@ -0,0 +1,208 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "AudioCommon/Mixer.h"
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+
+namespace
+{
+
+// Exposes the individual FIFOs, CMixer::Mix only mixes while the CPU runs.
+class TestMixer : public CMixer
+{
+public:
+	TestMixer() : CMixer(48000) {}
+
+	unsigned int MixDMA(short* samples, unsigned int num_samples) { return m_dma_mixer.Mix(samples, num_samples, false); }
+	unsigned int MixStreaming(short* samples, unsigned int num_samples) { return m_streaming_mixer.Mix(samples, num_samples, false); }
+	unsigned int MixWiimoteSpeaker(short* samples, unsigned int num_samples) { return m_wiimote_speaker_mixer.Mix(samples, num_samples, false); }
+};
+
+// Big-endian interleaved stereo, as pushed by the DSP.
+std::vector<short> MakeInput(unsigned int num_frames, double left_freq, double right_freq, double sample_rate)
+{
+	std::vector<short> input(num_frames * 2);
+	for (unsigned int i = 0; i < num_frames; ++i)
+	{
+		input[i * 2] = Common::swap16((u16)(s16)std::lround(16000 * std::sin(2 * 3.14159265358979 * left_freq * i / sample_rate)));
+		input[i * 2 + 1] = Common::swap16((u16)(s16)std::lround(12000 * std::cos(2 * 3.14159265358979 * right_freq * i / sample_rate)));
+	}
+	return input;
+}
+
+// Feeds 5 ms chunks at 32 kHz through the DMA FIFO and collects 48 kHz output.
+std::vector<short> ResampleDMA(const std::vector<short>& input, bool polyphase)
+{
+	SConfig::GetInstance().m_PolyphaseResampler = polyphase;
+
+	TestMixer mixer;
+	std::vector<short> output;
+	const unsigned int in_chunk = 160;
+	const unsigned int out_chunk = 240;
+	for (size_t pos = 0; pos + in_chunk * 2 <= input.size(); pos += in_chunk * 2)
+	{
+		mixer.PushSamples(&input[pos], in_chunk);
+		short out[out_chunk * 2] = {};
+		mixer.MixDMA(out, out_chunk);
+		output.insert(output.end(), out, out + out_chunk * 2);
+	}
+	return output;
+}
+
+class MixerTest : public testing::Test
+{
+protected:
+	void SetUp() override { SConfig::Init(); }
+	void TearDown() override { SConfig::Shutdown(); }
+};
+
+}  // namespace
+
+TEST_F(MixerTest, PolyphasePassesDC)
+{
+	std::vector<short> input(3200 * 2);
+	for (size_t i = 0; i < input.size(); i += 2)
+	{
+		input[i] = Common::swap16((u16)1234);
+		input[i + 1] = Common::swap16((u16)-5678);
+	}
+
+	std::vector<short> output = ResampleDMA(input, true);
+	// Skip the start, where the filter window still covers the silence the
+	// FIFO was initialized with. Output channels are swapped, like with the
+	// linear resampler.
+	for (size_t i = 480; i < output.size(); i += 2)
+	{
+		EXPECT_NEAR(-5678, output[i], 1);
+		EXPECT_NEAR(1234, output[i + 1], 1);
+	}
+}
+
+TEST_F(MixerTest, PolyphaseLinesUpWithLinear)
+{
+	// For a low frequency both resamplers must agree closely. A window that
+	// is off by a frame would be off by hundreds here.
+	std::vector<short> input = MakeInput(6400, 200.0, 150.0, 32000.0);
+	std::vector<short> linear = ResampleDMA(input, false);
+	std::vector<short> polyphase = ResampleDMA(input, true);
+
+	ASSERT_EQ(linear.size(), polyphase.size());
+	for (size_t i = 480; i < linear.size(); ++i)
+		EXPECT_NEAR(linear[i], polyphase[i], 32) << "at " << i;
+}
+
+TEST_F(MixerTest, CountsUnderrunsAndOverruns)
+{
+	TestMixer mixer;
+	std::vector<short> input = MakeInput(1000, 440.0, 440.0, 32000.0);
+	std::vector<short> output(1000 * 2);
+
+	// An idle FIFO is not underrunning.
+	mixer.MixStreaming(output.data(), 500);
+	EXPECT_EQ(0u, mixer.GetUnderrunCount());
+
+	// 100 input frames cannot cover 500 output frames at 48 kHz.
+	mixer.PushSamples(input.data(), 100);
+	mixer.MixDMA(output.data(), 500);
+	u64 underruns = mixer.GetUnderrunCount();
+	EXPECT_GT(underruns, 300u);
+	EXPECT_LT(underruns, 500u);
+
+	// Nothing is dropped until the ring is full.
+	for (int i = 0; i < 3; ++i)
+		mixer.PushSamples(input.data(), 500);
+	EXPECT_EQ(0u, mixer.GetOverrunCount());
+	mixer.PushSamples(input.data(), 1000);
+	EXPECT_EQ(1000u, mixer.GetOverrunCount());
+}
+
+TEST_F(MixerTest, StopsCountingUnderrunsOnceIdle)
+{
+	TestMixer mixer;
+	std::vector<short> input = MakeInput(1000, 440.0, 440.0, 32000.0);
+	std::vector<short> output(480 * 2);
+
+	// The stream plays for a while, then stops. The frame the resampler
+	// keeps back is never drained.
+	for (int i = 0; i < 10; ++i)
+	{
+		mixer.PushSamples(input.data(), 320);
+		mixer.MixDMA(output.data(), 480);
+	}
+	const u64 playing = mixer.GetUnderrunCount();
+
+	// Padding is still counted within the latency window after the last push...
+	for (int i = 0; i < 10; ++i)
+		mixer.MixDMA(output.data(), 480);
+	const u64 stopped = mixer.GetUnderrunCount();
+	EXPECT_LE(stopped - playing, 48000u * DEFAULT_LATENCY_TARGET / 1000 + 480);
+
+	// ...but not after it.
+	for (int i = 0; i < 100; ++i)
+		mixer.MixDMA(output.data(), 480);
+	EXPECT_EQ(stopped, mixer.GetUnderrunCount());
+
+	// Pushing again puts it back in use.
+	mixer.PushSamples(input.data(), 10);
+	mixer.MixDMA(output.data(), 480);
+	EXPECT_GT(mixer.GetUnderrunCount(), stopped);
+}
+
+TEST_F(MixerTest, DISABLED_Benchmark)
+{
+	// Not a pass/fail test, just timings for the three mixers.
+	const unsigned int out_frames = 48000 * 4;
+	const unsigned int chunk = 256;
+
+	struct Source
+	{
+		const char* name;
+		double input_rate;
+		unsigned int (TestMixer::*mix)(short*, unsigned int);
+	};
+	const Source sources[] = {
+		{ "DMA", 32000.0, &TestMixer::MixDMA },
+		{ "streaming", 48000.0, &TestMixer::MixStreaming },
+		{ "Wiimote speaker", 3000.0, &TestMixer::MixWiimoteSpeaker },
+	};
+
+	for (bool polyphase : { false, true })
+	{
+		SConfig::GetInstance().m_PolyphaseResampler = polyphase;
+		for (const Source& source : sources)
+		{
+			TestMixer mixer;
+			unsigned int in_chunk = (unsigned int)(chunk * source.input_rate / 48000.0) + 1;
+			std::vector<short> input = MakeInput(in_chunk, 440.0, 880.0, source.input_rate);
+			std::vector<short> output(chunk * 2);
+
+			std::chrono::nanoseconds elapsed(0);
+			for (unsigned int done = 0; done < out_frames; done += chunk)
+			{
+				if (source.mix == &TestMixer::MixWiimoteSpeaker)
+					mixer.PushWiimoteSpeakerSamples(input.data(), in_chunk, 3000);
+				else if (source.mix == &TestMixer::MixStreaming)
+					mixer.PushStreamingSamples(input.data(), in_chunk);
+				else
+					mixer.PushSamples(input.data(), in_chunk);
+
+				auto start = std::chrono::steady_clock::now();
+				(mixer.*source.mix)(output.data(), chunk);
+				elapsed += std::chrono::steady_clock::now() - start;
+			}
+
+			printf("%-16s %-9s %6.2f ns/frame\n", source.name, polyphase ? "polyphase" : "linear",
+			       (double)elapsed.count() / out_frames);
+		}
+	}
+}
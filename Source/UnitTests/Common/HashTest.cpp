@@ -0,0 +1,135 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/FileSearch.h"
+#include "Common/FileUtil.h"
+#include "Common/Hash.h"
+
+static std::vector<u8> MakeData(size_t size)
+{
+	std::vector<u8> data(size);
+	u32 seed = 12345;
+	for (u8& b : data)
+	{
+		seed = seed * 1103515245 + 12345;
+		b = (u8)(seed >> 16);
+	}
+	return data;
+}
+
+TEST(Hash, StripeHashKnownValues)
+{
+	// The texture cache relies on the hash being the same with and without
+	// SIMD, so these hold for every host.
+	const struct
+	{
+		u32 len;
+		u32 samples;
+		u64 hash;
+	} cases[] = {
+		{ 1, 0, 0x1721c4147a3e91d9 },
+		{ 7, 0, 0x03c11256456a12ea },
+		{ 8, 0, 0xa7e0f4057dc8c691 },
+		{ 63, 0, 0x3c8fe166e4e789a9 },
+		{ 64, 0, 0x6ed3fddbc6e74d5c },
+		{ 65, 0, 0x9e59b31e6b6fb4a4 },
+		{ 1000, 0, 0x178cf89aac3c591c },
+		{ 1024, 0, 0x313cc0dd9e4a9f72 },
+		{ 4113, 0, 0x2d3b854b9008ad24 },
+		{ 16384, 0, 0x9063ee1aaed5d0e8 },
+		{ 16384, 128, 0xcbdf6e8320027f3a },
+		{ 20000, 512, 0x64653ed03f3b42e1 },
+	};
+
+	const std::vector<u8> data = MakeData(20000);
+	for (const auto& c : cases)
+		EXPECT_EQ(c.hash, GetStripeHash(data.data(), c.len, c.samples)) << "len " << c.len << " samples " << c.samples;
+}
+
+TEST(Hash, StripeHashSeesEveryByte)
+{
+	std::vector<u8> data = MakeData(3000);
+	const u64 hash = GetStripeHash(data.data(), (u32)data.size(), 0);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] ^= 1 << (i % 8);
+		EXPECT_NE(hash, GetStripeHash(data.data(), (u32)data.size(), 0)) << "byte " << i;
+		data[i] ^= 1 << (i % 8);
+	}
+}
+
+TEST(Hash, StripeHashSeesStripeOrder)
+{
+	// Textures are made of identical tiles often, moving them around has to
+	// change the hash.
+	std::vector<u8> data = MakeData(64 * 40);
+	const u64 hash = GetStripeHash(data.data(), (u32)data.size(), 0);
+	for (size_t a : { 0, 3, 15 })
+	{
+		for (size_t b : { 1, 16, 17, 30 })
+		{
+			std::vector<u8> swapped = data;
+			std::swap_ranges(swapped.begin() + a * 64, swapped.begin() + a * 64 + 64, swapped.begin() + b * 64);
+			EXPECT_NE(hash, GetStripeHash(swapped.data(), (u32)swapped.size(), 0)) << a << " <-> " << b;
+		}
+	}
+}
+
+TEST(Hash, DISABLED_Benchmark)
+{
+	// Not a pass/fail test. Hashes the files in DOLPHIN_HASH_BENCHMARK_DIR,
+	// e.g. textures dumped from a game, or generated texture sized buffers.
+	std::vector<std::vector<u8>> textures;
+	if (const char* dir = getenv("DOLPHIN_HASH_BENCHMARK_DIR"))
+	{
+		for (const std::string& path : DoFileSearch({ "*" }, { dir }, true))
+		{
+			std::string contents;
+			if (File::ReadFileToString(path, contents) && !contents.empty())
+				textures.emplace_back(contents.begin(), contents.end());
+		}
+	}
+	if (textures.empty())
+	{
+		for (u32 size : { 32 * 32 * 4, 64 * 64, 128 * 128 * 2, 256 * 256 / 2, 512 * 512 * 4, 1024 * 1024 })
+			textures.push_back(MakeData(size));
+	}
+
+	size_t total = 0;
+	for (const std::vector<u8>& texture : textures)
+		total += texture.size();
+
+	const struct
+	{
+		const char* name;
+		u64 (*function)(const u8*, u32, u32);
+	} functions[] = {
+		{ "MurmurHash3", GetMurmurHash3 },
+		{ "Stripe", GetStripeHash },
+	};
+
+	for (const auto& f : functions)
+	{
+		const int rounds = (int)std::max<size_t>(256 * 1024 * 1024 / total, 1);
+		u64 sink = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < rounds; r++)
+		{
+			for (const std::vector<u8>& texture : textures)
+				sink += f.function(texture.data(), (u32)texture.size(), 0);
+		}
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		printf("%s: %.2f GB/s over %zu textures (%llx)\n", f.name,
+		       (double)total * rounds / elapsed.count() / 1e9, textures.size(), (unsigned long long)sink);
+	}
+}
@@ -0,0 +1,106 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/MPSCQueue.h"
+
+TEST(MPSCQueue, Simple)
+{
+	Common::MPSCQueue<u32, 16> q;
+
+	EXPECT_TRUE(q.Empty());
+
+	q.Push(1);
+	EXPECT_FALSE(q.Empty());
+
+	u32 v; q.Pop(v);
+	EXPECT_EQ(1u, v);
+	EXPECT_TRUE(q.Empty());
+	EXPECT_FALSE(q.Pop(v));
+
+	// Test the FIFO order, reusing the nodes of the pool several times over.
+	for (u32 i = 0; i < 1000; ++i)
+	{
+		q.Push(i);
+		if (i % 10 == 9)
+		{
+			for (u32 j = i - 9; j <= i; ++j)
+			{
+				u32 v2; q.Pop(v2);
+				EXPECT_EQ(j, v2);
+			}
+		}
+	}
+	EXPECT_TRUE(q.Empty());
+
+	// Leave some elements queued for the destructor.
+	for (u32 i = 0; i < 10; ++i)
+		q.Push(i);
+}
+
+TEST(MPSCQueue, Full)
+{
+	Common::MPSCQueue<u32, 16> q;
+
+	// One node is always the stub, so 15 elements fit.
+	for (u32 i = 0; i < 15; ++i)
+		EXPECT_TRUE(q.TryPush(i));
+	EXPECT_FALSE(q.TryPush(15u));
+
+	// Popping frees a node for the next push.
+	u32 v;
+	EXPECT_TRUE(q.Pop(v));
+	EXPECT_EQ(0u, v);
+	EXPECT_TRUE(q.TryPush(15u));
+	EXPECT_FALSE(q.TryPush(16u));
+
+	// A blocked writer carries on once the reader makes room.
+	std::thread writer([&q] { q.Push(16u); });
+	for (u32 i = 1; i <= 16; ++i)
+	{
+		while (!q.Pop(v))
+			std::this_thread::yield();
+		EXPECT_EQ(i, v);
+	}
+	writer.join();
+	EXPECT_TRUE(q.Empty());
+}
+
+TEST(MPSCQueue, MultiThreaded)
+{
+	const u32 num_threads = 4;
+	const u32 per_thread = 100000;
+	Common::MPSCQueue<u32, 64> q;
+
+	auto inserter = [&q](u32 thread) {
+		for (u32 i = 0; i < per_thread; ++i)
+			q.Push(thread << 24 | i);
+	};
+
+	std::vector<std::thread> inserters;
+	for (u32 t = 0; t < num_threads; ++t)
+		inserters.emplace_back(inserter, t);
+
+	// Every element has to arrive exactly once, in the order each writer pushed them. The writers
+	// fill the pool much faster than it's drained, so they keep waiting for free nodes.
+	std::vector<u32> next(num_threads, 0);
+	for (u32 received = 0; received < num_threads * per_thread;)
+	{
+		u32 v;
+		if (!q.Pop(v))
+			continue;
+		u32 thread = v >> 24;
+		ASSERT_LT(thread, num_threads);
+		EXPECT_EQ(next[thread], v & 0xFFFFFF);
+		next[thread] = (v & 0xFFFFFF) + 1;
+		++received;
+	}
+
+	for (std::thread& t : inserters)
+		t.join();
+	EXPECT_TRUE(q.Empty());
+}
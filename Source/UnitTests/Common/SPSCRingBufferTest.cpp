@@ -0,0 +1,145 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "Common/SPSCRingBuffer.h"
+
+TEST(SPSCRingBuffer, Simple)
+{
+	Common::SPSCRingBuffer buffer(16, 0xEE);
+	const u8* data;
+
+	EXPECT_TRUE(buffer.Empty());
+	EXPECT_EQ(0u, buffer.Peek(&data));
+
+	u8* p = buffer.Reserve(6);
+	ASSERT_NE(nullptr, p);
+	memcpy(p, "abcdef", 6);
+	// Nothing is visible before the commit, and only what was committed after it.
+	EXPECT_EQ(0u, buffer.Peek(&data));
+	buffer.Commit(4);
+	EXPECT_FALSE(buffer.Empty());
+	ASSERT_EQ(4u, buffer.Peek(&data));
+	EXPECT_EQ(0, memcmp(data, "abcd", 4));
+	EXPECT_EQ(4u, buffer.GetWritePosition());
+
+	// 4 bytes are in use, so 12 are left.
+	EXPECT_EQ(nullptr, buffer.Reserve(13));
+	p = buffer.Reserve(10);
+	ASSERT_NE(nullptr, p);
+	memcpy(p, "0123456789", 10);
+	buffer.Commit(10);
+	EXPECT_EQ(nullptr, buffer.Reserve(3));
+
+	buffer.Release(6);
+	ASSERT_EQ(8u, buffer.Peek(&data));
+	EXPECT_EQ(0, memcmp(data, "23456789", 8));
+
+	// Doesn't fit in front of the end, so the last 2 bytes become padding. The start of the
+	// buffer is free up to the read position.
+	EXPECT_EQ(nullptr, buffer.Reserve(7));
+	p = buffer.Reserve(3);
+	ASSERT_NE(nullptr, p);
+	memcpy(p, "xyz", 3);
+	buffer.Commit(3);
+	EXPECT_EQ(19u, buffer.GetWritePosition());
+
+	ASSERT_EQ(10u, buffer.Peek(&data));
+	EXPECT_EQ(0, memcmp(data, "23456789\xEE\xEE", 10));
+	buffer.Release(10);
+	ASSERT_EQ(3u, buffer.Peek(&data));
+	EXPECT_EQ(0, memcmp(data, "xyz", 3));
+	buffer.Release(3);
+	EXPECT_TRUE(buffer.Empty());
+}
+
+TEST(SPSCRingBuffer, SkipWhenEmpty)
+{
+	// Once the reader has caught up, a reservation can use the whole buffer, even when the
+	// write position is in the middle.
+	Common::SPSCRingBuffer buffer(16, 0xEE);
+	const u8* data;
+	ASSERT_NE(nullptr, buffer.Reserve(9));
+	buffer.Commit(9);
+	EXPECT_EQ(nullptr, buffer.Reserve(10));
+	buffer.Release(9);
+	EXPECT_TRUE(buffer.Empty());
+
+	// This overlaps where the end of the buffer would have been padded, so the reader has to
+	// start at the reservation rather than walk into its middle.
+	u8* p = buffer.Reserve(12);
+	ASSERT_NE(nullptr, p);
+	memcpy(p, "abcdefghijkl", 12);
+	buffer.Commit(12);
+	EXPECT_EQ(28u, buffer.GetWritePosition());
+	ASSERT_EQ(12u, buffer.Peek(&data));
+	EXPECT_EQ(0, memcmp(data, "abcdefghijkl", 12));
+	EXPECT_EQ(nullptr, buffer.Reserve(5));
+
+	// The same with a reader that releases up to write positions, including a stale one.
+	u64 position = buffer.GetWritePosition();
+	buffer.ReleaseTo(position);
+	p = buffer.Reserve(16);
+	ASSERT_NE(nullptr, p);
+	buffer.Commit(16);
+	EXPECT_EQ(48u, buffer.GetWritePosition());
+	buffer.ReleaseTo(position);
+	ASSERT_EQ(16u, buffer.Peek(&data));
+	EXPECT_EQ(nullptr, buffer.Reserve(1));
+	EXPECT_EQ(nullptr, buffer.Reserve(17));
+}
+
+TEST(SPSCRingBuffer, MultiThreaded)
+{
+	// Records of varying size, each filled with its own sequence number, so that any
+	// byte the reader gets too early or too late shows up.
+	const u32 num_records = 200000;
+	Common::SPSCRingBuffer buffer(4096, 0);
+
+	std::thread writer([&buffer] {
+		for (u32 i = 0; i < num_records; ++i)
+		{
+			const size_t size = 1 + (i * 7919) % 300;
+			u8* p;
+			while (!(p = buffer.Reserve(size + 1)))
+				std::this_thread::yield();
+			p[0] = (u8)size | 1;
+			memset(p + 1, (u8)(i | 1), size);
+			buffer.Commit(size + 1);
+		}
+	});
+
+	for (u32 i = 0; i < num_records;)
+	{
+		const u8* data;
+		size_t available = buffer.Peek(&data);
+		if (!available)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// Skip the padding, which is 0 here.
+		if (data[0] == 0)
+		{
+			buffer.Release(1);
+			continue;
+		}
+
+		const size_t size = 1 + (i * 7919) % 300;
+		ASSERT_EQ((u8)size | 1, data[0]);
+		// Records are committed whole, so the rest is there as well.
+		ASSERT_GE(available, size + 1);
+		for (size_t j = 1; j <= size; ++j)
+			ASSERT_EQ((u8)(i | 1), data[j]) << "record " << i;
+		buffer.Release(size + 1);
+		++i;
+	}
+
+	writer.join();
+	EXPECT_TRUE(buffer.Empty());
+}
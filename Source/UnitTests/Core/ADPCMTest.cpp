@@ -0,0 +1,147 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/DSP/DSPAccelerator.h"
+#include "Core/HW/StreamADPCM.h"
+
+// The accelerator's ADPCM step as it was before frames were decoded at once.
+static s16 ReferenceDSPSample(const u8* frame, u32 pos, u16 pred_scale, const s16* coefs, s16* yn1, s16* yn2)
+{
+	int scale = 1 << (pred_scale & 0xF);
+	int coef_idx = (pred_scale >> 4) & 0x7;
+
+	s32 coef1 = coefs[coef_idx * 2 + 0];
+	s32 coef2 = coefs[coef_idx * 2 + 1];
+
+	int temp = (pos & 1) ? (frame[pos >> 1] & 0xF) : (frame[pos >> 1] >> 4);
+
+	if (temp >= 8)
+		temp -= 16;
+
+	int val = (scale * temp) + ((0x400 + coef1 * *yn1 + coef2 * *yn2) >> 11);
+	val = MathUtil::Clamp(val, -0x7FFF, 0x7FFF);
+
+	*yn2 = *yn1;
+	*yn1 = val;
+	return val;
+}
+
+// The DTK decoder as it was before blocks were decoded at once.
+static s16 ReferenceStreamSample(s32 bits, s32 q, s32& hist1, s32& hist2)
+{
+	s32 hist = 0;
+	switch (q >> 4)
+	{
+	case 0:
+		hist = 0;
+		break;
+	case 1:
+		hist = (hist1 * 0x3c);
+		break;
+	case 2:
+		hist = (hist1 * 0x73) - (hist2 * 0x34);
+		break;
+	case 3:
+		hist = (hist1 * 0x62) - (hist2 * 0x37);
+		break;
+	}
+	hist = MathUtil::Clamp((hist + 0x20) >> 6, -0x200000, 0x1fffff);
+
+	s32 cur = (((s16)(bits << 12) >> (q & 0xf)) << 6) + hist;
+
+	hist2 = hist1;
+	hist1 = cur;
+
+	cur >>= 6;
+	cur = MathUtil::Clamp(cur, -0x8000, 0x7fff);
+
+	return (s16)cur;
+}
+
+TEST(ADPCM, DSPFramesMatchSingleSamples)
+{
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> byte(0, 255);
+	std::uniform_int_distribution<int> coef(-32768, 32767);
+
+	for (int stream = 0; stream < 200; ++stream)
+	{
+		s16 coefs[16];
+		for (s16& c : coefs)
+			c = (s16)coef(rng);
+
+		s16 ref_yn1 = (s16)coef(rng), ref_yn2 = (s16)coef(rng);
+		s16 yn1 = ref_yn1, yn2 = ref_yn2;
+
+		for (int f = 0; f < 16; ++f)
+		{
+			u8 frame[ADPCM_FRAME_SIZE];
+			for (u8& b : frame)
+				b = (u8)byte(rng);
+			const u16 pred_scale = frame[0];
+
+			s16 expected[16];
+			for (u32 pos = 2; pos < 16; ++pos)
+				expected[pos] = ReferenceDSPSample(frame, pos, pred_scale, coefs, &ref_yn1, &ref_yn2);
+
+			// Decode in uneven runs, as the accelerator does around end addresses.
+			s16 output[16];
+			u32 pos = 2;
+			while (pos < 16)
+			{
+				u32 run = std::uniform_int_distribution<u32>(1, 16 - pos)(rng);
+				DecodeADPCM(&output[pos], frame, pos, run, pred_scale, coefs, &yn1, &yn2);
+				pos += run;
+			}
+
+			for (u32 i = 2; i < 16; ++i)
+				ASSERT_EQ(expected[i], output[i]) << "stream " << stream << " frame " << f << " sample " << i;
+			ASSERT_EQ(ref_yn1, yn1);
+			ASSERT_EQ(ref_yn2, yn2);
+		}
+	}
+}
+
+TEST(ADPCM, StreamBlocksMatchSingleSamples)
+{
+	std::mt19937 rng(5678);
+	std::uniform_int_distribution<int> byte(0, 255);
+
+	s32 histl1 = 0, histl2 = 0, histr1 = 0, histr2 = 0;
+	NGCADPCM::InitFilter();
+
+	for (int block = 0; block < 2000; ++block)
+	{
+		u8 adpcm[NGCADPCM::ONE_BLOCK_SIZE];
+		for (u8& b : adpcm)
+			b = (u8)byte(rng);
+		// Mostly use the four real filters, so the history doesn't keep resetting.
+		if (block % 8)
+		{
+			adpcm[0] &= 0x3F;
+			adpcm[1] &= 0x3F;
+		}
+
+		s16 expected[NGCADPCM::SAMPLES_PER_BLOCK * 2];
+		for (int i = 0; i < NGCADPCM::SAMPLES_PER_BLOCK; i++)
+		{
+			const u8 bits = adpcm[i + (NGCADPCM::ONE_BLOCK_SIZE - NGCADPCM::SAMPLES_PER_BLOCK)];
+			expected[i * 2] = ReferenceStreamSample(bits & 0xf, adpcm[0], histl1, histl2);
+			expected[i * 2 + 1] = ReferenceStreamSample(bits >> 4, adpcm[1], histr1, histr2);
+		}
+
+		s16 pcm[NGCADPCM::SAMPLES_PER_BLOCK * 2];
+		NGCADPCM::DecodeBlock(pcm, adpcm);
+
+		for (int i = 0; i < NGCADPCM::SAMPLES_PER_BLOCK * 2; i++)
+			ASSERT_EQ(expected[i], pcm[i]) << "block " << block << " sample " << i;
+	}
+}
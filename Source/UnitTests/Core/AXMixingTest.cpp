@@ -0,0 +1,228 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/DSPHLE/UCodes/AXMixing.h"
+
+// For the PB list benchmark. This defines its own MAX_SAMPLES_PER_FRAME, AX GC's 1 ms.
+#define AX_GC
+#include "Core/HW/DSPHLE/UCodes/AXVoice.h"
+
+using namespace AXMixing;
+
+// The longest frame, AX Wii's 3 ms.
+static const u32 MAX_FRAME_SAMPLES = 96;
+
+// The mixing loop as it was before it got vectorized.
+static void ReferenceMixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
+{
+	u16& volume = pvol[0];
+	u16 volume_delta = ramp ? pvol[1] : 0;
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		s64 sample = input[i];
+		sample *= volume;
+		sample >>= 15;
+		sample = MathUtil::Clamp((s32)sample, -32767, 32767);
+
+		out[i] += (s16)sample;
+		volume += volume_delta;
+
+		*dpop = (s16)sample;
+	}
+}
+
+static void CheckMixAdd(const s16* input, u32 count, u16 volume, u16 volume_delta, bool ramp)
+{
+	int expected_out[MAX_FRAME_SAMPLES];
+	int out[MAX_FRAME_SAMPLES];
+	for (u32 i = 0; i < MAX_FRAME_SAMPLES; ++i)
+		expected_out[i] = out[i] = (int)(i * 1000) - 40000;
+
+	u16 expected_vol[2] = { volume, volume_delta };
+	u16 vol[2] = { volume, volume_delta };
+	s16 expected_dpop = 0x1234;
+	s16 dpop = 0x1234;
+
+	ReferenceMixAdd(expected_out, input, count, expected_vol, &expected_dpop, ramp);
+	MixAdd(out, input, count, vol, &dpop, ramp);
+
+	for (u32 i = 0; i < MAX_FRAME_SAMPLES; ++i)
+		ASSERT_EQ(expected_out[i], out[i]) << "sample " << i << ", volume " << volume << ", delta " << volume_delta;
+	EXPECT_EQ(expected_vol[0], vol[0]);
+	EXPECT_EQ(expected_dpop, dpop);
+}
+
+TEST(AXMixing, MixAddMatchesScalar)
+{
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> dist(-32768, 32767);
+
+	s16 input[MAX_FRAME_SAMPLES];
+	for (s16& sample : input)
+		sample = (s16)dist(rng);
+	input[0] = -32768;
+	input[1] = 32767;
+
+	static const u16 volumes[] = { 0, 1, 0x7FFF, 0x8000, 0xFFFF, 0x1234 };
+	static const u16 deltas[] = { 0, 1, 0xFFFF, 0x0100, 0xFF00 };
+	static const u32 counts[] = { 0, 1, 7, 8, 18, 31, 32, 96 };
+	for (u16 volume : volumes)
+	{
+		for (u16 delta : deltas)
+		{
+			for (u32 count : counts)
+			{
+				CheckMixAdd(input, count, volume, delta, true);
+				CheckMixAdd(input, count, volume, delta, false);
+			}
+		}
+	}
+}
+
+TEST(AXMixing, ApplyVolumeInPlace)
+{
+	s16 samples[MAX_FRAME_SAMPLES];
+	s16 expected[MAX_FRAME_SAMPLES];
+	u16 volume = 0x7F00;
+	for (u32 i = 0; i < MAX_FRAME_SAMPLES; ++i)
+	{
+		samples[i] = (s16)(i * 997 - 30000);
+		expected[i] = MathUtil::Clamp(((s32)samples[i] * volume) >> 15, -32767, 32767);
+		volume += 0x0203;
+	}
+
+	EXPECT_EQ(volume, ApplyVolume(samples, samples, MAX_FRAME_SAMPLES, 0x7F00, 0x0203));
+	for (u32 i = 0; i < MAX_FRAME_SAMPLES; ++i)
+		EXPECT_EQ(expected[i], samples[i]);
+}
+
+// Builds a list of num_voices looping voices in RAM at pb_addr, the way a game sets up a busy
+// mix: two ADPCM voices for every 16-bit PCM one, at assorted rates, all mixed to the main
+// buffers and some to AUX A and the surround channel. The sample data is random, in ARAM.
+static void GeneratePBList(u32 pb_addr, u32 num_voices, std::mt19937& rng)
+{
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 i = 0; i < DSP::ARAM_SIZE; ++i)
+		aram[i] = (u8)rng();
+
+	static const u32 ratios[] = { 0x8000, 0x10000, 0x15555, 0x1B000, 0x20000, 0x3A000 };
+	std::uniform_int_distribution<int> coef(-0x800, 0x800);
+
+	for (u32 v = 0; v < num_voices; ++v)
+	{
+		AXPB pb = {};
+		u32 next = v + 1 < num_voices ? pb_addr + sizeof(AXPB) : 0;
+		pb.next_pb_hi = (u16)(next >> 16);
+		pb.next_pb_lo = (u16)next;
+		pb.running = 1;
+		pb.src_type = v % 5 == 4 ? SRCTYPE_NEAREST : SRCTYPE_LINEAR;
+		pb.src.ratio_hi = (u16)(ratios[v % ArraySize(ratios)] >> 16);
+		pb.src.ratio_lo = (u16)ratios[v % ArraySize(ratios)];
+		pb.vol_env.cur_volume = 0x7000;
+		pb.vol_env.cur_volume_delta = v % 2 ? -1 : 1;
+		pb.mixer.left = pb.mixer.right = pb.mixer.surround = 0x4000 + v * 0x100;
+		pb.mixer.auxA_left = pb.mixer.auxA_right = 0x2000;
+		pb.mixer.left_delta = pb.mixer.right_delta = 1;
+
+		// Addresses are in nibbles for ADPCM, and in samples for PCM. Either way each voice gets its
+		// own 64 KB of ARAM.
+		bool adpcm = v % 3 != 0;
+		u32 start = adpcm ? v * 0x20000 : v * 0x8000;
+		u32 end = start + (adpcm ? 0x1FFFF : 0x7FFF);
+		pb.audio_addr.looping = 1;
+		pb.audio_addr.sample_format = adpcm ? 0x00 : 0x0A;
+		pb.audio_addr.loop_addr_hi = pb.audio_addr.cur_addr_hi = (u16)(start >> 16);
+		pb.audio_addr.loop_addr_lo = pb.audio_addr.cur_addr_lo = (u16)start;
+		pb.audio_addr.end_addr_hi = (u16)(end >> 16);
+		pb.audio_addr.end_addr_lo = (u16)end;
+		for (s16& c : pb.adpcm.coefs)
+			c = (s16)coef(rng);
+
+		WritePB(pb_addr, pb);
+		pb_addr += sizeof(AXPB);
+	}
+}
+
+static AXMixControl BenchmarkMixControl(u32 voice)
+{
+	u32 mctrl = MIX_L | MIX_R | MIX_L_RAMP | MIX_R_RAMP;
+	if (voice % 2)
+		mctrl |= MIX_AUXA_L | MIX_AUXA_R;
+	if (voice % 4 == 0)
+		mctrl |= MIX_S;
+	return (AXMixControl)mctrl;
+}
+
+// Benchmark: replays a generated PB list through ProcessVoice, a 5 ms AX frame at a time, the
+// way AXUCode::ProcessPBList does, and reports the time per voice and millisecond.
+// Disabled by default; run with --gtest_also_run_disabled_tests.
+TEST(AXMixing, DISABLED_PBListBenchmark)
+{
+	SConfig::Init();
+	CoreTiming::Init();
+	DSP::Init(true);
+	std::vector<u8> ram(Memory::RAM_SIZE);
+	Memory::m_pRAM = ram.data();
+
+	const u32 pb_list = 0x10000;
+	const u32 num_voices = 64;
+	const u32 num_frames = 2000;
+	std::mt19937 rng(1234);
+	GeneratePBList(pb_list, num_voices, rng);
+
+	std::vector<int> samples(9 * 5 * MAX_SAMPLES_PER_FRAME);
+	s64 checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (u32 frame = 0; frame < num_frames; ++frame)
+	{
+		std::fill(samples.begin(), samples.end(), 0);
+
+		u32 pb_addr = pb_list;
+		for (u32 voice = 0; pb_addr; ++voice)
+		{
+			AXBuffers buffers;
+			for (size_t i = 0; i < ArraySize(buffers.ptrs); ++i)
+				buffers.ptrs[i] = &samples[i * 5 * MAX_SAMPLES_PER_FRAME];
+
+			AXPB pb;
+			ReadPB(pb_addr, pb);
+			for (int ms = 0; ms < 5; ++ms)
+			{
+				ProcessVoice(pb, buffers, MAX_SAMPLES_PER_FRAME, BenchmarkMixControl(voice), nullptr);
+				for (size_t i = 0; i < ArraySize(buffers.ptrs); ++i)
+					buffers.ptrs[i] += MAX_SAMPLES_PER_FRAME;
+			}
+			WritePB(pb_addr, pb);
+			pb_addr = HILO_TO_32(pb.next_pb);
+		}
+
+		for (int sample : samples)
+			checksum += sample;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	printf("Mixed %u voices for %u ms in %.3f s (%.1f ns per voice and ms, checksum %lld)\n",
+	       num_voices, num_frames * 5, seconds, seconds * 1e9 / (num_voices * num_frames * 5),
+	       (long long)checksum);
+
+	Memory::m_pRAM = nullptr;
+	DSP::Shutdown();
+	CoreTiming::Shutdown();
+	SConfig::Shutdown();
+}
@@ -0,0 +1,103 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonFuncs.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/DSPHLE/DSPHLE.h"
+#include "Core/HW/DSPHLE/MailHandler.h"
+#include "Core/HW/DSPHLE/UCodes/AX.h"
+#include "Core/HW/Memmap.h"
+
+namespace
+{
+
+const u32 CMDLIST_ADDRESS = 0x1000;
+
+class TestAXUCode : public AXUCode
+{
+public:
+	explicit TestAXUCode(DSPHLE* dsphle) : AXUCode(dsphle, 0) {}
+
+	bool HasWorker() const { return m_worker.joinable(); }
+};
+
+class AXUCodeTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		SConfig::GetInstance().bDSPHLEWorkerThread = true;
+		CoreTiming::Init();
+		Core::g_want_determinism = false;
+
+		// A command list which only ends.
+		m_ram.assign(Memory::RAM_SIZE, 0);
+		Memory::m_pRAM = m_ram.data();
+		*(u16*)&m_ram[CMDLIST_ADDRESS] = Common::swap16(0x0F);
+	}
+
+	void TearDown() override
+	{
+		Core::g_want_determinism = false;
+		Memory::m_pRAM = nullptr;
+		CoreTiming::Shutdown();
+		SConfig::Shutdown();
+	}
+
+	// Returns whether the DSP_YIELD mail was sent before the next update.
+	bool RunCommandList(TestAXUCode* ucode)
+	{
+		m_dsphle.AccessMailHandler().Clear();
+		ucode->HandleMail(0xBABE0001);
+		ucode->HandleMail(CMDLIST_ADDRESS);
+		const bool yielded = !m_dsphle.AccessMailHandler().IsEmpty();
+		ucode->Update();
+		EXPECT_FALSE(m_dsphle.AccessMailHandler().IsEmpty());
+		return yielded;
+	}
+
+	DSPHLE m_dsphle;
+	std::vector<u8> m_ram;
+};
+
+}  // namespace
+
+TEST_F(AXUCodeTest, UsesTheWorkerWhenEnabled)
+{
+	TestAXUCode ucode(&m_dsphle);
+	EXPECT_FALSE(RunCommandList(&ucode));
+	EXPECT_TRUE(ucode.HasWorker());
+
+	SConfig::GetInstance().bDSPHLEWorkerThread = false;
+	EXPECT_TRUE(RunCommandList(&ucode));
+}
+
+TEST_F(AXUCodeTest, StopsUsingTheWorkerOnceDeterminismIsWanted)
+{
+	TestAXUCode ucode(&m_dsphle);
+	EXPECT_FALSE(RunCommandList(&ucode));
+
+	// A movie or netplay starting while the ucode is running.
+	Core::g_want_determinism = true;
+	EXPECT_TRUE(RunCommandList(&ucode));
+	EXPECT_TRUE(RunCommandList(&ucode));
+
+	Core::g_want_determinism = false;
+	EXPECT_FALSE(RunCommandList(&ucode));
+}
+
+TEST_F(AXUCodeTest, NoWorkerWhenCreatedWithDeterminism)
+{
+	Core::g_want_determinism = true;
+	TestAXUCode ucode(&m_dsphle);
+	EXPECT_TRUE(RunCommandList(&ucode));
+	EXPECT_FALSE(ucode.HasWorker());
+}
@@ -0,0 +1,185 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/PowerPC.h"
+
+// Sets up CoreTiming the way HW::Init would, with the calling thread acting as the CPU thread.
+class ScopeInit final
+{
+public:
+	ScopeInit()
+	{
+		if (!s_config_initialized)
+		{
+			SConfig::Init();
+			s_config_initialized = true;
+		}
+		Core::DeclareAsCPUThread();
+		CoreTiming::Init();
+	}
+	~ScopeInit()
+	{
+		CoreTiming::Shutdown();
+		Core::UndeclareAsCPUThread();
+	}
+
+private:
+	static bool s_config_initialized;
+};
+
+bool ScopeInit::s_config_initialized = false;
+
+static std::vector<u64> s_fired;
+static u64 s_fired_count;
+
+static void RecordCallback(u64 userdata, int)
+{
+	s_fired.push_back(userdata);
+}
+
+static void CountCallback(u64, int)
+{
+	++s_fired_count;
+}
+
+// Runs the scheduler until CountCallback has fired the expected number of times.
+static void AdvanceUntilCounted(u64 expected)
+{
+	while (s_fired_count < expected)
+	{
+		PowerPC::ppcState.downcount = 0;
+		CoreTiming::Advance();
+	}
+}
+
+TEST(CoreTiming, FiresInTimeOrder)
+{
+	ScopeInit guard;
+	s_fired.clear();
+	int type = CoreTiming::RegisterEvent("record", RecordCallback);
+
+	CoreTiming::ScheduleEvent(300, type, 3);
+	CoreTiming::ScheduleEvent(100, type, 1);
+	CoreTiming::ScheduleEvent(400, type, 4);
+	CoreTiming::ScheduleEvent(200, type, 2);
+
+	PowerPC::ppcState.downcount = 0;
+	CoreTiming::Advance();
+
+	EXPECT_EQ((std::vector<u64>{1, 2, 3, 4}), s_fired);
+}
+
+TEST(CoreTiming, SameTimeIsFifo)
+{
+	ScopeInit guard;
+	s_fired.clear();
+	int type = CoreTiming::RegisterEvent("record", RecordCallback);
+
+	for (u64 i = 0; i < 16; ++i)
+		CoreTiming::ScheduleEvent(100, type, i);
+	CoreTiming::ScheduleEvent(50, type, 100);
+
+	PowerPC::ppcState.downcount = 0;
+	CoreTiming::Advance();
+
+	ASSERT_EQ(17u, s_fired.size());
+	EXPECT_EQ(100u, s_fired[0]);
+	for (u64 i = 0; i < 16; ++i)
+		EXPECT_EQ(i, s_fired[i + 1]);
+}
+
+TEST(CoreTiming, RemoveEvent)
+{
+	ScopeInit guard;
+	s_fired.clear();
+	int keep = CoreTiming::RegisterEvent("keep", RecordCallback);
+	int drop = CoreTiming::RegisterEvent("drop", RecordCallback);
+
+	for (u64 i = 0; i < 8; ++i)
+		CoreTiming::ScheduleEvent(100 + (int)(i * 10), (i & 1) ? drop : keep, i);
+	CoreTiming::RemoveEvent(drop);
+
+	PowerPC::ppcState.downcount = 0;
+	CoreTiming::Advance();
+
+	EXPECT_EQ((std::vector<u64>{0, 2, 4, 6}), s_fired);
+}
+
+TEST(CoreTiming, SaveStateRoundTrip)
+{
+	ScopeInit guard;
+	s_fired.clear();
+	int type = CoreTiming::RegisterEvent("record", RecordCallback);
+
+	CoreTiming::ScheduleEvent(200, type, 2);
+	CoreTiming::ScheduleEvent(100, type, 1);
+	CoreTiming::ScheduleEvent(200, type, 3);
+
+	u8* ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	CoreTiming::DoState(p);
+	std::vector<u8> buffer(reinterpret_cast<size_t>(ptr));
+	ptr = buffer.data();
+	p.SetMode(PointerWrap::MODE_WRITE);
+	CoreTiming::DoState(p);
+
+	CoreTiming::ClearPendingEvents();
+	CoreTiming::ScheduleEvent(50, type, 99);
+
+	ptr = buffer.data();
+	p.SetMode(PointerWrap::MODE_READ);
+	CoreTiming::DoState(p);
+	EXPECT_EQ(buffer.data() + buffer.size(), ptr);
+
+	PowerPC::ppcState.downcount = 0;
+	CoreTiming::Advance();
+
+	EXPECT_EQ((std::vector<u64>{1, 2, 3}), s_fired);
+}
+
+// Micro-benchmark: schedules and drains a few million events with a spread of timestamps,
+// the way the periodic hardware events do, and reports the throughput.
+TEST(CoreTiming, DISABLED_ScheduleAndDrainBenchmark)
+{
+	ScopeInit guard;
+	s_fired_count = 0;
+	int type = CoreTiming::RegisterEvent("count", CountCallback);
+
+	const u64 total = 4000000;
+	const u64 pending = 256;
+	u32 seed = 12345;
+
+	auto start = std::chrono::steady_clock::now();
+	u64 scheduled = 0;
+	while (scheduled < total)
+	{
+		// Keep a realistic number of events pending, then let the scheduler drain a slice.
+		while (scheduled - s_fired_count < pending && scheduled < total)
+		{
+			seed = seed * 1103515245 + 12345;
+			CoreTiming::ScheduleEvent((int)((seed >> 16) % 40000), type);
+			++scheduled;
+		}
+		PowerPC::ppcState.downcount = 0;
+		CoreTiming::Advance();
+	}
+	AdvanceUntilCounted(total);
+	auto end = std::chrono::steady_clock::now();
+
+	EXPECT_EQ(total, s_fired_count);
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	printf("Scheduled and drained %llu events in %.3f s (%.1f Mevents/s)\n",
+	       (unsigned long long)total, seconds, total / seconds / 1e6);
+}
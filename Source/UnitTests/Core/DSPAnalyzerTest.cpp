@@ -0,0 +1,85 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <initializer_list>
+#include <gtest/gtest.h>
+
+// DSPCore.h pulls in XEmitter, whose TEST conflicts with gtest's. Only TEST_F
+// is used here.
+#undef TEST
+
+#include "Common/CommonTypes.h"
+#include "Core/DSP/DSPAnalyzer.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/DSP/DSPTables.h"
+
+namespace
+{
+
+class DSPAnalyzerTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		InitInstructionTable();
+		m_iram.fill(0);
+		m_irom.fill(0);
+		g_dsp.iram = m_iram.data();
+		g_dsp.irom = m_irom.data();
+	}
+
+	void TearDown() override
+	{
+		g_dsp.iram = nullptr;
+		g_dsp.irom = nullptr;
+	}
+
+	// Analyzes a ucode made of the given code words, and returns whether the
+	// loop at its start is skipped as idle.
+	bool IsIdleLoop(std::initializer_list<u16> code)
+	{
+		std::copy(code.begin(), code.end(), m_iram.begin());
+		DSPAnalyzer::Analyze();
+		return (DSPAnalyzer::code_flags[0] & DSPAnalyzer::CODE_IDLE_SKIP) != 0;
+	}
+
+	// LR $reg, @0x0352; TSTAXH $AX0.H; JNZ 0x0010; JMP 0x0000
+	bool IsLoadLoopIdle(u16 reg, u16 address = 0x0352)
+	{
+		return IsIdleLoop({ (u16)(0x00c0 | reg), address, 0x8600, 0x0294, 0x0010, 0x029f, 0x0000 });
+	}
+
+	std::array<u16, DSP_IRAM_SIZE> m_iram;
+	std::array<u16, DSP_IROM_SIZE> m_irom;
+};
+
+}  // namespace
+
+TEST_F(DSPAnalyzerTest, FindsLoadLoops)
+{
+	EXPECT_TRUE(IsLoadLoopIdle(0x1a));  // $AX0.H
+	EXPECT_TRUE(IsLoadLoopIdle(0x1e));  // $AC0.M
+	EXPECT_TRUE(IsLoadLoopIdle(0x00));  // $AR0
+	// Polling the high half of the mailbox.
+	EXPECT_TRUE(IsLoadLoopIdle(0x1a, 0xfffe));
+}
+
+TEST_F(DSPAnalyzerTest, RejectsLoadsWithSideEffects)
+{
+	// Reading the low half of the mailbox acknowledges the mail.
+	EXPECT_FALSE(IsLoadLoopIdle(0x1a, 0xffff));
+
+	// Loading a stack register pushes onto it.
+	for (u16 reg = DSP_REG_ST0; reg <= DSP_REG_ST3; reg++)
+		EXPECT_FALSE(IsLoadLoopIdle(reg)) << "register " << reg;
+	EXPECT_FALSE(IsLoadLoopIdle(DSP_REG_CR));
+	EXPECT_FALSE(IsLoadLoopIdle(DSP_REG_SR));
+}
+
+TEST_F(DSPAnalyzerTest, RejectsJumpsIntoTheLoop)
+{
+	// JMP inside the body rather than a conditional exit.
+	EXPECT_FALSE(IsIdleLoop({ 0x00da, 0x0352, 0x029f, 0x0003, 0x029f, 0x0000 }));
+}
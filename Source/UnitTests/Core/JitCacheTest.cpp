@@ -0,0 +1,247 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitCommon/JitCache.h"
+
+// A block cache that doesn't emit any code, so the bookkeeping can be tested without a JIT.
+class TestBlockCache final : public JitBaseBlockCache
+{
+public:
+	TestBlockCache()
+	{
+		iCache.fill(JIT_ICACHE_INVALID_BYTE);
+		iCacheEx.fill(JIT_ICACHE_INVALID_BYTE);
+		iCacheVMEM.fill(JIT_ICACHE_INVALID_BYTE);
+	}
+
+	// Adds a block of num_instructions at address, with a single exit to exit_address.
+	int AddBlock(u32 address, u32 num_instructions, u32 exit_address)
+	{
+		int block_num = AllocateBlock(address);
+		JitBlock* b = GetBlock(block_num);
+		b->originalSize = num_instructions;
+		b->codeSize = 0;
+		b->checkedEntry = s_code;
+		b->normalEntry = s_code;
+		b->linkData.push_back({nullptr, exit_address, false});
+		FinalizeBlock(block_num, true, s_code);
+		return block_num;
+	}
+
+	// Adds a trace made of the given (address, number of instructions) segments, with no exits.
+	int AddTrace(const std::vector<std::pair<u32, u32>>& segments)
+	{
+		int block_num = AllocateBlock(segments[0].first);
+		JitBlock* b = GetBlock(block_num);
+		b->originalSize = 0;
+		for (const auto& segment : segments)
+			b->originalSize += segment.second;
+		b->segments = segments;
+		b->codeSize = 0;
+		b->checkedEntry = s_code;
+		b->normalEntry = s_code;
+		FinalizeBlock(block_num, true, s_code);
+		return block_num;
+	}
+
+	// Adds a block with a bound entry, that jumps into the bound entry of bound_destination if
+	// that isn't -1.
+	int AddBoundBlock(u32 address, int bound_destination)
+	{
+		int block_num = AllocateBlock(address);
+		JitBlock* b = GetBlock(block_num);
+		b->originalSize = 8;
+		b->codeSize = 0;
+		b->checkedEntry = s_code;
+		b->normalEntry = s_code;
+		b->boundEntry = s_code;
+		b->boundSpill = s_code;
+		if (bound_destination >= 0)
+			b->boundLinks.push_back(bound_destination);
+		FinalizeBlock(block_num, true, s_code);
+		return block_num;
+	}
+
+	u64 m_links = 0;
+	u64 m_destroys = 0;
+	u64 m_bound_destroys = 0;
+	std::vector<u32> m_invalidated;
+
+private:
+	void WriteLinkBlock(u8*, const u8*) override { ++m_links; }
+	void WriteDestroyBlock(const u8*, u32) override { ++m_destroys; }
+	void WriteDestroyBoundEntry(const u8*, const u8*) override { ++m_bound_destroys; }
+	void OnBlockInvalidated(u32 address) override { m_invalidated.push_back(address); }
+
+	static const u8 s_code[1];
+};
+
+const u8 TestBlockCache::s_code[1] = {};
+
+TEST(JitCache, LinkAndUnlink)
+{
+	auto cache = std::make_unique<TestBlockCache>();
+
+	// The exit can't be linked until the block it goes to exists.
+	int a = cache->AddBlock(0x80001000, 8, 0x80002000);
+	EXPECT_EQ(0u, cache->m_links);
+	EXPECT_FALSE(cache->GetBlock(a)->linkData[0].linkStatus);
+
+	int b = cache->AddBlock(0x80002000, 8, 0x80003000);
+	EXPECT_EQ(1u, cache->m_links);
+	EXPECT_TRUE(cache->GetBlock(a)->linkData[0].linkStatus);
+	EXPECT_EQ(b, cache->GetBlockNumberFromStartAddress(0x80002000));
+
+	cache->InvalidateICache(0x80002000, 32, true);
+	EXPECT_EQ(1u, cache->m_destroys);
+	EXPECT_EQ(-1, cache->GetBlockNumberFromStartAddress(0x80002000));
+	EXPECT_FALSE(cache->GetBlock(a)->linkData[0].linkStatus);
+	EXPECT_EQ(a, cache->GetBlockNumberFromStartAddress(0x80001000));
+
+	// Recompiling the destination, as tiered compilation does, links the source to it again.
+	cache->AddBlock(0x80002000, 8, 0x80003000);
+	EXPECT_EQ(2u, cache->m_links);
+	EXPECT_TRUE(cache->GetBlock(a)->linkData[0].linkStatus);
+}
+
+TEST(JitCache, InvalidateOverlapping)
+{
+	auto cache = std::make_unique<TestBlockCache>();
+
+	int small = cache->AddBlock(0x80000000, 8, 0);
+	// This one spans several buckets of the range map.
+	int big = cache->AddBlock(0x80000020, 200, 0);
+	int after = cache->AddBlock(0x80000400, 8, 0);
+
+	// Only the block covering the invalidated line goes away, even though it starts well before it.
+	cache->InvalidateICache(0x80000200, 32, true);
+	EXPECT_FALSE(cache->GetBlock(small)->invalid);
+	EXPECT_TRUE(cache->GetBlock(big)->invalid);
+	EXPECT_FALSE(cache->GetBlock(after)->invalid);
+	EXPECT_EQ(1u, cache->m_destroys);
+
+	// Invalidating the same memory again must not touch the destroyed block.
+	cache->InvalidateICache(0x80000000, 0x1000, true);
+	EXPECT_TRUE(cache->GetBlock(small)->invalid);
+	EXPECT_TRUE(cache->GetBlock(after)->invalid);
+	EXPECT_EQ(3u, cache->m_destroys);
+}
+
+TEST(JitCache, InvalidateTrace)
+{
+	auto cache = std::make_unique<TestBlockCache>();
+
+	// A trace that jumps far ahead, then back into the same range-map bucket it started in.
+	int trace = cache->AddTrace({{0x80010000, 4}, {0x80020000, 4}, {0x80010080, 4}});
+	int other = cache->AddBlock(0x80020100, 8, 0);
+
+	// Memory between the segments isn't part of the trace.
+	cache->InvalidateICache(0x80010040, 32, true);
+	cache->InvalidateICache(0x80018000, 32, true);
+	EXPECT_FALSE(cache->GetBlock(trace)->invalid);
+	EXPECT_EQ(0u, cache->m_destroys);
+
+	// Code that was only reached through a followed branch still takes the trace down.
+	cache->InvalidateICache(0x80020000, 32, true);
+	EXPECT_TRUE(cache->GetBlock(trace)->invalid);
+	EXPECT_FALSE(cache->GetBlock(other)->invalid);
+	EXPECT_EQ(1u, cache->m_destroys);
+	EXPECT_EQ(-1, cache->GetBlockNumberFromStartAddress(0x80010000));
+
+	// The trace was removed from every bucket it was in, shared or not.
+	cache->InvalidateICache(0x80010000, 0x20000, true);
+	EXPECT_TRUE(cache->GetBlock(other)->invalid);
+	EXPECT_EQ(2u, cache->m_destroys);
+}
+
+TEST(JitCache, DestroyBoundLinkSources)
+{
+	auto cache = std::make_unique<TestBlockCache>();
+
+	int dest = cache->AddBoundBlock(0x80040000, -1);
+	int source = cache->AddBoundBlock(0x80050000, dest);
+	int source_of_source = cache->AddBoundBlock(0x80060000, source);
+	int unrelated = cache->AddBoundBlock(0x80070000, -1);
+
+	// A bound link can't be relinked to a recompiled block, so its source has to go too.
+	cache->InvalidateICache(0x80040000, 32, true);
+	EXPECT_TRUE(cache->GetBlock(dest)->invalid);
+	EXPECT_TRUE(cache->GetBlock(source)->invalid);
+	EXPECT_TRUE(cache->GetBlock(source_of_source)->invalid);
+	EXPECT_FALSE(cache->GetBlock(unrelated)->invalid);
+	EXPECT_EQ(3u, cache->m_destroys);
+	EXPECT_EQ(3u, cache->m_bound_destroys);
+	// Only the block whose code was invalidated is reported; the sources' code is unchanged.
+	EXPECT_EQ(std::vector<u32>{0x80040000}, cache->m_invalidated);
+
+	// The cascaded blocks are gone from the range map too.
+	cache->InvalidateICache(0x80040000, 0x40000, true);
+	EXPECT_EQ(4u, cache->m_destroys);
+	EXPECT_EQ((std::vector<u32>{0x80040000, 0x80070000}), cache->m_invalidated);
+}
+
+TEST(JitCache, RetireBlock)
+{
+	auto cache = std::make_unique<TestBlockCache>();
+
+	// A cold block, and a hot trace that follows a branch into the middle of it.
+	int cold = cache->AddBlock(0x80080000, 8, 0);
+	int trace = cache->AddTrace({{0x80090000, 4}, {0x80080010, 4}});
+
+	// Tiering up the cold block replaces just that block. Nothing was invalidated, so the trace
+	// stays compiled and keeps its place in the hot tier.
+	cache->RetireBlock(cold);
+	EXPECT_TRUE(cache->GetBlock(cold)->invalid);
+	EXPECT_FALSE(cache->GetBlock(trace)->invalid);
+	EXPECT_EQ(1u, cache->m_destroys);
+	EXPECT_TRUE(cache->m_invalidated.empty());
+	EXPECT_EQ(-1, cache->GetBlockNumberFromStartAddress(0x80080000));
+	EXPECT_EQ(trace, cache->GetBlockNumberFromStartAddress(0x80090000));
+
+	// The retired block is gone from the range map, so a later write only takes the trace down.
+	cache->InvalidateICache(0x80080000, 32, true);
+	EXPECT_TRUE(cache->GetBlock(trace)->invalid);
+	EXPECT_EQ(2u, cache->m_destroys);
+	EXPECT_EQ(std::vector<u32>{0x80090000}, cache->m_invalidated);
+}
+
+// Micro-benchmark: fills the cache with a chain of linked blocks, then invalidates all of it one
+// cache line at a time, the way dcbi/icbi loops over freshly loaded code do.
+TEST(JitCache, DISABLED_LinkAndInvalidateBenchmark)
+{
+	auto cache = std::make_unique<TestBlockCache>();
+
+	const u32 num_blocks = 120000;
+	const u32 block_size = 12;
+	const u32 base = 0x80003000;
+
+	// Link every block to the one before it, so each FinalizeBlock has something to link.
+	auto start = std::chrono::steady_clock::now();
+	for (u32 i = 0; i < num_blocks; ++i)
+	{
+		u32 address = base + i * block_size * 4;
+		cache->AddBlock(address, block_size, i ? address - block_size * 4 : 0);
+	}
+	auto linked = std::chrono::steady_clock::now();
+
+	for (u32 address = base; address < base + num_blocks * block_size * 4; address += 32)
+		cache->InvalidateICache(address, 32, true);
+	auto end = std::chrono::steady_clock::now();
+
+	EXPECT_EQ(num_blocks - 1, cache->m_links);
+	EXPECT_EQ(num_blocks, cache->m_destroys);
+
+	double link_seconds = std::chrono::duration<double>(linked - start).count();
+	double invalidate_seconds = std::chrono::duration<double>(end - linked).count();
+	printf("Linked %u blocks in %.3f s, invalidated them in %.3f s\n",
+	       num_blocks, link_seconds, invalidate_seconds);
+}
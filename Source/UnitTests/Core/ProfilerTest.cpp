@@ -0,0 +1,118 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+#include <gtest/gtest.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/Profiler.h"
+
+namespace
+{
+
+const u32 INTERVAL = 1000;
+
+class ProfilerTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		// PC, LR and the stack pointer are all 0, so every sample has the same one-frame stack.
+		PowerPC::ppcState = {};
+		Core::DeclareAsCPUThread();
+		CoreTiming::Init();
+		Profiler::Init();
+	}
+
+	void TearDown() override
+	{
+		Profiler::StopSampling();
+		Profiler::Shutdown();
+		CoreTiming::Shutdown();
+		Core::UndeclareAsCPUThread();
+		SConfig::Shutdown();
+	}
+
+	// Starting and stopping happens off the CPU thread, from the debugger UI.
+	static void StopAndRestart()
+	{
+		Core::UndeclareAsCPUThread();
+		Profiler::StopSampling();
+		Profiler::StartSampling(INTERVAL);
+		Core::DeclareAsCPUThread();
+
+		// Pick the first sample event up right away, as if the CPU checked for
+		// events at this point, so that it doesn't fire late.
+		CoreTiming::ForceExceptionCheck(0);
+		CoreTiming::Advance();
+	}
+
+	static void RunFor(u64 cycles)
+	{
+		const u64 end = CoreTiming::GetTicks() + cycles;
+		while (CoreTiming::GetTicks() < end)
+		{
+			PowerPC::ppcState.downcount = 0;
+			CoreTiming::Advance();
+		}
+	}
+
+	static u64 CountSamples()
+	{
+		const std::string dir = File::CreateTempDir();
+		const std::string path = dir + DIR_SEP "stacks.txt";
+		Profiler::WriteCollapsedStacks(path);
+		std::string text;
+		File::ReadFileToString(path, text);
+		File::DeleteDirRecursively(dir);
+
+		u64 cycles = 0;
+		if (!text.empty())
+		{
+			EXPECT_EQ(1, sscanf(text.c_str(), "00000000 %" SCNu64, &cycles)) << text;
+		}
+		return cycles / INTERVAL;
+	}
+};
+
+}  // namespace
+
+TEST_F(ProfilerTest, SamplesEveryInterval)
+{
+	StopAndRestart();
+	RunFor(INTERVAL * 100);
+	EXPECT_NEAR(100.0, (double)CountSamples(), 1.0);
+}
+
+TEST_F(ProfilerTest, RestartWhilePendingKeepsOneChain)
+{
+	StopAndRestart();
+	RunFor(INTERVAL * 10 + INTERVAL / 2);
+
+	// The next sample of the first chain is still scheduled.
+	StopAndRestart();
+	RunFor(INTERVAL * 100);
+	EXPECT_NEAR(100.0, (double)CountSamples(), 1.0);
+}
+
+TEST_F(ProfilerTest, StopEndsTheChain)
+{
+	StopAndRestart();
+	RunFor(INTERVAL * 10);
+	Core::UndeclareAsCPUThread();
+	Profiler::StopSampling();
+	Core::DeclareAsCPUThread();
+	const u64 samples = CountSamples();
+	RunFor(INTERVAL * 100);
+	EXPECT_EQ(samples, CountSamples());
+}
@@ -0,0 +1,183 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <gtest/gtest.h>
+
+// gtest's TEST macro conflicts with XEmitter::TEST, and only TEST_F is used here.
+#undef TEST
+
+#include "Common/CommonTypes.h"
+#include "Common/CommonFuncs.h"
+#include "Common/x64ABI.h"
+#include "Common/x64Emitter.h"
+#include "Core/ConfigManager.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+#include "Core/PowerPC/JitCommon/Jit_Util.h"
+#include "Core/PowerPC/PowerPC.h"
+
+namespace
+{
+
+const u32 VSID = 0x123;
+const u32 PAGE_TABLE_BASE = 0x00100000;
+const u32 PHYSICAL_BASE = 0x00200000;
+
+// Effective pages in segment 3, in the same set of the guest TLB.
+const u32 PAGE_A = 0x30000000;
+const u32 PAGE_B = PAGE_A + (HW_PAGE_INDEX_MASK + 1) * 0x1000;
+const u32 PAGE_C = PAGE_B + (HW_PAGE_INDEX_MASK + 1) * 0x1000;
+
+// Calls the JIT's probe for a 32-bit read, and returns the host address it
+// resolves the effective address to, or nullptr on a miss.
+class ProbeCode : public Gen::X64CodeBlock
+{
+public:
+	ProbeCode()
+	{
+		using namespace Gen;
+		AllocCodeSpace(4096);
+		m_probe = (Probe)GetCodePtr();
+		PUSH(RPPCSTATE);
+		MOV(64, R(RPPCSTATE), ImmPtr((u8*)&PowerPC::ppcState + 0x80));
+		MOV(32, R(ABI_PARAM1), R(ABI_PARAM1));
+		FixupBranch miss = EmitSoftTLBLookup(this, ABI_PARAM1, 0, 32, false, RAX, RDX);
+		LEA(64, RAX, MRegSum(RAX, ABI_PARAM1));
+		POP(RPPCSTATE);
+		RET();
+		SetJumpTarget(miss);
+		XOR(32, R(RAX), R(RAX));
+		POP(RPPCSTATE);
+		RET();
+	}
+
+	u8* operator()(u32 address) const { return m_probe(address); }
+
+private:
+	typedef u8* (*Probe)(u32 address);
+	Probe m_probe;
+};
+
+class SoftTLBTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		// Only RAM is needed, and Memory::Init would register the MMIO of
+		// every device, the video backend's included.
+		m_ram.assign(Memory::RAM_SIZE, 0);
+		Memory::physical_base = Memory::m_pRAM = m_ram.data();
+		PowerPC::InitSoftTLB(256);
+
+		PowerPC::ppcState = {};
+		for (auto& tlb : PowerPC::ppcState.tlb)
+			for (PowerPC::tlb_entry& set : tlb)
+				set.tag[0] = set.tag[1] = TLB_TAG_INVALID;
+		PowerPC::ppcState.spr[SPR_SDR] = PAGE_TABLE_BASE;
+		PowerPC::SDRUpdated();
+		PowerPC::ppcState.sr[3] = VSID;
+		PowerPC::ppcState.msr = 1 << (31 - 27);
+
+		MapPage(PAGE_A, PHYSICAL_BASE);
+		MapPage(PAGE_B, PHYSICAL_BASE + 0x1000);
+		MapPage(PAGE_C, PHYSICAL_BASE + 0x2000);
+	}
+
+	void TearDown() override
+	{
+		PowerPC::InitSoftTLB(0);
+		Memory::physical_base = Memory::m_pRAM = nullptr;
+		SConfig::Shutdown();
+	}
+
+	// Adds a page table entry with the C bit clear.
+	static void MapPage(u32 effective, u32 physical)
+	{
+		const u32 page_index = (effective >> 12) & 0xffff;
+		const u32 hash = VSID ^ page_index;
+		u32 pteg = PAGE_TABLE_BASE | ((hash & PowerPC::ppcState.pagetable_hashmask) << 6);
+		while (Memory::physical_base[pteg] & 0x80)
+			pteg += 8;
+		const u32 pte1 = 0x80000000 | (VSID << 7) | (effective >> 22 & 0x3f);
+		const u32 pte2 = physical | 0x100 | 0x2;
+		*(u32*)&Memory::physical_base[pteg] = Common::swap32(pte1);
+		*(u32*)&Memory::physical_base[pteg + 4] = Common::swap32(pte2);
+	}
+
+	static bool IsCached(u32 address)
+	{
+		const u32 tag = address >> HW_PAGE_INDEX_SHIFT;
+		return PowerPC::GetSoftTLB()[tag & PowerPC::GetSoftTLBMask()].read_tag == tag;
+	}
+
+	// A hit never updates the guest TLB's recent bit, so every cached page has
+	// to be the most recently used way of its set.
+	static void ExpectOnlyRecentWaysCached()
+	{
+		for (u32 i = 0; i <= PowerPC::GetSoftTLBMask(); i++)
+		{
+			const u32 tag = PowerPC::GetSoftTLB()[i].read_tag;
+			if (tag == TLB_TAG_INVALID)
+				continue;
+			const PowerPC::tlb_entry& set = PowerPC::ppcState.tlb[0][tag & HW_PAGE_INDEX_MASK];
+			EXPECT_EQ(tag, set.tag[set.recent]) << "page " << std::hex << (tag << HW_PAGE_INDEX_SHIFT);
+		}
+	}
+
+	std::vector<u8> m_ram;
+};
+
+}  // namespace
+
+TEST_F(SoftTLBTest, OnlyCachesTheMostRecentWay)
+{
+	PowerPC::Read_U32(PAGE_A);
+	EXPECT_TRUE(IsCached(PAGE_A));
+	ExpectOnlyRecentWaysCached();
+
+	PowerPC::Read_U32(PAGE_B);
+	EXPECT_TRUE(IsCached(PAGE_B));
+	EXPECT_FALSE(IsCached(PAGE_A));
+	ExpectOnlyRecentWaysCached();
+
+	// A hit in the guest TLB makes its way the most recent one.
+	PowerPC::Read_U32(PAGE_A);
+	EXPECT_TRUE(IsCached(PAGE_A));
+	EXPECT_FALSE(IsCached(PAGE_B));
+	ExpectOnlyRecentWaysCached();
+
+	// So the third page replaces B, not A.
+	PowerPC::Read_U32(PAGE_C);
+	const PowerPC::tlb_entry& set = PowerPC::ppcState.tlb[0][(PAGE_A >> HW_PAGE_INDEX_SHIFT) & HW_PAGE_INDEX_MASK];
+	EXPECT_TRUE(set.tag[0] == PAGE_A >> HW_PAGE_INDEX_SHIFT || set.tag[1] == PAGE_A >> HW_PAGE_INDEX_SHIFT);
+	EXPECT_TRUE(IsCached(PAGE_C));
+	ExpectOnlyRecentWaysCached();
+}
+
+TEST_F(SoftTLBTest, SettingTheChangeBitKeepsTheRecentWay)
+{
+	PowerPC::Read_U32(PAGE_A);
+	PowerPC::Read_U32(PAGE_B);
+
+	// The first write to A only sets its C bit, which doesn't make A the most
+	// recent way.
+	PowerPC::Write_U32(0, PAGE_A);
+	ExpectOnlyRecentWaysCached();
+}
+
+TEST_F(SoftTLBTest, ProbeOnlyHitsWithTranslationOn)
+{
+	ProbeCode probe;
+	PowerPC::Read_U32(PAGE_A);
+	EXPECT_EQ(Memory::physical_base + PHYSICAL_BASE + 0x10, probe(PAGE_A + 0x10));
+	EXPECT_EQ(nullptr, probe(PAGE_B + 0x10));
+	// Crosses into the next page.
+	EXPECT_EQ(nullptr, probe(PAGE_A + 0xffe));
+
+	// In real mode the same effective address isn't translated by the page table.
+	PowerPC::ppcState.msr = 0;
+	EXPECT_EQ(nullptr, probe(PAGE_A + 0x10));
+}
@@ -0,0 +1,115 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/MemTools.h"
+#include "Core/HW/Memmap.h"
+#include "VideoCommon/VideoBackendBase.h"
+
+#if _M_X86_64 && !defined(__APPLE__)
+namespace
+{
+
+// Memory::Init registers the CommandProcessor MMIO through the video backend.
+class FakeVideoBackend : public VideoBackendHardware
+{
+public:
+	unsigned int PeekMessages() override { return 0; }
+	bool Initialize(void*) override { return true; }
+	void Shutdown() override {}
+	std::string GetName() const override { return "Fake"; }
+	void ShowConfig(void*) override {}
+	void Video_Prepare() override {}
+	void Video_Cleanup() override {}
+};
+
+// Two pages far enough apart to never share a host page.
+const u32 PAGE_A = 0x80100000;
+const u32 PAGE_B = 0x80200000;
+const u32 SIZE = 0x1000;
+
+class WriteTrackingTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		SConfig::Init();
+		SConfig::GetInstance().bWii = false;
+		SConfig::GetInstance().bMMU = false;
+		g_video_backend = &m_backend;
+		Memory::Init();
+	}
+
+	void TearDown() override
+	{
+		Memory::SetWriteTracking(false);
+		Memory::Shutdown();
+		g_video_backend = nullptr;
+		SConfig::Shutdown();
+	}
+
+	FakeVideoBackend m_backend;
+};
+
+}  // namespace
+
+TEST_F(WriteTrackingTest, RecordsWrites)
+{
+	ASSERT_TRUE(Memory::SetWriteTracking(true));
+
+	u32 token_a = Memory::TrackWrites(PAGE_A, SIZE);
+	u32 token_b = Memory::TrackWrites(PAGE_B, SIZE);
+	EXPECT_FALSE(Memory::WrittenSince(PAGE_A, SIZE, token_a));
+	EXPECT_FALSE(Memory::WrittenSince(PAGE_B, SIZE, token_b));
+
+	// A plain write to a protected page goes through the exception handler.
+	Memory::Write_U32(0x12345678, PAGE_A + 0x10);
+	EXPECT_EQ(0x12345678u, Memory::Read_U32(PAGE_A + 0x10));
+	EXPECT_TRUE(Memory::WrittenSince(PAGE_A, SIZE, token_a));
+	EXPECT_FALSE(Memory::WrittenSince(PAGE_B, SIZE, token_b));
+
+	// A write the kernel would do never faults, so the scope records it instead.
+	{
+		Memory::HostWriteScope host_write(PAGE_B, 16);
+		memset(Memory::GetPointer(PAGE_B), 0xAB, 16);
+	}
+	EXPECT_TRUE(Memory::WrittenSince(PAGE_B, SIZE, token_b));
+
+	// Tracking again after the writes starts over.
+	token_a = Memory::TrackWrites(PAGE_A, SIZE);
+	EXPECT_FALSE(Memory::WrittenSince(PAGE_A, SIZE, token_a));
+}
+
+#ifndef _WIN32
+TEST_F(WriteTrackingTest, InstallsHandlerOnce)
+{
+	ASSERT_TRUE(Memory::SetWriteTracking(true));
+	stack_t first;
+	ASSERT_EQ(0, sigaltstack(nullptr, &first));
+
+	// Turning tracking off and on again keeps the signal stack it already has.
+	for (int i = 0; i < 4; ++i)
+	{
+		Memory::SetWriteTracking(false);
+		ASSERT_TRUE(Memory::SetWriteTracking(true));
+	}
+	stack_t current;
+	ASSERT_EQ(0, sigaltstack(nullptr, &current));
+	EXPECT_EQ(first.ss_sp, current.ss_sp);
+
+	u32 token = Memory::TrackWrites(PAGE_A, SIZE);
+	Memory::Write_U8(1, PAGE_A);
+	EXPECT_TRUE(Memory::WrittenSince(PAGE_A, SIZE, token));
+}
+#endif
+#endif
@@ -0,0 +1,168 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/HW/DSPHLE/UCodes/Zelda.h"
+
+// The scalar loops the renderer used before they were vectorized. They are
+// checked on odd counts too, so that the scalar tails are covered.
+
+static s32 ReferenceVolumeRamp(s16* dst, const s16* src, size_t count, s32 vol, s32 step)
+{
+	if (!vol && !step)
+		return vol;
+	for (size_t i = 0; i < count; ++i)
+	{
+		dst[i] += ((vol >> 16) * src[i]) >> 16;
+		vol = (s32)((u32)vol + step);
+	}
+	return vol;
+}
+
+static void ReferenceVolume(s16* dst, const s16* src, size_t count, u16 vol)
+{
+	while (count--)
+	{
+		s32 vol_src = ((s32)*src++ * (s32)vol) >> 15;
+		*dst++ += MathUtil::Clamp(vol_src, -0x8000, 0x7FFF);
+	}
+}
+
+static void ReferenceReverbFilter(s16* buffer, size_t count, const s16* coeffs)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		s32 sample = 0;
+		for (size_t j = 0; j < 8; ++j)
+			sample += (s32)buffer[i + j] * coeffs[j];
+		sample >>= 15;
+		buffer[i] = MathUtil::Clamp(sample, -0x8000, 0x7FFF);
+	}
+}
+
+static u32 ReferenceResample(s16* dst, const s16* src, size_t count, u32 pos, u32 ratio, const s16* coeffs)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const s16* c = &coeffs[((pos & 0xFFF) >> 6) * 4];
+		const s16* input = &src[pos >> 12];
+		s64 sample = 0;
+		for (size_t j = 0; j < 4; ++j)
+			sample += (s64)2 * c[j] * input[j];
+		dst[i] = (s16)MathUtil::Clamp<s64>(sample >> 16, -0x8000, 0x7FFF);
+		pos += ratio;
+	}
+	return pos;
+}
+
+namespace
+{
+class ZeldaMixing : public testing::Test
+{
+protected:
+	// Full scale values are the interesting ones for clamping and wrapping.
+	s16 Sample()
+	{
+		const int r = std::uniform_int_distribution<int>(0, 7)(m_rng);
+		if (r == 0)
+			return -0x8000;
+		if (r == 1)
+			return 0x7FFF;
+		return (s16)std::uniform_int_distribution<int>(-0x8000, 0x7FFF)(m_rng);
+	}
+
+	template <size_t N>
+	std::array<s16, N> Buffer()
+	{
+		std::array<s16, N> buf;
+		for (s16& s : buf)
+			s = Sample();
+		return buf;
+	}
+
+	std::mt19937 m_rng{ 4321 };
+};
+}  // namespace
+
+TEST_F(ZeldaMixing, VolumeRamp)
+{
+	for (int round = 0; round < 2000; ++round)
+	{
+		const size_t count = round % 2 ? 0x50 : 0x50 - round % 7;
+		const auto src = Buffer<0x50>();
+		auto expected = Buffer<0x50>();
+		auto actual = expected;
+		const s32 vol = (s32)Sample() << 16;
+		const s32 step = round % 3 ? (Sample() << 16) / 0x50 : (s32)m_rng();
+
+		const s32 expected_vol = ReferenceVolumeRamp(expected.data(), src.data(), count, vol, step);
+		const s32 actual_vol = ZeldaAudioRenderer::AddBuffersWithVolumeRamp(actual.data(), src.data(), count, vol, step);
+		ASSERT_EQ(expected_vol, actual_vol);
+		ASSERT_EQ(expected, actual) << "round " << round;
+	}
+}
+
+TEST_F(ZeldaMixing, Volume)
+{
+	for (int round = 0; round < 2000; ++round)
+	{
+		const size_t count = round % 2 ? 0x50 : 0x28 + round % 7;
+		const auto src = Buffer<0x50>();
+		auto expected = Buffer<0x50>();
+		auto actual = expected;
+		const u16 vol = (u16)Sample();
+
+		ReferenceVolume(expected.data(), src.data(), count, vol);
+		ZeldaAudioRenderer::AddBuffersWithVolume(actual.data(), src.data(), count, vol);
+		ASSERT_EQ(expected, actual) << "round " << round << " volume " << vol;
+	}
+}
+
+TEST_F(ZeldaMixing, ReverbFilter)
+{
+	for (int round = 0; round < 2000; ++round)
+	{
+		const size_t count = round % 2 ? 0x50 : 0x50 - round % 7;
+		const auto coeffs = Buffer<8>();
+		auto expected = Buffer<0x58>();
+		auto actual = expected;
+
+		ReferenceReverbFilter(expected.data(), count, coeffs.data());
+		ZeldaAudioRenderer::ApplyReverbFilter(actual.data(), count, coeffs.data());
+		ASSERT_EQ(expected, actual) << "round " << round;
+	}
+}
+
+TEST_F(ZeldaMixing, Resample)
+{
+	for (int round = 0; round < 2000; ++round)
+	{
+		// Alternate between full scale coefficients, which need 64-bit sums,
+		// and a table small enough for the 32-bit path.
+		auto coeffs = Buffer<0x100>();
+		const bool fit_s32 = round % 2 == 0;
+		if (fit_s32)
+		{
+			for (s16& c : coeffs)
+				c /= 4;
+		}
+
+		const auto src = Buffer<0x500 + 4>();
+		const size_t count = round % 4 < 2 ? 0x50 : 0x50 - round % 7;
+		const u32 ratio = std::uniform_int_distribution<u32>(1, 0x3FFF)(m_rng);
+		const u32 pos = std::uniform_int_distribution<u32>(0, 0xFFF)(m_rng);
+		std::array<s16, 0x50> expected{}, actual{};
+
+		const u32 expected_pos = ReferenceResample(expected.data(), src.data(), count, pos, ratio, coeffs.data());
+		const u32 actual_pos = ZeldaAudioRenderer::ResampleInterpolated(actual.data(), src.data(), count, pos, ratio,
+		                                                                coeffs.data(), fit_s32);
+		ASSERT_EQ(expected_pos, actual_pos);
+		ASSERT_EQ(expected, actual) << "round " << round;
+	}
+}
@@ -0,0 +1,175 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/TextureCacheIndex.h"
+
+namespace
+{
+struct Element
+{
+	int id;
+	IntrusiveLink<Element> index_link;
+	IntrusiveLink<Element> list_link;
+};
+
+typedef IntrusiveHashIndex<Element, &Element::index_link> Index;
+typedef IntrusiveList<Element, &Element::list_link> List;
+
+std::vector<int> Lookup(const Index& index, u64 key)
+{
+	std::vector<int> ids;
+	for (Element* e = index.Find(key); e; e = Index::Next(e))
+		ids.push_back(e->id);
+	return ids;
+}
+
+std::vector<int> ListIds(const List& list)
+{
+	std::vector<int> ids;
+	for (Element* e = list.Front(); e; e = List::Next(e))
+		ids.push_back(e->id);
+	return ids;
+}
+}
+
+TEST(TextureCacheIndex, MatchesMultimap)
+{
+	std::mt19937 rng(1234);
+	// Few distinct keys, so that chains form, and aligned like texture
+	// addresses, so that the low bits are useless for hashing.
+	std::uniform_int_distribution<u32> key_dist(0, 3000);
+
+	std::vector<std::unique_ptr<Element>> elements(20000);
+	for (int i = 0; i < (int)elements.size(); ++i)
+		elements[i].reset(new Element{ i });
+
+	Index index;
+	std::multimap<u64, int> reference;
+	std::vector<Element*> inserted;
+	size_t next_element = 0;
+
+	for (int step = 0; step < 100000; ++step)
+	{
+		// Grow for a while, then shrink, then grow again to cover table growth
+		// and runs of removals.
+		const bool grow = (step / 25000) % 2 == 0;
+		if (next_element < elements.size() && (inserted.empty() || (rng() % 4 != 0) == grow))
+		{
+			Element* e = elements[next_element++].get();
+			const u64 key = (u64)key_dist(rng) << 5;
+			index.Insert(key, e);
+			reference.emplace(key, e->id);
+			inserted.push_back(e);
+		}
+		else if (!inserted.empty())
+		{
+			const size_t i = rng() % inserted.size();
+			Element* e = inserted[i];
+			auto range = reference.equal_range(e->index_link.key);
+			reference.erase(std::find_if(range.first, range.second,
+				[e](const std::pair<const u64, int>& p) { return p.second == e->id; }));
+			index.Remove(e);
+			EXPECT_FALSE(Index::Contains(e));
+			inserted[i] = inserted.back();
+			inserted.pop_back();
+		}
+
+		if (step % 1000 == 0)
+		{
+			ASSERT_EQ(reference.size(), index.Size());
+			for (u32 k = 0; k <= 3000; ++k)
+			{
+				std::vector<int> expected;
+				auto range = reference.equal_range((u64)k << 5);
+				for (auto it = range.first; it != range.second; ++it)
+					expected.push_back(it->second);
+				ASSERT_EQ(expected, Lookup(index, (u64)k << 5)) << "key " << k << " at step " << step;
+			}
+		}
+	}
+}
+
+TEST(TextureCacheIndex, KeepsInsertionOrder)
+{
+	Element a{ 1 }, b{ 2 }, c{ 3 }, d{ 4 };
+	Index index;
+	index.Insert(0x80001000, &a);
+	index.Insert(0x80001000, &b);
+	index.Insert(0x80002000, &d);
+	index.Insert(0x80001000, &c);
+
+	EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), Lookup(index, 0x80001000));
+	index.Remove(&b);
+	EXPECT_EQ(std::vector<int>({ 1, 3 }), Lookup(index, 0x80001000));
+	index.Remove(&a);
+	index.Insert(0x80001000, &a);
+	EXPECT_EQ(std::vector<int>({ 3, 1 }), Lookup(index, 0x80001000));
+	EXPECT_EQ(std::vector<int>({ 4 }), Lookup(index, 0x80002000));
+	EXPECT_EQ(nullptr, index.Find(0x80003000));
+
+	index.Clear();
+	EXPECT_EQ(0u, index.Size());
+	EXPECT_EQ(nullptr, index.Find(0x80001000));
+}
+
+TEST(TextureCacheIndex, ListMoveToFront)
+{
+	Element e[4] = { { 0 }, { 1 }, { 2 }, { 3 } };
+	List list;
+	EXPECT_TRUE(list.Empty());
+	for (Element& element : e)
+		list.PushFront(&element);
+	EXPECT_EQ(std::vector<int>({ 3, 2, 1, 0 }), ListIds(list));
+
+	list.MoveToFront(&e[0]);
+	list.MoveToFront(&e[2]);
+	list.MoveToFront(&e[2]);
+	EXPECT_EQ(std::vector<int>({ 2, 0, 3, 1 }), ListIds(list));
+	EXPECT_EQ(&e[1], list.Back());
+	EXPECT_EQ(&e[3], List::Prev(list.Back()));
+
+	list.Remove(&e[1]);
+	list.Remove(&e[2]);
+	EXPECT_EQ(std::vector<int>({ 0, 3 }), ListIds(list));
+	EXPECT_EQ(2u, list.Size());
+	EXPECT_EQ(&e[3], list.Back());
+}
+
+TEST(TextureCacheIndex, RangeOverlaps)
+{
+	Element big{ 1 }, small{ 2 }, other{ 3 };
+	AddressRangeIndex<Element> index;
+	EXPECT_FALSE(index.Overlaps(0x80001000, 0x100));
+
+	// A copy that starts before the range but reaches into it, with a smaller
+	// copy in between that doesn't.
+	index.Insert(0x80001000, 0x1000, &big);
+	index.Insert(0x80001800, 0x10, &small);
+	index.Insert(0x80004000, 0x100, &other);
+
+	EXPECT_TRUE(index.Overlaps(0x80001900, 0x10));
+	EXPECT_TRUE(index.Overlaps(0x80000F00, 0x101));
+	EXPECT_FALSE(index.Overlaps(0x80000F00, 0x100));
+	EXPECT_FALSE(index.Overlaps(0x80002000, 0x2000));
+	EXPECT_TRUE(index.Overlaps(0x80002000, 0x2001));
+	EXPECT_TRUE(index.Overlaps(0x800040F0, 0x100));
+	EXPECT_FALSE(index.Overlaps(0x80004100, 0x100));
+
+	index.Remove(0x80001000, &big);
+	EXPECT_FALSE(index.Overlaps(0x80001900, 0x10));
+	EXPECT_TRUE(index.Overlaps(0x80001808, 0x10));
+	EXPECT_EQ(&small, index.LowerBound(0x80001001)->element);
+
+	index.Clear();
+	EXPECT_FALSE(index.Overlaps(0x80001808, 0x10));
+	EXPECT_TRUE(index.begin() == index.end());
+}
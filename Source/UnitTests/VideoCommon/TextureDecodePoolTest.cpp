@@ -0,0 +1,138 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Common/MemoryUtil.h"
+#include "VideoCommon/TextureDecodePool.h"
+#include "VideoCommon/TextureDecoder.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+class TextureDecodePoolTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		g_ActiveConfig.iTextureDecodingThreads = 3;
+		TextureDecodePool::Init();
+		ASSERT_TRUE(TextureDecodePool::IsRunning());
+
+		std::mt19937 rng(99);
+		m_source.resize(1024 * 1024 * 4);
+		for (u8& b : m_source)
+			b = (u8)rng();
+		for (u8& b : m_tlut)
+			b = (u8)rng();
+	}
+
+	void TearDown() override { TextureDecodePool::Shutdown(); }
+
+	// Decodes a texture and its mipmaps level by level with TexDecoder_Decode,
+	// and as one job on the pool, and checks that they match.
+	void CheckFormat(int format, u32 width, u32 height, u32 levels, bool copy_source)
+	{
+		const u32 bsw = TexDecoder_GetBlockWidthInTexels(format);
+		const u32 bsh = TexDecoder_GetBlockHeightInTexels(format);
+
+		std::vector<u32> level_widths, level_heights;
+		size_t source_size = 0, decoded_size = 0;
+		for (u32 level = 0; level < levels; ++level)
+		{
+			const u32 w = ROUND_UP(std::max(width >> level, 1u), bsw);
+			const u32 h = ROUND_UP(std::max(height >> level, 1u), bsh);
+			level_widths.push_back(w);
+			level_heights.push_back(h);
+			source_size += TexDecoder_GetTextureSizeInBytes(w, h, format);
+			decoded_size += w * h * 4;
+		}
+		ASSERT_LE(source_size, m_source.size());
+
+		std::vector<u32> expected(decoded_size / 4);
+		auto job = std::make_shared<TextureDecodeJob>(format, m_tlut, GX_TL_RGB5A3);
+		if (copy_source)
+			job->CopySource(m_source.data(), source_size, sizeof(m_tlut));
+		job->AllocateOutput(decoded_size);
+
+		const u8* src = m_source.data();
+		size_t src_offset = 0, dst_offset = 0;
+		for (u32 level = 0; level < levels; ++level)
+		{
+			const u32 w = level_widths[level], h = level_heights[level];
+			TexDecoder_Decode((u8*)&expected[dst_offset / 4], src + src_offset, w, h, format, m_tlut, GX_TL_RGB5A3);
+			job->AddLevel(job->GetOutput() + dst_offset,
+			              (copy_source ? job->GetSource() : src) + src_offset, w, h);
+			src_offset += TexDecoder_GetTextureSizeInBytes(w, h, format);
+			dst_offset += w * h * 4;
+		}
+
+		TextureDecodePool::Submit(job);
+		if (copy_source)
+		{
+			// The job works on its own copy from here on.
+			memset(m_source.data(), 0, source_size);
+			memset(m_tlut, 0, sizeof(m_tlut));
+		}
+		job->Wait();
+
+		ASSERT_TRUE(job->IsDone());
+		EXPECT_EQ(0, memcmp(expected.data(), job->GetOutput(), decoded_size))
+			<< "format " << format << " " << width << "x" << height;
+	}
+
+	std::vector<u8> m_source;
+	alignas(16) u8 m_tlut[16384 * 2];
+};
+}  // namespace
+
+TEST_F(TextureDecodePoolTest, MatchesSingleThreadedDecoding)
+{
+	const int formats[] = {
+		GX_TF_I4, GX_TF_I8, GX_TF_IA4, GX_TF_IA8, GX_TF_RGB565, GX_TF_RGB5A3,
+		GX_TF_RGBA8, GX_TF_C4, GX_TF_C8, GX_TF_C14X2, GX_TF_CMPR,
+	};
+	for (int format : formats)
+	{
+		CheckFormat(format, 1024, 512, 1, false);
+		CheckFormat(format, 640, 480, 1, false);
+		CheckFormat(format, 512, 512, 10, false);
+		CheckFormat(format, 20, 12, 3, false);
+	}
+}
+
+TEST_F(TextureDecodePoolTest, CopiedSourceOutlivesMemory)
+{
+	CheckFormat(GX_TF_CMPR, 1024, 1024, 11, true);
+	CheckFormat(GX_TF_C8, 512, 256, 4, true);
+}
+
+TEST_F(TextureDecodePoolTest, ManyJobsInFlight)
+{
+	// Jobs that are never waited on must not block the others, and shutting
+	// down decodes whatever is left.
+	std::vector<std::shared_ptr<TextureDecodeJob>> jobs;
+	for (int i = 0; i < 32; ++i)
+	{
+		auto job = std::make_shared<TextureDecodeJob>(GX_TF_RGBA8, m_tlut, GX_TL_RGB5A3);
+		job->CopySource(m_source.data(), 256 * 256 * 4, 0);
+		job->AllocateOutput(256 * 256 * 4);
+		job->AddLevel(job->GetOutput(), job->GetSource(), 256, 256);
+		TextureDecodePool::Submit(job);
+		jobs.push_back(job);
+	}
+	jobs[5]->Wait();
+	EXPECT_TRUE(jobs[5]->IsDone());
+
+	TextureDecodePool::Shutdown();
+	for (const auto& job : jobs)
+		EXPECT_TRUE(job->IsDone());
+	TextureDecodePool::Init();
+}
@@ -0,0 +1,168 @@
+// Copyright 2016 Dolphin Emulator Project
+// Licensed under GPLv2+
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/CPUDetect.h"
+#include "Common/MathUtil.h"
+#include "VideoCommon/TextureDecoder.h"
+
+// The generic decoder is the reference. The library is built with the x64 one
+// on x86, so the generic one is built into the test under another name.
+void GenericTexDecoder_DecodeImpl(u32* dst, const u8* src, int width, int height, int texformat,
+                                  const u8* tlut, TlutFormat tlutfmt);
+#define _TexDecoder_DecodeImpl GenericTexDecoder_DecodeImpl
+#include "VideoCommon/TextureDecoder_Generic.cpp"
+#undef _TexDecoder_DecodeImpl
+
+namespace
+{
+struct TestFormat
+{
+	int format;
+	const char* name;
+	bool paletted;
+};
+
+const TestFormat formats[] = {
+	{ GX_TF_I4, "I4", false },
+	{ GX_TF_I8, "I8", false },
+	{ GX_TF_IA4, "IA4", false },
+	{ GX_TF_IA8, "IA8", false },
+	{ GX_TF_RGB565, "RGB565", false },
+	{ GX_TF_RGB5A3, "RGB5A3", false },
+	{ GX_TF_RGBA8, "RGBA8", false },
+	{ GX_TF_C4, "C4", true },
+	{ GX_TF_C8, "C8", true },
+	{ GX_TF_C14X2, "C14X2", true },
+	{ GX_TF_CMPR, "CMPR", false },
+};
+
+const TlutFormat tlut_formats[] = { GX_TL_IA8, GX_TL_RGB565, GX_TL_RGB5A3 };
+
+std::vector<u8> RandomBytes(size_t size, u32 seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<u8> data(size);
+	for (u8& b : data)
+		b = (u8)rng();
+	return data;
+}
+
+// Decodes with _TexDecoder_DecodeImpl, taking whichever path cpu_info
+// selects, and compares with the generic decoder.
+void CheckAgainstGeneric()
+{
+	const std::vector<u8> tlut = RandomBytes(TexDecoder_GetPaletteSize(GX_TF_C14X2), 7);
+
+	// 12 texels wide, so that the formats with 4 texel wide blocks have an
+	// odd number of them per row.
+	const struct
+	{
+		int width;
+		int height;
+	} sizes[] = { { 8, 8 }, { 12, 8 }, { 64, 32 }, { 100, 60 } };
+
+	for (const TestFormat& f : formats)
+	{
+		for (const auto& size : sizes)
+		{
+			const int width = ROUND_UP(size.width, TexDecoder_GetBlockWidthInTexels(f.format));
+			const int height = ROUND_UP(size.height, TexDecoder_GetBlockHeightInTexels(f.format));
+			const std::vector<u8> src = RandomBytes(TexDecoder_GetTextureSizeInBytes(width, height, f.format), width * height);
+
+			for (TlutFormat tlutfmt : tlut_formats)
+			{
+				std::vector<u32> expected(width * height), actual(width * height);
+				GenericTexDecoder_DecodeImpl(expected.data(), src.data(), width, height, f.format, tlut.data(), tlutfmt);
+				_TexDecoder_DecodeImpl(actual.data(), src.data(), width, height, f.format, tlut.data(), tlutfmt);
+
+				for (int i = 0; i < width * height; i++)
+				{
+					if (expected[i] != actual[i])
+					{
+						ADD_FAILURE() << f.name << " " << width << "x" << height << " tlut " << tlutfmt
+						              << ": texel (" << i % width << ", " << i / width << ") is " << std::hex
+						              << actual[i] << ", expected " << expected[i];
+						break;
+					}
+				}
+
+				if (!f.paletted)
+					break;
+			}
+		}
+	}
+}
+
+class ScopedDisableAVX2
+{
+public:
+	ScopedDisableAVX2() : m_avx2(cpu_info.bAVX2) { cpu_info.bAVX2 = false; }
+	~ScopedDisableAVX2() { cpu_info.bAVX2 = m_avx2; }
+
+private:
+	bool m_avx2;
+};
+}
+
+TEST(TextureDecoder, MatchesGeneric)
+{
+	if (!cpu_info.bAVX2)
+		printf("No AVX2 on this CPU, testing the same path as MatchesGenericWithoutAVX2\n");
+	CheckAgainstGeneric();
+}
+
+TEST(TextureDecoder, MatchesGenericWithoutAVX2)
+{
+	ScopedDisableAVX2 disable;
+	CheckAgainstGeneric();
+}
+
+TEST(TextureDecoder, DISABLED_Benchmark)
+{
+	// Not a pass/fail test. Decodes a 256x256 texture of every format, which
+	// keeps the decoded texture in the cache and measures the decoders rather
+	// than the memory bandwidth.
+	const int width = 256, height = 256;
+	const std::vector<u8> tlut = RandomBytes(TexDecoder_GetPaletteSize(GX_TF_C14X2), 7);
+	std::vector<u32> dst(width * height);
+
+	const struct
+	{
+		const char* name;
+		bool avx2;
+		void (*decode)(u32*, const u8*, int, int, int, const u8*, TlutFormat);
+	} decoders[] = {
+		{ "Generic", false, GenericTexDecoder_DecodeImpl },
+		{ "Default", false, _TexDecoder_DecodeImpl },
+		{ "AVX2", true, _TexDecoder_DecodeImpl },
+	};
+
+	for (const TestFormat& f : formats)
+	{
+		const std::vector<u8> src = RandomBytes(TexDecoder_GetTextureSizeInBytes(width, height, f.format), 1);
+		printf("%-7s", f.name);
+		for (const auto& d : decoders)
+		{
+			if (d.avx2 && !cpu_info.bAVX2)
+				continue;
+			ScopedDisableAVX2 disable;
+			cpu_info.bAVX2 = d.avx2;
+
+			const int rounds = 300;
+			auto start = std::chrono::steady_clock::now();
+			for (int r = 0; r < rounds; r++)
+				d.decode(dst.data(), src.data(), width, height, f.format, tlut.data(), GX_TL_RGB5A3);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			printf("  %s %7.1f Mtexels/s", d.name, (double)width * height * rounds / elapsed.count() / 1e6);
+		}
+		printf("\n");
+	}
+}
@@ -153,7 +153,7 @@ TEST_P(VertexLoaderParamTest, PositionAll)
 			else
 				Input<u16>(i);
 		VertexLoaderManager::cached_arraybases[ARRAY_POSITION] = m_src.GetPointer();
-		g_main_cp_state.array_strides[ARRAY_POSITION] = elements * elem_size;
+		VertexLoaderManager::cached_arraystrides[ARRAY_POSITION] = elements * elem_size;
 	}
 	CreateAndCheckSizes(input_size, elements * sizeof(float));
 	for (float value : values)
@@ -194,7 +194,7 @@ TEST_F(VertexLoaderTest, PositionIndex16FloatXY)
 	CreateAndCheckSizes(sizeof(u16), 2 * sizeof(float));
 	Input<u16>(1); Input<u16>(0);
 	VertexLoaderManager::cached_arraybases[ARRAY_POSITION] = m_src.GetPointer();
-	g_main_cp_state.array_strides[ARRAY_POSITION] = sizeof(float); // ;)
+	VertexLoaderManager::cached_arraystrides[ARRAY_POSITION] = sizeof(float); // ;)
 	Input(1.f); Input(2.f); Input(3.f);
 	RunVertices(2);
 	ExpectOut(2); ExpectOut(3);
@@ -301,7 +301,7 @@ TEST_F(VertexLoaderTest, LargeFloatVertexSpeed)
 	for (int i = 0; i < 12; i++)
 	{
 		VertexLoaderManager::cached_arraybases[i] = m_src.GetPointer();
-		g_main_cp_state.array_strides[i] = 129;
+		VertexLoaderManager::cached_arraystrides[i] = 129;
 	}
 
 	// This test is only done 100x in a row since it's ~20x slower using the